@@ -18,13 +18,36 @@ cd testbed
 ./build.sh
 cd ..
 
+# Build tools
+echo "building tools"
+cd tools/telemetry
+./build.sh
+cd ../..
+cd tools/objbench
+./build.sh
+cd ../..
+cd tools/packer
+./build.sh
+cd ../..
+cd tools/texconv
+./build.sh
+cd ../..
+
 # Copy the built files to bin directory
 cp engine/libengine.so bin/
 cp testbed/testbed bin/
+cp tools/telemetry/telemetry bin/
+cp tools/objbench/objbench bin/
+cp tools/packer/packer bin/
+cp tools/texconv/texconv bin/
 
 # Remove the built files after copying to bin directory
 rm engine/libengine.so
 rm testbed/testbed
+rm tools/telemetry/telemetry
+rm tools/objbench/objbench
+rm tools/packer/packer
+rm tools/texconv/texconv
 
 # Copy testbed and engine assets to the bin directory
 echo "Copying assets to bin directory"
@@ -36,4 +59,19 @@ fi
 if [ -d "engine/assets" ]; then
   cp -r engine/assets/* bin/assets/
 fi
+
+# Convert textures ahead of time so loading them skips the decode and mip generation,
+# BC7 keeps them compressed on the GPU and falls back to a CPU decode without it
+echo "Converting textures"
+cd bin
+for image in assets/textures/*.png assets/textures/*.jpg; do
+  if [ -f "$image" ]; then
+    ./texconv "$image" "${image%.*}.ktex" -c bc7
+  fi
+done
+
+# Pack the assets so the game maps one file instead of opening each asset
+echo "Packing assets"
+./packer assets.pack assets -z
+cd ..
 echo "Successfully build all libs "
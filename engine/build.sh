@@ -6,15 +6,15 @@ echo "Building engine shared library..."
 mkdir -p obj
 
 # Compile each source file
-for file in src/*.c src/core/*.c src/platform/*.c src/renderer/*.c src/renderer/opengl/*.c src/containers/*.c src/shaders/*.c src/models/*.c src/resources/*.c; do
+for file in src/*.c src/core/*.c src/platform/*.c src/renderer/*.c src/renderer/opengl/*.c src/renderer/null/*.c src/containers/*.c src/shaders/*.c src/models/*.c src/resources/*.c; do
     if [ -f "$file" ]; then
         obj_file="obj/$(basename ${file%.c}.o)"
-        clang -g -fPIC -c "$file" -o "$obj_file" -I/usr/include/SDL2 -I/usr/include/freetype2 -Isrc -D_GNU_SOURCE=1 -D_REENTRANT
+        clang -g -fno-omit-frame-pointer -fPIC -c "$file" -o "$obj_file" -I/usr/include/SDL2 -I/usr/include/freetype2 -Isrc -D_GNU_SOURCE=1 -D_REENTRANT
     fi
 done
 
 # Create shared library
-clang -g -shared -o libengine.so obj/*.o -lSDL2 -lGL -lGLEW -lfreetype -lm
+clang -g -shared -o libengine.so obj/*.o -lSDL2 -lGL -lGLEW -lfreetype -lm -lpthread -lrt -ldl
 
 # Clean up object files
 rm -rf obj
@@ -0,0 +1,23 @@
+#include "probe_table.h"
+
+u32 probe_table_remove(void* table, u32 capacity, u32 slot, pfn_probe_table_used used,
+                       pfn_probe_table_hash hash, pfn_probe_table_move move) {
+    u32 mask = capacity - 1;
+    u32 hole = slot;
+    u32 next = slot;
+    for (;;) {
+        next = (next + 1) & mask;
+        if (!used(table, next)) {
+            break;
+        }
+        u32 home = (u32)(hash(table, next) & mask);
+        // Entries whose home lies cyclically in (hole, next] must stay put
+        b8 stays = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+        if (stays) {
+            continue;
+        }
+        move(table, hole, next);
+        hole = next;
+    }
+    return hole;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "definitions.h"
+
+// Open-addressing tables with linear probing over a power of two slot count,
+// like the VFS path cache and the resource manager's key lookup. The slots stay
+// with their owner, these helpers reach them through callbacks.
+
+// TRUE when slot holds an entry.
+typedef b8 (*pfn_probe_table_used)(void* table, u32 slot);
+// Hash of the entry in slot, its home slot is hash & (capacity - 1).
+typedef u64 (*pfn_probe_table_hash)(void* table, u32 slot);
+// Moves the entry in from to the slot to, overwriting it.
+typedef void (*pfn_probe_table_move)(void* table, u32 to, u32 from);
+
+// Backward-shift deletion. Call once the entry in slot has been released:
+// later entries of its probe run are shifted back so lookups never stop early
+// at the hole. Returns the slot left over at the end, which the caller empties.
+API u32 probe_table_remove(void* table, u32 capacity, u32 slot, pfn_probe_table_used used,
+                           pfn_probe_table_hash hash, pfn_probe_table_move move);
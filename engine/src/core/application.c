@@ -3,9 +3,22 @@
 #include "game_types.h"
 #include <core/logger.h>
 #include <platform/platform.h>
+#include <platform/perf_counters.h>
+#include <platform/sampling_profiler.h>
 #include <core/kmemory.h>
 #include <core/event.h>
 #include <core/clock.h>
+#include <core/profiler.h>
+#include <core/frame_stats.h>
+#include <core/perf_hud.h>
+#include <core/hitch_detector.h>
+#include <core/telemetry.h>
+#include <core/idle_tasks.h>
+#include <core/job_system.h>
+#include <core/vfs.h>
+#include <resources/resource_manager.h>
+#include <resources/texture_streaming.h>
+#include <platform/async_io.h>
 #include <SDL2/SDL_keycode.h>
 #include "renderer/renderer_frontend.h"
 
@@ -14,18 +27,153 @@ typedef struct application_state {
     b8 is_running;
     b8 is_suspended;
     platform_state platform;
+    u64 frame_count;
     i16 width;
     i16 height;
     clock clock;
     f64 last_time;
+    // Fixed-timestep state, see application_config.
+    b8 fixed_timestep;
+    f64 tick_seconds;
+    u32 max_ticks_per_frame;
+    f64 accumulator;
+    frame_pacer pacer;
+    f64 last_pacing_report;
+    // Recent frame times for the performance HUD.
+    frame_stats frame_times;
+    // Per-phase history of recent frames, dumped when one runs long.
+    hitch_detector hitches;
+    // Drawing happens on the render thread, so the swap is not part of render.
+    b8 render_threaded;
+    // Counter deltas per phase since the last report, see application_config.perf_counters.
+    b8 perf_counters_enabled;
+    perf_counter_values phase_counters[FRAME_PHASE_MAX];
+    u64 counter_frames;
+    // Window state and what it means for the loop, see application_config.minimized_mode.
+    b8 focused;
+    b8 minimized;
+    background_mode minimized_mode;
+    background_mode unfocused_mode;
+    background_mode background;
+    f32 foreground_frame_rate;
+    f32 background_frame_rate;
 } application_state;
 
+// Defaults used when the fixed-timestep config fields are left at 0.
+#define DEFAULT_TICK_RATE 60.0f
+#define DEFAULT_MAX_TICKS_PER_FRAME 5
+#define DEFAULT_TARGET_FRAME_RATE 60.0f
+#define DEFAULT_BACKGROUND_FRAME_RATE 10.0f
+// Longest a paused loop blocks on window events before checking for quit.
+#define SUSPENDED_WAIT_MS 250
+// How often achieved frame pacing is logged, in seconds.
+#define FRAME_PACING_REPORT_SECONDS 5.0
+
 static b8 initialized = FALSE;
 static application_state app_state;
 
+// Frame pacing
+void application_set_target_frame_rate(f32 target_frame_rate) {
+    app_state.foreground_frame_rate = target_frame_rate;
+    // A throttled app picks the new rate up when it comes back to the foreground
+    if(app_state.background != BACKGROUND_MODE_THROTTLE){
+        frame_pacer_set_target(&app_state.pacer, target_frame_rate);
+    }
+}
+
+void application_get_frame_pacing_stats(frame_pacing_stats* out_stats) {
+    frame_pacer_get_stats(&app_state.pacer, out_stats);
+}
+
+static void application_report_frame_pacing() {
+    frame_pacing_stats stats;
+    frame_pacer_get_stats(&app_state.pacer, &stats);
+    if(stats.frame_count > 0){
+        INFO("Frame pacing: %.1f fps, mean %.3f ms, std dev %.3f ms (variance %.4f ms^2), min %.3f ms, max %.3f ms",
+            1.0 / stats.mean, stats.mean * 1000.0, stats.std_deviation * 1000.0,
+            stats.variance * 1000.0 * 1000.0, stats.min * 1000.0, stats.max * 1000.0);
+    }
+    frame_pacer_reset_stats(&app_state.pacer);
+}
+
+// Perf counters
+static void application_counters_begin(perf_counter_values* out_begin) {
+    if(app_state.perf_counters_enabled){
+        perf_counters_read(out_begin);
+    }
+}
+
+static void application_counters_end(frame_phase phase, const perf_counter_values* begin) {
+    if(!app_state.perf_counters_enabled){
+        return;
+    }
+    perf_counter_values end;
+    perf_counters_read(&end);
+    for(u32 i = 0; i < PERF_COUNTER_MAX; ++i){
+        app_state.phase_counters[phase].values[i] += end.values[i] - begin->values[i];
+    }
+}
+
+static void application_report_phase_counters(frame_phase phase, f64 frames) {
+    const u64* v = app_state.phase_counters[phase].values;
+    if(perf_counters_hardware_available()){
+        f64 ipc = v[PERF_COUNTER_CYCLES] > 0 ? (f64)v[PERF_COUNTER_INSTRUCTIONS] / (f64)v[PERF_COUNTER_CYCLES] : 0;
+        INFO("Perf counters, %s per frame: IPC %.2f, %.0f cycles, %.0f instructions, %.0f cache misses, %.0f branch misses, %.1f page faults",
+            hitch_detector_phase_name(phase), ipc, v[PERF_COUNTER_CYCLES] / frames, v[PERF_COUNTER_INSTRUCTIONS] / frames,
+            v[PERF_COUNTER_CACHE_MISSES] / frames, v[PERF_COUNTER_BRANCH_MISSES] / frames, v[PERF_COUNTER_PAGE_FAULTS] / frames);
+    } else {
+        INFO("Perf counters, %s per frame: %.1f us task clock, %.1f page faults",
+            hitch_detector_phase_name(phase), v[PERF_COUNTER_TASK_CLOCK_NS] / frames / 1000.0,
+            v[PERF_COUNTER_PAGE_FAULTS] / frames);
+    }
+}
+
+static void application_report_perf_counters() {
+    if(!app_state.perf_counters_enabled || app_state.counter_frames == 0){
+        return;
+    }
+    f64 frames = (f64)app_state.counter_frames;
+    application_report_phase_counters(FRAME_PHASE_UPDATE, frames);
+    application_report_phase_counters(FRAME_PHASE_RENDER, frames);
+    kzero_memory(app_state.phase_counters, sizeof(app_state.phase_counters));
+    app_state.counter_frames = 0;
+}
+
+// Runs the game update for this frame. With fixed timestep on, this steps the
+// simulation in tick_seconds increments and reports the interpolation alpha.
+static b8 application_update(f64 delta, f32* out_alpha) {
+    game* game_instance = app_state.game_instance;
+    if(!app_state.fixed_timestep){
+        *out_alpha = 1.0f;
+        return game_instance->update(game_instance, (f32)delta);
+    }
+
+    app_state.accumulator += delta;
+    u32 ticks = 0;
+    while(app_state.accumulator >= app_state.tick_seconds && ticks < app_state.max_ticks_per_frame){
+        if(!game_instance->update(game_instance, (f32)app_state.tick_seconds)){
+            return FALSE;
+        }
+        app_state.accumulator -= app_state.tick_seconds;
+        ticks++;
+    }
+
+    // Spiral-of-death guard: if we hit the tick cap, drop the backlog instead of
+    // carrying it into the next frame. Keep the fractional tick so alpha stays valid.
+    if(app_state.accumulator >= app_state.tick_seconds){
+        u64 dropped = (u64)(app_state.accumulator / app_state.tick_seconds);
+        app_state.accumulator -= dropped * app_state.tick_seconds;
+        DEBUG("Fixed timestep fell behind, dropped %llu ticks", dropped);
+    }
+
+    *out_alpha = (f32)(app_state.accumulator / app_state.tick_seconds);
+    return TRUE;
+}
+
 // Event handlers
 b8 application_on_event(u16 code, void* sender, void* listener_inst, event_context context);
 b8 application_on_key(u16 code, void* sender, void* listener_inst, event_context context);
+b8 application_on_window(u16 code, void* sender, void* listener_inst, event_context context);
 
 b8 application_create(game* game_instance){
    
@@ -48,26 +196,94 @@ b8 application_create(game* game_instance){
         return FALSE;
     }
     
+    profiler_initialize();
+
     event_register(EVENT_CODE_APPLICATION_QUIT, 0, application_on_event);
     event_register(EVENT_CODE_KEY_PRESSED, 0, application_on_key);
     event_register(EVENT_CODE_KEY_RELEASED, 0, application_on_key);
+    event_register(EVENT_CODE_WINDOW_FOCUS, 0, application_on_window);
+    event_register(EVENT_CODE_WINDOW_MINIMIZED, 0, application_on_window);
     
     // Set initial window size
     app_state.width = game_instance->app_config.start_width;
     app_state.height = game_instance->app_config.start_height;
 
+    app_state.fixed_timestep = game_instance->app_config.fixed_timestep;
+    f32 tick_rate = game_instance->app_config.tick_rate > 0 ? game_instance->app_config.tick_rate : DEFAULT_TICK_RATE;
+    app_state.tick_seconds = 1.0 / tick_rate;
+    app_state.max_ticks_per_frame = game_instance->app_config.max_ticks_per_frame > 0 ?
+        game_instance->app_config.max_ticks_per_frame : DEFAULT_MAX_TICKS_PER_FRAME;
+    app_state.accumulator = 0;
+    f32 target_frame_rate = game_instance->app_config.target_frame_rate;
+    app_state.foreground_frame_rate = target_frame_rate == 0 ? DEFAULT_TARGET_FRAME_RATE : target_frame_rate;
+    frame_pacer_initialize(&app_state.pacer, app_state.foreground_frame_rate);
+
+    app_state.focused = TRUE;
+    app_state.minimized = FALSE;
+    app_state.background = BACKGROUND_MODE_RUN;
+    app_state.minimized_mode = game_instance->app_config.minimized_mode == BACKGROUND_MODE_DEFAULT ?
+        BACKGROUND_MODE_PAUSE : game_instance->app_config.minimized_mode;
+    app_state.unfocused_mode = game_instance->app_config.unfocused_mode == BACKGROUND_MODE_DEFAULT ?
+        BACKGROUND_MODE_RUN : game_instance->app_config.unfocused_mode;
+    app_state.background_frame_rate = game_instance->app_config.background_frame_rate > 0 ?
+        game_instance->app_config.background_frame_rate : DEFAULT_BACKGROUND_FRAME_RATE;
+
+    frame_stats_initialize(&app_state.frame_times);
+
+    f32 hitch_threshold_ms = game_instance->app_config.hitch_threshold_ms;
+    f64 hitch_threshold = 0;
+    if(hitch_threshold_ms > 0){
+        hitch_threshold = hitch_threshold_ms / 1000.0;
+    } else if(hitch_threshold_ms == 0){
+        // Default to two frame budgets, falling back to the default rate when unpaced
+        f64 budget = app_state.pacer.target_frame_seconds > 0 ? app_state.pacer.target_frame_seconds : 1.0 / DEFAULT_TARGET_FRAME_RATE;
+        hitch_threshold = budget * 2.0;
+    }
+    hitch_detector_initialize(&app_state.hitches, hitch_threshold);
+    if(hitch_threshold > 0){
+        INFO("Hitch detection enabled for frames over %.2f ms", hitch_threshold * 1000.0);
+    }
+
+    if(app_state.fixed_timestep){
+        INFO("Fixed timestep enabled: %.1f ticks/s, at most %u ticks per frame", tick_rate, app_state.max_ticks_per_frame);
+    }
+
+    b8 headless = game_instance->app_config.headless;
     if(!platform_startup(&app_state.platform, game_instance->app_config.name, 
                         game_instance->app_config.start_pos_x, game_instance->app_config.start_pos_y, 
-                        game_instance->app_config.start_width, game_instance->app_config.start_height)){
+                        game_instance->app_config.start_width, game_instance->app_config.start_height,
+                        headless)){
         return FALSE;
     }
     
-    // Renderer startup
-    if (!renderer_initialize(game_instance->app_config.name, &app_state.platform)) {
+    vfs_initialize();
+    const char* asset_root = game_instance->app_config.asset_root;
+    vfs_mount_directory("", asset_root ? asset_root : ".");
+    const char* asset_pack = game_instance->app_config.asset_pack;
+    if(asset_pack && platform_file_exists(asset_pack) && !vfs_mount_pack("", asset_pack)){
+        WARN("Could not mount asset pack '%s', using loose files", asset_pack);
+    }
+    
+    // Renderer startup, headless runs get a backend that never touches the GPU
+    renderer_backend_type backend_type = headless ? RENDERER_BACKEND_TYPE_NULL : RENDERER_BACKEND_TYPE_OPENGL;
+    if (!renderer_initialize(backend_type, game_instance->app_config.name, &app_state.platform)) {
        FATAL("Failed to initialize renderer. Aborting application.");
        return FALSE;
     }
 
+    resource_manager_initialize(RESOURCE_DEFAULT_GRACE_SECONDS, RESOURCE_DEFAULT_MAX_UNUSED);
+    perf_hud_initialize();
+    idle_tasks_initialize();
+    job_system_initialize(game_instance->app_config.job_worker_count);
+    async_io_initialize(0, TRUE);
+    texture_streaming_initialize(game_instance->app_config.texture_upload_budget);
+    if(game_instance->app_config.publish_telemetry){
+        telemetry_initialize();
+    }
+    if(game_instance->app_config.show_perf_hud){
+        perf_hud_set_visible(TRUE);
+    }
+
     if(!app_state.game_instance->initialize(app_state.game_instance)){
         FATAL("Game failed to initialize!");
         return FALSE;
@@ -91,50 +307,130 @@ b8 application_run(){
     clock_update(&app_state.clock);
 
     app_state.last_time = app_state.clock.elapsed;
-    f64 runing_time = 0;
-    u8 frame_count = 0;
-    f64 target_frame_seconds = 1.0f/60;
+    app_state.last_pacing_report = app_state.clock.elapsed;
+
+    sampling_profiler_register_thread("main");
+    u32 sampling_hz = app_state.game_instance->app_config.sampling_profiler_hz;
+    if(sampling_hz > 0){
+        sampling_profiler_start(sampling_hz);
+    }
+
+    // Counters follow the thread that opens them, so open them on the main loop's thread
+    if(app_state.game_instance->app_config.perf_counters){
+        app_state.perf_counters_enabled = perf_counters_initialize();
+    }
+
+    // Resources created during game initialize are already on the GPU, so the
+    // context can move to the render thread now.
+    if(app_state.game_instance->app_config.threaded_rendering){
+        app_state.render_threaded = renderer_start_render_thread();
+        if(!app_state.render_threaded){
+            WARN("Render thread could not be started, rendering on the main thread");
+        }
+    }
 
     while(app_state.is_running){
+        if(app_state.is_suspended){
+            // Nothing to update or draw, sleep in the event queue until the window comes back
+            if(!platform_wait_messages(&app_state.platform, SUSPENDED_WAIT_MS)){ app_state.is_running = FALSE;}
+            continue;
+        }
+
+        f64 frame_start = platform_get_absolute_time();
+        hitch_detector_begin_frame(&app_state.hitches, app_state.frame_count, frame_start);
+        frame_pacer_begin_frame(&app_state.pacer);
+        profiler_frame_mark();
+
         if(!platform_pump_messages(&app_state.platform)){ app_state.is_running = FALSE;}
+        async_io_dispatch();
+        resource_manager_update();
+        texture_streaming_update();
+        f64 phase_end = platform_get_absolute_time();
+        hitch_detector_record(&app_state.hitches, FRAME_PHASE_PUMP, phase_end - frame_start);
         
         if(!app_state.is_suspended){
             clock_update(&app_state.clock);
             f64 current_time = app_state.clock.elapsed;
             f64 delta = (current_time - app_state.last_time);
-            f64 frame_start_time = platform_get_absolute_time();
 
-            if(!app_state.game_instance->update(app_state.game_instance, (f32)delta)){
+            f32 alpha = 1.0f;
+            perf_counter_values counters;
+            application_counters_begin(&counters);
+            f64 phase_start = platform_get_absolute_time();
+            PROFILE_BEGIN("update");
+            b8 updated = application_update(delta, &alpha);
+            PROFILE_END();
+            phase_end = platform_get_absolute_time();
+            application_counters_end(FRAME_PHASE_UPDATE, &counters);
+            hitch_detector_record(&app_state.hitches, FRAME_PHASE_UPDATE, phase_end - phase_start);
+            if(!updated){
                 FATAL("Game update failed, shutting down");
                 app_state.is_running = FALSE;
                 break;
             }
 
-            if(!app_state.game_instance->render(app_state.game_instance, (f32)delta)){
+            frame_stats_push(&app_state.frame_times, delta);
+            f64 budget = app_state.pacer.target_frame_seconds > 0 ? app_state.pacer.target_frame_seconds : 1.0 / DEFAULT_TARGET_FRAME_RATE;
+            perf_hud_update(&app_state.frame_times, budget, current_time);
+
+            application_counters_begin(&counters);
+            phase_start = platform_get_absolute_time();
+            PROFILE_BEGIN("render");
+            b8 rendered = app_state.game_instance->render(app_state.game_instance, (f32)delta, alpha);
+            PROFILE_END();
+            phase_end = platform_get_absolute_time();
+            application_counters_end(FRAME_PHASE_RENDER, &counters);
+            app_state.counter_frames++;
+            f64 render_time = phase_end - phase_start;
+            f64 swap_time = renderer_get_last_present_seconds();
+            if(!app_state.render_threaded){
+                // The swap happened inside game render, report it on its own
+                render_time = render_time > swap_time ? render_time - swap_time : 0;
+            }
+            hitch_detector_record(&app_state.hitches, FRAME_PHASE_RENDER, render_time);
+            hitch_detector_record(&app_state.hitches, FRAME_PHASE_SWAP, swap_time);
+            if(!rendered){
                 FATAL("Game render failed, shutting down");
                 app_state.is_running = FALSE;
                 break;
             }
-            
-            f64 frame_end_time = platform_get_absolute_time();
-            f64 frame_elapsed_time = frame_end_time - frame_start_time;
-            runing_time += frame_elapsed_time;
-            f64 remaining_seconds = target_frame_seconds - frame_elapsed_time;
-            
-            if(remaining_seconds > 0)
-            {
-                u64 remaining_ms = (remaining_seconds * 1000);
-
-                // Limit frame rate to avoid over cpu usage
-                b8 limit_frames = TRUE;
-                if(remaining_ms > 0 && limit_frames){
-                    platform_sleep(remaining_ms - 1);
-                }
-
-                frame_count++;
+
+            // Spend the frame's slack on idle tasks, stopping a margin short of the
+            // deadline so the pacer still has time to land on it.
+            phase_start = platform_get_absolute_time();
+            f64 remaining = frame_pacer_remaining(&app_state.pacer);
+            f64 idle_deadline = app_state.pacer.target_frame_seconds > 0
+                ? phase_start + remaining - IDLE_TASKS_SAFETY_MARGIN_SECONDS - app_state.pacer.spin_seconds
+                : phase_start + IDLE_TASKS_UNPACED_BUDGET_SECONDS;
+            idle_tasks_run(idle_deadline);
+            phase_end = platform_get_absolute_time();
+            hitch_detector_record(&app_state.hitches, FRAME_PHASE_IDLE, phase_end - phase_start);
+
+            // Wait out the rest of the frame. The deadline is measured from the start of
+            // the frame, so event pumping and buffer swap time are accounted for.
+            phase_start = platform_get_absolute_time();
+            PROFILE_BEGIN("frame_pacer_wait");
+            frame_pacer_wait(&app_state.pacer);
+            PROFILE_END();
+            phase_end = platform_get_absolute_time();
+            hitch_detector_record(&app_state.hitches, FRAME_PHASE_SLEEP, phase_end - phase_start);
+            hitch_detector_end_frame(&app_state.hitches, phase_end);
+            telemetry_update(app_state.frame_count, delta, &app_state.frame_times, phase_end);
+
+            if(current_time - app_state.last_pacing_report >= FRAME_PACING_REPORT_SECONDS){
+                application_report_frame_pacing();
+                application_report_perf_counters();
+                app_state.last_pacing_report = current_time;
             }
 
             app_state.last_time = current_time;
+
+            app_state.frame_count++;
+            u64 max_frames = app_state.game_instance->app_config.max_frames;
+            if(max_frames > 0 && app_state.frame_count >= max_frames){
+                INFO("Reached the configured limit of %llu frames, shutting down.", max_frames);
+                app_state.is_running = FALSE;
+            }
         }
     }
     app_state.is_running = FALSE;
@@ -142,11 +438,32 @@ b8 application_run(){
     event_unregister(EVENT_CODE_APPLICATION_QUIT, 0, application_on_event);
     event_unregister(EVENT_CODE_KEY_PRESSED, 0, application_on_key);
     event_unregister(EVENT_CODE_KEY_RELEASED, 0, application_on_key);
+    event_unregister(EVENT_CODE_WINDOW_FOCUS, 0, application_on_window);
+    event_unregister(EVENT_CODE_WINDOW_MINIMIZED, 0, application_on_window);
     event_shutdown();
-    
+
+    // Let in-flight frames finish and bring the context back before tearing down
+    renderer_stop_render_thread();
+    if(app_state.game_instance->shutdown){
+        app_state.game_instance->shutdown(app_state.game_instance);
+    }
+    texture_streaming_shutdown();
+    resource_manager_shutdown();
+    idle_tasks_shutdown();
+    async_io_shutdown();
+    job_system_shutdown();
+    perf_hud_shutdown();
+    telemetry_shutdown();
+    if(sampling_profiler_is_running()){
+        sampling_profiler_stop("sample_profile.txt", "sample_profile.folded");
+    }
+    perf_counters_shutdown();
     renderer_shutdown(); 
+    vfs_shutdown();
     
     platform_shutdown(&app_state.platform);
+
+    profiler_shutdown();
     
     return TRUE;
 }
@@ -163,6 +480,63 @@ b8 application_on_event(u16 code, void* sender, void* listener_inst, event_conte
      return FALSE;
  }
  
+static const char* background_mode_name(background_mode mode) {
+    switch (mode) {
+        case BACKGROUND_MODE_THROTTLE: return "throttled";
+        case BACKGROUND_MODE_PAUSE: return "paused";
+        default: return "running";
+    }
+}
+
+// Works out the background mode for the current window state and applies it.
+static void application_update_background() {
+    background_mode mode = BACKGROUND_MODE_RUN;
+    if(app_state.minimized && app_state.minimized_mode > mode){
+        mode = app_state.minimized_mode;
+    }
+    if(!app_state.focused && app_state.unfocused_mode > mode){
+        mode = app_state.unfocused_mode;
+    }
+    if(mode == app_state.background){
+        return;
+    }
+
+    background_mode previous = app_state.background;
+    app_state.background = mode;
+    app_state.is_suspended = mode == BACKGROUND_MODE_PAUSE;
+    frame_pacer_set_target(&app_state.pacer,
+        mode == BACKGROUND_MODE_THROTTLE ? app_state.background_frame_rate : app_state.foreground_frame_rate);
+
+    if(previous == BACKGROUND_MODE_PAUSE){
+        // Carry on from now instead of simulating the time spent paused
+        frame_pacer_resync(&app_state.pacer);
+        clock_update(&app_state.clock);
+        app_state.last_time = app_state.clock.elapsed;
+        app_state.accumulator = 0;
+    }
+
+    INFO("Application %s (window %s, %s)", background_mode_name(mode),
+        app_state.minimized ? "minimized" : "visible", app_state.focused ? "focused" : "unfocused");
+    event_context data = {};
+    if(mode == BACKGROUND_MODE_RUN){
+        event_fire(EVENT_CODE_APPLICATION_RESUMED, 0, data);
+    } else {
+        data.data.u16[0] = mode;
+        event_fire(EVENT_CODE_APPLICATION_SUSPENDED, 0, data);
+    }
+}
+
+ b8 application_on_window(u16 code, void* sender, void* listener_inst, event_context context) {
+     if (code == EVENT_CODE_WINDOW_FOCUS) {
+         app_state.focused = context.data.u16[0];
+     } else if (code == EVENT_CODE_WINDOW_MINIMIZED) {
+         app_state.minimized = context.data.u16[0];
+     }
+     application_update_background();
+     // Games may want these too
+     return FALSE;
+ }
+
  b8 application_on_key(u16 code, void* sender, void* listener_inst, event_context context) {
      if (code == EVENT_CODE_KEY_PRESSED) {
          u16 key_code = context.data.u16[0];
@@ -172,6 +546,9 @@ b8 application_on_event(u16 code, void* sender, void* listener_inst, event_conte
              event_fire(EVENT_CODE_APPLICATION_QUIT, 0, data);
              // Block anything else from processing this.
              return TRUE;
+         } else if (key_code == SDLK_BACKQUOTE) {
+             perf_hud_toggle();
+             return TRUE;
          } else if (key_code == SDLK_a) {
              // Example on checking for a key
              DEBUG("Explicit - A key pressed!");
@@ -1,9 +1,23 @@
 #pragma once
 
 #include "definitions.h"
+#include "core/frame_pacer.h"
+#include "core/hitch_detector.h"
 
 struct game;
 
+// What the main loop does while the window is in the background.
+typedef enum background_mode {
+    // Minimized windows pause, unfocused ones keep running.
+    BACKGROUND_MODE_DEFAULT,
+    // Keep updating and rendering at the normal rate.
+    BACKGROUND_MODE_RUN,
+    // Update and render at background_frame_rate.
+    BACKGROUND_MODE_THROTTLE,
+    // Skip update and render entirely and block on window events until restored.
+    BACKGROUND_MODE_PAUSE
+} background_mode;
+
 // config struct basically the window features
 typedef struct application_config {
     i16 start_pos_x;
@@ -11,8 +25,83 @@ typedef struct application_config {
     i16 start_width;
     i16 start_height;
     char* name;
+
+    // Fixed-timestep simulation. When enabled, game->update is called with a
+    // constant delta of 1/tick_rate seconds as many times as the accumulated
+    // frame time allows, and game->render receives the leftover fraction as alpha.
+    b8 fixed_timestep;
+    // Simulation ticks per second. Defaults to 60 when left at 0.
+    f32 tick_rate;
+    // Upper bound on ticks run in one frame, so a long frame can't snowball
+    // into ever longer frames. Defaults to 5 when left at 0.
+    u32 max_ticks_per_frame;
+
+    // Frames per second the main loop is paced to. 0 uses the default of 60,
+    // FRAME_RATE_UNLIMITED runs as fast as possible.
+    f32 target_frame_rate;
+
+    // Run without a window or GPU, using the null renderer backend.
+    b8 headless;
+    // Stop after this many frames. 0 runs until quit is requested.
+    u64 max_frames;
+
+    // Draw on a dedicated render thread that owns the context, so frame N is
+    // submitted to the GPU while the main thread updates frame N+1.
+    b8 threaded_rendering;
+
+    // Frames longer than this write the recent per-phase frame history and memory
+    // stats to hitch_<time>_frame<N>.csv in the working directory. 0 uses twice
+    // the frame budget, HITCH_DETECTION_DISABLED turns it off.
+    f32 hitch_threshold_ms;
+
+    // Publish live frame, memory and renderer stats in shared memory for
+    // external tools such as tools/telemetry.
+    b8 publish_telemetry;
+
+    // Sample CPU performance counters (cycles, instructions, cache and branch
+    // misses, or software counters where the PMU is not accessible) around
+    // update and render, and log per-frame averages with the pacing report.
+    b8 perf_counters;
+
+    // Sample call stacks this many times per second of CPU time while the app
+    // runs, and write sample_profile.txt and sample_profile.folded at exit.
+    // 0 turns it off, see platform/sampling_profiler.h.
+    u32 sampling_profiler_hz;
+
+    // Bytes of streamed texture data uploaded per frame, see
+    // resources/texture_streaming.h. 0 uses the default of 4 MiB.
+    u64 texture_upload_budget;
+
+    // Start with the performance HUD visible. The ` key toggles it at runtime.
+    b8 show_perf_hud;
+
+    // Behaviour while the window is minimized or has lost focus. When both apply
+    // the more restrictive one wins. EVENT_CODE_APPLICATION_SUSPENDED and
+    // EVENT_CODE_APPLICATION_RESUMED are fired on every change.
+    background_mode minimized_mode;
+    background_mode unfocused_mode;
+    // Frame rate for BACKGROUND_MODE_THROTTLE. Defaults to 10 when left at 0.
+    f32 background_frame_rate;
+
+    // Threads in the job system pool used by loaders. 0 starts one per
+    // processor besides the main thread.
+    u32 job_worker_count;
+
+    // Directory mounted at the root of the VFS (see core/vfs.h), paths such as
+    // "assets/shaders/..." resolve against it. 0 uses the working directory.
+    const char* asset_root;
+    // Pack file mounted at the VFS root on top of asset_root before the renderer
+    // loads its assets, anything not in it is read from loose files. 0 or a
+    // missing file means loose files only.
+    const char* asset_pack;
 } application_config;
 
 API b8 application_create(struct game* game_instance);
 
 API b8 application_run();
+
+// Changes the frame rate target at runtime. Accepts FRAME_RATE_UNLIMITED.
+API void application_set_target_frame_rate(f32 target_frame_rate);
+
+// Achieved frame timings over the current reporting window.
+API void application_get_frame_pacing_stats(frame_pacing_stats* out_stats);
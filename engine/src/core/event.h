@@ -81,5 +81,27 @@ typedef enum system_event_code {
   */
  EVENT_CODE_RESIZED = 0x08,
 
+ // Window gained or lost input focus.
+ /* Context usage:
+  * b8 focused = data.data.u16[0];
+  */
+ EVENT_CODE_WINDOW_FOCUS = 0x09,
+
+ // Window was minimized or hidden, or restored from that.
+ /* Context usage:
+  * b8 minimized = data.data.u16[0];
+  */
+ EVENT_CODE_WINDOW_MINIMIZED = 0x0A,
+
+ // The application went into the background and now runs throttled or paused,
+ // see application_config.unfocused_mode. Fired again if the mode changes.
+ /* Context usage:
+  * background_mode mode = data.data.u16[0];
+  */
+ EVENT_CODE_APPLICATION_SUSPENDED = 0x0B,
+
+ // The application is back in the foreground and runs at its normal rate.
+ EVENT_CODE_APPLICATION_RESUMED = 0x0C,
+
  MAX_EVENT_CODE = 0xFF
 } system_event_code;
@@ -1,37 +1,97 @@
 #include "file_operations.h"
 
 #include "core/logger.h"
+#include "core/vfs.h"
 #include "platform/platform.h"
 
 
 API b8 file_exists(const char* path) {
-    return platform_file_exists(path);
+    return vfs_stat(path, 0);
 }
 
 API b8 create_directory(const char* path) {
+    vfs_invalidate(path);
     return platform_create_directory(path);
 }   
 
 API b8 delete_file(const char* path) {
+    vfs_invalidate(path);
     return platform_delete_file(path);
 }
 
 API u64 get_file_size(const char* path) {
-    return platform_get_file_size(path);
+    vfs_file file;
+    return vfs_stat(path, &file) ? file.size : 0;
 }
 
 API b8 read_file_to_string(const char* path, char** buffer, u64* size) {
-    return platform_read_file_to_string(path, buffer, size);
+    return vfs_read(path, buffer, size);
 }   
 
 API b8 write_string_to_file(const char* path, const char* string) {
+    vfs_invalidate(path);
     return platform_write_string_to_file(path, string);
 }
 
 API b8 read_file_to_buffer(const char* path, char** buffer, u64* size) {
-    return platform_read_file_to_buffer(path, buffer, size);
+    return vfs_read(path, buffer, size);
 }
 
 API b8 write_buffer_to_file(const char* path, const char* buffer, u64 size) {
+    vfs_invalidate(path);
     return platform_write_buffer_to_file(path, buffer, size);
 }
+
+API b8 file_map_readonly(const char* path, u32 hints, file_view* out_view) {
+    out_view->data = 0;
+    out_view->size = 0;
+    out_view->source = FILE_VIEW_NONE;
+
+    vfs_file file;
+    if (!vfs_stat(path, &file)) {
+        return FALSE;
+    }
+    if (file.data) {
+        if (file.type == VFS_MOUNT_PACK) {
+            // Part of the pack's mapping
+            platform_file_map_advise(file.data, file.size, hints);
+        }
+        out_view->data = file.data;
+        out_view->size = file.size;
+        out_view->source = FILE_VIEW_BORROWED;
+        return TRUE;
+    }
+
+    char real_path[VFS_PATH_MAX];
+    platform_file_mapping mapping;
+    if (vfs_real_path(path, real_path, sizeof(real_path)) && platform_file_map(real_path, &mapping)) {
+        platform_file_map_advise(mapping.data, mapping.size, hints);
+        out_view->data = mapping.data ? mapping.data : "";
+        out_view->size = mapping.size;
+        out_view->source = FILE_VIEW_MAPPED;
+        return TRUE;
+    }
+
+    // Compressed pack entries, or a file that exists but can't be mapped
+    char* buffer;
+    u64 size;
+    if (!vfs_read(path, &buffer, &size)) {
+        return FALSE;
+    }
+    out_view->data = buffer;
+    out_view->size = size;
+    out_view->source = FILE_VIEW_COPY;
+    return TRUE;
+}
+
+API void file_unmap(file_view* view) {
+    if (view->source == FILE_VIEW_MAPPED && view->size > 0) {
+        platform_file_mapping mapping = {view->data, view->size};
+        platform_file_unmap(&mapping);
+    } else if (view->source == FILE_VIEW_COPY) {
+        platform_free((void*)view->data, FALSE);
+    }
+    view->data = 0;
+    view->size = 0;
+    view->source = FILE_VIEW_NONE;
+}
@@ -1,13 +1,44 @@
 #pragma once
 
 #include "definitions.h"
-     
+
+// Reads and lookups resolve paths through the VFS mounts (see core/vfs.h).
+// Writes and deletes go to the path on disk and drop it from the VFS cache.
+// Buffers returned by the read functions are heap memory released with free().
+
+// Where the bytes of a file_view come from.
+typedef enum file_view_source {
+    FILE_VIEW_NONE,
+    // A read-only mapping of the file on disk
+    FILE_VIEW_MAPPED,
+    // Memory owned by a VFS mount, such as an uncompressed pack entry
+    FILE_VIEW_BORROWED,
+    // A heap copy, for compressed pack entries or when mapping failed
+    FILE_VIEW_COPY
+} file_view_source;
+
+// Read-only bytes of a whole file, see file_map_readonly.
+typedef struct file_view {
+    const char* data;
+    u64 size;
+    file_view_source source;
+} file_view;
+
 API b8 file_exists(const char* path);
 API b8 create_directory(const char* path);
 API b8 delete_file(const char* path);
 API u64 get_file_size(const char* path);
+// The string is null-terminated, size excludes the terminator.
 API b8 read_file_to_string(const char* path, char** buffer, u64* size);
 API b8 write_string_to_file(const char* path, const char* string);
 API b8 read_file_to_buffer(const char* path, char** buffer, u64* size);
 API b8 write_buffer_to_file(const char* path, const char* buffer, u64 size);
 
+// Gives read-only access to a file without copying it where possible: files
+// on disk are mapped, packed and memory files point at the mount's bytes.
+// hints are platform_map_hint flags, e.g. SEQUENTIAL | WILL_NEED for a file
+// parsed once front to back. Falls back to read_file_to_buffer when the file
+// can't be mapped. data is never 0 on success, empty files give "".
+// The view is valid until file_unmap, and for packed files until unmounted.
+API b8 file_map_readonly(const char* path, u32 hints, file_view* out_view);
+API void file_unmap(file_view* view);
@@ -0,0 +1,109 @@
+#include "frame_pacer.h"
+
+#include "core/kmemory.h"
+#include "platform/platform.h"
+
+#include <math.h>
+
+// Wake-up latency of clock_nanosleep is typically well under a millisecond,
+// so sleep until 1 ms before the deadline and spin the rest of the way.
+#define FRAME_PACER_DEFAULT_SPIN_SECONDS 0.001
+
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+void frame_pacer_initialize(frame_pacer* pacer, f32 target_frame_rate) {
+    kzero_memory(pacer, sizeof(frame_pacer));
+    pacer->spin_seconds = FRAME_PACER_DEFAULT_SPIN_SECONDS;
+    frame_pacer_set_target(pacer, target_frame_rate);
+    frame_pacer_reset_stats(pacer);
+}
+
+void frame_pacer_set_target(frame_pacer* pacer, f32 target_frame_rate) {
+    f64 previous = pacer->target_frame_seconds;
+    pacer->target_frame_seconds = target_frame_rate > 0 ? 1.0 / target_frame_rate : 0;
+    if (pacer->target_frame_seconds <= 0 || previous <= 0) {
+        // Nothing to carry over, begin_frame starts a schedule from now
+        pacer->next_deadline = 0;
+    } else if (pacer->next_deadline != 0) {
+        // Keep the phase: the current slot started one old period before its
+        // deadline, so it now ends one new period after that
+        pacer->next_deadline += pacer->target_frame_seconds - previous;
+    }
+}
+
+void frame_pacer_begin_frame(frame_pacer* pacer) {
+    f64 now = platform_get_absolute_time();
+
+    if (pacer->last_frame_start > 0) {
+        f64 frame_time = now - pacer->last_frame_start;
+        pacer->sample_count++;
+        f64 delta = frame_time - pacer->mean;
+        pacer->mean += delta / (f64)pacer->sample_count;
+        pacer->m2 += delta * (frame_time - pacer->mean);
+        if (frame_time < pacer->min) pacer->min = frame_time;
+        if (frame_time > pacer->max) pacer->max = frame_time;
+    }
+    pacer->last_frame_start = now;
+
+    if (pacer->target_frame_seconds <= 0) {
+        pacer->next_deadline = 0;
+        return;
+    }
+
+    // Deadlines advance by exactly one slot so the schedule doesn't drift. If the
+    // last frame overran by more than the spin window, start a new schedule from now
+    // rather than squeezing the next frame to catch up, which would show as judder.
+    if (pacer->next_deadline == 0 || now - pacer->next_deadline > pacer->spin_seconds) {
+        pacer->next_deadline = now + pacer->target_frame_seconds;
+    } else {
+        pacer->next_deadline += pacer->target_frame_seconds;
+    }
+}
+
+void frame_pacer_resync(frame_pacer* pacer) {
+    pacer->last_frame_start = 0;
+    pacer->next_deadline = 0;
+}
+
+void frame_pacer_wait(frame_pacer* pacer) {
+    if (pacer->target_frame_seconds <= 0 || pacer->next_deadline == 0) {
+        return;
+    }
+
+    f64 coarse_deadline = pacer->next_deadline - pacer->spin_seconds;
+    if (platform_get_absolute_time() < coarse_deadline) {
+        platform_sleep_until(coarse_deadline);
+    }
+
+    while (platform_get_absolute_time() < pacer->next_deadline) {
+        cpu_relax();
+    }
+}
+
+f64 frame_pacer_remaining(const frame_pacer* pacer) {
+    if (pacer->target_frame_seconds <= 0 || pacer->next_deadline == 0) {
+        return 0;
+    }
+    return pacer->next_deadline - platform_get_absolute_time();
+}
+
+void frame_pacer_get_stats(const frame_pacer* pacer, frame_pacing_stats* out_stats) {
+    out_stats->frame_count = pacer->sample_count;
+    out_stats->mean = pacer->mean;
+    out_stats->variance = pacer->sample_count > 1 ? pacer->m2 / (f64)(pacer->sample_count - 1) : 0;
+    out_stats->std_deviation = sqrt(out_stats->variance);
+    out_stats->min = pacer->sample_count > 0 ? pacer->min : 0;
+    out_stats->max = pacer->max;
+}
+
+void frame_pacer_reset_stats(frame_pacer* pacer) {
+    pacer->sample_count = 0;
+    pacer->mean = 0;
+    pacer->m2 = 0;
+    pacer->min = 1e30;
+    pacer->max = 0;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "definitions.h"
+
+// Pass as the target rate to disable pacing entirely.
+#define FRAME_RATE_UNLIMITED -1.0f
+
+// Achieved frame-to-frame timings since the last reset, in seconds.
+typedef struct frame_pacing_stats {
+    u64 frame_count;
+    f64 mean;
+    f64 variance;
+    f64 std_deviation;
+    f64 min;
+    f64 max;
+} frame_pacing_stats;
+
+typedef struct frame_pacer {
+    // Seconds per frame, 0 when unlimited.
+    f64 target_frame_seconds;
+    // How long before the deadline to stop sleeping and start spinning.
+    f64 spin_seconds;
+    // Absolute time the current frame should end at.
+    f64 next_deadline;
+    // Start of the previous frame, used to measure achieved frame time.
+    f64 last_frame_start;
+
+    // Running mean/variance (Welford) of achieved frame times.
+    u64 sample_count;
+    f64 mean;
+    f64 m2;
+    f64 min;
+    f64 max;
+} frame_pacer;
+
+// Sets up the pacer for the given rate in frames per second.
+// Pass FRAME_RATE_UNLIMITED to run without waiting.
+void frame_pacer_initialize(frame_pacer* pacer, f32 target_frame_rate);
+
+// Changes the target rate. The current frame's deadline moves to one new period
+// after the start of its slot, so the schedule keeps its phase.
+void frame_pacer_set_target(frame_pacer* pacer, f32 target_frame_rate);
+
+// Marks the start of a frame. Records the achieved time of the previous frame.
+void frame_pacer_begin_frame(frame_pacer* pacer);
+
+// Forgets the previous frame and the schedule, so time spent paused is not
+// counted as one long frame.
+void frame_pacer_resync(frame_pacer* pacer);
+
+// Waits for the end of the current frame's time slot. Sleeps with
+// clock_nanosleep for the bulk of it and spins for the last spin_seconds.
+void frame_pacer_wait(frame_pacer* pacer);
+
+// Seconds left until the current frame's deadline. Negative if late, 0 when unlimited.
+f64 frame_pacer_remaining(const frame_pacer* pacer);
+
+// Copies out the achieved frame timings.
+void frame_pacer_get_stats(const frame_pacer* pacer, frame_pacing_stats* out_stats);
+
+// Clears the achieved frame timings.
+void frame_pacer_reset_stats(frame_pacer* pacer);
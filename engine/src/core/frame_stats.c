@@ -0,0 +1,66 @@
+#include "frame_stats.h"
+
+#include "core/kmemory.h"
+
+// Weight of the newest sample in the moving average. 0.1 settles in roughly 20 frames.
+#define FRAME_STATS_SMOOTHING 0.1
+
+void frame_stats_initialize(frame_stats* stats) {
+    kzero_memory(stats, sizeof(frame_stats));
+}
+
+void frame_stats_push(frame_stats* stats, f64 frame_seconds) {
+    stats->samples[stats->head] = frame_seconds;
+    stats->head = (stats->head + 1) % FRAME_STATS_HISTORY;
+    if (stats->count < FRAME_STATS_HISTORY) {
+        stats->count++;
+    }
+
+    if (stats->count == 1) {
+        stats->smoothed = frame_seconds;
+    } else {
+        stats->smoothed += (frame_seconds - stats->smoothed) * FRAME_STATS_SMOOTHING;
+    }
+}
+
+f64 frame_stats_get(const frame_stats* stats, u32 frames_ago) {
+    if (frames_ago >= stats->count) {
+        return 0;
+    }
+    u32 index = (stats->head + FRAME_STATS_HISTORY - 1 - frames_ago) % FRAME_STATS_HISTORY;
+    return stats->samples[index];
+}
+
+// Nearest-rank percentile of a sorted array.
+static f64 percentile(const f64* sorted, u32 count, f64 fraction) {
+    u32 rank = (u32)(fraction * (f64)count + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+void frame_stats_summarize(const frame_stats* stats, frame_stats_summary* out_summary) {
+    kzero_memory(out_summary, sizeof(frame_stats_summary));
+    if (stats->count == 0) {
+        return;
+    }
+
+    // Insertion sort, the history is small and mostly similar values
+    f64 sorted[FRAME_STATS_HISTORY];
+    for (u32 i = 0; i < stats->count; ++i) {
+        f64 value = frame_stats_get(stats, i);
+        u32 j = i;
+        while (j > 0 && sorted[j - 1] > value) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+
+    out_summary->smoothed = stats->smoothed;
+    out_summary->p50 = percentile(sorted, stats->count, 0.50);
+    out_summary->p95 = percentile(sorted, stats->count, 0.95);
+    out_summary->p99 = percentile(sorted, stats->count, 0.99);
+    out_summary->min = sorted[0];
+    out_summary->max = sorted[stats->count - 1];
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "definitions.h"
+
+// Frame times kept for percentiles and the HUD graph, about 4 seconds at 60 fps.
+#define FRAME_STATS_HISTORY 240
+
+// Frame time summary, in seconds.
+typedef struct frame_stats_summary {
+    // Exponential moving average, steadier than the last frame's 1/dt.
+    f64 smoothed;
+    f64 p50;
+    f64 p95;
+    f64 p99;
+    f64 min;
+    f64 max;
+} frame_stats_summary;
+
+typedef struct frame_stats {
+    f64 samples[FRAME_STATS_HISTORY];
+    // Index the next sample is written to.
+    u32 head;
+    u32 count;
+    f64 smoothed;
+} frame_stats;
+
+void frame_stats_initialize(frame_stats* stats);
+
+// Records one frame time in seconds.
+void frame_stats_push(frame_stats* stats, f64 frame_seconds);
+
+// Sample i frames ago, 0 being the most recent. Returns 0 past the recorded history.
+f64 frame_stats_get(const frame_stats* stats, u32 frames_ago);
+
+// Sorts a copy of the history, so keep it to a few calls per frame.
+void frame_stats_summarize(const frame_stats* stats, frame_stats_summary* out_summary);
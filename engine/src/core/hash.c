@@ -0,0 +1,58 @@
+#include "hash.h"
+
+#include <string.h>
+
+#define HASH_PRIME_1 0x9E3779B97F4A7C15ull
+#define HASH_PRIME_2 0xC2B2AE3D27D4EB4Full
+#define HASH_PRIME_3 0x165667B19E3779F9ull
+
+static inline u64 hash_mix(u64 value) {
+    value ^= value >> 33;
+    value *= HASH_PRIME_2;
+    value ^= value >> 29;
+    value *= HASH_PRIME_3;
+    value ^= value >> 32;
+    return value;
+}
+
+static inline u64 hash_read_u64(const u8* bytes) {
+    u64 value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+u64 hash_bytes(const void* data, u64 size, u64 seed) {
+    const u8* bytes = data;
+    // Four independent lanes so the multiplies of consecutive words overlap
+    u64 lanes[4] = {seed + HASH_PRIME_1, seed ^ HASH_PRIME_2, seed - HASH_PRIME_3, ~seed};
+    u64 remaining = size;
+
+    while (remaining >= 32) {
+        for (u32 i = 0; i < 4; ++i) {
+            lanes[i] = (lanes[i] ^ hash_read_u64(bytes + i * 8)) * HASH_PRIME_1;
+            lanes[i] ^= lanes[i] >> 31;
+        }
+        bytes += 32;
+        remaining -= 32;
+    }
+
+    u64 hash = size * HASH_PRIME_3;
+    for (u32 i = 0; i < 4; ++i) {
+        hash = (hash ^ hash_mix(lanes[i])) * HASH_PRIME_1;
+    }
+    while (remaining >= 8) {
+        hash = (hash ^ hash_mix(hash_read_u64(bytes))) * HASH_PRIME_2;
+        bytes += 8;
+        remaining -= 8;
+    }
+    if (remaining > 0) {
+        u64 tail = 0;
+        memcpy(&tail, bytes, remaining);
+        hash = (hash ^ hash_mix(tail)) * HASH_PRIME_2;
+    }
+    return hash_mix(hash);
+}
+
+u64 hash_string(const char* string, u64 seed) {
+    return hash_bytes(string, strlen(string), seed);
+}
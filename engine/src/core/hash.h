@@ -0,0 +1,11 @@
+#pragma once
+
+#include "definitions.h"
+
+// Fast non-cryptographic 64-bit hashing for cache keys and lookup tables. Not
+// stable across endianness, don't persist hashes between different machines.
+
+API u64 hash_bytes(const void* data, u64 size, u64 seed);
+
+// Hash of a null-terminated string, without its terminator.
+API u64 hash_string(const char* string, u64 seed);
@@ -0,0 +1,114 @@
+#include "hitch_detector.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+#include <stdio.h>
+#include <time.h>
+
+static const char* phase_names[FRAME_PHASE_MAX] = {"pump", "update", "render", "swap", "idle", "sleep"};
+
+const char* hitch_detector_phase_name(frame_phase phase) {
+    return phase < FRAME_PHASE_MAX ? phase_names[phase] : "unknown";
+}
+
+void hitch_detector_initialize(hitch_detector* detector, f64 threshold_seconds) {
+    kzero_memory(detector, sizeof(hitch_detector));
+    detector->threshold_seconds = threshold_seconds > 0 ? threshold_seconds : 0;
+    detector->last_report = -HITCH_REPORT_COOLDOWN_SECONDS;
+}
+
+void hitch_detector_begin_frame(hitch_detector* detector, u64 frame_number, f64 now) {
+    frame_record* record = &detector->frames[detector->head];
+    kzero_memory(record, sizeof(frame_record));
+    record->frame_number = frame_number;
+    record->start = now;
+}
+
+void hitch_detector_record(hitch_detector* detector, frame_phase phase, f64 seconds) {
+    if (phase < FRAME_PHASE_MAX) {
+        detector->frames[detector->head].phases[phase] += seconds;
+    }
+}
+
+b8 hitch_detector_end_frame(hitch_detector* detector, f64 now) {
+    frame_record* record = &detector->frames[detector->head];
+    record->total = now - record->start;
+    detector->head = (detector->head + 1) % HITCH_HISTORY_FRAMES;
+    if (detector->count < HITCH_HISTORY_FRAMES) {
+        detector->count++;
+    }
+
+    if (detector->threshold_seconds <= 0 || record->total <= detector->threshold_seconds) {
+        return FALSE;
+    }
+
+    detector->hitch_count++;
+    if (now - detector->last_report < HITCH_REPORT_COOLDOWN_SECONDS) {
+        DEBUG("Hitch: frame %llu took %.2f ms", record->frame_number, record->total * 1000.0);
+        return TRUE;
+    }
+    detector->last_report = now;
+
+    WARN("Hitch: frame %llu took %.2f ms (pump %.2f, update %.2f, render %.2f, swap %.2f, idle %.2f, sleep %.2f)",
+         record->frame_number, record->total * 1000.0,
+         record->phases[FRAME_PHASE_PUMP] * 1000.0, record->phases[FRAME_PHASE_UPDATE] * 1000.0,
+         record->phases[FRAME_PHASE_RENDER] * 1000.0, record->phases[FRAME_PHASE_SWAP] * 1000.0,
+         record->phases[FRAME_PHASE_IDLE] * 1000.0, record->phases[FRAME_PHASE_SLEEP] * 1000.0);
+
+    // Wall-clock name, so reports collected from several machines sort by time
+    char stamp[32];
+    time_t wall = time(0);
+    struct tm local;
+    localtime_r(&wall, &local);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local);
+    char path[96];
+    snprintf(path, sizeof(path), "hitch_%s_frame%llu.csv", stamp, record->frame_number);
+
+    if (hitch_detector_write_report(detector, path)) {
+        detector->reports_written++;
+        WARN("Hitch report written to '%s'", path);
+    }
+    return TRUE;
+}
+
+b8 hitch_detector_write_report(const hitch_detector* detector, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        ERROR("Failed to open '%s' for the hitch report", path);
+        return FALSE;
+    }
+
+    memory_usage usage;
+    get_memory_usage(&usage);
+    fprintf(file, "# threshold_ms,%.3f\n", detector->threshold_seconds * 1000.0);
+    fprintf(file, "# hitches,%llu\n", detector->hitch_count);
+    fprintf(file, "# memory_total_bytes,%llu\n", usage.total_allocated);
+    fprintf(file, "# memory_allocations,%llu\n", usage.allocation_count);
+    fprintf(file, "# memory_allocated_bytes,%llu\n", usage.allocated_bytes);
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
+        if (usage.tagged_allocations[i] > 0) {
+            fprintf(file, "# memory_tag,%s,%llu\n", get_memory_tag_name((memory_tag)i), usage.tagged_allocations[i]);
+        }
+    }
+
+    fprintf(file, "frame,start_s,total_ms");
+    for (u32 p = 0; p < FRAME_PHASE_MAX; ++p) {
+        fprintf(file, ",%s_ms", phase_names[p]);
+    }
+    fprintf(file, "\n");
+
+    // Oldest first
+    u32 first = (detector->head + HITCH_HISTORY_FRAMES - detector->count) % HITCH_HISTORY_FRAMES;
+    for (u32 i = 0; i < detector->count; ++i) {
+        const frame_record* record = &detector->frames[(first + i) % HITCH_HISTORY_FRAMES];
+        fprintf(file, "%llu,%.6f,%.3f", record->frame_number, record->start, record->total * 1000.0);
+        for (u32 p = 0; p < FRAME_PHASE_MAX; ++p) {
+            fprintf(file, ",%.3f", record->phases[p] * 1000.0);
+        }
+        fprintf(file, "\n");
+    }
+
+    fclose(file);
+    return TRUE;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "definitions.h"
+
+// Frames kept for a hitch report, about 5 seconds at 60 fps.
+#define HITCH_HISTORY_FRAMES 300
+// At most one report per this many seconds, a bad stretch would otherwise write
+// a file every frame.
+#define HITCH_REPORT_COOLDOWN_SECONDS 10.0
+// Pass as the threshold to turn hitch detection off.
+#define HITCH_DETECTION_DISABLED -1.0f
+
+typedef enum frame_phase {
+    FRAME_PHASE_PUMP,
+    FRAME_PHASE_UPDATE,
+    // Game render, i.e. building and submitting the packet. Excludes the swap
+    // when rendering on the main thread.
+    FRAME_PHASE_RENDER,
+    // Buffer swap of the most recent presented frame. Runs on the render thread
+    // when one is active, so it overlaps the other phases there.
+    FRAME_PHASE_SWAP,
+    // Idle tasks run in the frame's slack, before the pacer sleeps.
+    FRAME_PHASE_IDLE,
+    FRAME_PHASE_SLEEP,
+    FRAME_PHASE_MAX
+} frame_phase;
+
+// Timings of one frame, in seconds.
+typedef struct frame_record {
+    u64 frame_number;
+    // platform_get_absolute_time() at the start of the frame.
+    f64 start;
+    f64 total;
+    f64 phases[FRAME_PHASE_MAX];
+} frame_record;
+
+typedef struct hitch_detector {
+    frame_record frames[HITCH_HISTORY_FRAMES];
+    // Index of the frame being recorded.
+    u32 head;
+    u32 count;
+    // Frames longer than this trigger a report, 0 when disabled.
+    f64 threshold_seconds;
+    f64 last_report;
+    u64 hitch_count;
+    u64 reports_written;
+} hitch_detector;
+
+// threshold_seconds <= 0 disables detection, phases are still recorded.
+void hitch_detector_initialize(hitch_detector* detector, f64 threshold_seconds);
+
+void hitch_detector_begin_frame(hitch_detector* detector, u64 frame_number, f64 now);
+
+// Adds time to a phase of the current frame.
+void hitch_detector_record(hitch_detector* detector, frame_phase phase, f64 seconds);
+
+// Closes the current frame. Writes a report when it went over the threshold.
+// Returns TRUE if the frame was a hitch.
+b8 hitch_detector_end_frame(hitch_detector* detector, f64 now);
+
+// Writes the history and memory stats to path as CSV. Used by end_frame, but
+// also handy to call on demand.
+b8 hitch_detector_write_report(const hitch_detector* detector, const char* path);
+
+const char* hitch_detector_phase_name(frame_phase phase);
@@ -0,0 +1,147 @@
+#include "idle_tasks.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "platform/platform.h"
+
+typedef struct idle_task {
+    idle_task_id id;
+    const char* name;
+    pfn_idle_task task;
+    pfn_idle_task_drop drop;
+    void* user_data;
+    f32 progress;
+    // Time spent across all slices, reported when the task finishes
+    f64 run_seconds;
+    u32 slices;
+} idle_task;
+
+typedef struct idle_tasks_state {
+    // FIFO ring, head is the oldest task
+    idle_task tasks[IDLE_TASKS_MAX];
+    u32 head;
+    u32 count;
+    idle_task_id next_id;
+} idle_tasks_state;
+
+static idle_tasks_state state;
+static b8 initialized = FALSE;
+
+static idle_task* idle_tasks_at(u32 position) {
+    return &state.tasks[(state.head + position) % IDLE_TASKS_MAX];
+}
+
+void idle_tasks_initialize() {
+    kzero_memory(&state, sizeof(idle_tasks_state));
+    state.next_id = 1;
+    initialized = TRUE;
+}
+
+void idle_tasks_shutdown() {
+    if (!initialized) return;
+    if (state.count > 0) {
+        WARN("Idle tasks: dropping %u unfinished tasks at shutdown", state.count);
+    }
+    for (u32 i = 0; i < state.count; ++i) {
+        idle_task* task = idle_tasks_at(i);
+        if (task->drop) {
+            task->drop(task->user_data);
+        }
+    }
+    state.count = 0;
+    initialized = FALSE;
+}
+
+idle_task_id idle_tasks_submit(const char* name, pfn_idle_task task, pfn_idle_task_drop drop, void* user_data) {
+    if (!initialized || !task) {
+        return INVALID_IDLE_TASK_ID;
+    }
+    if (state.count >= IDLE_TASKS_MAX) {
+        WARN("Idle tasks: queue full, '%s' rejected", name ? name : "task");
+        return INVALID_IDLE_TASK_ID;
+    }
+
+    idle_task* slot = idle_tasks_at(state.count);
+    kzero_memory(slot, sizeof(idle_task));
+    slot->id = state.next_id++;
+    if (state.next_id == INVALID_IDLE_TASK_ID) {
+        state.next_id = 1;
+    }
+    slot->name = name ? name : "task";
+    slot->task = task;
+    slot->drop = drop;
+    slot->user_data = user_data;
+    state.count++;
+    return slot->id;
+}
+
+static i32 idle_tasks_find(idle_task_id id) {
+    for (u32 i = 0; i < state.count; ++i) {
+        if (idle_tasks_at(i)->id == id) {
+            return (i32)i;
+        }
+    }
+    return -1;
+}
+
+static void idle_tasks_remove(u32 position) {
+    // Keep the queue order, later tasks move up by one
+    for (u32 i = position; i + 1 < state.count; ++i) {
+        *idle_tasks_at(i) = *idle_tasks_at(i + 1);
+    }
+    state.count--;
+}
+
+b8 idle_tasks_cancel(idle_task_id id) {
+    i32 position = idle_tasks_find(id);
+    if (position < 0) {
+        return FALSE;
+    }
+    idle_task* task = idle_tasks_at((u32)position);
+    if (task->drop) {
+        task->drop(task->user_data);
+    }
+    idle_tasks_remove((u32)position);
+    return TRUE;
+}
+
+b8 idle_tasks_get_progress(idle_task_id id, f32* out_progress) {
+    i32 position = idle_tasks_find(id);
+    if (position < 0) {
+        return FALSE;
+    }
+    *out_progress = idle_tasks_at((u32)position)->progress;
+    return TRUE;
+}
+
+u32 idle_tasks_pending() {
+    return state.count;
+}
+
+f64 idle_tasks_run(f64 deadline) {
+    if (!initialized || state.count == 0) {
+        return 0;
+    }
+    PROFILE_FUNCTION();
+
+    f64 start = platform_get_absolute_time();
+    f64 now = start;
+    while (state.count > 0 && now < deadline) {
+        idle_task* task = idle_tasks_at(0);
+        f64 slice_end = now + IDLE_TASKS_SLICE_SECONDS;
+        b8 finished = task->task(task->user_data, slice_end < deadline ? slice_end : deadline, &task->progress);
+        f64 after = platform_get_absolute_time();
+        task->run_seconds += after - now;
+        task->slices++;
+        now = after;
+
+        if (finished) {
+            DEBUG("Idle task '%s' finished in %u slices, %.2f ms of idle time",
+                  task->name, task->slices, task->run_seconds * 1000.0);
+            state.head = (state.head + 1) % IDLE_TASKS_MAX;
+            state.count--;
+        }
+    }
+    return now - start;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "definitions.h"
+
+// Low-priority work that runs in the slack left at the end of a frame, instead
+// of the frame pacer sleeping through it. Tasks run on the main thread, oldest
+// first, in short slices.
+
+// Tasks queued at once.
+#define IDLE_TASKS_MAX 64
+// Longest a task may run before it should return and let the loop re-check the
+// deadline. Tasks are handed min(slice end, idle deadline).
+#define IDLE_TASKS_SLICE_SECONDS 0.002
+// Left unused before the frame deadline, so a slightly long slice can't make
+// the frame late.
+#define IDLE_TASKS_SAFETY_MARGIN_SECONDS 0.002
+// Without a frame rate target there is no slack, so tasks get this much per frame.
+#define IDLE_TASKS_UNPACED_BUDGET_SECONDS 0.001
+
+typedef u32 idle_task_id;
+#define INVALID_IDLE_TASK_ID 0
+
+// Does a piece of work and returns TRUE once the task is finished. Should return
+// before deadline (a platform_get_absolute_time() value) and is called again in
+// a later slice otherwise. Write progress in 0..1 to out_progress if known.
+typedef b8 (*pfn_idle_task)(void* user_data, f64 deadline, f32* out_progress);
+// Called instead when a task is cancelled or dropped at shutdown before it
+// finished, so it can free user_data.
+typedef void (*pfn_idle_task_drop)(void* user_data);
+
+void idle_tasks_initialize();
+// Drops unfinished tasks without running them, calling their drop functions.
+void idle_tasks_shutdown();
+
+// drop may be NULL.
+API idle_task_id idle_tasks_submit(const char* name, pfn_idle_task task, pfn_idle_task_drop drop, void* user_data);
+// Removes a task that has not finished. Returns FALSE if it is no longer queued.
+API b8 idle_tasks_cancel(idle_task_id id);
+// Progress last reported by the task. Returns FALSE once it has finished or was cancelled.
+API b8 idle_tasks_get_progress(idle_task_id id, f32* out_progress);
+API u32 idle_tasks_pending();
+
+// Runs queued tasks until deadline. Called by the application loop, returns the
+// time spent.
+f64 idle_tasks_run(f64 deadline);
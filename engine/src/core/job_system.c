@@ -0,0 +1,226 @@
+#include "job_system.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "platform/platform.h"
+#include "platform/sampling_profiler.h"
+
+#include <stdio.h>
+
+typedef struct job_system_state {
+    platform_thread workers[JOB_SYSTEM_MAX_WORKERS];
+    u32 worker_count;
+
+    // One token per worker that should join the current batch or run a
+    // background job, or leave at shutdown. Tokens of batches that finished
+    // without the worker are left over and wake it for nothing.
+    platform_semaphore wake;
+    // Signalled by the last worker out of a batch the submitter was waiting on.
+    platform_semaphore done;
+    // Serializes parallel_for callers.
+    platform_mutex submit;
+
+    // Current batch. Written before the wake tokens are posted, so workers
+    // holding a token always see the batch they were woken for.
+    pfn_job job;
+    void* context;
+    u32 count;
+    // Shared counters, always accessed through __atomic builtins.
+    u32 next_index;
+    // Threads still working on the batch, the submitter included.
+    u32 participants;
+    // Helper places in the current batch not yet taken by a worker.
+    u32 open_places;
+    u32 quit;
+
+    // Background jobs, a ring under background_lock.
+    platform_mutex background_lock;
+    pfn_background_job background_jobs[JOB_SYSTEM_MAX_BACKGROUND_JOBS];
+    void* background_contexts[JOB_SYSTEM_MAX_BACKGROUND_JOBS];
+    u32 background_head;
+    u32 background_count;
+} job_system_state;
+
+static job_system_state state;
+static b8 initialized = FALSE;
+
+static void job_system_run_batch() {
+    while (TRUE) {
+        u32 index = __atomic_fetch_add(&state.next_index, 1, __ATOMIC_RELAXED);
+        if (index >= state.count) {
+            break;
+        }
+        state.job(state.context, index);
+    }
+}
+
+// Takes one of the current batch's helper places, FALSE if none is open.
+static b8 job_system_join_batch() {
+    u32 open = __atomic_load_n(&state.open_places, __ATOMIC_ACQUIRE);
+    while (open > 0) {
+        if (__atomic_compare_exchange_n(&state.open_places, &open, open - 1, FALSE, __ATOMIC_ACQ_REL,
+                                        __ATOMIC_ACQUIRE)) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static b8 job_system_pop_background(pfn_background_job* out_job, void** out_context) {
+    platform_mutex_lock(&state.background_lock);
+    b8 found = state.background_count > 0;
+    if (found) {
+        *out_job = state.background_jobs[state.background_head];
+        *out_context = state.background_contexts[state.background_head];
+        state.background_head = (state.background_head + 1) % JOB_SYSTEM_MAX_BACKGROUND_JOBS;
+        state.background_count--;
+    }
+    platform_mutex_unlock(&state.background_lock);
+    return found;
+}
+
+static u32 job_worker_main(void* params) {
+    u32 worker_index = (u32)(u64)params;
+    char name[32];
+    snprintf(name, sizeof(name), "job %u", worker_index);
+    profiler_set_thread_name(name);
+    sampling_profiler_register_thread(name);
+
+    while (TRUE) {
+        platform_semaphore_wait(&state.wake);
+        if (__atomic_load_n(&state.quit, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+        // Batches come first, they have a thread waiting on them
+        if (job_system_join_batch()) {
+            job_system_run_batch();
+            if (__atomic_sub_fetch(&state.participants, 1, __ATOMIC_ACQ_REL) == 0) {
+                platform_semaphore_signal(&state.done);
+            }
+            continue;
+        }
+        pfn_background_job job;
+        void* context;
+        if (job_system_pop_background(&job, &context)) {
+            job(context);
+        }
+    }
+
+    sampling_profiler_unregister_thread();
+    return 0;
+}
+
+b8 job_system_initialize(u32 worker_count) {
+    if (initialized) {
+        return TRUE;
+    }
+    kzero_memory(&state, sizeof(job_system_state));
+
+    if (worker_count == 0) {
+        u32 processors = platform_processor_count();
+        worker_count = processors > 1 ? processors - 1 : 0;
+    }
+    if (worker_count > JOB_SYSTEM_MAX_WORKERS) {
+        worker_count = JOB_SYSTEM_MAX_WORKERS;
+    }
+
+    platform_semaphore_create(0, &state.wake);
+    platform_semaphore_create(0, &state.done);
+    platform_mutex_create(&state.submit);
+    platform_mutex_create(&state.background_lock);
+    initialized = TRUE;
+
+    for (u32 i = 0; i < worker_count; ++i) {
+        if (!platform_thread_create(job_worker_main, (void*)(u64)i, &state.workers[i])) {
+            WARN("Job system: could only start %u of %u workers", i, worker_count);
+            break;
+        }
+        state.worker_count++;
+    }
+
+    INFO("Job system started with %u workers", state.worker_count);
+    return state.worker_count > 0;
+}
+
+void job_system_shutdown() {
+    if (!initialized) return;
+
+    __atomic_store_n(&state.quit, 1, __ATOMIC_RELEASE);
+    for (u32 i = 0; i < state.worker_count; ++i) {
+        platform_semaphore_signal(&state.wake);
+    }
+    for (u32 i = 0; i < state.worker_count; ++i) {
+        platform_thread_join(&state.workers[i]);
+    }
+    pfn_background_job job;
+    void* context;
+    while (job_system_pop_background(&job, &context)) {
+        job(context);
+    }
+
+    platform_semaphore_destroy(&state.wake);
+    platform_semaphore_destroy(&state.done);
+    platform_mutex_destroy(&state.submit);
+    platform_mutex_destroy(&state.background_lock);
+    initialized = FALSE;
+}
+
+u32 job_system_worker_count() {
+    return initialized ? state.worker_count : 0;
+}
+
+void job_system_parallel_for(u32 count, pfn_job job, void* context) {
+    if (count == 0) {
+        return;
+    }
+    if (!initialized || state.worker_count == 0 || count == 1) {
+        for (u32 i = 0; i < count; ++i) {
+            job(context, i);
+        }
+        return;
+    }
+    PROFILE_FUNCTION();
+
+    platform_mutex_lock(&state.submit);
+    // No point waking more workers than there are indices for
+    u32 helpers = count - 1 < state.worker_count ? count - 1 : state.worker_count;
+    state.job = job;
+    state.context = context;
+    state.count = count;
+    __atomic_store_n(&state.next_index, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&state.participants, helpers + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&state.open_places, helpers, __ATOMIC_RELEASE);
+    for (u32 i = 0; i < helpers; ++i) {
+        platform_semaphore_signal(&state.wake);
+    }
+
+    job_system_run_batch();
+    // Workers busy with background jobs never get to this batch. Close their
+    // places instead of waiting for them.
+    u32 unjoined = __atomic_exchange_n(&state.open_places, 0, __ATOMIC_ACQ_REL);
+    if (__atomic_sub_fetch(&state.participants, unjoined + 1, __ATOMIC_ACQ_REL) != 0) {
+        platform_semaphore_wait(&state.done);
+    }
+    platform_mutex_unlock(&state.submit);
+}
+
+b8 job_system_submit(pfn_background_job job, void* context) {
+    if (!initialized || state.worker_count == 0) {
+        job(context);
+        return TRUE;
+    }
+    platform_mutex_lock(&state.background_lock);
+    b8 queued = state.background_count < JOB_SYSTEM_MAX_BACKGROUND_JOBS;
+    if (queued) {
+        u32 tail = (state.background_head + state.background_count) % JOB_SYSTEM_MAX_BACKGROUND_JOBS;
+        state.background_jobs[tail] = job;
+        state.background_contexts[tail] = context;
+        state.background_count++;
+    }
+    platform_mutex_unlock(&state.background_lock);
+    if (queued) {
+        platform_semaphore_signal(&state.wake);
+    }
+    return queued;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "definitions.h"
+
+// Fork-join worker pool for data-parallel loops. Workers sleep on a semaphore
+// between batches, and the submitting thread works on its own batch too.
+// Idle workers also run background jobs, which nobody waits for.
+
+// Upper bound on workers regardless of processor count.
+#define JOB_SYSTEM_MAX_WORKERS 32
+// Background jobs queued and not yet started at once.
+#define JOB_SYSTEM_MAX_BACKGROUND_JOBS 256
+
+// Processes one index of a parallel_for batch.
+typedef void (*pfn_job)(void* context, u32 index);
+// A background job, e.g. decoding an asset.
+typedef void (*pfn_background_job)(void* context);
+
+// Starts worker_count workers, or one per processor besides the calling thread
+// when 0. Returns FALSE if no worker could be started, parallel_for then runs
+// batches on the calling thread.
+API b8 job_system_initialize(u32 worker_count);
+API void job_system_shutdown();
+
+API u32 job_system_worker_count();
+
+// Calls job(context, i) for every i in [0, count) across the workers and the
+// calling thread, and returns once all calls have finished. Jobs must not use
+// kallocate (its stats are not thread-safe) or submit batches of their own.
+// Batches from different threads run one after the other.
+API void job_system_parallel_for(u32 count, pfn_job job, void* context);
+
+// Queues job(context) for the next idle worker and returns right away. The
+// job reports back itself, e.g. through an atomic flag polled each frame. The
+// same rules as for parallel_for jobs apply. Returns FALSE when the queue is
+// full. Without workers the job runs on the calling thread before returning.
+// Jobs still queued at shutdown run on the thread calling job_system_shutdown.
+API b8 job_system_submit(pfn_background_job job, void* context);
@@ -7,10 +7,6 @@
  #include <core/kstring.h>
  #include <stdio.h>
  
- struct memory_stats {
-     u64 total_allocated;
-     u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
- };
  
  static const char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] = {
      "UNKNOWN    ",
@@ -33,7 +29,7 @@
      "MODEL      "
  };
  
- static struct memory_stats stats;
+ static memory_usage stats;
  
  void initialize_memory() {
      platform_zero_memory(&stats, sizeof(stats));
@@ -51,6 +47,8 @@
  
      stats.total_allocated += size;
      stats.tagged_allocations[tag] += size;
+     stats.allocation_count++;
+     stats.allocated_bytes += size;
  
      // TODO: Memory alignment
      void* block = platform_allocate(size, FALSE);
@@ -82,6 +80,14 @@
      return platform_set_memory(dest, value, size);
  }
  
+ void get_memory_usage(memory_usage* out_usage) {
+     *out_usage = stats;
+ }
+
+ const char* get_memory_tag_name(memory_tag tag) {
+     return tag < MEMORY_TAG_MAX_TAGS ? memory_tag_strings[tag] : "INVALID    ";
+ }
+
  char* get_memory_usage_str() {
      const u64 gib = 1024 * 1024 * 1024;
      const u64 mib = 1024 * 1024;
@@ -26,6 +26,16 @@ typedef enum memory_tag {
      MEMORY_TAG_MAX_TAGS
  } memory_tag;
  
+ // Snapshot of the allocator's bookkeeping.
+ typedef struct memory_usage {
+     u64 total_allocated;
+     u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
+     // Lifetime totals, never decremented. Differences between two snapshots
+     // give the allocation rate.
+     u64 allocation_count;
+     u64 allocated_bytes;
+ } memory_usage;
+
  API void initialize_memory();
  API void shutdown_memory();
  
@@ -40,3 +50,8 @@ typedef enum memory_tag {
  API void* kset_memory(void* dest, i32 value, u64 size);
  
  API char* get_memory_usage_str();
+
+ API void get_memory_usage(memory_usage* out_usage);
+
+ // Fixed-width display name of a tag, e.g. "RENDERER   ".
+ API const char* get_memory_tag_name(memory_tag tag);
@@ -0,0 +1,174 @@
+#include "lz4.h"
+#include "platform/platform.h"
+
+#include <string.h>
+
+#define LZ4_MIN_MATCH 4
+// The format requires the last 5 bytes to be literals and the last match to
+// start at least 12 bytes before the end.
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MATCH_FIND_LIMIT 12
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_HASH_BITS 16
+
+static inline u32 lz4_read_u32(const u8* p) {
+    u32 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline u32 lz4_hash(u32 sequence) {
+    return (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+// Writes the 255-run length extension of a 4-bit field.
+static inline u8* lz4_write_length(u8* op, u64 length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (u8)length;
+    return op;
+}
+
+u64 lz4_compress_bound(u64 size) {
+    return size + size / 255 + 16;
+}
+
+static u8* lz4_emit_sequence(u8* op, const u8* op_end, const u8* literals, u64 literal_length, u64 offset, u64 match_length) {
+    // Worst case for the token, both length extensions and the offset
+    if ((u64)(op_end - op) < 1 + literal_length + literal_length / 255 + match_length / 255 + 8) {
+        return 0;
+    }
+    u8* token = op++;
+    *token = (u8)((literal_length >= 15 ? 15 : literal_length) << 4);
+    if (literal_length >= 15) {
+        op = lz4_write_length(op, literal_length - 15);
+    }
+    memcpy(op, literals, literal_length);
+    op += literal_length;
+    if (match_length == 0) {
+        // The final literal-only sequence
+        return op;
+    }
+
+    *op++ = (u8)(offset & 0xFF);
+    *op++ = (u8)(offset >> 8);
+    u64 extra = match_length - LZ4_MIN_MATCH;
+    *token |= (u8)(extra >= 15 ? 15 : extra);
+    if (extra >= 15) {
+        op = lz4_write_length(op, extra - 15);
+    }
+    return op;
+}
+
+u64 lz4_compress(const void* source, u64 size, void* destination, u64 capacity) {
+    const u8* src = source;
+    u8* op = destination;
+    const u8* op_end = op + capacity;
+    u64 anchor = 0;
+
+    if (size > 0xFFFFFFFFull) {
+        return 0;
+    }
+
+    if (size > LZ4_MATCH_FIND_LIMIT) {
+        // Positions are stored plus one so a zeroed slot is empty
+        u32* table = platform_allocate(sizeof(u32) << LZ4_HASH_BITS, FALSE);
+        platform_zero_memory(table, sizeof(u32) << LZ4_HASH_BITS);
+        u64 match_start_limit = size - LZ4_MATCH_FIND_LIMIT;
+        u64 match_end_limit = size - LZ4_LAST_LITERALS;
+
+        u64 ip = 0;
+        while (ip < match_start_limit) {
+            u32 sequence = lz4_read_u32(src + ip);
+            u32 slot = lz4_hash(sequence);
+            u64 candidate = table[slot];
+            table[slot] = (u32)(ip + 1);
+            if (candidate == 0 || ip - (candidate - 1) > LZ4_MAX_OFFSET || lz4_read_u32(src + candidate - 1) != sequence) {
+                ip++;
+                continue;
+            }
+            candidate--;
+
+            u64 length = LZ4_MIN_MATCH;
+            while (ip + length < match_end_limit && src[candidate + length] == src[ip + length]) {
+                length++;
+            }
+            op = lz4_emit_sequence(op, op_end, src + anchor, ip - anchor, ip - candidate, length);
+            if (!op) {
+                platform_free(table, FALSE);
+                return 0;
+            }
+            ip += length;
+            anchor = ip;
+        }
+        platform_free(table, FALSE);
+    }
+
+    op = lz4_emit_sequence(op, op_end, src + anchor, size - anchor, 0, 0);
+    return op ? (u64)(op - (u8*)destination) : 0;
+}
+
+b8 lz4_decompress(const void* source, u64 source_size, void* destination, u64 size) {
+    const u8* ip = source;
+    const u8* ip_end = ip + source_size;
+    u8* dst = destination;
+    u64 op = 0;
+
+    while (ip < ip_end) {
+        u8 token = *ip++;
+
+        u64 literal_length = token >> 4;
+        if (literal_length == 15) {
+            u8 byte;
+            do {
+                if (ip >= ip_end) return FALSE;
+                byte = *ip++;
+                literal_length += byte;
+            } while (byte == 255);
+        }
+        if ((u64)(ip_end - ip) < literal_length || size - op < literal_length) {
+            return FALSE;
+        }
+        memcpy(dst + op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+        if (ip == ip_end) {
+            break;
+        }
+
+        if (ip_end - ip < 2) return FALSE;
+        u64 offset = (u64)ip[0] | ((u64)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) {
+            return FALSE;
+        }
+
+        u64 match_length = token & 15;
+        if (match_length == 15) {
+            u8 byte;
+            do {
+                if (ip >= ip_end) return FALSE;
+                byte = *ip++;
+                match_length += byte;
+            } while (byte == 255);
+        }
+        match_length += LZ4_MIN_MATCH;
+        if (size - op < match_length) {
+            return FALSE;
+        }
+
+        const u8* match = dst + op - offset;
+        if (offset >= match_length) {
+            memcpy(dst + op, match, match_length);
+        } else {
+            // Overlapping copy repeats the last offset bytes
+            for (u64 i = 0; i < match_length; ++i) {
+                dst[op + i] = match[i];
+            }
+        }
+        op += match_length;
+    }
+    return op == size;
+}
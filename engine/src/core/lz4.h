@@ -0,0 +1,17 @@
+#pragma once
+
+#include "definitions.h"
+
+// LZ4 block format codec, compatible with the reference liblz4 block API.
+// Blocks are limited to 4 GiB.
+
+// Largest compressed size of size input bytes.
+API u64 lz4_compress_bound(u64 size);
+
+// Greedy single-pass compressor, fast rather than small. Returns the compressed
+// size, or 0 if the output doesn't fit in capacity.
+API u64 lz4_compress(const void* source, u64 size, void* destination, u64 capacity);
+
+// Decompresses a whole block. Returns FALSE on malformed input or when the
+// block doesn't decompress to exactly size bytes.
+API b8 lz4_decompress(const void* source, u64 source_size, void* destination, u64 size);
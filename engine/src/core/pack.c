@@ -0,0 +1,113 @@
+#include "pack.h"
+#include "core/hash.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "core/lz4.h"
+#include "core/profiler.h"
+#include "platform/platform.h"
+
+#include <string.h>
+
+static b8 pack_validate(const platform_file_mapping* file, const char* path) {
+    const pack_header* header = (const pack_header*)file->data;
+    if (!file->data || file->size < sizeof(pack_header) || header->magic != PACK_MAGIC) {
+        ERROR("'%s' is not a pack file", path);
+        return FALSE;
+    }
+    if (header->version != PACK_VERSION) {
+        ERROR("Pack '%s' is version %u, expected %u", path, header->version, PACK_VERSION);
+        return FALSE;
+    }
+    if (header->file_size != file->size || header->slot_count == 0 ||
+        (header->slot_count & (header->slot_count - 1)) != 0 || header->entry_count > header->slot_count ||
+        header->toc_offset % sizeof(u64) != 0 || header->toc_offset < sizeof(pack_header) ||
+        header->toc_offset + (u64)header->slot_count * sizeof(pack_entry) > header->names_offset ||
+        header->names_offset > file->size) {
+        ERROR("Pack '%s' is truncated or corrupt", path);
+        return FALSE;
+    }
+
+    const pack_entry* toc = (const pack_entry*)(file->data + header->toc_offset);
+    u64 names_size = file->size - header->names_offset;
+    for (u32 i = 0; i < header->slot_count; ++i) {
+        const pack_entry* entry = &toc[i];
+        if (!(entry->flags & PACK_ENTRY_USED)) {
+            continue;
+        }
+        if (entry->name_offset >= names_size || entry->offset > file->size ||
+            entry->stored_size > file->size - entry->offset ||
+            (!(entry->flags & PACK_ENTRY_COMPRESSED) && entry->stored_size != entry->size)) {
+            ERROR("Pack '%s' has an entry out of bounds", path);
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+b8 pack_open(const char* path, pack_archive* out_archive) {
+    PROFILE_FUNCTION();
+    kzero_memory(out_archive, sizeof(pack_archive));
+
+    platform_file_mapping file;
+    if (!platform_file_map(path, &file)) {
+        return FALSE;
+    }
+    if (!pack_validate(&file, path)) {
+        platform_file_unmap(&file);
+        return FALSE;
+    }
+
+    out_archive->file = file;
+    out_archive->header = (const pack_header*)file.data;
+    out_archive->toc = (const pack_entry*)(file.data + out_archive->header->toc_offset);
+    out_archive->names = file.data + out_archive->header->names_offset;
+    out_archive->names_size = file.size - out_archive->header->names_offset;
+    INFO("Opened pack '%s': %u entries, %.1f MiB", path, out_archive->header->entry_count,
+         (f64)file.size / (1024.0 * 1024.0));
+    return TRUE;
+}
+
+void pack_close(pack_archive* archive) {
+    platform_file_unmap(&archive->file);
+    kzero_memory(archive, sizeof(pack_archive));
+}
+
+b8 pack_find(const pack_archive* archive, const char* name, pack_file* out_file) {
+    if (!archive->header) {
+        return FALSE;
+    }
+
+    u64 hash = hash_string(name, 0);
+    u32 mask = archive->header->slot_count - 1;
+    for (u32 probe = 0; probe <= mask; ++probe) {
+        const pack_entry* entry = &archive->toc[(hash + probe) & mask];
+        if (!(entry->flags & PACK_ENTRY_USED)) {
+            return FALSE;
+        }
+        if (entry->name_hash != hash ||
+            strncmp(archive->names + entry->name_offset, name, archive->names_size - entry->name_offset) != 0) {
+            continue;
+        }
+        if (out_file) {
+            out_file->data = archive->file.data + entry->offset;
+            out_file->stored_size = entry->stored_size;
+            out_file->size = entry->size;
+            out_file->content_hash = entry->content_hash;
+            out_file->compressed = (entry->flags & PACK_ENTRY_COMPRESSED) != 0;
+        }
+        return TRUE;
+    }
+    return FALSE;
+}
+
+b8 pack_read(const pack_file* file, void* buffer) {
+    if (!file->compressed) {
+        kcopy_memory(buffer, file->data, file->size);
+        return TRUE;
+    }
+    if (!lz4_decompress(file->data, file->stored_size, buffer, file->size)) {
+        ERROR("Corrupt compressed pack entry (%llu bytes)", file->stored_size);
+        return FALSE;
+    }
+    return TRUE;
+}
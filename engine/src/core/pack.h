@@ -0,0 +1,80 @@
+#pragma once
+
+#include "definitions.h"
+#include "platform/platform.h"
+
+// Read-only asset archives. A pack is mapped once when opened and entries are
+// looked up by path in a hashed table of contents, so opening an asset costs a
+// hash probe instead of a filesystem round trip. Built by tools/packer, and
+// usually mounted through core/vfs.h rather than used directly.
+//
+// File layout: pack_header, the TOC (slot_count pack_entry records), the name
+// table, then entry data, each entry starting at a multiple of alignment.
+
+#define PACK_MAGIC 0x4B41504Bu // "KPAK"
+#define PACK_VERSION 1
+#define PACK_DEFAULT_ALIGNMENT 16
+
+typedef enum pack_entry_flags {
+    // Set for occupied TOC slots
+    PACK_ENTRY_USED = 0x1,
+    // Data is an LZ4 block of size bytes once decompressed
+    PACK_ENTRY_COMPRESSED = 0x2
+} pack_entry_flags;
+
+typedef struct pack_header {
+    u32 magic;
+    u32 version;
+    u64 file_size;
+    u32 entry_count;
+    // Power of two. The TOC is open-addressed and probed linearly from
+    // name_hash & (slot_count - 1).
+    u32 slot_count;
+    u32 alignment;
+    u32 reserved;
+    u64 toc_offset;
+    u64 names_offset;
+} pack_header;
+
+typedef struct pack_entry {
+    // hash_string of the name, seed 0
+    u64 name_hash;
+    // Null-terminated name at names_offset + name_offset
+    u32 name_offset;
+    u32 flags;
+    u64 offset;
+    u64 stored_size;
+    u64 size;
+    // hash_bytes of the uncompressed data, seed 0
+    u64 content_hash;
+} pack_entry;
+
+// An open pack. Lookups only read it, so they are safe from any thread.
+typedef struct pack_archive {
+    platform_file_mapping file;
+    const pack_header* header;
+    const pack_entry* toc;
+    const char* names;
+    u64 names_size;
+} pack_archive;
+
+// An entry of an open pack. data points into the mapping and stays valid
+// until the pack is closed.
+typedef struct pack_file {
+    const char* data;
+    u64 stored_size;
+    u64 size;
+    u64 content_hash;
+    b8 compressed;
+} pack_file;
+
+// Maps and validates a pack.
+API b8 pack_open(const char* path, pack_archive* out_archive);
+API void pack_close(pack_archive* archive);
+
+// Finds name (e.g. "assets/textures/crate.png") in the pack. out_file may be 0
+// to only test for presence.
+API b8 pack_find(const pack_archive* archive, const char* name, pack_file* out_file);
+
+// Copies or decompresses the file's size bytes into buffer.
+API b8 pack_read(const pack_file* file, void* buffer);
@@ -0,0 +1,204 @@
+#include "perf_hud.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "renderer/renderer_frontend.h"
+
+#include <stdio.h>
+
+// Layout in screen pixels from the top-left corner.
+#define HUD_X 20.0f
+#define HUD_Y 140.0f
+#define HUD_WIDTH 480.0f
+#define HUD_PADDING 8.0f
+#define HUD_LINE_HEIGHT 20.0f
+#define HUD_TEXT_SCALE 0.35f
+#define HUD_GRAPH_HEIGHT 80.0f
+// The graph tops out at this multiple of the frame budget.
+#define HUD_GRAPH_RANGE 2.0
+
+// Background, budget line and one bar per recorded frame.
+#define HUD_MAX_QUADS (FRAME_STATS_HISTORY + 2)
+
+typedef struct perf_hud_state {
+    b8 visible;
+
+    // Everything the overlay points at lives here, nothing is allocated per frame.
+    char lines[PERF_HUD_MAX_LINES][PERF_HUD_LINE_LENGTH];
+    text_command text_commands[PERF_HUD_MAX_LINES];
+    u32 line_count;
+    quad_command quads[HUD_MAX_QUADS];
+    u32 quad_count;
+
+    // Allocator totals at the last text refresh, for the allocation rate.
+    f64 last_refresh;
+    u64 last_allocation_count;
+    u64 last_allocated_bytes;
+} perf_hud_state;
+
+static perf_hud_state state;
+static b8 initialized = FALSE;
+
+void perf_hud_initialize() {
+    kzero_memory(&state, sizeof(perf_hud_state));
+    state.last_refresh = -PERF_HUD_TEXT_REFRESH_SECONDS;
+    initialized = TRUE;
+}
+
+void perf_hud_shutdown() {
+    if (!initialized) return;
+    renderer_set_overlay(0, 0, 0, 0);
+    initialized = FALSE;
+}
+
+void perf_hud_set_visible(b8 visible) {
+    state.visible = visible;
+    if (!visible) {
+        renderer_set_overlay(0, 0, 0, 0);
+    } else {
+        // Rebuild the text on the next update rather than showing stale numbers
+        state.last_refresh = -PERF_HUD_TEXT_REFRESH_SECONDS;
+        state.line_count = 0;
+        state.last_allocation_count = 0;
+    }
+    INFO("Performance HUD %s", visible ? "shown" : "hidden");
+}
+
+void perf_hud_toggle() {
+    perf_hud_set_visible(!state.visible);
+}
+
+b8 perf_hud_is_visible() {
+    return state.visible;
+}
+
+static char* perf_hud_next_line() {
+    if (state.line_count >= PERF_HUD_MAX_LINES) {
+        return 0;
+    }
+    return state.lines[state.line_count++];
+}
+
+#define perf_hud_printf(...)                                   \
+    do {                                                       \
+        char* line = perf_hud_next_line();                     \
+        if (line) {                                            \
+            snprintf(line, PERF_HUD_LINE_LENGTH, __VA_ARGS__); \
+        }                                                      \
+    } while (0)
+
+static void perf_hud_build_text(const frame_stats* stats, f64 now) {
+    state.line_count = 0;
+
+    frame_stats_summary summary;
+    frame_stats_summarize(stats, &summary);
+    f64 fps = summary.smoothed > 0 ? 1.0 / summary.smoothed : 0;
+    perf_hud_printf("Frame %.2f ms (%.0f fps)", summary.smoothed * 1000.0, fps);
+    perf_hud_printf("p50 %.2f  p95 %.2f  p99 %.2f ms", summary.p50 * 1000.0, summary.p95 * 1000.0, summary.p99 * 1000.0);
+    perf_hud_printf("min %.2f  max %.2f ms over %u frames", summary.min * 1000.0, summary.max * 1000.0, stats->count);
+
+    renderer_frame_stats frame;
+    if (renderer_get_frame_stats(&frame)) {
+        perf_hud_printf("Draws %u  Tris %llu  Shaders %u  Textures %u",
+                        frame.draw_calls, frame.triangles, frame.shader_binds, frame.texture_binds);
+        perf_hud_printf("Uploads %u (%.1f KB)  Uniforms %u  State %u",
+                        frame.buffer_uploads, frame.buffer_upload_bytes / 1024.0, frame.uniform_updates,
+                        frame.state_changes);
+    }
+
+    memory_usage usage;
+    get_memory_usage(&usage);
+    f64 elapsed = now - state.last_refresh;
+    f64 allocs_per_second = 0;
+    f64 bytes_per_second = 0;
+    if (state.last_allocation_count > 0 && elapsed > 0) {
+        allocs_per_second = (f64)(usage.allocation_count - state.last_allocation_count) / elapsed;
+        bytes_per_second = (f64)(usage.allocated_bytes - state.last_allocated_bytes) / elapsed;
+    }
+    state.last_allocation_count = usage.allocation_count;
+    state.last_allocated_bytes = usage.allocated_bytes;
+    perf_hud_printf("Memory %.2f MB  %.0f allocs/s  %.1f KB/s",
+                    usage.total_allocated / (1024.0 * 1024.0), allocs_per_second, bytes_per_second / 1024.0);
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
+        if (usage.tagged_allocations[i] > 0) {
+            perf_hud_printf("  %s %.1f KB", get_memory_tag_name((memory_tag)i), usage.tagged_allocations[i] / 1024.0);
+        }
+    }
+
+    font* f = renderer_get_default_font();
+    for (u32 i = 0; i < state.line_count; ++i) {
+        text_command* cmd = &state.text_commands[i];
+        cmd->text = state.lines[i];
+        cmd->text_id = i;
+        cmd->position = (vec2){{HUD_X + HUD_PADDING, HUD_Y + HUD_PADDING + HUD_LINE_HEIGHT * (i + 1)}};
+        cmd->color = (vec4){{1.0f, 1.0f, 1.0f, 1.0f}};
+        cmd->scale = HUD_TEXT_SCALE;
+        cmd->font = f;
+    }
+}
+
+static void perf_hud_build_quads(const frame_stats* stats, f64 budget_seconds) {
+    state.quad_count = 0;
+
+    f32 text_height = HUD_LINE_HEIGHT * state.line_count + HUD_PADDING;
+    f32 graph_top = HUD_Y + HUD_PADDING + text_height;
+    f32 graph_bottom = graph_top + HUD_GRAPH_HEIGHT;
+    f32 graph_width = HUD_WIDTH - 2.0f * HUD_PADDING;
+
+    state.quads[state.quad_count++] = (quad_command){
+        .position = {{HUD_X, HUD_Y}},
+        .size = {{HUD_WIDTH, graph_bottom + HUD_PADDING - HUD_Y}},
+        .color = {{0.0f, 0.0f, 0.0f, 0.6f}},
+    };
+
+    // Oldest frame on the left, newest on the right, like a strip chart
+    f64 range = budget_seconds * HUD_GRAPH_RANGE;
+    f32 bar_width = graph_width / FRAME_STATS_HISTORY;
+    for (u32 i = 0; i < stats->count; ++i) {
+        f64 seconds = frame_stats_get(stats, i);
+        f32 height = (f32)(seconds / range) * HUD_GRAPH_HEIGHT;
+        if (height > HUD_GRAPH_HEIGHT) height = HUD_GRAPH_HEIGHT;
+        if (height < 1.0f) height = 1.0f;
+
+        vec4 color;
+        if (seconds <= budget_seconds) {
+            color = (vec4){{0.2f, 0.8f, 0.2f, 0.9f}};
+        } else if (seconds <= budget_seconds * 1.5) {
+            color = (vec4){{0.9f, 0.8f, 0.1f, 0.9f}};
+        } else {
+            color = (vec4){{0.9f, 0.2f, 0.2f, 0.9f}};
+        }
+
+        f32 x = HUD_X + HUD_PADDING + graph_width - bar_width * (i + 1);
+        state.quads[state.quad_count++] = (quad_command){
+            .position = {{x, graph_bottom - height}},
+            .size = {{bar_width, height}},
+            .color = color,
+        };
+    }
+
+    // Budget line drawn over the bars
+    f32 budget_y = graph_bottom - (f32)(budget_seconds / range) * HUD_GRAPH_HEIGHT;
+    state.quads[state.quad_count++] = (quad_command){
+        .position = {{HUD_X + HUD_PADDING, budget_y}},
+        .size = {{graph_width, 1.0f}},
+        .color = {{1.0f, 1.0f, 1.0f, 0.5f}},
+    };
+}
+
+void perf_hud_update(const frame_stats* stats, f64 budget_seconds, f64 now) {
+    if (!initialized || !state.visible || !stats) {
+        return;
+    }
+    if (budget_seconds <= 0) {
+        budget_seconds = 1.0 / 60.0;
+    }
+
+    if (now - state.last_refresh >= PERF_HUD_TEXT_REFRESH_SECONDS) {
+        perf_hud_build_text(stats, now);
+        state.last_refresh = now;
+    }
+    perf_hud_build_quads(stats, budget_seconds);
+
+    renderer_set_overlay(state.text_commands, state.line_count, state.quads, state.quad_count);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "definitions.h"
+#include "core/frame_stats.h"
+
+// Text lines the HUD can show: frame times, renderer counters and memory tags.
+#define PERF_HUD_MAX_LINES 20
+#define PERF_HUD_LINE_LENGTH 96
+// How often the text is rebuilt, in seconds. The graph updates every frame.
+#define PERF_HUD_TEXT_REFRESH_SECONDS 0.25
+
+void perf_hud_initialize();
+void perf_hud_shutdown();
+
+API void perf_hud_toggle();
+API void perf_hud_set_visible(b8 visible);
+API b8 perf_hud_is_visible();
+
+// Rebuilds the overlay from the latest frame times and hands it to the renderer.
+// Call once per frame before the game renders. budget_seconds is the frame time
+// the graph is scaled against, e.g. 1/60.
+void perf_hud_update(const frame_stats* stats, f64 budget_seconds, f64 now);
@@ -0,0 +1,264 @@
+#include "profiler.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "core/kstring.h"
+#include "platform/platform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_USE_TSC 1
+#else
+#define PROFILER_USE_TSC 0
+#endif
+
+typedef struct profile_event {
+    const char* name;
+    u64 start;
+    u64 end;
+} profile_event;
+
+// Written only by its owning thread. write_index is published with release
+// stores so the exporter can read every event below it.
+typedef struct profiler_thread_buffer {
+    u64 thread_id;
+    char name[32];
+    u64 write_index;
+    profile_event* events;
+    u32 depth;
+    profile_zone stack[PROFILER_MAX_DEPTH];
+} profiler_thread_buffer;
+
+typedef struct profiler_state {
+    b8 initialized;
+    b8 capture_pending;
+    u32 frames_requested;
+    u32 frames_remaining;
+    char path[256];
+    // Clock pairs taken at capture start and end to convert ticks to microseconds.
+    u64 start_ticks;
+    f64 start_time;
+    u64 frame_start;
+} profiler_state;
+
+b8 profiler_active = FALSE;
+
+static profiler_state state;
+static profiler_thread_buffer* thread_buffers[PROFILER_MAX_THREADS];
+static u32 thread_count = 0;
+static __thread profiler_thread_buffer* local_buffer = 0;
+
+static void profiler_export();
+
+u64 profiler_timestamp() {
+#if PROFILER_USE_TSC
+    return __rdtsc();
+#else
+    return (u64)(platform_get_absolute_time() * 1000000000.0);
+#endif
+}
+
+static profiler_thread_buffer* profiler_get_thread_buffer() {
+    if (local_buffer) {
+        return local_buffer;
+    }
+    if (__atomic_load_n(&thread_count, __ATOMIC_ACQUIRE) >= PROFILER_MAX_THREADS) {
+        return 0;
+    }
+    u32 index = __atomic_fetch_add(&thread_count, 1, __ATOMIC_ACQ_REL);
+    if (index >= PROFILER_MAX_THREADS) {
+        return 0;
+    }
+
+    // Any thread can land here, and kallocate's tag statistics are not
+    // thread-safe, so these buffers come straight from the platform layer.
+    profiler_thread_buffer* buffer = platform_allocate(sizeof(profiler_thread_buffer), FALSE);
+    platform_zero_memory(buffer, sizeof(profiler_thread_buffer));
+    buffer->events = platform_allocate(sizeof(profile_event) * PROFILER_EVENTS_PER_THREAD, FALSE);
+    buffer->thread_id = platform_current_thread_id();
+    snprintf(buffer->name, sizeof(buffer->name), index == 0 ? "main" : "thread %u", index);
+
+    __atomic_store_n(&thread_buffers[index], buffer, __ATOMIC_RELEASE);
+    local_buffer = buffer;
+    return buffer;
+}
+
+void profiler_initialize() {
+    kzero_memory(&state, sizeof(profiler_state));
+    state.initialized = TRUE;
+    // Claim slot 0 for the thread that owns the main loop
+    profiler_get_thread_buffer();
+}
+
+void profiler_shutdown() {
+    if (!state.initialized) {
+        return;
+    }
+    if (profiler_active) {
+        WARN("Profiler capture interrupted by shutdown, writing the frames recorded so far");
+        profiler_export();
+    }
+    __atomic_store_n(&profiler_active, FALSE, __ATOMIC_RELEASE);
+
+    u32 count = thread_count < PROFILER_MAX_THREADS ? thread_count : PROFILER_MAX_THREADS;
+    for (u32 i = 0; i < count; ++i) {
+        if (thread_buffers[i]) {
+            platform_free(thread_buffers[i]->events, FALSE);
+            platform_free(thread_buffers[i], FALSE);
+            thread_buffers[i] = 0;
+        }
+    }
+    thread_count = 0;
+    local_buffer = 0;
+    state.initialized = FALSE;
+}
+
+b8 profiler_capture_frames(u32 frame_count, const char* path) {
+    if (!state.initialized || frame_count == 0 || !path) {
+        return FALSE;
+    }
+    if (profiler_active || state.capture_pending) {
+        WARN("A profiler capture is already in progress");
+        return FALSE;
+    }
+    if (string_length(path) >= sizeof(state.path)) {
+        ERROR("Profiler capture path is too long: %s", path);
+        return FALSE;
+    }
+    strcpy(state.path, path);
+    state.frames_requested = frame_count;
+    state.capture_pending = TRUE;
+    INFO("Profiler: capturing the next %u frames to '%s'", frame_count, path);
+    return TRUE;
+}
+
+b8 profiler_is_capturing() {
+    return profiler_active || state.capture_pending;
+}
+
+void profiler_frame_mark() {
+    if (!state.initialized) {
+        return;
+    }
+
+    u64 now = profiler_timestamp();
+    if (profiler_active) {
+        profiler_record("Frame", state.frame_start, now);
+        if (--state.frames_remaining == 0) {
+            __atomic_store_n(&profiler_active, FALSE, __ATOMIC_RELEASE);
+            profiler_export();
+            return;
+        }
+    } else if (state.capture_pending) {
+        state.capture_pending = FALSE;
+        state.frames_remaining = state.frames_requested;
+        state.start_time = platform_get_absolute_time();
+        state.start_ticks = profiler_timestamp();
+        now = state.start_ticks;
+        __atomic_store_n(&profiler_active, TRUE, __ATOMIC_RELEASE);
+    }
+    state.frame_start = now;
+}
+
+void profiler_set_thread_name(const char* name) {
+    profiler_thread_buffer* buffer = profiler_get_thread_buffer();
+    if (buffer) {
+        snprintf(buffer->name, sizeof(buffer->name), "%s", name);
+    }
+}
+
+void profiler_record(const char* name, u64 start, u64 end) {
+    profiler_thread_buffer* buffer = profiler_get_thread_buffer();
+    if (!buffer) {
+        return;
+    }
+    u64 index = buffer->write_index;
+    profile_event* event = &buffer->events[index & (PROFILER_EVENTS_PER_THREAD - 1)];
+    event->name = name;
+    event->start = start;
+    event->end = end;
+    __atomic_store_n(&buffer->write_index, index + 1, __ATOMIC_RELEASE);
+}
+
+void profiler_push(const char* name) {
+    profiler_thread_buffer* buffer = profiler_get_thread_buffer();
+    if (!buffer) {
+        return;
+    }
+    if (buffer->depth >= PROFILER_MAX_DEPTH) {
+        // Still count it so the matching PROFILE_END stays balanced
+        buffer->depth++;
+        return;
+    }
+    buffer->stack[buffer->depth++] = profiler_zone_begin(name);
+}
+
+void profiler_pop() {
+    profiler_thread_buffer* buffer = profiler_get_thread_buffer();
+    if (!buffer || buffer->depth == 0) {
+        return;
+    }
+    buffer->depth--;
+    if (buffer->depth < PROFILER_MAX_DEPTH) {
+        profiler_zone_end(&buffer->stack[buffer->depth]);
+    }
+}
+
+// Writes every event recorded since the capture started as Chrome "complete" events.
+// Nesting is implied by the timestamps, so no explicit parent links are needed.
+static void profiler_export() {
+    f64 elapsed = platform_get_absolute_time() - state.start_time;
+    u64 elapsed_ticks = profiler_timestamp() - state.start_ticks;
+    f64 ticks_per_us = elapsed > 0 ? (f64)elapsed_ticks / (elapsed * 1000000.0) : 1000.0;
+
+    FILE* file = fopen(state.path, "w");
+    if (!file) {
+        ERROR("Profiler: failed to open '%s' for writing", state.path);
+        return;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    b8 first = TRUE;
+    u64 written = 0;
+    u64 dropped = 0;
+    u32 count = __atomic_load_n(&thread_count, __ATOMIC_ACQUIRE);
+    if (count > PROFILER_MAX_THREADS) count = PROFILER_MAX_THREADS;
+
+    for (u32 t = 0; t < count; ++t) {
+        profiler_thread_buffer* buffer = __atomic_load_n(&thread_buffers[t], __ATOMIC_ACQUIRE);
+        if (!buffer) continue;
+
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", t + 1, buffer->name);
+        first = FALSE;
+
+        u64 end_index = __atomic_load_n(&buffer->write_index, __ATOMIC_ACQUIRE);
+        u64 begin_index = end_index > PROFILER_EVENTS_PER_THREAD ? end_index - PROFILER_EVENTS_PER_THREAD : 0;
+        for (u64 i = begin_index; i < end_index; ++i) {
+            profile_event* event = &buffer->events[i & (PROFILER_EVENTS_PER_THREAD - 1)];
+            if (event->start < state.start_ticks) {
+                continue;
+            }
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    event->name, t + 1,
+                    (f64)(event->start - state.start_ticks) / ticks_per_us,
+                    (f64)(event->end - event->start) / ticks_per_us);
+            written++;
+        }
+        // The ring wrapped during the capture, the oldest events were overwritten
+        if (begin_index > 0 && buffer->events[begin_index & (PROFILER_EVENTS_PER_THREAD - 1)].start >= state.start_ticks) {
+            dropped++;
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    INFO("Profiler: wrote %llu events from %u frames to '%s'", written,
+         state.frames_requested - state.frames_remaining, state.path);
+    if (dropped) {
+        WARN("Profiler: %llu threads overflowed their event buffer, the start of the capture is missing", dropped);
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "definitions.h"
+
+// Instrumentation is compiled in unless the build defines PROFILER_ENABLED=0.
+// While no capture is running each zone costs one predictable branch.
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+// Events kept per thread. Older events are overwritten once a capture outgrows it.
+#define PROFILER_EVENTS_PER_THREAD (1 << 16)
+// Threads that can record at the same time.
+#define PROFILER_MAX_THREADS 16
+// Nesting depth for PROFILE_BEGIN/PROFILE_END pairs.
+#define PROFILER_MAX_DEPTH 64
+
+// An open zone. start is 0 when the zone began outside a capture.
+typedef struct profile_zone {
+    const char* name;
+    u64 start;
+} profile_zone;
+
+// Set while a capture is recording. Read by the instrumentation macros.
+API extern b8 profiler_active;
+
+void profiler_initialize();
+void profiler_shutdown();
+
+// Records the next frame_count frames, starting at the next frame boundary,
+// and writes them to path as Chrome trace-event JSON (chrome://tracing, Perfetto).
+API b8 profiler_capture_frames(u32 frame_count, const char* path);
+API b8 profiler_is_capturing();
+
+// Called once at the start of every frame by the application loop.
+void profiler_frame_mark();
+
+// Names the calling thread in exported traces.
+API void profiler_set_thread_name(const char* name);
+
+// Raw timestamp in profiler ticks (TSC where available, nanoseconds otherwise).
+API u64 profiler_timestamp();
+API void profiler_record(const char* name, u64 start, u64 end);
+API void profiler_push(const char* name);
+API void profiler_pop();
+
+static inline profile_zone profiler_zone_begin(const char* name) {
+    profile_zone zone = {name, 0};
+    if (__builtin_expect(__atomic_load_n(&profiler_active, __ATOMIC_RELAXED), 0)) {
+        zone.start = profiler_timestamp();
+    }
+    return zone;
+}
+
+static inline void profiler_zone_end(profile_zone* zone) {
+    if (__builtin_expect(zone->start != 0, 0)) {
+        profiler_record(zone->name, zone->start, profiler_timestamp());
+    }
+}
+
+#if PROFILER_ENABLED
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// Times the rest of the enclosing block, including early returns.
+#define PROFILE_SCOPE(name)                                                                \
+    profile_zone PROFILE_CONCAT(profile_zone_, __LINE__) __attribute__((cleanup(profiler_zone_end))) = \
+        profiler_zone_begin(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+
+// Explicit zones for spans that don't match a block. Must be balanced per thread,
+// so they are tracked even when no capture is running.
+#define PROFILE_BEGIN(name) profiler_push(name)
+#define PROFILE_END() profiler_pop()
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_BEGIN(name) ((void)0)
+#define PROFILE_END() ((void)0)
+#endif
@@ -0,0 +1,120 @@
+#include "telemetry.h"
+
+#include "core/frame_stats.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+#include "renderer/renderer_frontend.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+// Percentiles sort the whole history, so only refresh them every few frames.
+#define TELEMETRY_PERCENTILE_INTERVAL_SECONDS 0.25
+
+typedef struct telemetry_state {
+    platform_shared_memory memory;
+    telemetry_block* block;
+    f64 start_time;
+    f64 last_percentiles;
+    frame_stats_summary summary;
+    u32 loading_queue_depth;
+} telemetry_state;
+
+static telemetry_state state;
+static b8 initialized = FALSE;
+
+_Static_assert(MEMORY_TAG_MAX_TAGS <= TELEMETRY_MAX_TAGS, "telemetry_block cannot hold every memory tag");
+
+b8 telemetry_initialize() {
+    if (initialized) {
+        return TRUE;
+    }
+    kzero_memory(&state, sizeof(telemetry_state));
+
+    char name[64];
+    snprintf(name, sizeof(name), TELEMETRY_NAME_PREFIX "%d", (i32)getpid());
+    if (!platform_shared_memory_create(name, sizeof(telemetry_block), &state.memory)) {
+        WARN("Telemetry disabled, shared memory could not be created");
+        return FALSE;
+    }
+
+    telemetry_block* block = state.memory.block;
+    block->magic = TELEMETRY_MAGIC;
+    block->version = TELEMETRY_VERSION;
+    block->size = sizeof(telemetry_block);
+    block->pid = (u32)getpid();
+    block->tag_count = MEMORY_TAG_MAX_TAGS;
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
+        snprintf(block->tag_names[i], TELEMETRY_TAG_NAME_LENGTH, "%s", get_memory_tag_name((memory_tag)i));
+    }
+    __atomic_store_n(&block->running, 1, __ATOMIC_RELEASE);
+
+    state.block = block;
+    state.start_time = platform_get_absolute_time();
+    state.last_percentiles = -TELEMETRY_PERCENTILE_INTERVAL_SECONDS;
+    initialized = TRUE;
+    INFO("Publishing telemetry in shared memory '%s'", name);
+    return TRUE;
+}
+
+void telemetry_shutdown() {
+    if (!initialized) return;
+    __atomic_store_n(&state.block->running, 0, __ATOMIC_RELEASE);
+    platform_shared_memory_destroy(&state.memory);
+    state.block = 0;
+    initialized = FALSE;
+}
+
+void telemetry_set_loading_queue_depth(u32 depth) {
+    __atomic_store_n(&state.loading_queue_depth, depth, __ATOMIC_RELAXED);
+}
+
+void telemetry_update(u64 frame_number, f64 frame_seconds, const frame_stats* stats, f64 now) {
+    if (!initialized) {
+        return;
+    }
+
+    // Gather everything first so the write window stays short
+    if (stats && now - state.last_percentiles >= TELEMETRY_PERCENTILE_INTERVAL_SECONDS) {
+        frame_stats_summarize(stats, &state.summary);
+        state.last_percentiles = now;
+    }
+    memory_usage usage;
+    get_memory_usage(&usage);
+    renderer_frame_stats frame;
+    b8 has_frame = renderer_get_frame_stats(&frame);
+
+    telemetry_block* block = state.block;
+    u64 sequence = block->sequence;
+    __atomic_store_n(&block->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    block->frame_number = frame_number;
+    block->uptime_seconds = now - state.start_time;
+    block->frame_ms = frame_seconds * 1000.0;
+    block->smoothed_ms = (stats ? stats->smoothed : frame_seconds) * 1000.0;
+    block->p50_ms = state.summary.p50 * 1000.0;
+    block->p95_ms = state.summary.p95 * 1000.0;
+    block->p99_ms = state.summary.p99 * 1000.0;
+    block->max_ms = state.summary.max * 1000.0;
+
+    block->memory_total = usage.total_allocated;
+    block->allocation_count = usage.allocation_count;
+    block->allocated_bytes = usage.allocated_bytes;
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
+        block->tagged_allocations[i] = usage.tagged_allocations[i];
+    }
+
+    if (has_frame) {
+        block->draw_calls = frame.draw_calls;
+        block->shader_binds = frame.shader_binds;
+        block->texture_binds = frame.texture_binds;
+        block->buffer_uploads = frame.buffer_uploads;
+        block->triangles = frame.triangles;
+        block->buffer_upload_bytes = frame.buffer_upload_bytes;
+    }
+    block->loading_queue_depth = __atomic_load_n(&state.loading_queue_depth, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&block->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "definitions.h"
+
+// Live stats published in a POSIX shared-memory segment, one per process, so
+// external tools can watch a running instance. The engine only writes to mapped
+// memory each frame, no syscalls. Readers use telemetry_read below.
+//
+// This header is shared with tools/telemetry and only depends on definitions.h.
+
+// Segment name is TELEMETRY_NAME_PREFIX followed by the process id.
+#define TELEMETRY_NAME_PREFIX "/gameengine_telemetry_"
+#define TELEMETRY_MAGIC 0x4C45544BU  // "KTEL"
+// Bump whenever telemetry_block changes layout.
+#define TELEMETRY_VERSION 1
+// Fixed so the layout does not move when memory tags are added.
+#define TELEMETRY_MAX_TAGS 32
+#define TELEMETRY_TAG_NAME_LENGTH 16
+
+typedef struct telemetry_block {
+    // Written once at startup, safe to read without the sequence check.
+    u32 magic;
+    u32 version;
+    u32 size;  // sizeof(telemetry_block)
+    u32 pid;
+    u32 tag_count;
+    u32 running;  // Cleared at shutdown
+    char tag_names[TELEMETRY_MAX_TAGS][TELEMETRY_TAG_NAME_LENGTH];
+
+    // Seqlock: odd while the engine is writing, readers retry until they see the
+    // same even value before and after copying.
+    u64 sequence;
+
+    u64 frame_number;
+    f64 uptime_seconds;
+
+    // Frame times in milliseconds. Percentiles cover the last FRAME_STATS_HISTORY
+    // frames and are refreshed a few times per second.
+    f64 frame_ms;
+    f64 smoothed_ms;
+    f64 p50_ms;
+    f64 p95_ms;
+    f64 p99_ms;
+    f64 max_ms;
+
+    // Allocator
+    u64 memory_total;
+    u64 allocation_count;
+    u64 allocated_bytes;
+    u64 tagged_allocations[TELEMETRY_MAX_TAGS];
+
+    // Renderer counters of the last drawn frame
+    u32 draw_calls;
+    u32 shader_binds;
+    u32 texture_binds;
+    u32 buffer_uploads;
+    u64 triangles;
+    u64 buffer_upload_bytes;
+
+    // Loads queued but not finished yet.
+    u32 loading_queue_depth;
+    u32 padding;
+} telemetry_block;
+
+// Copies a consistent snapshot of a mapped block. Returns FALSE if the engine
+// kept writing through every attempt, which only happens under heavy contention.
+static inline b8 telemetry_read(const telemetry_block* block, telemetry_block* out_snapshot) {
+    for (u32 attempt = 0; attempt < 1000; ++attempt) {
+        u64 begin = __atomic_load_n(&block->sequence, __ATOMIC_ACQUIRE);
+        if (begin & 1) {
+            continue;
+        }
+        __builtin_memcpy(out_snapshot, (const void*)block, sizeof(telemetry_block));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        u64 end = __atomic_load_n(&block->sequence, __ATOMIC_RELAXED);
+        if (begin == end) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+struct frame_stats;
+
+// Creates the segment. Publishing is off until this succeeds.
+b8 telemetry_initialize();
+void telemetry_shutdown();
+
+// Publishes this frame's numbers. Call once per frame from the main loop.
+void telemetry_update(u64 frame_number, f64 frame_seconds, const struct frame_stats* stats, f64 now);
+
+// Reported as loading_queue_depth until changed.
+API void telemetry_set_loading_queue_depth(u32 depth);
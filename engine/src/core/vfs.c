@@ -0,0 +1,446 @@
+#include "vfs.h"
+#include "containers/probe_table.h"
+#include "core/hash.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "core/pack.h"
+#include "core/profiler.h"
+#include "platform/platform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Cache entries for paths found in no mount
+#define VFS_MISS -1
+
+typedef struct vfs_mount {
+    vfs_mount_type type;
+    char mount_point[VFS_MOUNT_POINT_MAX];
+    u32 mount_point_length;
+    // VFS_MOUNT_DIRECTORY
+    char directory[VFS_PATH_MAX];
+    // VFS_MOUNT_PACK
+    pack_archive pack;
+    // VFS_MOUNT_MEMORY, searched linearly since results are cached anyway
+    const vfs_memory_file* files;
+    u32 file_count;
+} vfs_mount;
+
+// Cached resolution of one path, slots with no path are empty.
+typedef struct vfs_cache_entry {
+    u64 hash;
+    char* path;
+    i32 mount;
+    vfs_file file;
+    pack_file packed;
+} vfs_cache_entry;
+
+typedef struct vfs_state {
+    vfs_mount mounts[VFS_MAX_MOUNTS];
+    u32 mount_count;
+
+    // Open-addressed with linear probing, capacity is a power of two. Entries
+    // are platform_allocate'd since lookups come from worker threads too.
+    vfs_cache_entry* cache;
+    u32 cache_capacity;
+    u32 cache_count;
+    platform_mutex lock;
+
+    u64 lookups;
+    u64 cache_hits;
+} vfs_state;
+
+static vfs_state state;
+static b8 initialized = FALSE;
+
+b8 vfs_normalize(const char* path, char* out_path) {
+    while (path[0] == '.' && (path[1] == '/' || path[1] == '\\')) {
+        path += 2;
+    }
+    u64 length = strlen(path);
+    if (length >= VFS_PATH_MAX) {
+        WARN("VFS path too long: %s", path);
+        return FALSE;
+    }
+    for (u64 i = 0; i <= length; ++i) {
+        out_path[i] = path[i] == '\\' ? '/' : path[i];
+    }
+    return TRUE;
+}
+
+static void vfs_directory_path(const vfs_mount* mount, const char* name, char* out_path, u64 size) {
+    if (mount->directory[0] == '\0' || strcmp(mount->directory, ".") == 0) {
+        snprintf(out_path, size, "%s", name);
+    } else {
+        snprintf(out_path, size, "%s/%s", mount->directory, name);
+    }
+}
+
+// Searches the mounts, newest first, without touching the cache.
+static i32 vfs_resolve(const char* path, vfs_file* out_file, pack_file* out_packed) {
+    kzero_memory(out_file, sizeof(vfs_file));
+    kzero_memory(out_packed, sizeof(pack_file));
+
+    for (i32 i = (i32)state.mount_count - 1; i >= 0; --i) {
+        const vfs_mount* mount = &state.mounts[i];
+        if (strncmp(path, mount->mount_point, mount->mount_point_length) != 0) {
+            continue;
+        }
+        const char* name = path + mount->mount_point_length;
+
+        switch (mount->type) {
+            case VFS_MOUNT_DIRECTORY: {
+                char full_path[VFS_PATH_MAX * 2];
+                vfs_directory_path(mount, name, full_path, sizeof(full_path));
+                platform_file_info info;
+                if (platform_get_file_info(full_path, &info)) {
+                    out_file->type = VFS_MOUNT_DIRECTORY;
+                    out_file->size = info.size;
+                    out_file->modified_ns = info.modified_ns;
+                    return i;
+                }
+            } break;
+            case VFS_MOUNT_PACK:
+                if (pack_find(&mount->pack, name, out_packed)) {
+                    out_file->type = VFS_MOUNT_PACK;
+                    out_file->size = out_packed->size;
+                    out_file->content_hash = out_packed->content_hash;
+                    out_file->data = out_packed->compressed ? 0 : out_packed->data;
+                    if (out_packed->compressed) {
+                        out_file->compressed_data = out_packed->data;
+                        out_file->compressed_size = out_packed->stored_size;
+                    }
+                    return i;
+                }
+                break;
+            case VFS_MOUNT_MEMORY:
+                for (u32 f = 0; f < mount->file_count; ++f) {
+                    if (strcmp(mount->files[f].path, name) == 0) {
+                        out_file->type = VFS_MOUNT_MEMORY;
+                        out_file->size = mount->files[f].size;
+                        out_file->data = mount->files[f].data;
+                        return i;
+                    }
+                }
+                break;
+        }
+    }
+    return VFS_MISS;
+}
+
+static void vfs_cache_create(u32 capacity) {
+    state.cache_capacity = capacity;
+    state.cache_count = 0;
+    state.cache = platform_allocate(sizeof(vfs_cache_entry) * capacity, FALSE);
+    platform_zero_memory(state.cache, sizeof(vfs_cache_entry) * capacity);
+}
+
+static void vfs_cache_destroy() {
+    for (u32 i = 0; i < state.cache_capacity; ++i) {
+        if (state.cache[i].path) {
+            platform_free(state.cache[i].path, FALSE);
+        }
+    }
+    platform_free(state.cache, FALSE);
+    state.cache = 0;
+    state.cache_capacity = 0;
+    state.cache_count = 0;
+}
+
+// Returns the slot holding path, or the empty slot it belongs in.
+static u32 vfs_cache_find(const char* path, u64 hash) {
+    u32 mask = state.cache_capacity - 1;
+    u32 slot = (u32)(hash & mask);
+    while (state.cache[slot].path &&
+           (state.cache[slot].hash != hash || strcmp(state.cache[slot].path, path) != 0)) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void vfs_cache_grow() {
+    vfs_cache_entry* old = state.cache;
+    u32 old_capacity = state.cache_capacity;
+    u32 count = state.cache_count;
+    vfs_cache_create(old_capacity * 2);
+    for (u32 i = 0; i < old_capacity; ++i) {
+        if (old[i].path) {
+            state.cache[vfs_cache_find(old[i].path, old[i].hash)] = old[i];
+        }
+    }
+    state.cache_count = count;
+    platform_free(old, FALSE);
+}
+
+static b8 vfs_cache_used(void* table, u32 slot) {
+    return ((vfs_cache_entry*)table)[slot].path != 0;
+}
+
+static u64 vfs_cache_hash(void* table, u32 slot) {
+    return ((vfs_cache_entry*)table)[slot].hash;
+}
+
+static void vfs_cache_move(void* table, u32 to, u32 from) {
+    ((vfs_cache_entry*)table)[to] = ((vfs_cache_entry*)table)[from];
+}
+
+// Empties a slot, see probe_table_remove.
+static void vfs_cache_remove(u32 slot) {
+    platform_free(state.cache[slot].path, FALSE);
+    state.cache_count--;
+    u32 hole = probe_table_remove(state.cache, state.cache_capacity, slot, vfs_cache_used, vfs_cache_hash,
+                                  vfs_cache_move);
+    kzero_memory(&state.cache[hole], sizeof(vfs_cache_entry));
+}
+
+// Resolves a normalized path through the cache. Call with the lock held.
+static i32 vfs_lookup(const char* path, vfs_file* out_file, pack_file* out_packed) {
+    u64 hash = hash_string(path, 0);
+    state.lookups++;
+
+    u32 slot = vfs_cache_find(path, hash);
+    vfs_cache_entry* entry = &state.cache[slot];
+    if (entry->path) {
+        state.cache_hits++;
+    } else {
+        if ((state.cache_count + 1) * 10 > state.cache_capacity * 7) {
+            vfs_cache_grow();
+            slot = vfs_cache_find(path, hash);
+            entry = &state.cache[slot];
+        }
+        u64 length = strlen(path) + 1;
+        entry->path = platform_allocate(length, FALSE);
+        platform_copy_memory(entry->path, path, length);
+        entry->hash = hash;
+        entry->mount = vfs_resolve(path, &entry->file, &entry->packed);
+        state.cache_count++;
+    }
+
+    *out_file = entry->file;
+    *out_packed = entry->packed;
+    return entry->mount;
+}
+
+b8 vfs_initialize() {
+    if (initialized) {
+        return TRUE;
+    }
+    kzero_memory(&state, sizeof(vfs_state));
+    if (!platform_mutex_create(&state.lock)) {
+        ERROR("Failed to create the VFS lock");
+        return FALSE;
+    }
+    vfs_cache_create(VFS_CACHE_INITIAL_CAPACITY);
+    initialized = TRUE;
+    return TRUE;
+}
+
+void vfs_shutdown() {
+    if (!initialized) {
+        return;
+    }
+    if (state.lookups > 0) {
+        INFO("VFS: %llu lookups, %llu served from the path cache (%u paths)", state.lookups, state.cache_hits,
+             state.cache_count);
+    }
+    vfs_unmount_all();
+    vfs_cache_destroy();
+    platform_mutex_destroy(&state.lock);
+    initialized = FALSE;
+}
+
+static vfs_mount* vfs_add_mount(const char* mount_point, vfs_mount_type type) {
+    if (!initialized) {
+        ERROR("vfs_initialize must be called before mounting");
+        return 0;
+    }
+    if (state.mount_count == VFS_MAX_MOUNTS) {
+        ERROR("Can't mount at '%s', already %u mounts", mount_point, VFS_MAX_MOUNTS);
+        return 0;
+    }
+    if (strlen(mount_point) >= VFS_MOUNT_POINT_MAX) {
+        ERROR("Mount point too long: %s", mount_point);
+        return 0;
+    }
+    vfs_mount* mount = &state.mounts[state.mount_count];
+    kzero_memory(mount, sizeof(vfs_mount));
+    mount->type = type;
+    strncpy(mount->mount_point, mount_point, VFS_MOUNT_POINT_MAX - 1);
+    mount->mount_point_length = (u32)strlen(mount->mount_point);
+    return mount;
+}
+
+// Makes a mount set up by vfs_add_mount visible. Earlier results may now
+// resolve differently, so the whole cache goes.
+static void vfs_commit_mount() {
+    platform_mutex_lock(&state.lock);
+    state.mount_count++;
+    platform_mutex_unlock(&state.lock);
+    vfs_invalidate_all();
+}
+
+b8 vfs_mount_directory(const char* mount_point, const char* directory) {
+    vfs_mount* mount = vfs_add_mount(mount_point, VFS_MOUNT_DIRECTORY);
+    if (!mount) {
+        return FALSE;
+    }
+    if (strlen(directory) >= VFS_PATH_MAX) {
+        ERROR("Directory path too long: %s", directory);
+        return FALSE;
+    }
+    strncpy(mount->directory, directory, VFS_PATH_MAX - 1);
+    vfs_commit_mount();
+    INFO("Mounted directory '%s' at '%s'", directory, mount_point);
+    return TRUE;
+}
+
+b8 vfs_mount_pack(const char* mount_point, const char* pack_path) {
+    vfs_mount* mount = vfs_add_mount(mount_point, VFS_MOUNT_PACK);
+    if (!mount || !pack_open(pack_path, &mount->pack)) {
+        return FALSE;
+    }
+    vfs_commit_mount();
+    INFO("Mounted pack '%s' at '%s'", pack_path, mount_point);
+    return TRUE;
+}
+
+b8 vfs_mount_memory(const char* mount_point, const vfs_memory_file* files, u32 file_count) {
+    vfs_mount* mount = vfs_add_mount(mount_point, VFS_MOUNT_MEMORY);
+    if (!mount) {
+        return FALSE;
+    }
+    mount->files = files;
+    mount->file_count = file_count;
+    vfs_commit_mount();
+    return TRUE;
+}
+
+void vfs_unmount_all() {
+    if (!initialized) {
+        return;
+    }
+    platform_mutex_lock(&state.lock);
+    for (u32 i = 0; i < state.mount_count; ++i) {
+        if (state.mounts[i].type == VFS_MOUNT_PACK) {
+            pack_close(&state.mounts[i].pack);
+        }
+    }
+    kzero_memory(state.mounts, sizeof(state.mounts));
+    state.mount_count = 0;
+    platform_mutex_unlock(&state.lock);
+    vfs_invalidate_all();
+}
+
+b8 vfs_stat(const char* path, vfs_file* out_file) {
+    vfs_file file;
+    if (!initialized) {
+        platform_file_info info;
+        if (!platform_get_file_info(path, &info)) {
+            return FALSE;
+        }
+        file = (vfs_file){VFS_MOUNT_DIRECTORY, info.size, info.modified_ns, 0, 0};
+    } else {
+        char normalized[VFS_PATH_MAX];
+        if (!vfs_normalize(path, normalized)) {
+            return FALSE;
+        }
+        pack_file packed;
+        platform_mutex_lock(&state.lock);
+        i32 mount = vfs_lookup(normalized, &file, &packed);
+        platform_mutex_unlock(&state.lock);
+        if (mount == VFS_MISS) {
+            return FALSE;
+        }
+    }
+    if (out_file) {
+        *out_file = file;
+    }
+    return TRUE;
+}
+
+b8 vfs_read(const char* path, char** out_buffer, u64* out_size) {
+    PROFILE_FUNCTION();
+    if (!initialized) {
+        return platform_read_file_to_buffer(path, out_buffer, out_size);
+    }
+
+    char normalized[VFS_PATH_MAX];
+    if (!vfs_normalize(path, normalized)) {
+        return FALSE;
+    }
+    vfs_file file;
+    pack_file packed;
+    platform_mutex_lock(&state.lock);
+    i32 mount_index = vfs_lookup(normalized, &file, &packed);
+    // Mounts only change while no loads are in flight, so the copy stays valid
+    vfs_mount mount = mount_index != VFS_MISS ? state.mounts[mount_index] : (vfs_mount){0};
+    platform_mutex_unlock(&state.lock);
+    if (mount_index == VFS_MISS) {
+        return FALSE;
+    }
+
+    if (file.type == VFS_MOUNT_DIRECTORY) {
+        char full_path[VFS_PATH_MAX * 2];
+        vfs_directory_path(&mount, normalized + mount.mount_point_length, full_path, sizeof(full_path));
+        return platform_read_file_to_buffer(full_path, out_buffer, out_size);
+    }
+
+    char* buffer = platform_allocate(file.size + 1, FALSE);
+    if (file.data) {
+        platform_copy_memory(buffer, file.data, file.size);
+    } else if (!pack_read(&packed, buffer)) {
+        platform_free(buffer, FALSE);
+        return FALSE;
+    }
+    buffer[file.size] = '\0';
+    *out_buffer = buffer;
+    *out_size = file.size;
+    return TRUE;
+}
+
+b8 vfs_real_path(const char* path, char* out_path, u64 size) {
+    if (!initialized) {
+        snprintf(out_path, size, "%s", path);
+        return TRUE;
+    }
+
+    char normalized[VFS_PATH_MAX];
+    if (!vfs_normalize(path, normalized)) {
+        return FALSE;
+    }
+    vfs_file file;
+    pack_file packed;
+    platform_mutex_lock(&state.lock);
+    i32 mount_index = vfs_lookup(normalized, &file, &packed);
+    b8 on_disk = mount_index != VFS_MISS && file.type == VFS_MOUNT_DIRECTORY;
+    if (on_disk) {
+        const vfs_mount* mount = &state.mounts[mount_index];
+        vfs_directory_path(mount, normalized + mount->mount_point_length, out_path, size);
+    }
+    platform_mutex_unlock(&state.lock);
+    return on_disk;
+}
+
+void vfs_invalidate(const char* path) {
+    char normalized[VFS_PATH_MAX];
+    if (!initialized || !vfs_normalize(path, normalized)) {
+        return;
+    }
+    platform_mutex_lock(&state.lock);
+    u32 slot = vfs_cache_find(normalized, hash_string(normalized, 0));
+    if (state.cache[slot].path) {
+        vfs_cache_remove(slot);
+    }
+    platform_mutex_unlock(&state.lock);
+}
+
+void vfs_invalidate_all() {
+    if (!initialized) {
+        return;
+    }
+    platform_mutex_lock(&state.lock);
+    u32 capacity = state.cache_capacity;
+    vfs_cache_destroy();
+    vfs_cache_create(capacity);
+    platform_mutex_unlock(&state.lock);
+}
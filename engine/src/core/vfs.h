@@ -0,0 +1,82 @@
+#pragma once
+
+#include "definitions.h"
+
+// Virtual file system. Paths resolve against an ordered list of mount points,
+// the most recent mount first: directories on disk, packs (core/pack.h) and
+// tables of files in memory. Every resolved path is cached with its size and
+// modification time, misses included, so repeated probes and stats are hash
+// lookups instead of system calls. core/file_operations.h reads through it.
+//
+// Mount and unmount from the main thread while no loads are in flight, lookups
+// and reads are safe from any thread. Before vfs_initialize every path goes
+// straight to the filesystem, uncached.
+
+#define VFS_MAX_MOUNTS 16
+#define VFS_MOUNT_POINT_MAX 64
+#define VFS_PATH_MAX 512
+#define VFS_CACHE_INITIAL_CAPACITY 256
+
+typedef enum vfs_mount_type {
+    VFS_MOUNT_DIRECTORY,
+    VFS_MOUNT_PACK,
+    VFS_MOUNT_MEMORY
+} vfs_mount_type;
+
+// A file served from memory by vfs_mount_memory, path is relative to the
+// mount point.
+typedef struct vfs_memory_file {
+    const char* path;
+    const void* data;
+    u64 size;
+} vfs_memory_file;
+
+// What a path resolved to.
+typedef struct vfs_file {
+    vfs_mount_type type;
+    u64 size;
+    // 0 for pack and memory files
+    u64 modified_ns;
+    // hash_bytes of the contents with seed 0 when known without reading them,
+    // which is for pack entries. 0 otherwise.
+    u64 content_hash;
+    // The bytes themselves for memory files and uncompressed pack entries,
+    // valid until unmounted. 0 when the file has to be read.
+    const char* data;
+    // The LZ4 block of a compressed pack entry and its size, valid until
+    // unmounted. 0 otherwise.
+    const char* compressed_data;
+    u64 compressed_size;
+} vfs_file;
+
+API b8 vfs_initialize();
+API void vfs_shutdown();
+
+// mount_point is a path prefix such as "assets/", or "" to match every path.
+// The rest of the path is looked up inside the mount.
+API b8 vfs_mount_directory(const char* mount_point, const char* directory);
+API b8 vfs_mount_pack(const char* mount_point, const char* pack_path);
+// The files array and the data it points to must outlive the mount.
+API b8 vfs_mount_memory(const char* mount_point, const vfs_memory_file* files, u32 file_count);
+API void vfs_unmount_all();
+
+// Resolves path, from the cache when it was looked up before. out_file may be
+// 0 to only test for presence.
+API b8 vfs_stat(const char* path, vfs_file* out_file);
+
+// Reads the whole file into a heap buffer released with free(). The buffer is
+// null-terminated, size excludes the terminator.
+API b8 vfs_read(const char* path, char** out_buffer, u64* out_size);
+
+// Strips leading "./" and turns backslashes into slashes, the form paths are
+// looked up in. out_path holds VFS_PATH_MAX bytes, FALSE when path is longer.
+API b8 vfs_normalize(const char* path, char* out_path);
+
+// For files found in a directory mount, writes the path on disk, e.g. to map
+// the file. FALSE for pack and memory files.
+API b8 vfs_real_path(const char* path, char* out_path, u64 size);
+
+// Drops the cached result for one path, or for every path. Needed after files
+// change behind the VFS's back, file_operations writes do it themselves.
+API void vfs_invalidate(const char* path);
+API void vfs_invalidate_all();
@@ -13,6 +13,7 @@ int main(void){
     initialize_memory();
 
     game game_instance;
+    kzero_memory(&game_instance, sizeof(game));
     if(!create_game(&game_instance)){
         FATAL("Could not create the GAME!");
         return -1;
@@ -14,8 +14,13 @@ typedef struct game {
     // fp to game update
     b8 (*update)(struct game* game_instance, f32 delta_time);
 
-    // fp to game render
-    b8 (*render)(struct game* game_instance, f32 delta_time);
+    // fp to game render. alpha is how far (0..1) the current time lies between
+    // the last two fixed update ticks, always 1.0 when fixed timestep is off.
+    b8 (*render)(struct game* game_instance, f32 delta_time, f32 alpha);
+
+    // fp to game shutdown, optional. Runs before engine systems shut down so
+    // the game can release what it holds.
+    void (*shutdown)(struct game* game_instance);
 
     // fp to window on resize function
     void (*onresize)(struct game* game_instance, u32 width, u32 height);
@@ -0,0 +1,271 @@
+#include "kmesh.h"
+#include "core/file_operations.h"
+#include "core/hash.h"
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "core/vfs.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#define KMESH_INDEX_BATCH 4096
+
+static u64 kmesh_align(u64 value) {
+    return (value + KMESH_BLOB_ALIGNMENT - 1) & ~(u64)(KMESH_BLOB_ALIGNMENT - 1);
+}
+
+// Describes the engine's vertex struct, a cache built for another layout is stale.
+static void kmesh_describe_vertex(kmesh_header* header) {
+    header->vertex_stride = sizeof(vertex);
+    header->attribute_count = 3;
+    header->attributes[0] = (kmesh_attribute){KMESH_ATTRIBUTE_POSITION, 3, offsetof(vertex, position), 0};
+    header->attributes[1] = (kmesh_attribute){KMESH_ATTRIBUTE_TEXCOORD, 2, offsetof(vertex, tex_coords), 0};
+    header->attributes[2] = (kmesh_attribute){KMESH_ATTRIBUTE_COLOR, 4, offsetof(vertex, color), 0};
+}
+
+static b8 kmesh_hash_source(const char* path, const vfs_file* source, u64* out_hash) {
+    if (source->content_hash) {
+        // Packs store it in their TOC
+        *out_hash = source->content_hash;
+        return TRUE;
+    }
+    file_view file;
+    if (!file_map_readonly(path, PLATFORM_MAP_HINT_SEQUENTIAL, &file)) {
+        return FALSE;
+    }
+    *out_hash = hash_bytes(file.data, file.size, 0);
+    file_unmap(&file);
+    return TRUE;
+}
+
+static b8 kmesh_validate(const kmesh_header* header, u64 file_size, const char* source_path) {
+    if (file_size < sizeof(kmesh_header) || header->magic != KMESH_MAGIC) {
+        WARN("Mesh cache for '%s' is not a kmesh file", source_path);
+        return FALSE;
+    }
+    if (header->version != KMESH_VERSION || header->file_size != file_size) {
+        return FALSE;
+    }
+
+    kmesh_header layout = {0};
+    kmesh_describe_vertex(&layout);
+    if (header->vertex_stride != layout.vertex_stride || header->attribute_count != layout.attribute_count ||
+        memcmp(header->attributes, layout.attributes, sizeof(kmesh_attribute) * layout.attribute_count) != 0) {
+        return FALSE;
+    }
+
+    // Guards against hash collisions between source paths
+    if (strncmp(header->source_path, source_path, KMESH_SOURCE_PATH_MAX) != 0) {
+        return FALSE;
+    }
+
+    if (header->index_size != sizeof(u16) && header->index_size != sizeof(u32)) {
+        return FALSE;
+    }
+    u64 vertex_bytes = (u64)header->vertex_count * header->vertex_stride;
+    u64 index_bytes = (u64)header->index_count * header->index_size;
+    if (header->vertex_offset % KMESH_BLOB_ALIGNMENT != 0 || header->index_offset % KMESH_BLOB_ALIGNMENT != 0 ||
+        header->vertex_offset < sizeof(kmesh_header) || header->vertex_offset + vertex_bytes > file_size ||
+        header->index_offset < header->vertex_offset + vertex_bytes || header->index_offset + index_bytes > file_size) {
+        WARN("Mesh cache for '%s' has blobs out of bounds", source_path);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void kmesh_cache_path(const char* source_path, char* out_path, u64 out_size) {
+    snprintf(out_path, out_size, "%s/%016llx.kmesh", KMESH_CACHE_DIRECTORY,
+             (unsigned long long)hash_string(source_path, 0));
+}
+
+b8 kmesh_open(const char* source_path, kmesh_view* out_view) {
+    PROFILE_FUNCTION();
+    memset(out_view, 0, sizeof(kmesh_view));
+
+    vfs_file source;
+    if (!vfs_stat(source_path, &source)) {
+        return FALSE;
+    }
+
+    char cache_path[512];
+    kmesh_cache_path(source_path, cache_path, sizeof(cache_path));
+    platform_file_mapping file;
+    if (!platform_file_map(cache_path, &file)) {
+        return FALSE;
+    }
+
+    const kmesh_header* header = (const kmesh_header*)file.data;
+    if (!file.data || !kmesh_validate(header, file.size, source_path) || header->source_size != source.size) {
+        DEBUG("Mesh cache %s is stale", cache_path);
+        platform_file_unmap(&file);
+        return FALSE;
+    }
+
+    // Pack and memory sources have no modification time, they always go by hash
+    if (source.modified_ns == 0 || header->source_modified_ns != source.modified_ns) {
+        // Touched but maybe not changed, e.g. by a checkout. Compare contents
+        // before throwing the cache away.
+        u64 source_hash;
+        if (!kmesh_hash_source(source_path, &source, &source_hash) || source_hash != header->source_hash) {
+            DEBUG("Mesh cache %s is stale", cache_path);
+            platform_file_unmap(&file);
+            return FALSE;
+        }
+        out_view->touched_modified_ns = source.modified_ns;
+    }
+
+    out_view->file = file;
+    out_view->header = header;
+    out_view->vertices = (const vertex*)(file.data + header->vertex_offset);
+    out_view->indices = file.data + header->index_offset;
+    return TRUE;
+}
+
+void kmesh_close(kmesh_view* view) {
+    char cache_path[512];
+    if (view->touched_modified_ns) {
+        kmesh_cache_path(view->header->source_path, cache_path, sizeof(cache_path));
+    }
+    platform_file_unmap(&view->file);
+
+    // Never written through while mapped, the mapping would see the write
+    FILE* update = view->touched_modified_ns ? fopen(cache_path, "r+b") : 0;
+    if (update) {
+        fseek(update, offsetof(kmesh_header, source_modified_ns), SEEK_SET);
+        fwrite(&view->touched_modified_ns, sizeof(u64), 1, update);
+        fclose(update);
+    }
+    memset(view, 0, sizeof(kmesh_view));
+}
+
+b8 kmesh_write_begin(const char* source_path, const kmesh_source* source, const vertex* vertices,
+                     u32 vertex_count, const u32* indices, u32 index_count, vec3 bounds_min, vec3 bounds_max,
+                     kmesh_writer* out_writer) {
+    PROFILE_FUNCTION();
+    memset(out_writer, 0, sizeof(kmesh_writer));
+    if (strlen(source_path) >= KMESH_SOURCE_PATH_MAX) {
+        WARN("Not caching '%s', the path is too long", source_path);
+        out_writer->failed = TRUE;
+        return FALSE;
+    }
+
+    kmesh_header* header = &out_writer->header;
+    header->magic = KMESH_MAGIC;
+    header->version = KMESH_VERSION;
+    header->source_size = source->size;
+    header->source_modified_ns = source->modified_ns;
+    header->source_hash = source->hash;
+    strncpy(header->source_path, source_path, KMESH_SOURCE_PATH_MAX - 1);
+    kmesh_describe_vertex(header);
+    header->vertex_count = vertex_count;
+    header->index_count = index_count;
+    header->index_size = vertex_count <= 0x10000 ? sizeof(u16) : sizeof(u32);
+    header->vertex_offset = kmesh_align(sizeof(kmesh_header));
+    header->index_offset = kmesh_align(header->vertex_offset + (u64)vertex_count * sizeof(vertex));
+    header->file_size = header->index_offset + (u64)index_count * header->index_size;
+    for (u32 i = 0; i < 3; ++i) {
+        header->bounds_min[i] = bounds_min.data[i];
+        header->bounds_max[i] = bounds_max.data[i];
+    }
+    out_writer->vertices = vertices;
+    out_writer->indices = indices;
+
+    if (!platform_file_exists(KMESH_CACHE_DIRECTORY)) {
+        platform_create_directory(KMESH_CACHE_DIRECTORY);
+    }
+    kmesh_cache_path(source_path, out_writer->cache_path, sizeof(out_writer->cache_path));
+    snprintf(out_writer->temp_path, sizeof(out_writer->temp_path), "%s.tmp", out_writer->cache_path);
+    out_writer->file = fopen(out_writer->temp_path, "wb");
+    if (!out_writer->file) {
+        WARN("Could not create mesh cache %s", out_writer->temp_path);
+        out_writer->failed = TRUE;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+b8 kmesh_write_step(kmesh_writer* writer) {
+    PROFILE_FUNCTION();
+    if (!writer->file) {
+        return TRUE;
+    }
+    static const u8 zeros[KMESH_BLOB_ALIGNMENT] = {0};
+    const kmesh_header* header = &writer->header;
+    u64 vertex_end = header->vertex_offset + (u64)header->vertex_count * sizeof(vertex);
+    u64 end = header->file_size - writer->written < KMESH_WRITE_STEP_BYTES ? header->file_size
+                                                                            : writer->written + KMESH_WRITE_STEP_BYTES;
+    u16 batch[KMESH_INDEX_BATCH];
+    b8 ok = TRUE;
+
+    // Walks the file layout from where the last step stopped. Steps are even
+    // and the blobs aligned, so a step never splits a u16 index.
+    while (ok && writer->written < end) {
+        u64 at = writer->written;
+        const void* bytes;
+        u64 available;
+        if (at < sizeof(kmesh_header)) {
+            bytes = (const u8*)header + at;
+            available = sizeof(kmesh_header) - at;
+        } else if (at < header->vertex_offset) {
+            bytes = zeros;
+            available = header->vertex_offset - at;
+        } else if (at < vertex_end) {
+            bytes = (const u8*)writer->vertices + (at - header->vertex_offset);
+            available = vertex_end - at;
+        } else if (at < header->index_offset) {
+            bytes = zeros;
+            available = header->index_offset - at;
+        } else if (header->index_size == sizeof(u32)) {
+            bytes = (const u8*)writer->indices + (at - header->index_offset);
+            available = header->file_size - at;
+        } else {
+            u32 first = (u32)((at - header->index_offset) / sizeof(u16));
+            u32 count = header->index_count - first < KMESH_INDEX_BATCH ? header->index_count - first
+                                                                         : KMESH_INDEX_BATCH;
+            for (u32 i = 0; i < count; ++i) {
+                batch[i] = (u16)writer->indices[first + i];
+            }
+            bytes = batch;
+            available = (u64)count * sizeof(u16);
+        }
+        u64 size = end - at < available ? end - at : available;
+        ok = fwrite(bytes, size, 1, writer->file) == 1;
+        writer->written += size;
+    }
+
+    if (ok && writer->written < header->file_size) {
+        return FALSE;
+    }
+    ok = (fclose(writer->file) == 0) && ok;
+    writer->file = 0;
+    if (!ok || rename(writer->temp_path, writer->cache_path) != 0) {
+        WARN("Could not write mesh cache %s", writer->cache_path);
+        platform_delete_file(writer->temp_path);
+        writer->failed = TRUE;
+        return TRUE;
+    }
+    INFO("Wrote mesh cache %s (%llu bytes)", writer->cache_path, header->file_size);
+    return TRUE;
+}
+
+void kmesh_write_abort(kmesh_writer* writer) {
+    if (writer->file) {
+        fclose(writer->file);
+        writer->file = 0;
+        platform_delete_file(writer->temp_path);
+    }
+    writer->failed = TRUE;
+}
+
+b8 kmesh_write(const char* source_path, const kmesh_source* source, const vertex* vertices, u32 vertex_count,
+               const u32* indices, u32 index_count, vec3 bounds_min, vec3 bounds_max) {
+    kmesh_writer writer;
+    if (!kmesh_write_begin(source_path, source, vertices, vertex_count, indices, index_count, bounds_min,
+                           bounds_max, &writer)) {
+        return FALSE;
+    }
+    while (!kmesh_write_step(&writer)) {
+    }
+    return !writer.failed;
+}
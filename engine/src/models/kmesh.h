@@ -0,0 +1,126 @@
+#pragma once
+
+#include "definitions.h"
+#include "platform/platform.h"
+#include "renderer/renderer_types.inl"
+
+// Binary mesh cache. The first load of a source model writes its processed
+// vertex and index buffers to KMESH_CACHE_DIRECTORY, later loads map the cache
+// and upload straight from the mapping instead of parsing the source again.
+//
+// File layout: kmesh_header, then the vertex blob at vertex_offset and the index
+// blob at index_offset, both KMESH_BLOB_ALIGNMENT aligned.
+
+#define KMESH_MAGIC 0x48534D4Bu // "KMSH"
+// Bump when the header or blob layout changes, older caches are rebuilt.
+#define KMESH_VERSION 1
+#define KMESH_CACHE_DIRECTORY "cache"
+#define KMESH_BLOB_ALIGNMENT 16
+#define KMESH_MAX_ATTRIBUTES 8
+#define KMESH_SOURCE_PATH_MAX 256
+
+typedef enum kmesh_attribute_semantic {
+    KMESH_ATTRIBUTE_POSITION,
+    KMESH_ATTRIBUTE_TEXCOORD,
+    KMESH_ATTRIBUTE_COLOR
+} kmesh_attribute_semantic;
+
+// One f32 vector attribute of the vertex blob.
+typedef struct kmesh_attribute {
+    u32 semantic;
+    u32 components;
+    u32 offset;
+    u32 reserved;
+} kmesh_attribute;
+
+typedef struct kmesh_header {
+    u32 magic;
+    u32 version;
+    // Size of the whole cache file, catches truncated writes
+    u64 file_size;
+
+    // The source the cache was built from, resolved through the VFS. A cache is
+    // current when size and modification time match, or the content hash does
+    // after a touch or for sources in packs.
+    u64 source_size;
+    u64 source_modified_ns;
+    u64 source_hash;
+    char source_path[KMESH_SOURCE_PATH_MAX];
+
+    // Vertex layout, must match the engine's vertex struct to be used
+    u32 vertex_stride;
+    u32 attribute_count;
+    kmesh_attribute attributes[KMESH_MAX_ATTRIBUTES];
+
+    u32 vertex_count;
+    u32 index_count;
+    // 2 or 4 bytes per index
+    u32 index_size;
+    u32 reserved;
+    u64 vertex_offset;
+    u64 index_offset;
+
+    f32 bounds_min[3];
+    f32 bounds_max[3];
+} kmesh_header;
+
+// A mapped cache file. The pointers stay valid until kmesh_close.
+typedef struct kmesh_view {
+    platform_file_mapping file;
+    const kmesh_header* header;
+    const vertex* vertices;
+    const void* indices;
+    // Nonzero when the source was touched but not changed. kmesh_close stores
+    // it in the header once the file is unmapped, so the next open skips the hash.
+    u64 touched_modified_ns;
+} kmesh_view;
+
+// Writes the cache file path for source_path into out_path.
+API void kmesh_cache_path(const char* source_path, char* out_path, u64 out_size);
+
+// Maps the cache of source_path if one exists and is still current.
+API b8 kmesh_open(const char* source_path, kmesh_view* out_view);
+API void kmesh_close(kmesh_view* view);
+
+// What the cache records about its source. Captured when the source is parsed,
+// so writing the cache later doesn't have to read the source again.
+typedef struct kmesh_source {
+    u64 size;
+    // 0 for pack and memory files
+    u64 modified_ns;
+    // hash_bytes of the contents with seed 0
+    u64 hash;
+} kmesh_source;
+
+// Bytes a kmesh_write_step writes at most.
+#define KMESH_WRITE_STEP_BYTES (64 * 1024)
+
+// A cache file being written a step at a time. vertices and indices are not
+// copied and must stay valid until the write finishes.
+typedef struct kmesh_writer {
+    kmesh_header header;
+    const vertex* vertices;
+    const u32* indices;
+    void* file;
+    u64 written;
+    b8 failed;
+    char cache_path[512];
+    char temp_path[520];
+} kmesh_writer;
+
+// Starts writing the cache for source_path. Indices are stored as u16 when
+// every vertex fits. The file is written under a temporary name and renamed
+// into place once complete, so a crash never leaves a half-written cache
+// behind. Returns FALSE if the file can't be created.
+API b8 kmesh_write_begin(const char* source_path, const kmesh_source* source, const vertex* vertices,
+                         u32 vertex_count, const u32* indices, u32 index_count, vec3 bounds_min, vec3 bounds_max,
+                         kmesh_writer* out_writer);
+// Writes up to KMESH_WRITE_STEP_BYTES more. Returns TRUE once the write is
+// finished, writer->failed tells whether the cache was written.
+API b8 kmesh_write_step(kmesh_writer* writer);
+// Stops an unfinished write and deletes the temporary file.
+API void kmesh_write_abort(kmesh_writer* writer);
+
+// Writes the whole cache in one go.
+API b8 kmesh_write(const char* source_path, const kmesh_source* source, const vertex* vertices, u32 vertex_count,
+                   const u32* indices, u32 index_count, vec3 bounds_min, vec3 bounds_max);
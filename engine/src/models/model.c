@@ -3,34 +3,32 @@
 #include "core/file_operations.h"
 #include "core/kstring.h"
 #include "renderer/renderer_frontend.h"
-#include "resources/texture.h"
+#include "resources/resource_manager.h"
 #include "containers/darray.h"
+#include "core/profiler.h"
+#include "models/obj_parser.h"
+#include "models/kmesh.h"
+#include "core/idle_tasks.h"
+#include "core/vfs.h"
+#include "platform/platform.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// Temporary structures for OBJ loading
-typedef struct {
-    f32 x, y, z;
-} obj_vertex;
+// Open-addressing map from an OBJ (position, texcoord, normal) index triple to
+// the model vertex built from it. vertex_index is stored plus one so a zeroed
+// slot is empty.
+typedef struct vertex_dedup_slot {
+    obj_face_vertex key;
+    u32 vertex_index;
+} vertex_dedup_slot;
 
-typedef struct {
-    f32 u, v;
-} obj_texcoord;
-
-typedef struct {
-    f32 x, y, z;
-} obj_normal;
-
-typedef struct {
-    u32 v_index;  // Vertex index
-    u32 t_index;  // Texture coordinate index
-    u32 n_index;  // Normal index
-} obj_face_vertex;
-
-typedef struct {
-    obj_face_vertex vertices[3]; // Triangle face
-} obj_face;
+static inline u64 vertex_dedup_hash(const obj_face_vertex* key) {
+    u64 hash = key->v_index * 0x9E3779B97F4A7C15ull;
+    hash ^= (key->t_index + 0x632BE59BD9B4E019ull) * 0xC2B2AE3D27D4EB4Full;
+    hash ^= (key->n_index + 0x165667B19E3779F9ull) * 0x85EBCA77C2B2AE63ull;
+    return hash ^ (hash >> 29);
+}
 
 // Global model manager state
 static u32 next_model_id = 0;
@@ -43,173 +41,10 @@ static u32 next_model_id = 0;
 // static void unregister_model(model* m);
 static char* extract_filename(const char* path);
 
-model* model_load_obj(const char* file_path) {
-    INFO("Loading OBJ model: %s", file_path);
-    
-    FILE* file = fopen(file_path, "r");
-    if (!file) {
-        ERROR("Failed to open OBJ file: %s", file_path);
-        return NULL;
-    }
-    
-    // Create darrays for temporary storage
-    void* vertices = darray_create(obj_vertex);
-    void* texcoords = darray_create(obj_texcoord);
-    void* normals = darray_create(obj_normal);
-    void* faces = darray_create(obj_face);
-    
-    char line[1024];
-    while (fgets(line, sizeof(line), file)) {
-        // Remove newline character
-        size_t len = strlen(line);
-        if (len > 0 && line[len-1] == '\n') {
-            line[len-1] = '\0';
-        }
-        
-        // Process based on line type
-        if (line[0] == 'v' && line[1] == ' ') {
-            // Vertex
-            obj_vertex v;
-            if (sscanf(line, "v %f %f %f", &v.x, &v.y, &v.z) == 3) {
-                darray_push(vertices, v);
-            }
-        } else if (line[0] == 'v' && line[1] == 't' && line[2] == ' ') {
-            // Texture coordinate
-            obj_texcoord t;
-            if (sscanf(line, "vt %f %f", &t.u, &t.v) == 2) {
-                darray_push(texcoords, t);
-            }
-        } else if (line[0] == 'v' && line[1] == 'n' && line[2] == ' ') {
-            // Normal
-            obj_normal n;
-            if (sscanf(line, "vn %f %f %f", &n.x, &n.y, &n.z) == 3) {
-                darray_push(normals, n);
-            }
-        } else if (line[0] == 'f' && line[1] == ' ') {
-            // Face - support both triangles and quads
-            int v1, t1, n1, v2, t2, n2, v3, t3, n3, v4, t4, n4;
-            int matches = sscanf(line, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d",
-                &v1, &t1, &n1, &v2, &t2, &n2, &v3, &t3, &n3, &v4, &t4, &n4);
-            
-            if (matches == 9) {
-                // Triangle
-                obj_face f;
-                // OBJ indices are 1-based, convert to 0-based
-                f.vertices[0].v_index = v1 - 1;
-                f.vertices[0].t_index = t1 - 1;
-                f.vertices[0].n_index = n1 - 1;
-                
-                f.vertices[1].v_index = v2 - 1;
-                f.vertices[1].t_index = t2 - 1;
-                f.vertices[1].n_index = n2 - 1;
-                
-                f.vertices[2].v_index = v3 - 1;
-                f.vertices[2].t_index = t3 - 1;
-                f.vertices[2].n_index = n3 - 1;
-                
-                darray_push(faces, f);
-            } else if (matches == 12) {
-                // Quad - split into two triangles
-                obj_face f1, f2;
-                
-                // First triangle (v1, v2, v3)
-                f1.vertices[0].v_index = v1 - 1;
-                f1.vertices[0].t_index = t1 - 1;
-                f1.vertices[0].n_index = n1 - 1;
-                
-                f1.vertices[1].v_index = v2 - 1;
-                f1.vertices[1].t_index = t2 - 1;
-                f1.vertices[1].n_index = n2 - 1;
-                
-                f1.vertices[2].v_index = v3 - 1;
-                f1.vertices[2].t_index = t3 - 1;
-                f1.vertices[2].n_index = n3 - 1;
-                
-                // Second triangle (v1, v3, v4)
-                f2.vertices[0].v_index = v1 - 1;
-                f2.vertices[0].t_index = t1 - 1;
-                f2.vertices[0].n_index = n1 - 1;
-                
-                f2.vertices[1].v_index = v3 - 1;
-                f2.vertices[1].t_index = t3 - 1;
-                f2.vertices[1].n_index = n3 - 1;
-                
-                f2.vertices[2].v_index = v4 - 1;
-                f2.vertices[2].t_index = t4 - 1;
-                f2.vertices[2].n_index = n4 - 1;
-                
-                darray_push(faces, f1);
-                darray_push(faces, f2);
-            } else {
-                // Try alternative format: f v//n v//n v//n
-                matches = sscanf(line, "f %d//%d %d//%d %d//%d",
-                    &v1, &n1, &v2, &n2, &v3, &n3);
-                
-                if (matches == 6) {
-                    obj_face f;
-                    f.vertices[0].v_index = v1 - 1;
-                    f.vertices[0].t_index = 0; // No texture coords
-                    f.vertices[0].n_index = n1 - 1;
-                    
-                    f.vertices[1].v_index = v2 - 1;
-                    f.vertices[1].t_index = 0;
-                    f.vertices[1].n_index = n2 - 1;
-                    
-                    f.vertices[2].v_index = v3 - 1;
-                    f.vertices[2].t_index = 0;
-                    f.vertices[2].n_index = n3 - 1;
-                    
-                    darray_push(faces, f);
-                } else {
-                    // Try another format: f v v v
-                    matches = sscanf(line, "f %d %d %d", &v1, &v2, &v3);
-                    
-                    if (matches == 3) {
-                        obj_face f;
-                        f.vertices[0].v_index = v1 - 1;
-                        f.vertices[0].t_index = 0;
-                        f.vertices[0].n_index = 0;
-                        
-                        f.vertices[1].v_index = v2 - 1;
-                        f.vertices[1].t_index = 0;
-                        f.vertices[1].n_index = 0;
-                        
-                        f.vertices[2].v_index = v3 - 1;
-                        f.vertices[2].t_index = 0;
-                        f.vertices[2].n_index = 0;
-                        
-                        darray_push(faces, f);
-                    }
-                }
-            }
-        }
-    }
-    
-    fclose(file);
-    
-    u64 vertex_count = darray_length(vertices);
-    u64 texcoord_count = darray_length(texcoords);
-    u64 normal_count = darray_length(normals);
-    u64 face_count = darray_length(faces);
-    
-    INFO("OBJ loaded: %llu vertices, %llu texcoords, %llu normals, %llu faces",
-         vertex_count, texcoord_count, normal_count, face_count);
-    
-    if (face_count == 0) {
-        ERROR("No faces found in OBJ file");
-        darray_destroy(vertices);
-        darray_destroy(texcoords);
-        darray_destroy(normals);
-        darray_destroy(faces);
-        return NULL;
-    }
-    
-    // Create the model
+// Allocates a model named after the file and finds its texture.
+static model* model_create(const char* file_path) {
     model* m = kallocate(sizeof(model), MEMORY_TAG_MODEL);
     m->id = next_model_id++;
-    m->vertex_count = (u32)(face_count * 3); // Each face has 3 vertices
-    m->vertices = kallocate(sizeof(vertex) * m->vertex_count, MEMORY_TAG_MODEL);
-    m->is_indexed = FALSE;
     m->texture = NULL;  // Initialize texture pointer to NULL
     
     // Extract filename for model name
@@ -217,90 +52,280 @@ model* model_load_obj(const char* file_path) {
     strncpy(m->name, filename, sizeof(m->name) - 1);
     m->name[sizeof(m->name) - 1] = '\0'; // Ensure null termination
     
-    // Try to load a texture for this model
-    // First, check if a texture with the same name as the model exists
+    // Try to load a texture with the same name as the model. Candidates are
+    // checked with file_exists first, a TOC probe when the assets are packed.
+    // Models sharing a name share the texture, which streams in after the
+    // model is already drawn with a placeholder. Containers made by
+    // tools/texconv come first, they need no decode.
+    static const char* texture_extensions[] = {"ktex", "png", "jpg"};
     char texture_path[512];
-    snprintf(texture_path, sizeof(texture_path), "assets/textures/%s.png", filename);
+    resource_handle tex = INVALID_RESOURCE_HANDLE;
+    for (u32 i = 0; !tex && i < sizeof(texture_extensions) / sizeof(texture_extensions[0]); i++) {
+        snprintf(texture_path, sizeof(texture_path), "assets/textures/%s.%s", filename, texture_extensions[i]);
+        if (file_exists(texture_path)) {
+            tex = resource_acquire_async(RESOURCE_TYPE_TEXTURE, texture_path);
+        }
+    }
     
-    // Try to load the texture
-    texture* tex = texture_load(texture_path);
     if (!tex) {
-        // Try jpg format if png failed
-        snprintf(texture_path, sizeof(texture_path), "assets/textures/%s.jpg", filename);
-        tex = texture_load(texture_path);
+        // Every untextured model shares one checkerboard
+        tex = resource_acquire_checkerboard();
         
         if (!tex) {
-            // Fall back to a default texture or create a checkerboard pattern
-            INFO("Creating default checkerboard texture for model %s", filename);
-            tex = texture_create_default_checkerboard();
-            
-            if (!tex) {
-                WARN("Could not create default texture for model %s. Model will use color data only.", filename);
-            } else {
-                INFO("Using default checkerboard texture for model %s", filename);
-            }
+            WARN("Could not create default texture for model %s. Model will use color data only.", filename);
         } else {
-            INFO("Loaded texture %s for model %s", texture_path, filename);
+            INFO("Using default checkerboard texture for model %s", filename);
         }
     } else {
         INFO("Loaded texture %s for model %s", texture_path, filename);
     }
     
-    m->texture = tex;
+    m->texture_handle = tex;
+    m->texture = resource_get_texture(tex);
     
     kfree(filename, strlen(filename) + 1, MEMORY_TAG_STRING);
+    return m;
+}
+
+// Builds the model from its mesh cache, uploading straight from the mapping.
+static model* model_load_cached(const char* file_path) {
+    kmesh_view cache;
+    if (!kmesh_open(file_path, &cache)) {
+        return NULL;
+    }
+    
+    model* m = model_create(file_path);
+    m->vertex_count = cache.header->vertex_count;
+    m->index_count = cache.header->index_count;
+    m->is_indexed = TRUE;
+    for (u32 i = 0; i < 3; i++) {
+        m->bounds_min.data[i] = cache.header->bounds_min[i];
+        m->bounds_max.data[i] = cache.header->bounds_max[i];
+    }
+    m->mesh = renderer_create_indexed_mesh(cache.vertices, m->vertex_count, cache.indices, m->index_count,
+                                           cache.header->index_size);
+    kmesh_close(&cache);
+    
+    INFO("Model '%s' loaded from mesh cache with ID %u: %u vertices, %u indices", m->name, m->id, m->vertex_count,
+         m->index_count);
+    return m;
+}
+
+// A mesh cache write queued for idle time. The path, vertices and indices are
+// copied into the same allocation, the model may be gone before it runs.
+typedef struct kmesh_cache_write {
+    u64 size;
+    char* path;
+    vertex* vertices;
+    u32 vertex_count;
+    u32* indices;
+    u32 index_count;
+    vec3 bounds_min;
+    vec3 bounds_max;
+    kmesh_source source;
+    b8 started;
+    kmesh_writer writer;
+} kmesh_cache_write;
+
+static void kmesh_cache_write_drop(void* user_data) {
+    kmesh_cache_write* write = user_data;
+    kmesh_write_abort(&write->writer);
+    kfree(write, write->size, MEMORY_TAG_MODEL);
+}
+
+// Writes the file a step at a time until deadline, so a big mesh spreads over
+// several frames' idle time.
+static b8 kmesh_cache_write_run(void* user_data, f64 deadline, f32* out_progress) {
+    kmesh_cache_write* write = user_data;
+    if (!write->started) {
+        write->started = TRUE;
+        if (!kmesh_write_begin(write->path, &write->source, write->vertices, write->vertex_count, write->indices,
+                               write->index_count, write->bounds_min, write->bounds_max, &write->writer)) {
+            kmesh_cache_write_drop(write);
+            *out_progress = 1.0f;
+            return TRUE;
+        }
+    }
+
+    b8 done;
+    do {
+        done = kmesh_write_step(&write->writer);
+    } while (!done && platform_get_absolute_time() < deadline);
+    if (!done) {
+        *out_progress = (f32)((f64)write->writer.written / (f64)write->writer.header.file_size);
+        return FALSE;
+    }
+    kmesh_cache_write_drop(write);
+    *out_progress = 1.0f;
+    return TRUE;
+}
+
+// Later loads map the cache instead of parsing the OBJ again. Writing it
+// isn't needed for this load, so it waits for the frame's idle time.
+static void model_queue_cache_write(const char* file_path, const kmesh_source* source, const model* m) {
+    u64 path_size = string_length(file_path) + 1;
+    u64 vertices_size = sizeof(vertex) * m->vertex_count;
+    u64 indices_size = sizeof(u32) * m->index_count;
+    u64 size = sizeof(kmesh_cache_write) + vertices_size + indices_size + path_size;
+    kmesh_cache_write* write = kallocate(size, MEMORY_TAG_MODEL);
+    write->size = size;
+    write->vertices = (vertex*)(write + 1);
+    write->indices = (u32*)((u8*)write->vertices + vertices_size);
+    write->path = (char*)write->indices + indices_size;
+    kcopy_memory(write->vertices, m->vertices, vertices_size);
+    kcopy_memory(write->indices, m->indices, indices_size);
+    kcopy_memory(write->path, file_path, path_size);
+    write->vertex_count = m->vertex_count;
+    write->index_count = m->index_count;
+    write->bounds_min = m->bounds_min;
+    write->bounds_max = m->bounds_max;
+    write->source = *source;
+
+    if (idle_tasks_submit("mesh cache write", kmesh_cache_write_run, kmesh_cache_write_drop, write) ==
+        INVALID_IDLE_TASK_ID) {
+        // No idle queue, outside the application loop or full
+        while (!kmesh_cache_write_run(write, 0, &(f32){0})) {
+        }
+    }
+}
+
+model* model_load_obj(const char* file_path) {
+    PROFILE_FUNCTION();
+    INFO("Loading OBJ model: %s", file_path);
+    
+    model* cached = model_load_cached(file_path);
+    if (cached) {
+        return cached;
+    }
+    
+    // Stat before parsing, a change made in between then fails the cache's
+    // hash check instead of going unnoticed
+    vfs_file stat;
+    kmesh_source source = {0};
+    if (vfs_stat(file_path, &stat)) {
+        source.modified_ns = stat.modified_ns;
+    }
+    obj_data obj;
+    if (!obj_parse(file_path, &obj)) {
+        return NULL;
+    }
+    source.size = obj.source_size;
+    source.hash = obj.source_hash;
     
-    // Convert faces to vertices
-    obj_vertex* obj_vertices = (obj_vertex*)vertices;
-    obj_texcoord* obj_texcoords = (obj_texcoord*)texcoords;
-    obj_normal* obj_normals = (obj_normal*)normals;
-    obj_face* obj_faces = (obj_face*)faces;
+    u64 vertex_count = darray_length(obj.vertices);
+    u64 texcoord_count = darray_length(obj.texcoords);
+    u64 normal_count = darray_length(obj.normals);
+    u64 face_count = darray_length(obj.faces);
+    
+    INFO("OBJ loaded: %llu vertices, %llu texcoords, %llu normals, %llu faces",
+         vertex_count, texcoord_count, normal_count, face_count);
+    
+    if (face_count == 0) {
+        ERROR("No faces found in OBJ file");
+        obj_data_destroy(&obj);
+        return NULL;
+    }
+    if (vertex_count == 0) {
+        // Bad position indices fall back to vertex 0, which doesn't exist here
+        ERROR("OBJ file %s has faces but no vertices", file_path);
+        obj_data_destroy(&obj);
+        return NULL;
+    }
+    
+    // Create the model
+    model* m = model_create(file_path);
+    m->index_count = (u32)(face_count * 3); // Each face has 3 vertices
+    m->indices = kallocate(sizeof(u32) * m->index_count, MEMORY_TAG_MODEL);
+    m->is_indexed = TRUE;
+    
+    // Convert faces to indexed vertices. Corners that share the same position,
+    // texcoord and normal become one vertex.
+    obj_vertex* obj_vertices = obj.vertices;
+    obj_texcoord* obj_texcoords = obj.texcoords;
+    obj_face* obj_faces = obj.faces;
+    
+    u64 slot_count = 16;
+    while (slot_count < (u64)m->index_count * 2) {
+        slot_count <<= 1;
+    }
+    vertex_dedup_slot* slots = kallocate(sizeof(vertex_dedup_slot) * slot_count, MEMORY_TAG_MODEL);
+    // Worst case every corner is unique, trimmed to size below
+    vertex* unique = kallocate(sizeof(vertex) * m->index_count, MEMORY_TAG_MODEL);
+    u32 unique_count = 0;
     
     for (u32 i = 0; i < face_count; i++) {
         for (u32 j = 0; j < 3; j++) {
-            u32 vertex_index = i * 3 + j;
-            u32 v_idx = obj_faces[i].vertices[j].v_index;
-            u32 t_idx = obj_faces[i].vertices[j].t_index;
-            u32 n_idx = obj_faces[i].vertices[j].n_index;
+            obj_face_vertex key = obj_faces[i].vertices[j];
             
             // Ensure indices are valid
-            if (v_idx >= vertex_count) {
-                WARN("Invalid vertex index: %u (max: %llu)", v_idx, vertex_count - 1);
-                v_idx = 0;
+            if (key.v_index >= vertex_count) {
+                WARN("Invalid vertex index: %u (max: %llu)", key.v_index, vertex_count - 1);
+                key.v_index = 0;
             }
+            if (key.t_index >= texcoord_count) {
+                key.t_index = OBJ_INDEX_NONE;
+            }
+            if (key.n_index >= normal_count) {
+                key.n_index = OBJ_INDEX_NONE;
+            }
+            
+            u64 slot = vertex_dedup_hash(&key) & (slot_count - 1);
+            while (slots[slot].vertex_index != 0 &&
+                   (slots[slot].key.v_index != key.v_index || slots[slot].key.t_index != key.t_index ||
+                    slots[slot].key.n_index != key.n_index)) {
+                slot = (slot + 1) & (slot_count - 1);
+            }
+            if (slots[slot].vertex_index != 0) {
+                m->indices[i * 3 + j] = slots[slot].vertex_index - 1;
+                continue;
+            }
+            
+            vertex* v = &unique[unique_count];
+            slots[slot].key = key;
+            slots[slot].vertex_index = ++unique_count;
+            m->indices[i * 3 + j] = unique_count - 1;
             
             // Position
-            m->vertices[vertex_index].position.x = obj_vertices[v_idx].x;
-            m->vertices[vertex_index].position.y = obj_vertices[v_idx].y;
-            m->vertices[vertex_index].position.z = obj_vertices[v_idx].z;
+            v->position.x = obj_vertices[key.v_index].x;
+            v->position.y = obj_vertices[key.v_index].y;
+            v->position.z = obj_vertices[key.v_index].z;
+            for (u32 k = 0; k < 3; k++) {
+                if (unique_count == 1 || v->position.data[k] < m->bounds_min.data[k]) m->bounds_min.data[k] = v->position.data[k];
+                if (unique_count == 1 || v->position.data[k] > m->bounds_max.data[k]) m->bounds_max.data[k] = v->position.data[k];
+            }
             
             // Texture coordinates
-            if (texcoord_count > 0 && t_idx < texcoord_count) {
-                m->vertices[vertex_index].tex_coords.x = obj_texcoords[t_idx].u;
-                m->vertices[vertex_index].tex_coords.y = obj_texcoords[t_idx].v;
+            if (key.t_index != OBJ_INDEX_NONE) {
+                v->tex_coords.x = obj_texcoords[key.t_index].u;
+                v->tex_coords.y = obj_texcoords[key.t_index].v;
             } else {
                 // Default texture coordinates
-                m->vertices[vertex_index].tex_coords.x = 0.0f;
-                m->vertices[vertex_index].tex_coords.y = 0.0f;
+                v->tex_coords.x = 0.0f;
+                v->tex_coords.y = 0.0f;
             }
             
             // Color (default to white)
-            m->vertices[vertex_index].color.x = 1.0f; // R
-            m->vertices[vertex_index].color.y = 1.0f; // G
-            m->vertices[vertex_index].color.z = 1.0f; // B
-            m->vertices[vertex_index].color.w = 1.0f; // A
+            v->color.x = 1.0f; // R
+            v->color.y = 1.0f; // G
+            v->color.z = 1.0f; // B
+            v->color.w = 1.0f; // A
             
-            // Normals
-            if (normal_count > 0 && n_idx < normal_count) {
-                // We could store these in the vertex structure if needed
-                // For now, we're using flat shading
-            }
+            // Normals are part of the key so vertices stay distinct once the
+            // vertex structure stores them. For now, we're using flat shading
         }
     }
     
+    m->vertex_count = unique_count;
+    m->vertices = kallocate(sizeof(vertex) * unique_count, MEMORY_TAG_MODEL);
+    kcopy_memory(m->vertices, unique, sizeof(vertex) * unique_count);
+    kfree(unique, sizeof(vertex) * m->index_count, MEMORY_TAG_MODEL);
+    kfree(slots, sizeof(vertex_dedup_slot) * slot_count, MEMORY_TAG_MODEL);
+    INFO("Model '%s': %u unique vertices for %u corners", m->name, m->vertex_count, m->index_count);
+    
     // Create mesh for rendering
-    m->mesh = renderer_create_mesh(m->vertices, m->vertex_count);
-   
+    m->mesh = renderer_create_indexed_mesh(m->vertices, m->vertex_count, m->indices, m->index_count, sizeof(u32));
+    
+    model_queue_cache_write(file_path, &source, m);
     
     // Register the model
     // register_model(m);
@@ -308,10 +333,7 @@ model* model_load_obj(const char* file_path) {
     INFO("%s Model '%s' loaded successfully with ID %u", __FILE__, m->name, m->id);
     
     // Free temporary storage
-    darray_destroy(vertices);
-    darray_destroy(texcoords);
-    darray_destroy(normals);
-    darray_destroy(faces);
+    obj_data_destroy(&obj);
     
     return m;
 }
@@ -327,10 +349,8 @@ void model_destroy(model* m) {
         renderer_destroy_mesh(m->mesh);
     }
     
-    // Destroy texture
-    if (m->texture) {
-        texture_destroy(m->texture);
-    }
+    // Drop the texture reference, it may be shared with other models
+    resource_release(m->texture_handle);
     
     // Free vertex data
     if (m->vertices) {
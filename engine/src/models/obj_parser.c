@@ -0,0 +1,512 @@
+#include "obj_parser.h"
+
+#include "containers/darray.h"
+#include "core/job_system.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "core/file_operations.h"
+#include "core/hash.h"
+#include "platform/platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Growable array for chunk output. Chunks are parsed on job threads, where
+// kallocate's stats can't be touched, so these go straight to the platform.
+typedef struct obj_buffer {
+    void* data;
+    u64 count;
+    u64 capacity;
+} obj_buffer;
+
+static void* obj_buffer_push(obj_buffer* buffer, u64 stride) {
+    if (buffer->count == buffer->capacity) {
+        u64 capacity = buffer->capacity ? buffer->capacity * 2 : 1024;
+        void* data = platform_allocate(capacity * stride, FALSE);
+        if (buffer->data) {
+            platform_copy_memory(data, buffer->data, buffer->count * stride);
+            platform_free(buffer->data, FALSE);
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+    return (u8*)buffer->data + stride * buffer->count++;
+}
+
+static void obj_buffer_free(obj_buffer* buffer) {
+    if (buffer->data) {
+        platform_free(buffer->data, FALSE);
+    }
+    kzero_memory(buffer, sizeof(obj_buffer));
+}
+
+typedef struct obj_chunk {
+    const char* begin;
+    const char* end;
+    obj_buffer vertices;
+    obj_buffer texcoords;
+    obj_buffer normals;
+    obj_buffer faces;
+    // A negative (relative) index was seen. Those depend on how many vertices
+    // came before, which a chunk doesn't know, so the file is reparsed whole.
+    b8 relative_indices;
+    // Output offsets of this chunk, from prefix sums over the chunk counts.
+    u64 vertex_offset;
+    u64 texcoord_offset;
+    u64 normal_offset;
+    u64 face_offset;
+} obj_chunk;
+
+typedef struct obj_parse_job {
+    obj_chunk* chunks;
+    obj_data* out_data;
+} obj_parse_job;
+
+static inline b8 obj_is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* obj_skip_space(const char* p, const char* end) {
+    while (p < end && obj_is_space(*p)) p++;
+    return p;
+}
+
+// Exact powers of ten for the fast float path
+static const f64 obj_powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Parses [sign] digits [. digits] [e [sign] digits] without a locale, leaving
+// *p after the number. Anything else (nan, inf, hex floats, very long mantissas)
+// goes through strtod.
+static b8 obj_parse_float(const char** p, const char* end, f32* out_value) {
+    const char* s = obj_skip_space(*p, end);
+    const char* start = s;
+    b8 negative = FALSE;
+    if (s < end && (*s == '-' || *s == '+')) {
+        negative = *s == '-';
+        s++;
+    }
+
+    u64 mantissa = 0;
+    i32 digits = 0;
+    i32 exponent = 0;
+    while (s < end && *s >= '0' && *s <= '9') {
+        mantissa = mantissa * 10 + (u64)(*s++ - '0');
+        digits++;
+    }
+    if (s < end && *s == '.') {
+        s++;
+        while (s < end && *s >= '0' && *s <= '9') {
+            mantissa = mantissa * 10 + (u64)(*s++ - '0');
+            digits++;
+            exponent--;
+        }
+    }
+    if (digits == 0 || digits > 19) {
+        goto slow_path;
+    }
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        s++;
+        b8 exponent_negative = FALSE;
+        if (s < end && (*s == '-' || *s == '+')) {
+            exponent_negative = *s == '-';
+            s++;
+        }
+        i32 value = 0;
+        if (s >= end || *s < '0' || *s > '9') {
+            goto slow_path;
+        }
+        while (s < end && *s >= '0' && *s <= '9') {
+            if (value < 10000) value = value * 10 + (*s - '0');
+            s++;
+        }
+        exponent += exponent_negative ? -value : value;
+    }
+    if (s < end && !obj_is_space(*s) && *s != '\n' && *s != '/') {
+        goto slow_path;
+    }
+    if (exponent < -22 || exponent > 22) {
+        goto slow_path;
+    }
+
+    f64 value = (f64)mantissa;
+    value = exponent < 0 ? value / obj_powers_of_ten[-exponent] : value * obj_powers_of_ten[exponent];
+    *out_value = (f32)(negative ? -value : value);
+    *p = s;
+    return TRUE;
+
+slow_path: {
+    // strtod needs a terminated string, the mapped file has none
+    char text[64];
+    u64 length = 0;
+    while (start + length < end && length < sizeof(text) - 1 && !obj_is_space(start[length]) && start[length] != '\n') {
+        text[length] = start[length];
+        length++;
+    }
+    text[length] = '\0';
+    char* parsed_end;
+    f64 parsed = strtod(text, &parsed_end);
+    if (parsed_end == text) {
+        return FALSE;
+    }
+    *out_value = (f32)parsed;
+    *p = start + (parsed_end - text);
+    return TRUE;
+}
+}
+
+static b8 obj_parse_int(const char** p, const char* end, i64* out_value) {
+    const char* s = *p;
+    b8 negative = FALSE;
+    if (s < end && (*s == '-' || *s == '+')) {
+        negative = *s == '-';
+        s++;
+    }
+    if (s >= end || *s < '0' || *s > '9') {
+        return FALSE;
+    }
+    i64 value = 0;
+    while (s < end && *s >= '0' && *s <= '9') {
+        value = value * 10 + (*s++ - '0');
+    }
+    *out_value = negative ? -value : value;
+    *p = s;
+    return TRUE;
+}
+
+// Converts a 1-based OBJ index to 0-based. Negative indices count back from the
+// end of what this chunk has read so far, FALSE if that goes past its start.
+static inline b8 obj_resolve_index(i64 index, u64 count, u32* out_index) {
+    if (index < 0) {
+        // Only resolvable if this chunk starts at the top of the file
+        if ((i64)count + index < 0) {
+            *out_index = OBJ_INDEX_NONE;
+            return FALSE;
+        }
+        *out_index = (u32)((i64)count + index);
+        return TRUE;
+    }
+    *out_index = index > 0 ? (u32)(index - 1) : OBJ_INDEX_NONE;
+    return TRUE;
+}
+
+// Parses one v[/t][/n] face vertex.
+static b8 obj_parse_face_vertex(const char** p, const char* end, obj_chunk* chunk, b8 first_chunk, obj_face_vertex* out) {
+    i64 index;
+    if (!obj_parse_int(p, end, &index)) {
+        return FALSE;
+    }
+    if (index < 0 && !first_chunk) {
+        chunk->relative_indices = TRUE;
+    }
+    obj_resolve_index(index, chunk->vertices.count, &out->v_index);
+    out->t_index = OBJ_INDEX_NONE;
+    out->n_index = OBJ_INDEX_NONE;
+
+    if (*p < end && **p == '/') {
+        (*p)++;
+        if (*p < end && **p != '/') {
+            if (obj_parse_int(p, end, &index)) {
+                if (index < 0 && !first_chunk) chunk->relative_indices = TRUE;
+                obj_resolve_index(index, chunk->texcoords.count, &out->t_index);
+            }
+        }
+        if (*p < end && **p == '/') {
+            (*p)++;
+            if (obj_parse_int(p, end, &index)) {
+                if (index < 0 && !first_chunk) chunk->relative_indices = TRUE;
+                obj_resolve_index(index, chunk->normals.count, &out->n_index);
+            }
+        }
+    }
+    return TRUE;
+}
+
+static void obj_parse_line(const char* p, const char* end, obj_chunk* chunk, b8 first_chunk) {
+    p = obj_skip_space(p, end);
+    if (end - p < 2) {
+        return;
+    }
+
+    if (p[0] == 'v' && obj_is_space(p[1])) {
+        obj_vertex v;
+        p += 2;
+        if (obj_parse_float(&p, end, &v.x) && obj_parse_float(&p, end, &v.y) && obj_parse_float(&p, end, &v.z)) {
+            *(obj_vertex*)obj_buffer_push(&chunk->vertices, sizeof(obj_vertex)) = v;
+        }
+    } else if (p[0] == 'v' && p[1] == 't' && end - p > 2 && obj_is_space(p[2])) {
+        obj_texcoord t;
+        p += 3;
+        if (obj_parse_float(&p, end, &t.u) && obj_parse_float(&p, end, &t.v)) {
+            *(obj_texcoord*)obj_buffer_push(&chunk->texcoords, sizeof(obj_texcoord)) = t;
+        }
+    } else if (p[0] == 'v' && p[1] == 'n' && end - p > 2 && obj_is_space(p[2])) {
+        obj_normal n;
+        p += 3;
+        if (obj_parse_float(&p, end, &n.x) && obj_parse_float(&p, end, &n.y) && obj_parse_float(&p, end, &n.z)) {
+            *(obj_normal*)obj_buffer_push(&chunk->normals, sizeof(obj_normal)) = n;
+        }
+    } else if (p[0] == 'f' && obj_is_space(p[1])) {
+        // Fan-triangulate: (first, previous, current) for every vertex after the second
+        obj_face_vertex first, previous, current;
+        u32 count = 0;
+        p += 2;
+        while (TRUE) {
+            p = obj_skip_space(p, end);
+            if (p >= end || !obj_parse_face_vertex(&p, end, chunk, first_chunk, &current)) {
+                break;
+            }
+            if (count == 0) {
+                first = current;
+            } else if (count >= 2) {
+                obj_face* face = obj_buffer_push(&chunk->faces, sizeof(obj_face));
+                face->vertices[0] = first;
+                face->vertices[1] = previous;
+                face->vertices[2] = current;
+            }
+            previous = current;
+            count++;
+        }
+    }
+}
+
+static void obj_parse_chunk(obj_chunk* chunk, b8 first_chunk) {
+    const char* p = chunk->begin;
+    while (p < chunk->end) {
+        const char* line_end = memchr(p, '\n', (size_t)(chunk->end - p));
+        if (!line_end) {
+            line_end = chunk->end;
+        }
+        obj_parse_line(p, line_end, chunk, first_chunk);
+        p = line_end + 1;
+    }
+}
+
+static void obj_parse_chunk_job(void* context, u32 index) {
+    obj_parse_job* job = context;
+    obj_parse_chunk(&job->chunks[index], index == 0);
+}
+
+static void obj_chunk_free(obj_chunk* chunk) {
+    obj_buffer_free(&chunk->vertices);
+    obj_buffer_free(&chunk->texcoords);
+    obj_buffer_free(&chunk->normals);
+    obj_buffer_free(&chunk->faces);
+}
+
+static void obj_copy_chunk_job(void* context, u32 index) {
+    obj_parse_job* job = context;
+    obj_chunk* chunk = &job->chunks[index];
+    obj_data* out = job->out_data;
+    if (chunk->vertices.count) {
+        platform_copy_memory(out->vertices + chunk->vertex_offset, chunk->vertices.data, chunk->vertices.count * sizeof(obj_vertex));
+    }
+    if (chunk->texcoords.count) {
+        platform_copy_memory(out->texcoords + chunk->texcoord_offset, chunk->texcoords.data, chunk->texcoords.count * sizeof(obj_texcoord));
+    }
+    if (chunk->normals.count) {
+        platform_copy_memory(out->normals + chunk->normal_offset, chunk->normals.data, chunk->normals.count * sizeof(obj_normal));
+    }
+    if (chunk->faces.count) {
+        platform_copy_memory(out->faces + chunk->face_offset, chunk->faces.data, chunk->faces.count * sizeof(obj_face));
+    }
+    obj_chunk_free(chunk);
+}
+
+// Cuts the file into count pieces that each end just after a newline.
+static u32 obj_split_chunks(const char* data, u64 size, u32 count, obj_chunk* out_chunks) {
+    const char* end = data + size;
+    const char* begin = data;
+    u32 produced = 0;
+    for (u32 i = 0; i < count && begin < end; ++i) {
+        const char* cut = i == count - 1 ? end : data + size * (i + 1) / count;
+        if (cut < begin) {
+            cut = begin;
+        }
+        if (cut < end) {
+            const char* newline = memchr(cut, '\n', (size_t)(end - cut));
+            cut = newline ? newline + 1 : end;
+        }
+        kzero_memory(&out_chunks[produced], sizeof(obj_chunk));
+        out_chunks[produced].begin = begin;
+        out_chunks[produced].end = cut;
+        produced++;
+        begin = cut;
+    }
+    return produced;
+}
+
+static void* obj_darray_reserve(u64 count, u64 stride) {
+    void* array = _darray_create(count > 0 ? count : 1, stride);
+    darray_length_set(array, count);
+    return array;
+}
+
+// Parses the whole text of an OBJ file, path is only used for messages.
+static void obj_parse_text(platform_file_mapping file, const char* path, obj_data* out_data) {
+    u32 chunk_count = 1;
+    if (file.size >= OBJ_PARALLEL_MIN_BYTES) {
+        u32 threads = job_system_worker_count() + 1;
+        u64 by_size = file.size / OBJ_CHUNK_MIN_BYTES;
+        chunk_count = threads * OBJ_CHUNKS_PER_THREAD;
+        if (by_size < chunk_count) {
+            chunk_count = by_size > 0 ? (u32)by_size : 1;
+        }
+    }
+
+    obj_chunk* chunks = kallocate(sizeof(obj_chunk) * chunk_count, MEMORY_TAG_MODEL);
+    obj_parse_job job = {chunks, out_data};
+    u32 parsed_chunks = obj_split_chunks(file.data, file.size, chunk_count, chunks);
+    job_system_parallel_for(parsed_chunks, obj_parse_chunk_job, &job);
+
+    b8 relative_indices = FALSE;
+    for (u32 i = 0; i < parsed_chunks; ++i) {
+        relative_indices |= chunks[i].relative_indices;
+    }
+    if (relative_indices && parsed_chunks > 1) {
+        DEBUG("%s uses relative indices, parsing it on one thread", path);
+        for (u32 i = 0; i < parsed_chunks; ++i) {
+            obj_chunk_free(&chunks[i]);
+        }
+        parsed_chunks = obj_split_chunks(file.data, file.size, 1, chunks);
+        obj_parse_chunk(&chunks[0], TRUE);
+    }
+
+    // Prefix sums give each chunk its place in the merged arrays
+    u64 vertex_count = 0, texcoord_count = 0, normal_count = 0, face_count = 0;
+    for (u32 i = 0; i < parsed_chunks; ++i) {
+        chunks[i].vertex_offset = vertex_count;
+        chunks[i].texcoord_offset = texcoord_count;
+        chunks[i].normal_offset = normal_count;
+        chunks[i].face_offset = face_count;
+        vertex_count += chunks[i].vertices.count;
+        texcoord_count += chunks[i].texcoords.count;
+        normal_count += chunks[i].normals.count;
+        face_count += chunks[i].faces.count;
+    }
+    out_data->vertices = obj_darray_reserve(vertex_count, sizeof(obj_vertex));
+    out_data->texcoords = obj_darray_reserve(texcoord_count, sizeof(obj_texcoord));
+    out_data->normals = obj_darray_reserve(normal_count, sizeof(obj_normal));
+    out_data->faces = obj_darray_reserve(face_count, sizeof(obj_face));
+    job_system_parallel_for(parsed_chunks, obj_copy_chunk_job, &job);
+
+    kfree(chunks, sizeof(obj_chunk) * chunk_count, MEMORY_TAG_MODEL);
+}
+
+b8 obj_parse(const char* path, obj_data* out_data) {
+    PROFILE_FUNCTION();
+    kzero_memory(out_data, sizeof(obj_data));
+
+    // Parsed once front to back, straight from the mapping or pack
+    file_view view;
+    if (!file_map_readonly(path, PLATFORM_MAP_HINT_SEQUENTIAL | PLATFORM_MAP_HINT_WILL_NEED, &view)) {
+        ERROR("Failed to open OBJ file: %s", path);
+        return FALSE;
+    }
+    platform_file_mapping file = {view.data, view.size};
+    obj_parse_text(file, path, out_data);
+    out_data->source_size = view.size;
+    out_data->source_hash = hash_bytes(view.data, view.size, 0);
+    file_unmap(&view);
+    return TRUE;
+}
+
+b8 obj_parse_reference(const char* path, obj_data* out_data) {
+    PROFILE_FUNCTION();
+    kzero_memory(out_data, sizeof(obj_data));
+
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        ERROR("Failed to open OBJ file: %s", path);
+        return FALSE;
+    }
+
+    // Create darrays for temporary storage
+    obj_vertex* vertices = darray_create(obj_vertex);
+    obj_texcoord* texcoords = darray_create(obj_texcoord);
+    obj_normal* normals = darray_create(obj_normal);
+    obj_face* faces = darray_create(obj_face);
+
+    char line[1024];
+    while (fgets(line, sizeof(line), file)) {
+        // Remove newline character
+        size_t len = strlen(line);
+        if (len > 0 && line[len-1] == '\n') {
+            line[len-1] = '\0';
+        }
+
+        // Process based on line type
+        if (line[0] == 'v' && line[1] == ' ') {
+            // Vertex
+            obj_vertex v;
+            if (sscanf(line, "v %f %f %f", &v.x, &v.y, &v.z) == 3) {
+                darray_push(vertices, v);
+            }
+        } else if (line[0] == 'v' && line[1] == 't' && line[2] == ' ') {
+            // Texture coordinate
+            obj_texcoord t;
+            if (sscanf(line, "vt %f %f", &t.u, &t.v) == 2) {
+                darray_push(texcoords, t);
+            }
+        } else if (line[0] == 'v' && line[1] == 'n' && line[2] == ' ') {
+            // Normal
+            obj_normal n;
+            if (sscanf(line, "vn %f %f %f", &n.x, &n.y, &n.z) == 3) {
+                darray_push(normals, n);
+            }
+        } else if (line[0] == 'f' && line[1] == ' ') {
+            // Face - support both triangles and quads
+            int v[4], t[4], n[4];
+            int matches = sscanf(line, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d",
+                &v[0], &t[0], &n[0], &v[1], &t[1], &n[1], &v[2], &t[2], &n[2], &v[3], &t[3], &n[3]);
+            int corners = 0;
+            if (matches == 9 || matches == 12) {
+                corners = matches / 3;
+            } else {
+                // Try alternative format: f v//n v//n v//n
+                matches = sscanf(line, "f %d//%d %d//%d %d//%d", &v[0], &n[0], &v[1], &n[1], &v[2], &n[2]);
+                if (matches == 6) {
+                    corners = 3;
+                    t[0] = t[1] = t[2] = 0;
+                } else if (sscanf(line, "f %d %d %d", &v[0], &v[1], &v[2]) == 3) {
+                    // Try another format: f v v v
+                    corners = 3;
+                    t[0] = t[1] = t[2] = 0;
+                    n[0] = n[1] = n[2] = 0;
+                }
+            }
+
+            // Quads are split into (v1, v2, v3) and (v1, v3, v4). OBJ indices
+            // are 1-based, 0 marks a missing texcoord or normal.
+            for (int tri = 0; tri + 2 < corners; ++tri) {
+                int order[3] = {0, tri + 1, tri + 2};
+                obj_face f;
+                for (int k = 0; k < 3; ++k) {
+                    f.vertices[k].v_index = v[order[k]] - 1;
+                    f.vertices[k].t_index = t[order[k]] > 0 ? (u32)(t[order[k]] - 1) : OBJ_INDEX_NONE;
+                    f.vertices[k].n_index = n[order[k]] > 0 ? (u32)(n[order[k]] - 1) : OBJ_INDEX_NONE;
+                }
+                darray_push(faces, f);
+            }
+        }
+    }
+
+    fclose(file);
+
+    out_data->vertices = vertices;
+    out_data->texcoords = texcoords;
+    out_data->normals = normals;
+    out_data->faces = faces;
+    return TRUE;
+}
+
+void obj_data_destroy(obj_data* data) {
+    if (data->vertices) darray_destroy(data->vertices);
+    if (data->texcoords) darray_destroy(data->texcoords);
+    if (data->normals) darray_destroy(data->normals);
+    if (data->faces) darray_destroy(data->faces);
+    kzero_memory(data, sizeof(obj_data));
+}
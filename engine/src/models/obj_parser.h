@@ -0,0 +1,61 @@
+#pragma once
+
+#include "definitions.h"
+
+// Wavefront OBJ geometry parser. Only v, vt, vn and f lines are read, polygons
+// are fan-triangulated.
+
+typedef struct obj_vertex {
+    f32 x, y, z;
+} obj_vertex;
+
+typedef struct obj_texcoord {
+    f32 u, v;
+} obj_texcoord;
+
+typedef struct obj_normal {
+    f32 x, y, z;
+} obj_normal;
+
+// Face vertices that don't reference a texcoord or normal use this index.
+#define OBJ_INDEX_NONE 0xFFFFFFFFu
+
+typedef struct obj_face_vertex {
+    u32 v_index;  // Vertex index, 0-based
+    u32 t_index;  // Texture coordinate index
+    u32 n_index;  // Normal index
+} obj_face_vertex;
+
+typedef struct obj_face {
+    obj_face_vertex vertices[3]; // Triangle face
+} obj_face;
+
+// Parsed geometry, every array is a darray.
+typedef struct obj_data {
+    obj_vertex* vertices;
+    obj_texcoord* texcoords;
+    obj_normal* normals;
+    obj_face* faces;
+    // Of the text parsed, for the mesh cache. hash is hash_bytes with seed 0,
+    // only obj_parse fills these in.
+    u64 source_size;
+    u64 source_hash;
+} obj_data;
+
+// Files smaller than this are parsed on the calling thread.
+#define OBJ_PARALLEL_MIN_BYTES (512 * 1024)
+// Smallest chunk handed to a job, chunks are cut at the next newline.
+#define OBJ_CHUNK_MIN_BYTES (256 * 1024)
+// Chunks per thread, so a chunk with slow lines doesn't hold up the batch.
+#define OBJ_CHUNKS_PER_THREAD 4
+
+// Memory-maps the file, or reads it in place from a VFS pack or memory mount,
+// and parses newline-aligned chunks in parallel on the job system, then merges
+// them in file order.
+API b8 obj_parse(const char* path, obj_data* out_data);
+
+// The previous line-at-a-time fgets and sscanf parser. Slow, kept as a
+// baseline for tools/objbench.
+API b8 obj_parse_reference(const char* path, obj_data* out_data);
+
+API void obj_data_destroy(obj_data* data);
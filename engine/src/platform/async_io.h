@@ -0,0 +1,81 @@
+#pragma once
+
+#include "definitions.h"
+
+// Asynchronous whole-file reads and writes. Requests are queued by the caller
+// and submitted in batches, then completion callbacks run on the main thread
+// from async_io_dispatch. On Linux the backend is io_uring when the kernel
+// allows it, otherwise a small pool of threads doing blocking I/O. With
+// io_uring the pool still opens files and sizes whole-file reads, so the
+// submitting thread never waits on the filesystem.
+//
+// Read paths resolve through core/vfs.h. Files in directory mounts are read
+// from disk, memory files and uncompressed pack entries are copied from the
+// mount without touching the backend. Compressed pack entries are decompressed
+// from the pack's mapping on a worker. Writes go to the path on disk.
+//
+// Submit, wait and dispatch from the main thread only.
+
+// Requests in flight or waiting for dispatch at once.
+#define ASYNC_IO_MAX_REQUESTS 256
+// Threads of the fallback backend.
+#define ASYNC_IO_WORKER_COUNT 2
+#define ASYNC_IO_PATH_MAX 512
+
+typedef u32 async_io_id;
+#define INVALID_ASYNC_IO_ID 0
+
+typedef enum async_io_backend {
+    ASYNC_IO_BACKEND_NONE,
+    ASYNC_IO_BACKEND_IO_URING,
+    ASYNC_IO_BACKEND_THREAD_POOL
+} async_io_backend;
+
+typedef struct async_io_result {
+    async_io_id id;
+    const char* path;
+    b8 success;
+    // errno of the failed step when success is FALSE
+    i32 error;
+    // Reads: the data. Buffers allocated by async_io_read belong to the
+    // callback from here on, release them with free(). Writes: the source.
+    void* buffer;
+    // Bytes transferred. Reads stop early at end of file.
+    u64 size;
+} async_io_result;
+
+typedef void (*pfn_async_io_complete)(const async_io_result* result, void* user_data);
+
+// queue_depth 0 picks a default. io_uring is skipped when allow_io_uring is
+// FALSE, e.g. to compare the backends.
+API b8 async_io_initialize(u32 queue_depth, b8 allow_io_uring);
+// Waits for everything in flight and dispatches it before tearing down.
+API void async_io_shutdown();
+API async_io_backend async_io_get_backend();
+
+// Reads size bytes at offset into buffer. With buffer 0 one is allocated with a
+// null terminator after the data, and handed to the callback. Size 0 reads the
+// rest of the file and needs buffer 0, since the size isn't known up front.
+// Returns INVALID_ASYNC_IO_ID when the queue is full or the arguments are invalid.
+API async_io_id async_io_read(const char* path, void* buffer, u64 offset, u64 size, pfn_async_io_complete callback,
+                              void* user_data);
+// Creates or truncates path and writes size bytes of data, which must stay
+// valid until the callback.
+API async_io_id async_io_write(const char* path, const void* data, u64 size, pfn_async_io_complete callback,
+                               void* user_data);
+
+// Hands queued requests to the backend in one batch. Reads and writes call it
+// themselves once the batch is full, dispatch and wait call it too.
+API void async_io_submit();
+
+API b8 async_io_is_complete(async_io_id id);
+// Blocks until the request completes and runs its callback. Returns FALSE for
+// unknown or already dispatched ids.
+API b8 async_io_wait(async_io_id id);
+
+// Runs the callbacks of completed requests, returns how many ran. Called once
+// per frame by the application loop.
+API u32 async_io_dispatch();
+
+// Requests submitted or queued and not yet dispatched.
+API u32 async_io_pending();
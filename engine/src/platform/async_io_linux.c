@@ -0,0 +1,797 @@
+#include "async_io.h"
+
+#include "core/logger.h"
+#include "core/lz4.h"
+#include "core/profiler.h"
+#include "core/telemetry.h"
+#include "core/vfs.h"
+#include "platform/platform.h"
+#include "platform/sampling_profiler.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define ASYNC_IO_HAS_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#define ASYNC_IO_DEFAULT_QUEUE_DEPTH 64
+// Low bits of an id are the request slot, the rest a serial number so stale ids
+// don't match a reused slot.
+#define ASYNC_IO_SLOT_BITS 8
+#define ASYNC_IO_SLOT_MASK ((1u << ASYNC_IO_SLOT_BITS) - 1)
+
+typedef enum async_io_op {
+    ASYNC_IO_OP_READ,
+    ASYNC_IO_OP_WRITE
+} async_io_op;
+
+typedef enum async_io_request_state {
+    ASYNC_IO_REQUEST_FREE,
+    // Waiting for async_io_submit
+    ASYNC_IO_REQUEST_QUEUED,
+    ASYNC_IO_REQUEST_IN_FLIGHT,
+    // io_uring: opened by a worker, waiting to go on the ring
+    ASYNC_IO_REQUEST_OPENED,
+    // Waiting for async_io_dispatch
+    ASYNC_IO_REQUEST_COMPLETE
+} async_io_request_state;
+
+typedef struct async_io_request {
+    async_io_id id;
+    // async_io_request_state, atomic since pool workers complete requests
+    u32 state;
+    async_io_op op;
+    char path[ASYNC_IO_PATH_MAX];
+    // What is opened, the file on disk a read's path resolved to
+    char disk_path[ASYNC_IO_PATH_MAX];
+    i32 fd;
+    u8* buffer;
+    b8 owns_buffer;
+    u64 offset;
+    // Requested bytes, known after opening for whole-file reads
+    u64 size;
+    u64 done;
+    i32 error;
+    pfn_async_io_complete callback;
+    void* user_data;
+    // Compressed pack entries: the LZ4 block in the pack's mapping and the
+    // entry's size once decompressed
+    const char* compressed;
+    u64 compressed_size;
+    u64 file_size;
+    // Opened by a worker, then transferred through the io_uring
+    b8 use_ring;
+    // Main thread only, set once the transfer is on the ring
+    b8 in_ring;
+    // io_uring reads and writes point at this
+    struct iovec iov;
+} async_io_request;
+
+#ifdef ASYNC_IO_HAS_IO_URING
+typedef struct async_io_ring {
+    i32 fd;
+    u32* sq_head;
+    u32* sq_tail;
+    u32 sq_mask;
+    u32 sq_entries;
+    u32* sq_array;
+    struct io_uring_sqe* sqes;
+    u32* cq_head;
+    u32* cq_tail;
+    u32 cq_mask;
+    struct io_uring_cqe* cqes;
+
+    void* sq_ring;
+    u64 sq_ring_size;
+    void* cq_ring;
+    u64 cq_ring_size;
+    u64 sqes_size;
+
+    // Prepared but not yet passed to io_uring_enter
+    u32 unsubmitted;
+    // Submitted and not yet reaped, kept within sq_entries so the completion
+    // queue can't overflow
+    u32 in_flight;
+} async_io_ring;
+#endif
+
+typedef struct async_io_state {
+    async_io_backend backend;
+    async_io_request requests[ASYNC_IO_MAX_REQUESTS];
+    u32 next_serial;
+    u32 next_slot;
+    u32 pending;
+
+    // Slots queued since the last submit, oldest first
+    u32 queued[ASYNC_IO_MAX_REQUESTS];
+    u32 queued_count;
+    u32 batch_size;
+
+#ifdef ASYNC_IO_HAS_IO_URING
+    async_io_ring ring;
+#endif
+    // Set when io_uring_enter failed and the backend fell back to the pool,
+    // read by workers handing over opened requests
+    b8 ring_failed;
+
+    // Workers open files for both backends and do the whole transfer for the
+    // thread pool one. They also decompress compressed pack entries.
+    platform_thread workers[ASYNC_IO_WORKER_COUNT];
+    u32 worker_count;
+    platform_mutex work_lock;
+    // One count per request in work_queue
+    platform_semaphore work;
+    // One count per request a worker finished, or opened for the ring
+    platform_semaphore completed;
+    u32 work_queue[ASYNC_IO_MAX_REQUESTS];
+    u32 work_head;
+    u32 work_tail;
+    b8 quit;
+} async_io_state;
+
+static async_io_state state;
+static b8 initialized = FALSE;
+
+static async_io_request_state request_state(const async_io_request* request) {
+    return (async_io_request_state)__atomic_load_n(&request->state, __ATOMIC_ACQUIRE);
+}
+
+static void request_set_state(async_io_request* request, async_io_request_state new_state) {
+    __atomic_store_n(&request->state, (u32)new_state, __ATOMIC_RELEASE);
+}
+
+static async_io_request* request_from_id(async_io_id id) {
+    if (!initialized || id == INVALID_ASYNC_IO_ID) {
+        return 0;
+    }
+    async_io_request* request = &state.requests[id & ASYNC_IO_SLOT_MASK];
+    return request->id == id && request_state(request) != ASYNC_IO_REQUEST_FREE ? request : 0;
+}
+
+// Opens the file, sizes whole-file reads and allocates read buffers. Runs on a
+// worker, so the caller never blocks on the filesystem.
+static b8 request_open(async_io_request* request) {
+    if (request->op == ASYNC_IO_OP_READ) {
+        request->fd = open(request->disk_path, O_RDONLY | O_CLOEXEC);
+        if (request->fd < 0) {
+            request->error = errno;
+            return FALSE;
+        }
+        if (request->size == 0) {
+            struct stat info;
+            if (fstat(request->fd, &info) != 0) {
+                request->error = errno;
+                return FALSE;
+            }
+            request->size = (u64)info.st_size > request->offset ? (u64)info.st_size - request->offset : 0;
+        }
+        if (!request->buffer) {
+            request->buffer = platform_allocate(request->size + 1, FALSE);
+            request->owns_buffer = TRUE;
+        }
+    } else {
+        request->fd = open(request->disk_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (request->fd < 0) {
+            request->error = errno;
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// Decompresses a compressed pack entry on a worker. Ranges that aren't the
+// whole entry go through a scratch buffer, LZ4 blocks only decompress whole.
+static void request_decompress(async_io_request* request) {
+    if (!request->buffer) {
+        request->buffer = platform_allocate(request->size + 1, FALSE);
+        request->owns_buffer = TRUE;
+    }
+    b8 whole = request->offset == 0 && request->size == request->file_size;
+    u8* target = whole ? request->buffer : platform_allocate(request->file_size, FALSE);
+    if (!lz4_decompress(request->compressed, request->compressed_size, target, request->file_size)) {
+        ERROR("Async I/O: pack entry '%s' is corrupt", request->path);
+        request->error = EIO;
+    } else {
+        if (!whole && request->size > 0) {
+            memcpy(request->buffer, target + request->offset, request->size);
+        }
+        request->done = request->size;
+    }
+    if (!whole) {
+        platform_free(target, FALSE);
+    }
+}
+
+static void request_finish(async_io_request* request) {
+    if (request->fd >= 0) {
+        close(request->fd);
+        request->fd = -1;
+    }
+    if (request->owns_buffer) {
+        request->buffer[request->done] = 0;
+    }
+    request_set_state(request, ASYNC_IO_REQUEST_COMPLETE);
+}
+
+// Reads resolve through the VFS like file_operations does. Files in directory
+// mounts go to the backend under their path on disk and compressed pack
+// entries to a worker to decompress. Memory files and uncompressed pack entries
+// are copied out right here. Returns FALSE when that already completed the
+// request.
+static b8 request_resolve(async_io_request* request) {
+    vfs_file file;
+    if (!vfs_stat(request->path, &file)) {
+        request->error = ENOENT;
+        request_finish(request);
+        return FALSE;
+    }
+    if (file.type == VFS_MOUNT_DIRECTORY) {
+        if (vfs_real_path(request->path, request->disk_path, sizeof(request->disk_path))) {
+            return TRUE;
+        }
+        request->error = ENOENT;
+        request_finish(request);
+        return FALSE;
+    }
+
+    u64 available = file.size > request->offset ? file.size - request->offset : 0;
+    if (request->size == 0 || request->size > available) {
+        request->size = available;
+    }
+    if (file.compressed_data) {
+        request->compressed = file.compressed_data;
+        request->compressed_size = file.compressed_size;
+        request->file_size = file.size;
+        return TRUE;
+    }
+    if (!request->buffer) {
+        request->buffer = platform_allocate(request->size + 1, FALSE);
+        request->owns_buffer = TRUE;
+    }
+    if (request->size > 0) {
+        memcpy(request->buffer, file.data + request->offset, request->size);
+    }
+    request->done = request->size;
+    request_finish(request);
+    return FALSE;
+}
+
+// Runs the callback on the main thread and frees the slot.
+static void request_dispatch(async_io_request* request) {
+    async_io_result result;
+    result.id = request->id;
+    result.path = request->path;
+    result.error = request->error;
+    if (result.error == 0 && request->op == ASYNC_IO_OP_WRITE && request->done < request->size) {
+        result.error = EIO;
+    }
+    result.success = result.error == 0;
+    if (request->op == ASYNC_IO_OP_WRITE) {
+        // Like file_operations writes, so the next lookup sees the new file
+        vfs_invalidate(request->path);
+    }
+    result.buffer = request->buffer;
+    result.size = request->done;
+
+    if (request->owns_buffer && !result.success) {
+        platform_free(request->buffer, FALSE);
+        result.buffer = 0;
+    }
+    if (request->callback) {
+        request->callback(&result, request->user_data);
+    } else if (request->owns_buffer && result.buffer) {
+        platform_free(request->buffer, FALSE);
+    }
+
+    request->id = INVALID_ASYNC_IO_ID;
+    request_set_state(request, ASYNC_IO_REQUEST_FREE);
+    state.pending--;
+}
+
+#ifdef ASYNC_IO_HAS_IO_URING
+
+static b8 ring_setup(u32 entries) {
+    async_io_ring* ring = &state.ring;
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring->fd = (i32)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) {
+        DEBUG("io_uring_setup failed: %s", strerror(errno));
+        return FALSE;
+    }
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    b8 single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap && ring->cq_ring_size > ring->sq_ring_size) {
+        ring->sq_ring_size = ring->cq_ring_size;
+    }
+    ring->sq_ring = mmap(0, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+                         IORING_OFF_SQ_RING);
+    ring->cq_ring = single_mmap ? ring->sq_ring
+                                : mmap(0, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                       ring->fd, IORING_OFF_CQ_RING);
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(0, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+                      IORING_OFF_SQES);
+    if (ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED || ring->sqes == MAP_FAILED) {
+        WARN("Mapping the io_uring queues failed: %s", strerror(errno));
+        close(ring->fd);
+        return FALSE;
+    }
+    if (single_mmap) {
+        ring->cq_ring_size = 0;
+    }
+
+    u8* sq = ring->sq_ring;
+    u8* cq = ring->cq_ring;
+    ring->sq_head = (u32*)(sq + params.sq_off.head);
+    ring->sq_tail = (u32*)(sq + params.sq_off.tail);
+    ring->sq_mask = *(u32*)(sq + params.sq_off.ring_mask);
+    ring->sq_entries = params.sq_entries;
+    ring->sq_array = (u32*)(sq + params.sq_off.array);
+    ring->cq_head = (u32*)(cq + params.cq_off.head);
+    ring->cq_tail = (u32*)(cq + params.cq_off.tail);
+    ring->cq_mask = *(u32*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return TRUE;
+}
+
+static void ring_teardown() {
+    async_io_ring* ring = &state.ring;
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring_size) {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->fd);
+}
+
+// Fails the requests the ring holds or was about to take with error, and
+// drops the ring. Workers do whole transfers from then on, like the thread
+// pool backend. Closing the ring cancels what the kernel still has.
+static void ring_abandon(i32 error) {
+    ERROR("io_uring_enter failed: %s, falling back to the thread pool", strerror(error));
+    __atomic_store_n(&state.ring_failed, TRUE, __ATOMIC_SEQ_CST);
+    state.backend = ASYNC_IO_BACKEND_THREAD_POOL;
+    for (u32 i = 0; i < ASYNC_IO_MAX_REQUESTS; ++i) {
+        async_io_request* request = &state.requests[i];
+        // Races with a worker handing the request over, see request_hand_to_ring
+        u32 opened = ASYNC_IO_REQUEST_OPENED;
+        if ((request->in_ring && request_state(request) == ASYNC_IO_REQUEST_IN_FLIGHT) ||
+            __atomic_compare_exchange_n(&request->state, &opened, ASYNC_IO_REQUEST_IN_FLIGHT, FALSE,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+            request->error = error;
+            request_finish(request);
+        }
+    }
+    state.ring.unsubmitted = 0;
+    state.ring.in_flight = 0;
+    ring_teardown();
+}
+
+// Submits prepared entries, and with min_complete blocks until that many
+// completions are available. Returns FALSE when the ring failed and was
+// abandoned.
+static b8 ring_enter(u32 min_complete) {
+    async_io_ring* ring = &state.ring;
+    u32 flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+    while (ring->unsubmitted > 0 || min_complete > 0) {
+        i32 submitted = (i32)syscall(__NR_io_uring_enter, ring->fd, ring->unsubmitted, min_complete, flags, 0, 0);
+        if (submitted < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ring_abandon(errno);
+            return FALSE;
+        }
+        ring->unsubmitted -= (u32)submitted;
+        min_complete = 0;
+        flags = 0;
+    }
+    return TRUE;
+}
+
+// Queues a read or write of the rest of the request.
+static void ring_prepare(async_io_request* request) {
+    async_io_ring* ring = &state.ring;
+    u32 tail = *ring->sq_tail;
+    u32 index = tail & ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+
+    request->iov.iov_base = request->buffer + request->done;
+    request->iov.iov_len = request->size - request->done;
+    // The vectored ops predate IORING_OP_READ/WRITE, so older kernels work too
+    sqe->opcode = request->op == ASYNC_IO_OP_READ ? IORING_OP_READV : IORING_OP_WRITEV;
+    sqe->fd = request->fd;
+    sqe->addr = (u64)(uintptr_t)&request->iov;
+    sqe->len = 1;
+    sqe->off = request->offset + request->done;
+    sqe->user_data = request->id & ASYNC_IO_SLOT_MASK;
+    request->in_ring = TRUE;
+
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->unsubmitted++;
+    ring->in_flight++;
+}
+
+// Puts requests the workers have opened on the ring, as many as fit.
+static void ring_start_opened() {
+    async_io_ring* ring = &state.ring;
+    for (u32 i = 0; i < ASYNC_IO_MAX_REQUESTS && ring->in_flight < ring->sq_entries; ++i) {
+        async_io_request* request = &state.requests[i];
+        if (request_state(request) == ASYNC_IO_REQUEST_OPENED) {
+            request_set_state(request, ASYNC_IO_REQUEST_IN_FLIGHT);
+            ring_prepare(request);
+        }
+    }
+}
+
+// Handles every available completion, short transfers are resubmitted, then
+// starts newly opened requests in the room that made.
+static void ring_reap() {
+    async_io_ring* ring = &state.ring;
+    u32 head = *ring->cq_head;
+    u32 tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        struct io_uring_cqe* cqe = &ring->cqes[head & ring->cq_mask];
+        async_io_request* request = &state.requests[cqe->user_data & ASYNC_IO_SLOT_MASK];
+        i32 transferred = cqe->res;
+        head++;
+        ring->in_flight--;
+
+        if (transferred < 0) {
+            if (transferred == -EINTR || transferred == -EAGAIN) {
+                ring_prepare(request);
+                continue;
+            }
+            request->error = -transferred;
+            request_finish(request);
+        } else if (transferred == 0) {
+            // End of file
+            request_finish(request);
+        } else {
+            request->done += (u64)transferred;
+            if (request->done < request->size) {
+                ring_prepare(request);
+            } else {
+                request_finish(request);
+            }
+        }
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    ring_start_opened();
+    // Everything prepared above in one system call
+    ring_enter(0);
+}
+
+#endif
+
+// Leaves an opened request for the main thread to put on the ring. FALSE when
+// the ring failed first, the worker then does the transfer itself.
+static b8 request_hand_to_ring(async_io_request* request) {
+    __atomic_store_n(&request->state, (u32)ASYNC_IO_REQUEST_OPENED, __ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&state.ring_failed, __ATOMIC_SEQ_CST)) {
+        return TRUE;
+    }
+    // ring_abandon may be failing it right now, whoever moves it out of
+    // OPENED first owns it
+    u32 opened = ASYNC_IO_REQUEST_OPENED;
+    return !__atomic_compare_exchange_n(&request->state, &opened, ASYNC_IO_REQUEST_IN_FLIGHT, FALSE,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static u32 async_io_worker_main(void* params) {
+    u32 worker_index = (u32)(u64)params;
+    char name[32];
+    snprintf(name, sizeof(name), "io %u", worker_index);
+    profiler_set_thread_name(name);
+    sampling_profiler_register_thread(name);
+
+    while (TRUE) {
+        platform_semaphore_wait(&state.work);
+        if (__atomic_load_n(&state.quit, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+        platform_mutex_lock(&state.work_lock);
+        u32 slot = state.work_queue[state.work_head++ % ASYNC_IO_MAX_REQUESTS];
+        platform_mutex_unlock(&state.work_lock);
+
+        async_io_request* request = &state.requests[slot];
+        if (request->compressed) {
+            request_decompress(request);
+            request_finish(request);
+            platform_semaphore_signal(&state.completed);
+            continue;
+        }
+        b8 opened = request_open(request);
+        if (opened && request->use_ring && request->size > 0 && request_hand_to_ring(request)) {
+            // The main thread takes it from here
+            platform_semaphore_signal(&state.completed);
+            continue;
+        }
+        if (opened) {
+            while (request->done < request->size) {
+                ssize_t transferred =
+                    request->op == ASYNC_IO_OP_READ
+                        ? pread(request->fd, request->buffer + request->done, request->size - request->done,
+                                (off_t)(request->offset + request->done))
+                        : pwrite(request->fd, request->buffer + request->done, request->size - request->done,
+                                 (off_t)(request->offset + request->done));
+                if (transferred < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    request->error = errno;
+                    break;
+                }
+                if (transferred == 0) {
+                    break;
+                }
+                request->done += (u64)transferred;
+            }
+        }
+        request_finish(request);
+        platform_semaphore_signal(&state.completed);
+    }
+
+    sampling_profiler_unregister_thread();
+    return 0;
+}
+
+static b8 pool_start() {
+    if (!platform_mutex_create(&state.work_lock) || !platform_semaphore_create(0, &state.work) ||
+        !platform_semaphore_create(0, &state.completed)) {
+        ERROR("Failed to create async I/O synchronization objects");
+        return FALSE;
+    }
+    for (u32 i = 0; i < ASYNC_IO_WORKER_COUNT; ++i) {
+        if (!platform_thread_create(async_io_worker_main, (void*)(u64)i, &state.workers[state.worker_count])) {
+            WARN("Failed to start async I/O worker %u", i);
+            break;
+        }
+        state.worker_count++;
+    }
+    return state.worker_count > 0;
+}
+
+static void pool_stop() {
+    __atomic_store_n(&state.quit, TRUE, __ATOMIC_RELEASE);
+    for (u32 i = 0; i < state.worker_count; ++i) {
+        platform_semaphore_signal(&state.work);
+    }
+    for (u32 i = 0; i < state.worker_count; ++i) {
+        platform_thread_join(&state.workers[i]);
+    }
+    platform_semaphore_destroy(&state.completed);
+    platform_semaphore_destroy(&state.work);
+    platform_mutex_destroy(&state.work_lock);
+}
+
+static void pool_submit(async_io_request* request) {
+    request_set_state(request, ASYNC_IO_REQUEST_IN_FLIGHT);
+    platform_mutex_lock(&state.work_lock);
+    state.work_queue[state.work_tail++ % ASYNC_IO_MAX_REQUESTS] = request->id & ASYNC_IO_SLOT_MASK;
+    platform_mutex_unlock(&state.work_lock);
+    platform_semaphore_signal(&state.work);
+}
+
+b8 async_io_initialize(u32 queue_depth, b8 allow_io_uring) {
+    if (initialized) {
+        return TRUE;
+    }
+    memset(&state, 0, sizeof(state));
+    state.next_serial = 1;
+    state.batch_size = queue_depth ? queue_depth : ASYNC_IO_DEFAULT_QUEUE_DEPTH;
+    if (state.batch_size > ASYNC_IO_MAX_REQUESTS) {
+        state.batch_size = ASYNC_IO_MAX_REQUESTS;
+    }
+
+    if (!pool_start()) {
+        ERROR("No async I/O backend could be started");
+        return FALSE;
+    }
+    state.backend = ASYNC_IO_BACKEND_THREAD_POOL;
+#ifdef ASYNC_IO_HAS_IO_URING
+    if (allow_io_uring && ring_setup(state.batch_size)) {
+        state.backend = ASYNC_IO_BACKEND_IO_URING;
+    }
+#endif
+
+    initialized = TRUE;
+    INFO("Async I/O: %s backend, batches of %u",
+         state.backend == ASYNC_IO_BACKEND_IO_URING ? "io_uring" : "thread pool", state.batch_size);
+    return TRUE;
+}
+
+void async_io_shutdown() {
+    if (!initialized) {
+        return;
+    }
+    for (u32 i = 0; i < ASYNC_IO_MAX_REQUESTS; ++i) {
+        if (request_state(&state.requests[i]) != ASYNC_IO_REQUEST_FREE) {
+            async_io_wait(state.requests[i].id);
+        }
+    }
+
+#ifdef ASYNC_IO_HAS_IO_URING
+    if (state.backend == ASYNC_IO_BACKEND_IO_URING) {
+        ring_teardown();
+    }
+#endif
+    pool_stop();
+    telemetry_set_loading_queue_depth(0);
+    initialized = FALSE;
+}
+
+async_io_backend async_io_get_backend() {
+    return initialized ? state.backend : ASYNC_IO_BACKEND_NONE;
+}
+
+static async_io_id async_io_queue(async_io_op op, const char* path, void* buffer, u64 offset, u64 size,
+                                  pfn_async_io_complete callback, void* user_data) {
+    if (!initialized) {
+        ERROR("async_io_initialize must be called before queueing I/O");
+        return INVALID_ASYNC_IO_ID;
+    }
+    if (strlen(path) >= ASYNC_IO_PATH_MAX) {
+        ERROR("Async I/O path too long: %s", path);
+        return INVALID_ASYNC_IO_ID;
+    }
+    if (op == ASYNC_IO_OP_READ && buffer && size == 0) {
+        // The rest of the file could be any size, it would overrun buffer
+        ERROR("Async read of '%s' into a caller's buffer needs a size", path);
+        return INVALID_ASYNC_IO_ID;
+    }
+    if (state.pending == ASYNC_IO_MAX_REQUESTS) {
+        return INVALID_ASYNC_IO_ID;
+    }
+
+    u32 slot = state.next_slot;
+    while (request_state(&state.requests[slot]) != ASYNC_IO_REQUEST_FREE) {
+        slot = (slot + 1) % ASYNC_IO_MAX_REQUESTS;
+    }
+    state.next_slot = (slot + 1) % ASYNC_IO_MAX_REQUESTS;
+
+    async_io_request* request = &state.requests[slot];
+    memset(request, 0, sizeof(async_io_request));
+    u32 serial = state.next_serial++ & (0xFFFFFFFFu >> ASYNC_IO_SLOT_BITS);
+    if (serial == 0) {
+        serial = state.next_serial++;
+    }
+    request->id = (serial << ASYNC_IO_SLOT_BITS) | slot;
+    request->op = op;
+    strncpy(request->path, path, ASYNC_IO_PATH_MAX - 1);
+    strncpy(request->disk_path, path, ASYNC_IO_PATH_MAX - 1);
+    request->fd = -1;
+    request->buffer = buffer;
+    request->offset = offset;
+    request->size = size;
+    request->callback = callback;
+    request->user_data = user_data;
+    request_set_state(request, ASYNC_IO_REQUEST_QUEUED);
+    if (op == ASYNC_IO_OP_READ && !request_resolve(request)) {
+        // Nothing for the backend, the callback runs at the next dispatch
+        state.pending++;
+        return request->id;
+    }
+
+    state.queued[state.queued_count++] = slot;
+    state.pending++;
+    if (state.queued_count >= state.batch_size) {
+        async_io_submit();
+    }
+    return request->id;
+}
+
+async_io_id async_io_read(const char* path, void* buffer, u64 offset, u64 size, pfn_async_io_complete callback,
+                          void* user_data) {
+    return async_io_queue(ASYNC_IO_OP_READ, path, buffer, offset, size, callback, user_data);
+}
+
+async_io_id async_io_write(const char* path, const void* data, u64 size, pfn_async_io_complete callback,
+                           void* user_data) {
+    // The buffer is only read from for writes
+    return async_io_queue(ASYNC_IO_OP_WRITE, path, (void*)data, 0, size, callback, user_data);
+}
+
+void async_io_submit() {
+    if (!initialized || state.queued_count == 0) {
+        return;
+    }
+    PROFILE_FUNCTION();
+    for (u32 i = 0; i < state.queued_count; ++i) {
+        async_io_request* request = &state.requests[state.queued[i]];
+        request->use_ring = state.backend == ASYNC_IO_BACKEND_IO_URING && !request->compressed;
+        pool_submit(request);
+    }
+    state.queued_count = 0;
+    telemetry_set_loading_queue_depth(state.pending);
+}
+
+b8 async_io_is_complete(async_io_id id) {
+    async_io_request* request = request_from_id(id);
+    if (!request) {
+        return FALSE;
+    }
+#ifdef ASYNC_IO_HAS_IO_URING
+    if (state.backend == ASYNC_IO_BACKEND_IO_URING) {
+        ring_reap();
+    }
+#endif
+    return request_state(request) == ASYNC_IO_REQUEST_COMPLETE;
+}
+
+b8 async_io_wait(async_io_id id) {
+    async_io_request* request = request_from_id(id);
+    if (!request) {
+        return FALSE;
+    }
+    PROFILE_FUNCTION();
+    async_io_submit();
+    while (request_state(request) != ASYNC_IO_REQUEST_COMPLETE) {
+#ifdef ASYNC_IO_HAS_IO_URING
+        if (state.backend == ASYNC_IO_BACKEND_IO_URING) {
+            ring_reap();
+        }
+        // Checked again, the reap may have abandoned the ring
+        if (state.backend == ASYNC_IO_BACKEND_IO_URING) {
+            if (request->in_ring || request_state(request) == ASYNC_IO_REQUEST_OPENED) {
+                // Opened requests wait for room on the ring, which a completion makes
+                if (state.ring.in_flight > 0) {
+                    ring_enter(1);
+                }
+                continue;
+            }
+        }
+        if (request_state(request) == ASYNC_IO_REQUEST_COMPLETE) {
+            // Failed by the reap abandoning the ring
+            break;
+        }
+#endif
+        // Still with a worker. Counts from other requests just make the loop
+        // check again.
+        platform_semaphore_wait(&state.completed);
+    }
+    request_dispatch(request);
+    telemetry_set_loading_queue_depth(state.pending);
+    return TRUE;
+}
+
+u32 async_io_dispatch() {
+    if (!initialized || state.pending == 0) {
+        return 0;
+    }
+    PROFILE_FUNCTION();
+    async_io_submit();
+#ifdef ASYNC_IO_HAS_IO_URING
+    if (state.backend == ASYNC_IO_BACKEND_IO_URING) {
+        ring_reap();
+    }
+#endif
+
+    u32 dispatched = 0;
+    for (u32 i = 0; i < ASYNC_IO_MAX_REQUESTS; ++i) {
+        if (request_state(&state.requests[i]) == ASYNC_IO_REQUEST_COMPLETE) {
+            request_dispatch(&state.requests[i]);
+            dispatched++;
+        }
+    }
+    telemetry_set_loading_queue_depth(state.pending);
+    return dispatched;
+}
+
+u32 async_io_pending() {
+    return initialized ? state.pending : 0;
+}
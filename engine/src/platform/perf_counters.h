@@ -0,0 +1,35 @@
+#pragma once
+
+#include "definitions.h"
+
+// CPU performance counters of the calling thread, e.g. perf_event_open on Linux.
+// Hardware counters need PMU access, which VMs and containers often deny. The
+// software counters still work there.
+typedef enum perf_counter {
+    PERF_COUNTER_CYCLES,
+    PERF_COUNTER_INSTRUCTIONS,
+    PERF_COUNTER_CACHE_MISSES,
+    PERF_COUNTER_BRANCH_MISSES,
+    // Software fallbacks
+    PERF_COUNTER_TASK_CLOCK_NS,
+    PERF_COUNTER_PAGE_FAULTS,
+    PERF_COUNTER_MAX
+} perf_counter;
+
+typedef struct perf_counter_values {
+    // Running totals. Hardware values are scaled up when the kernel multiplexed
+    // the counters, so they are estimates in that case.
+    u64 values[PERF_COUNTER_MAX];
+} perf_counter_values;
+
+// Opens the counters for the calling thread. Returns FALSE if none could be opened.
+b8 perf_counters_initialize();
+void perf_counters_shutdown();
+
+b8 perf_counters_available(perf_counter counter);
+b8 perf_counters_hardware_available();
+
+// Reads every open counter, costs one or two syscalls. Unavailable counters read 0.
+b8 perf_counters_read(perf_counter_values* out_values);
+
+const char* perf_counters_name(perf_counter counter);
@@ -0,0 +1,187 @@
+#include "perf_counters.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+static const char* counter_names[PERF_COUNTER_MAX] = {
+    "cycles", "instructions", "cache-misses", "branch-misses", "task-clock", "page-faults"};
+
+const char* perf_counters_name(perf_counter counter) {
+    return counter < PERF_COUNTER_MAX ? counter_names[counter] : "unknown";
+}
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Counters are opened in two groups, hardware and software, so each group is
+// scheduled onto the PMU together and read with a single read().
+typedef struct perf_counter_group {
+    i32 leader_fd;
+    u32 count;
+    perf_counter counters[PERF_COUNTER_MAX];
+    i32 fds[PERF_COUNTER_MAX];
+} perf_counter_group;
+
+typedef struct perf_counters_state {
+    perf_counter_group hardware;
+    perf_counter_group software;
+    b8 available[PERF_COUNTER_MAX];
+} perf_counters_state;
+
+static perf_counters_state state;
+static b8 initialized = FALSE;
+
+static i32 perf_event_open(struct perf_event_attr* attr, i32 group_fd) {
+    // pid 0 and cpu -1: the calling thread, on whichever CPU it runs
+    return (i32)syscall(SYS_perf_event_open, attr, 0, -1, group_fd, 0);
+}
+
+static void group_add(perf_counter_group* group, perf_counter counter, u32 type, u64 config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group->count == 0;  // The leader starts the whole group
+    // User space only, which perf_event_paranoid 2 (the common default) still allows
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    i32 fd = perf_event_open(&attr, group->count == 0 ? -1 : group->leader_fd);
+    if (fd < 0) {
+        DEBUG("perf_event_open for %s failed: %s", counter_names[counter], strerror(errno));
+        return;
+    }
+    if (group->count == 0) {
+        group->leader_fd = fd;
+    }
+    group->counters[group->count] = counter;
+    group->fds[group->count] = fd;
+    group->count++;
+    state.available[counter] = TRUE;
+}
+
+static void group_start(perf_counter_group* group) {
+    if (group->count == 0) return;
+    ioctl(group->leader_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(group->leader_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+static void group_close(perf_counter_group* group) {
+    // Members first, the leader last
+    for (i32 i = (i32)group->count - 1; i >= 0; --i) {
+        close(group->fds[i]);
+    }
+    group->count = 0;
+}
+
+static b8 group_read(perf_counter_group* group, perf_counter_values* out_values) {
+    if (group->count == 0) return TRUE;
+
+    // Layout for PERF_FORMAT_GROUP with both time fields
+    u64 buffer[3 + PERF_COUNTER_MAX];
+    ssize_t expected = (ssize_t)(sizeof(u64) * (3 + group->count));
+    if (read(group->leader_fd, buffer, sizeof(buffer)) != expected) {
+        return FALSE;
+    }
+    u64 enabled = buffer[1];
+    u64 running = buffer[2];
+    for (u32 i = 0; i < group->count; ++i) {
+        u64 value = buffer[3 + i];
+        if (running > 0 && running < enabled) {
+            value = (u64)((f64)value * (f64)enabled / (f64)running);
+        }
+        out_values->values[group->counters[i]] = value;
+    }
+    return TRUE;
+}
+
+b8 perf_counters_initialize() {
+    if (initialized) {
+        return TRUE;
+    }
+    kzero_memory(&state, sizeof(perf_counters_state));
+
+    group_add(&state.hardware, PERF_COUNTER_CYCLES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    if (state.hardware.count > 0) {
+        group_add(&state.hardware, PERF_COUNTER_INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        group_add(&state.hardware, PERF_COUNTER_CACHE_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        group_add(&state.hardware, PERF_COUNTER_BRANCH_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    }
+    group_add(&state.software, PERF_COUNTER_TASK_CLOCK_NS, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK);
+    if (state.software.count > 0) {
+        group_add(&state.software, PERF_COUNTER_PAGE_FAULTS, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+    }
+
+    if (state.hardware.count == 0 && state.software.count == 0) {
+        WARN("No performance counters available (perf_event_open denied or unsupported)");
+        return FALSE;
+    }
+    if (state.hardware.count == 0) {
+        WARN("Hardware performance counters unavailable, using software counters only");
+    }
+
+    group_start(&state.hardware);
+    group_start(&state.software);
+    initialized = TRUE;
+    INFO("Performance counters enabled: %u hardware, %u software", state.hardware.count, state.software.count);
+    return TRUE;
+}
+
+void perf_counters_shutdown() {
+    if (!initialized) return;
+    group_close(&state.hardware);
+    group_close(&state.software);
+    kzero_memory(state.available, sizeof(state.available));
+    initialized = FALSE;
+}
+
+b8 perf_counters_available(perf_counter counter) {
+    return initialized && counter < PERF_COUNTER_MAX && state.available[counter];
+}
+
+b8 perf_counters_hardware_available() {
+    return initialized && state.hardware.count > 0;
+}
+
+b8 perf_counters_read(perf_counter_values* out_values) {
+    kzero_memory(out_values, sizeof(perf_counter_values));
+    if (!initialized) {
+        return FALSE;
+    }
+    b8 hardware = group_read(&state.hardware, out_values);
+    b8 software = group_read(&state.software, out_values);
+    return hardware && software;
+}
+
+#else
+
+b8 perf_counters_initialize() {
+    WARN("Performance counters are only implemented on Linux");
+    return FALSE;
+}
+
+void perf_counters_shutdown() {
+}
+
+b8 perf_counters_available(perf_counter counter) {
+    return FALSE;
+}
+
+b8 perf_counters_hardware_available() {
+    return FALSE;
+}
+
+b8 perf_counters_read(perf_counter_values* out_values) {
+    kzero_memory(out_values, sizeof(perf_counter_values));
+    return FALSE;
+}
+
+#endif
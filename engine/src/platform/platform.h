@@ -9,18 +9,68 @@ typedef struct platform_state{
     SDL_Window* window_handle;  // SDL window handle
 } platform_state;
 
+// Thread entry point. The return value is the thread's exit code.
+typedef u32 (*pfn_thread_start)(void* params);
+
+typedef struct platform_thread {
+    void* internal_data;
+    u64 thread_id;
+} platform_thread;
+
+typedef struct platform_mutex {
+    void* internal_data;
+} platform_mutex;
+
+typedef struct platform_semaphore {
+    void* internal_data;
+} platform_semaphore;
+
+// Read-only view of a whole file.
+typedef struct platform_file_mapping {
+    const char* data;
+    u64 size;
+} platform_file_mapping;
+
+// Access hints for mapped memory, combined as flags.
+typedef enum platform_map_hint {
+    // Pages are read front to back once, read-ahead can be aggressive and
+    // pages dropped early.
+    PLATFORM_MAP_HINT_SEQUENTIAL = 0x1,
+    // Pages will be needed soon, start reading them in now.
+    PLATFORM_MAP_HINT_WILL_NEED = 0x2
+} platform_map_hint;
+
+typedef struct platform_file_info {
+    u64 size;
+    // Last modification time in nanoseconds since the epoch.
+    u64 modified_ns;
+} platform_file_info;
+
+typedef struct platform_shared_memory {
+    void* block;
+    u64 size;
+    char name[64];
+} platform_shared_memory;
+
+// When headless is set no window or GL context is created and
+// platform_pump_messages only reports whether the app is still running.
 b8 platform_startup(
     platform_state* plat_state,
     const char* appliation_name,
     i32 x,
     i32 y,
     i32 width,
-    i32 height);
+    i32 height,
+    b8 headless);
 
 void platform_shutdown(platform_state* plat_state);
 
 b8 platform_pump_messages(platform_state* plat_state);
 
+// Like platform_pump_messages, but blocks until an event arrives or timeout_ms
+// passes, for loops that have nothing to do until the window is restored.
+b8 platform_wait_messages(platform_state* plat_state, u32 timeout_ms);
+
 void* platform_allocate(u64 size, b8 aligned);
 void platform_free(void* block, b8 aligned);
 void* platform_zero_memory(void* block, u64 size);
@@ -34,11 +84,48 @@ f64 platform_get_absolute_time();
 
 void platform_sleep(u64 ms);
 
+// Sleeps until the given platform_get_absolute_time() value. Returns
+// immediately if that time has already passed.
+void platform_sleep_until(f64 absolute_time);
+
 b8 platform_file_exists(const char* path);
 b8 platform_create_directory(const char* path);
 b8 platform_delete_file(const char* path);
 u64 platform_get_file_size(const char* path);
+// Returns FALSE if the file doesn't exist or can't be queried.
+b8 platform_get_file_info(const char* path, platform_file_info* out_info);
 b8 platform_read_file_to_string(const char* path, char** buffer, u64* size);
 b8 platform_write_string_to_file(const char* path, const char* string);
 b8 platform_read_file_to_buffer(const char* path, char** buffer, u64* size);
-b8 platform_write_buffer_to_file(const char* path, const char* buffer, u64 size);
\ No newline at end of file
+b8 platform_write_buffer_to_file(const char* path, const char* buffer, u64 size);
+// Maps a file read-only. Empty files succeed with data set to 0.
+b8 platform_file_map(const char* path, platform_file_mapping* out_mapping);
+void platform_file_unmap(platform_file_mapping* mapping);
+// Passes platform_map_hint flags for a range of a mapping to the kernel. The
+// range is widened to whole pages. Only a hint, failures are ignored.
+void platform_file_map_advise(const void* data, u64 size, u32 hints);
+
+// Threading
+b8 platform_thread_create(pfn_thread_start start_function, void* params, platform_thread* out_thread);
+// Blocks until the thread exits and releases its resources.
+void platform_thread_join(platform_thread* thread);
+u64 platform_current_thread_id();
+// Number of logical processors available to this process.
+u32 platform_processor_count();
+
+b8 platform_mutex_create(platform_mutex* out_mutex);
+void platform_mutex_destroy(platform_mutex* mutex);
+b8 platform_mutex_lock(platform_mutex* mutex);
+b8 platform_mutex_unlock(platform_mutex* mutex);
+
+b8 platform_semaphore_create(u32 initial_count, platform_semaphore* out_semaphore);
+void platform_semaphore_destroy(platform_semaphore* semaphore);
+// Blocks until the count is above zero, then decrements it.
+b8 platform_semaphore_wait(platform_semaphore* semaphore);
+b8 platform_semaphore_signal(platform_semaphore* semaphore);
+
+// Named memory other processes can map, e.g. /dev/shm on Linux. The block is
+// zeroed. Names start with a '/' and contain no other slashes.
+b8 platform_shared_memory_create(const char* name, u64 size, platform_shared_memory* out_memory);
+// Unmaps the block and removes the name.
+void platform_shared_memory_destroy(platform_shared_memory* memory);
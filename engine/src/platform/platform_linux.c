@@ -3,6 +3,7 @@
 #include <core/event.h>
 #include <core/kmemory.h>
 #include <core/kstring.h>
+#include <core/profiler.h>
 #ifdef __linux__
 #include <sys/time.h>
 #include <sys/stat.h>
@@ -16,12 +17,19 @@
 #include <string.h>
 #include <containers/darray.h>
 #include <time.h>  // For platform_get_absolute_time and platform_sleep
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 
 // Internal state for SDL2 platform
 typedef struct internal_state {
     SDL_Window* window;
     SDL_GLContext gl_context;
     b8 running;  // Tracks if the application should continue running
+    b8 headless; // No window, no GL context, no SDL video
+    b8 minimized; // Last reported through EVENT_CODE_WINDOW_MINIMIZED
 } internal_state;
 
 b8 platform_startup(
@@ -30,7 +38,24 @@ b8 platform_startup(
     i32 x,
     i32 y,
     i32 width,
-    i32 height) {
+    i32 height,
+    b8 headless) {
+    if (headless) {
+        // Nothing to open, just keep enough state to answer pump_messages
+        plat_state->internal_state = malloc(sizeof(internal_state));
+        internal_state* state = (internal_state*)plat_state->internal_state;
+        if (!state) {
+            FATAL("Failed to allocate internal state memory.");
+            return FALSE;
+        }
+        memset(state, 0, sizeof(internal_state));
+        state->headless = TRUE;
+        state->running = TRUE;
+        plat_state->window_handle = NULL;
+        INFO("Platform started headless, no window created");
+        return TRUE;
+    }
+
     // Initialize SDL2
     if (SDL_Init(SDL_INIT_EVERYTHING) < 0) {
         FATAL("SDL could not initialize! SDL_Error: %s", SDL_GetError());
@@ -45,6 +70,7 @@ b8 platform_startup(
         SDL_Quit();
         return FALSE;
     }
+    state->headless = FALSE;
 
     // Set OpenGL attributes
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
@@ -102,6 +128,11 @@ b8 platform_startup(
 
 void platform_shutdown(platform_state* plat_state) {
     internal_state* state = (internal_state*)plat_state->internal_state;
+    if (state && state->headless) {
+        free(state);
+        plat_state->internal_state = NULL;
+        return;
+    }
     if (state) {
         if (state->gl_context) {
             SDL_GL_DeleteContext(state->gl_context);
@@ -115,86 +146,138 @@ void platform_shutdown(platform_state* plat_state) {
     SDL_Quit();  
 }
 
+static void platform_handle_event(internal_state* state, SDL_Event* event) {
+    switch (event->type) {
+        case SDL_QUIT:  // Window close button or Alt+F4
+            state->running = FALSE;
+            break;
+
+        case SDL_KEYDOWN: {
+            SDL_Scancode code = event->key.keysym.scancode;
+            SDL_Keycode keycode = SDL_GetKeyFromScancode(code);
+            // Fire off an event for immediate processing.
+            event_context context;
+            context.data.u16[0] = keycode;
+            event_fire(EVENT_CODE_KEY_PRESSED, 0, context);
+            break;
+        }
+        case SDL_KEYUP: {
+            SDL_Scancode code = event->key.keysym.scancode;
+            SDL_Keycode keycode = SDL_GetKeyFromScancode(code);
+            // Fire off an event for immediate processing.
+            event_context context;
+            context.data.u16[0] = keycode;
+            event_fire(EVENT_CODE_KEY_RELEASED, 0, context);
+            break;
+        }
+
+        case SDL_MOUSEBUTTONDOWN:{
+            // Fire the event.
+            u8 button = event->button.button;
+            event_context context;
+            context.data.u16[0] = button;
+            event_fire(EVENT_CODE_BUTTON_PRESSED, 0, context);
+            break;
+        }
+        case SDL_MOUSEBUTTONUP: {
+            // Fire the event.
+            u8 button = event->button.button;
+            event_context context;
+            context.data.u16[0] = button;
+            event_fire(EVENT_CODE_BUTTON_RELEASED, 0, context);
+            break;
+        }
+
+        case SDL_MOUSEMOTION: {
+            int x = event->motion.x, y = event->motion.y;
+            // Fire the event.
+            event_context context;
+            context.data.u16[0] = x;
+            context.data.u16[1] = y;
+            event_fire(EVENT_CODE_MOUSE_MOVED, 0, context);
+            break;
+        }
+
+        case SDL_MOUSEWHEEL: {
+            // Fire the event.
+            event_context context;
+            context.data.u16[0] = event->wheel.y;
+            event_fire(EVENT_CODE_MOUSE_WHEEL, 0, context);
+            break;
+        }
+        case SDL_WINDOWEVENT: {
+            event_context context;
+            switch (event->window.event) {
+                case SDL_WINDOWEVENT_RESIZED:
+                    // Fire a resize event
+                    context.data.u16[0] = event->window.data1;  // width
+                    context.data.u16[1] = event->window.data2;  // height
+                    event_fire(EVENT_CODE_RESIZED, 0, context);
+                    break;
+                case SDL_WINDOWEVENT_MINIMIZED:
+                case SDL_WINDOWEVENT_HIDDEN:
+                case SDL_WINDOWEVENT_RESTORED:
+                case SDL_WINDOWEVENT_SHOWN: {
+                    // Restored also follows un-maximizing, only report real changes
+                    b8 minimized = event->window.event == SDL_WINDOWEVENT_MINIMIZED ||
+                                   event->window.event == SDL_WINDOWEVENT_HIDDEN;
+                    if (minimized != state->minimized) {
+                        state->minimized = minimized;
+                        context.data.u16[0] = minimized;
+                        event_fire(EVENT_CODE_WINDOW_MINIMIZED, 0, context);
+                    }
+                    break;
+                }
+                case SDL_WINDOWEVENT_FOCUS_GAINED:
+                case SDL_WINDOWEVENT_FOCUS_LOST:
+                    context.data.u16[0] = event->window.event == SDL_WINDOWEVENT_FOCUS_GAINED;
+                    event_fire(EVENT_CODE_WINDOW_FOCUS, 0, context);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        }
+
+        default:
+            // Ignore other events
+            break;
+    }
+}
+
 b8 platform_pump_messages(platform_state* plat_state) {
+    PROFILE_FUNCTION();
     internal_state* state = (internal_state*)plat_state->internal_state;
+    if (state->headless) {
+        return state->running;
+    }
 
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
-        switch (event.type) {
-            case SDL_QUIT:  // Window close button or Alt+F4
-                state->running = FALSE;
-                break;
-
-            case SDL_KEYDOWN: {
-                SDL_Scancode code = event.key.keysym.scancode;
-                SDL_Keycode keycode = SDL_GetKeyFromScancode(code);
-                // Fire off an event for immediate processing.
-                event_context context;
-                context.data.u16[0] = keycode;
-                event_fire(EVENT_CODE_KEY_PRESSED, 0, context);
-                break;
-            }
-            case SDL_KEYUP: {
-                SDL_Scancode code = event.key.keysym.scancode;
-                SDL_Keycode keycode = SDL_GetKeyFromScancode(code);
-                // Fire off an event for immediate processing.
-                event_context context;
-                context.data.u16[0] = keycode;
-                event_fire(EVENT_CODE_KEY_RELEASED, 0, context);
-                break;
-            }
-
-            case SDL_MOUSEBUTTONDOWN:{
-                // Fire the event.
-                u8 button = event.button.button;
-                event_context context;
-                context.data.u16[0] = button;
-                event_fire(EVENT_CODE_BUTTON_PRESSED, 0, context);
-                break;
-            }
-            case SDL_MOUSEBUTTONUP: {
-                // Fire the event.
-                u8 button = event.button.button;
-                event_context context;
-                context.data.u16[0] = button;
-                event_fire(EVENT_CODE_BUTTON_RELEASED, 0, context);
-                break;
-            }
+        platform_handle_event(state, &event);
+    }
 
-            case SDL_MOUSEMOTION: {
-                int x = event.motion.x, y = event.motion.y;
-                // Fire the event.
-                event_context context;
-                context.data.u16[0] = x;
-                context.data.u16[1] = y;
-                event_fire(EVENT_CODE_MOUSE_MOVED, 0, context);
-                break;
-            }
+    return state->running;  // Return TRUE if still running, FALSE if quitting
+}
 
-            case SDL_MOUSEWHEEL: {
-                // Fire the event.
-                event_context context;
-                context.data.u16[0] = event.wheel.y;
-                event_fire(EVENT_CODE_MOUSE_WHEEL, 0, context);
-                break;
-            }
-            case SDL_WINDOWEVENT:
-                if (event.window.event == SDL_WINDOWEVENT_RESIZED) {
-                    // Fire a resize event
-                    event_context context;
-                    context.data.u16[0] = event.window.data1;  // width
-                    context.data.u16[1] = event.window.data2;  // height
-                    event_fire(EVENT_CODE_RESIZED, 0, context);
-                }
-                break;
+b8 platform_wait_messages(platform_state* plat_state, u32 timeout_ms) {
+    PROFILE_FUNCTION();
+    internal_state* state = (internal_state*)plat_state->internal_state;
+    if (state->headless) {
+        platform_sleep(timeout_ms);
+        return state->running;
+    }
 
-            default:
-                // Ignore other events
-                break;
+    // Blocks in the event queue rather than polling, then drains whatever else arrived
+    SDL_Event event;
+    if (SDL_WaitEventTimeout(&event, (int)timeout_ms)) {
+        platform_handle_event(state, &event);
+        while (SDL_PollEvent(&event)) {
+            platform_handle_event(state, &event);
         }
     }
 
-    return state->running;  // Return TRUE if still running, FALSE if quitting
+    return state->running;
 }
 
 void* platform_allocate(u64 size, b8 aligned) {
@@ -230,12 +313,35 @@ void platform_console_write_error(const char* message, log_level level) {
 }
 
 f64 platform_get_absolute_time() {
-    Uint64 ticks = SDL_GetPerformanceCounter();
-    Uint64 freq = SDL_GetPerformanceFrequency();
-    return (f64)ticks / (f64)freq;  // Time in seconds
+    // CLOCK_MONOTONIC so the value can be handed straight back to clock_nanosleep
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (f64)now.tv_sec + (f64)now.tv_nsec * 0.000000001;  // Time in seconds
 }
+
 void platform_sleep(u64 ms) {
-    SDL_Delay(ms);  // SDL2's built-in delay function
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000 * 1000;
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {
+        // Interrupted by a signal, sleep for whatever is left
+    }
+}
+
+void platform_sleep_until(f64 absolute_time) {
+    if (absolute_time <= 0) {
+        return;
+    }
+    struct timespec deadline;
+    deadline.tv_sec = (time_t)absolute_time;
+    deadline.tv_nsec = (long)((absolute_time - (f64)deadline.tv_sec) * 1000000000.0);
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    // Absolute deadline, so a signal interruption just retries the same target
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, 0) == EINTR) {
+    }
 }
 
 b8 platform_file_exists(const char* path) {
@@ -256,20 +362,46 @@ u64 platform_get_file_size(const char* path) {
     return stat_buffer.st_size;
 }
 
+b8 platform_get_file_info(const char* path, platform_file_info* out_info) {
+    struct stat stat_buffer;
+    if (stat(path, &stat_buffer) != 0) {
+        return FALSE;
+    }
+    out_info->size = (u64)stat_buffer.st_size;
+    out_info->modified_ns = (u64)stat_buffer.st_mtim.tv_sec * 1000000000ull + (u64)stat_buffer.st_mtim.tv_nsec;
+    return TRUE;
+}
+
+// Reads all of an open file into a null-terminated malloc buffer and closes it.
+static b8 platform_read_open_file(FILE* file, char** buffer, u64* size) {
+    long length = -1;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        length = ftell(file);
+    }
+    if (length < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        return FALSE;
+    }
+    char* data = (char*)malloc((u64)length + 1);
+    if (fread(data, 1, (u64)length, file) != (u64)length) {
+        free(data);
+        fclose(file);
+        return FALSE;
+    }
+    data[length] = '\0';
+    fclose(file);
+    *buffer = data;
+    *size = (u64)length;
+    return TRUE;
+}
+
 b8 platform_read_file_to_string(const char* path, char** buffer, u64* size) {
     FILE* file = fopen(path, "rb");
     if (!file) {
         return FALSE;
     }   
 
-    fseek(file, 0, SEEK_END);
-    *size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    *buffer = (char*)malloc(*size);
-    fread(*buffer, 1, *size, file);
-    fclose(file);
-
-    return TRUE;
+    return platform_read_open_file(file, buffer, size);
 }
 
 b8 platform_write_string_to_file(const char* path, const char* string) {
@@ -289,13 +421,7 @@ b8 platform_read_file_to_buffer(const char* path, char** buffer, u64* size) {
         return FALSE;
     }
 
-    fseek(file, 0, SEEK_END);
-    *size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    *buffer = (char*)malloc(*size);
-    fread(*buffer, 1, *size, file);
-    fclose(file);
-    return TRUE;
+    return platform_read_open_file(file, buffer, size);
 }
 
 b8 platform_write_buffer_to_file(const char* path, const char* buffer, u64 size) {
@@ -308,4 +434,211 @@ b8 platform_write_buffer_to_file(const char* path, const char* buffer, u64 size)
     fclose(file);
     return TRUE;
 }
+
+b8 platform_file_map(const char* path, platform_file_mapping* out_mapping) {
+    out_mapping->data = 0;
+    out_mapping->size = 0;
+
+    i32 fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return FALSE;
+    }
+    struct stat stat_buffer;
+    if (fstat(fd, &stat_buffer) != 0) {
+        close(fd);
+        return FALSE;
+    }
+    if (stat_buffer.st_size == 0) {
+        close(fd);
+        return TRUE;
+    }
+
+    void* data = mmap(0, (size_t)stat_buffer.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file
+    close(fd);
+    if (data == MAP_FAILED) {
+        ERROR("mmap of '%s' failed: %s", path, strerror(errno));
+        return FALSE;
+    }
+    out_mapping->data = (const char*)data;
+    out_mapping->size = (u64)stat_buffer.st_size;
+    return TRUE;
+}
+
+void platform_file_map_advise(const void* data, u64 size, u32 hints) {
+    if (!data || size == 0) {
+        return;
+    }
+    u64 page_size = (u64)sysconf(_SC_PAGESIZE);
+    u64 start = (u64)(uintptr_t)data & ~(page_size - 1);
+    u64 length = (u64)(uintptr_t)data + size - start;
+    if (hints & PLATFORM_MAP_HINT_SEQUENTIAL) {
+        madvise((void*)(uintptr_t)start, length, MADV_SEQUENTIAL);
+    }
+    if (hints & PLATFORM_MAP_HINT_WILL_NEED) {
+        madvise((void*)(uintptr_t)start, length, MADV_WILLNEED);
+    }
+}
+
+void platform_file_unmap(platform_file_mapping* mapping) {
+    if (mapping->data) {
+        munmap((void*)mapping->data, mapping->size);
+    }
+    mapping->data = 0;
+    mapping->size = 0;
+}
+
+// Threading
+
+typedef struct linux_thread_start {
+    pfn_thread_start start_function;
+    void* params;
+} linux_thread_start;
+
+static void* linux_thread_entry(void* arg) {
+    linux_thread_start start = *(linux_thread_start*)arg;
+    free(arg);
+    return (void*)(u64)start.start_function(start.params);
+}
+
+b8 platform_thread_create(pfn_thread_start start_function, void* params, platform_thread* out_thread) {
+    if (!start_function || !out_thread) {
+        return FALSE;
+    }
+
+    linux_thread_start* start = malloc(sizeof(linux_thread_start));
+    start->start_function = start_function;
+    start->params = params;
+
+    pthread_t* thread = malloc(sizeof(pthread_t));
+    i32 result = pthread_create(thread, NULL, linux_thread_entry, start);
+    if (result != 0) {
+        ERROR("pthread_create failed: %s", strerror(result));
+        free(start);
+        free(thread);
+        return FALSE;
+    }
+
+    out_thread->internal_data = thread;
+    out_thread->thread_id = (u64)*thread;
+    return TRUE;
+}
+
+void platform_thread_join(platform_thread* thread) {
+    if (!thread || !thread->internal_data) {
+        return;
+    }
+    pthread_join(*(pthread_t*)thread->internal_data, NULL);
+    free(thread->internal_data);
+    thread->internal_data = NULL;
+    thread->thread_id = 0;
+}
+
+u64 platform_current_thread_id() {
+    return (u64)pthread_self();
+}
+
+u32 platform_processor_count() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (u32)count : 1;
+}
+
+b8 platform_mutex_create(platform_mutex* out_mutex) {
+    pthread_mutex_t* mutex = malloc(sizeof(pthread_mutex_t));
+    if (pthread_mutex_init(mutex, NULL) != 0) {
+        ERROR("Failed to create mutex");
+        free(mutex);
+        return FALSE;
+    }
+    out_mutex->internal_data = mutex;
+    return TRUE;
+}
+
+void platform_mutex_destroy(platform_mutex* mutex) {
+    if (!mutex || !mutex->internal_data) {
+        return;
+    }
+    pthread_mutex_destroy((pthread_mutex_t*)mutex->internal_data);
+    free(mutex->internal_data);
+    mutex->internal_data = NULL;
+}
+
+b8 platform_mutex_lock(platform_mutex* mutex) {
+    return pthread_mutex_lock((pthread_mutex_t*)mutex->internal_data) == 0;
+}
+
+b8 platform_mutex_unlock(platform_mutex* mutex) {
+    return pthread_mutex_unlock((pthread_mutex_t*)mutex->internal_data) == 0;
+}
+
+b8 platform_semaphore_create(u32 initial_count, platform_semaphore* out_semaphore) {
+    sem_t* semaphore = malloc(sizeof(sem_t));
+    if (sem_init(semaphore, 0, initial_count) != 0) {
+        ERROR("Failed to create semaphore: %s", strerror(errno));
+        free(semaphore);
+        return FALSE;
+    }
+    out_semaphore->internal_data = semaphore;
+    return TRUE;
+}
+
+void platform_semaphore_destroy(platform_semaphore* semaphore) {
+    if (!semaphore || !semaphore->internal_data) {
+        return;
+    }
+    sem_destroy((sem_t*)semaphore->internal_data);
+    free(semaphore->internal_data);
+    semaphore->internal_data = NULL;
+}
+
+b8 platform_semaphore_wait(platform_semaphore* semaphore) {
+    while (sem_wait((sem_t*)semaphore->internal_data) != 0) {
+        if (errno != EINTR) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+b8 platform_semaphore_signal(platform_semaphore* semaphore) {
+    return sem_post((sem_t*)semaphore->internal_data) == 0;
+}
+
+b8 platform_shared_memory_create(const char* name, u64 size, platform_shared_memory* out_memory) {
+    // A stale segment from a crashed run with a recycled pid is simply replaced
+    int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        ERROR("shm_open('%s') failed: %s", name, strerror(errno));
+        return FALSE;
+    }
+    if (ftruncate(fd, (off_t)size) != 0) {
+        ERROR("ftruncate on shared memory '%s' failed: %s", name, strerror(errno));
+        close(fd);
+        shm_unlink(name);
+        return FALSE;
+    }
+    void* block = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // The mapping keeps the segment alive, the descriptor is no longer needed
+    close(fd);
+    if (block == MAP_FAILED) {
+        ERROR("mmap of shared memory '%s' failed: %s", name, strerror(errno));
+        shm_unlink(name);
+        return FALSE;
+    }
+
+    out_memory->block = block;
+    out_memory->size = size;
+    snprintf(out_memory->name, sizeof(out_memory->name), "%s", name);
+    return TRUE;
+}
+
+void platform_shared_memory_destroy(platform_shared_memory* memory) {
+    if (!memory->block) {
+        return;
+    }
+    munmap(memory->block, memory->size);
+    shm_unlink(memory->name);
+    memory->block = 0;
+    memory->size = 0;
+}
 #endif
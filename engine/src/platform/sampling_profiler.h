@@ -0,0 +1,34 @@
+#pragma once
+
+#include "definitions.h"
+
+// Statistical CPU profiler. Each registered thread gets a CPU-time timer that
+// raises SIGPROF, and the handler records the interrupted call stack by walking
+// frame pointers. Stacks are symbolized with dladdr once the capture stops, so
+// only exported symbols get names: build with -fno-omit-frame-pointer, and link
+// executables with -rdynamic.
+
+#define SAMPLER_DEFAULT_HZ 997  // Not a round number, so it won't lock step with frames
+#define SAMPLER_MAX_DEPTH 64
+// Threads registered over the life of the process. Slots are never reused, so
+// samples keep their thread's name.
+#define SAMPLER_MAX_THREADS 32
+// Shared sample buffer, one header word plus one word per frame for each sample.
+// 16 MiB holds about 20 seconds of two busy threads at the default rate.
+#define SAMPLER_BUFFER_WORDS (1 << 21)
+
+// Starts sampling every registered thread at frequency_hz of CPU time.
+API b8 sampling_profiler_start(u32 frequency_hz);
+
+// Stops sampling and writes a flat profile (self and total samples per function)
+// to flat_path and folded stacks for flamegraph.pl or speedscope to folded_path.
+// Either path may be 0 to skip that report.
+API b8 sampling_profiler_stop(const char* flat_path, const char* folded_path);
+
+API b8 sampling_profiler_is_running();
+
+// Makes the calling thread eligible for sampling. Threads that register while a
+// capture runs join it right away.
+API void sampling_profiler_register_thread(const char* name);
+// Call before a registered thread exits.
+API void sampling_profiler_unregister_thread();
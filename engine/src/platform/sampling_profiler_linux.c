@@ -0,0 +1,551 @@
+#include "sampling_profiler.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+
+#if defined(__linux__)
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+// Older glibc headers only expose the raw union member
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+typedef struct sampler_thread {
+    b8 registered;
+    b8 timer_armed;
+    char name[32];
+    pid_t tid;
+    clockid_t cpu_clock;
+    timer_t timer;
+    // Bounds for the frame pointer walk, a corrupt chain must not leave the stack
+    u64 stack_low;
+    u64 stack_high;
+} sampler_thread;
+
+typedef struct sampler_state {
+    platform_mutex lock;  // Registration and start/stop, never taken in the handler
+    sampler_thread threads[SAMPLER_MAX_THREADS];
+    u32 thread_count;
+
+    u64* buffer;
+    u32 frequency_hz;
+    f64 start_time;
+    struct sigaction previous_action;
+
+    // Shared with the signal handler
+    u32 running;
+    u32 in_flight;
+    u64 write_index;
+    u64 dropped;
+} sampler_state;
+
+static sampler_state state;
+static b8 lock_created = FALSE;
+
+static void sampler_ensure_lock() {
+    // Registration can come before start, both from the main thread during startup
+    if (!lock_created) {
+        platform_mutex_create(&state.lock);
+        lock_created = TRUE;
+    }
+}
+
+// Walks the frame pointer chain from the interrupted context. Only reads memory
+// inside the thread's stack, so it is safe on code built without frame pointers,
+// it just stops early there.
+static u32 sampler_walk_stack(void* context, const sampler_thread* thread, u64* frames) {
+    ucontext_t* uc = (ucontext_t*)context;
+#if defined(__x86_64__)
+    u64 pc = (u64)uc->uc_mcontext.gregs[REG_RIP];
+    u64 fp = (u64)uc->uc_mcontext.gregs[REG_RBP];
+#elif defined(__aarch64__)
+    u64 pc = (u64)uc->uc_mcontext.pc;
+    u64 fp = (u64)uc->uc_mcontext.regs[29];
+#else
+    u64 pc = 0;
+    u64 fp = 0;
+#endif
+    u32 depth = 0;
+    if (pc == 0) {
+        return 0;
+    }
+    frames[depth++] = pc;
+
+    while (depth < SAMPLER_MAX_DEPTH && fp >= thread->stack_low && fp + 16 <= thread->stack_high && (fp & 7) == 0) {
+        const u64* frame = (const u64*)fp;
+        u64 next = frame[0];
+        u64 return_address = frame[1];
+        if (return_address == 0) {
+            break;
+        }
+        frames[depth++] = return_address;
+        // Stacks grow down, callers always sit at higher addresses
+        if (next <= fp) {
+            break;
+        }
+        fp = next;
+    }
+    return depth;
+}
+
+static void sampler_signal_handler(int signal, siginfo_t* info, void* context) {
+    int saved_errno = errno;
+    __atomic_add_fetch(&state.in_flight, 1, __ATOMIC_ACQ_REL);
+
+    if (__atomic_load_n(&state.running, __ATOMIC_ACQUIRE)) {
+        pid_t tid = (pid_t)syscall(SYS_gettid);
+        u32 count = __atomic_load_n(&state.thread_count, __ATOMIC_ACQUIRE);
+        for (u32 slot = 0; slot < count; ++slot) {
+            const sampler_thread* thread = &state.threads[slot];
+            if (thread->tid != tid || !thread->registered) {
+                continue;
+            }
+
+            u64 frames[SAMPLER_MAX_DEPTH];
+            u32 depth = sampler_walk_stack(context, thread, frames);
+            if (depth == 0) {
+                break;
+            }
+            // Lock-free: reserve the words, then fill them. Nobody reads the
+            // buffer until every handler has left.
+            u64 words = 1 + depth;
+            u64 index = __atomic_fetch_add(&state.write_index, words, __ATOMIC_RELAXED);
+            if (index + words > SAMPLER_BUFFER_WORDS) {
+                __atomic_add_fetch(&state.dropped, 1, __ATOMIC_RELAXED);
+                break;
+            }
+            u64* record = state.buffer + index;
+            for (u32 i = 0; i < depth; ++i) {
+                record[1 + i] = frames[i];
+            }
+            record[0] = ((u64)(slot + 1) << 32) | depth;
+            break;
+        }
+    }
+
+    __atomic_sub_fetch(&state.in_flight, 1, __ATOMIC_ACQ_REL);
+    errno = saved_errno;
+}
+
+static b8 sampler_arm_thread(sampler_thread* thread) {
+    struct sigevent event;
+    memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event.sigev_notify_thread_id = thread->tid;
+    if (timer_create(thread->cpu_clock, &event, &thread->timer) != 0) {
+        WARN("Sampling profiler: timer_create for thread '%s' failed: %s", thread->name, strerror(errno));
+        return FALSE;
+    }
+
+    u64 interval_ns = 1000000000ULL / state.frequency_hz;
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = (time_t)(interval_ns / 1000000000ULL);
+    spec.it_interval.tv_nsec = (long)(interval_ns % 1000000000ULL);
+    spec.it_value = spec.it_interval;
+    if (timer_settime(thread->timer, 0, &spec, 0) != 0) {
+        WARN("Sampling profiler: timer_settime for thread '%s' failed: %s", thread->name, strerror(errno));
+        timer_delete(thread->timer);
+        return FALSE;
+    }
+    thread->timer_armed = TRUE;
+    return TRUE;
+}
+
+static void sampler_disarm_thread(sampler_thread* thread) {
+    if (thread->timer_armed) {
+        timer_delete(thread->timer);
+        thread->timer_armed = FALSE;
+    }
+}
+
+void sampling_profiler_register_thread(const char* name) {
+    sampler_ensure_lock();
+    platform_mutex_lock(&state.lock);
+    if (state.thread_count >= SAMPLER_MAX_THREADS) {
+        platform_mutex_unlock(&state.lock);
+        WARN("Sampling profiler: too many threads registered, '%s' will not be sampled", name);
+        return;
+    }
+
+    sampler_thread* thread = &state.threads[state.thread_count];
+    memset(thread, 0, sizeof(sampler_thread));
+    snprintf(thread->name, sizeof(thread->name), "%s", name ? name : "thread");
+    thread->tid = (pid_t)syscall(SYS_gettid);
+    pthread_getcpuclockid(pthread_self(), &thread->cpu_clock);
+
+    pthread_attr_t attributes;
+    if (pthread_getattr_np(pthread_self(), &attributes) == 0) {
+        void* stack = 0;
+        size_t stack_size = 0;
+        pthread_attr_getstack(&attributes, &stack, &stack_size);
+        thread->stack_low = (u64)stack;
+        thread->stack_high = (u64)stack + stack_size;
+        pthread_attr_destroy(&attributes);
+    }
+    thread->registered = TRUE;
+    // Publish the slot only once it is filled in, the handler reads without the lock
+    __atomic_store_n(&state.thread_count, state.thread_count + 1, __ATOMIC_RELEASE);
+
+    if (__atomic_load_n(&state.running, __ATOMIC_ACQUIRE)) {
+        sampler_arm_thread(thread);
+    }
+    platform_mutex_unlock(&state.lock);
+}
+
+void sampling_profiler_unregister_thread() {
+    if (!lock_created) return;
+    pid_t tid = (pid_t)syscall(SYS_gettid);
+    platform_mutex_lock(&state.lock);
+    for (u32 i = 0; i < state.thread_count; ++i) {
+        sampler_thread* thread = &state.threads[i];
+        if (thread->registered && thread->tid == tid) {
+            sampler_disarm_thread(thread);
+            thread->registered = FALSE;
+        }
+    }
+    platform_mutex_unlock(&state.lock);
+}
+
+b8 sampling_profiler_is_running() {
+    return __atomic_load_n(&state.running, __ATOMIC_ACQUIRE) != 0;
+}
+
+b8 sampling_profiler_start(u32 frequency_hz) {
+    sampler_ensure_lock();
+    if (sampling_profiler_is_running()) {
+        WARN("Sampling profiler is already running");
+        return FALSE;
+    }
+
+    if (!state.buffer) {
+        // Allocated outside kallocate, the handler must never touch allocator stats
+        state.buffer = platform_allocate(sizeof(u64) * SAMPLER_BUFFER_WORDS, FALSE);
+    }
+    platform_zero_memory(state.buffer, sizeof(u64) * SAMPLER_BUFFER_WORDS);
+    state.write_index = 0;
+    state.dropped = 0;
+    state.frequency_hz = frequency_hz > 0 ? frequency_hz : SAMPLER_DEFAULT_HZ;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = sampler_signal_handler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &state.previous_action) != 0) {
+        ERROR("Sampling profiler: could not install the SIGPROF handler: %s", strerror(errno));
+        return FALSE;
+    }
+
+    platform_mutex_lock(&state.lock);
+    __atomic_store_n(&state.running, 1, __ATOMIC_RELEASE);
+    u32 armed = 0;
+    for (u32 i = 0; i < state.thread_count; ++i) {
+        if (state.threads[i].registered && sampler_arm_thread(&state.threads[i])) {
+            armed++;
+        }
+    }
+    platform_mutex_unlock(&state.lock);
+
+    state.start_time = platform_get_absolute_time();
+    INFO("Sampling profiler started at %u Hz on %u threads", state.frequency_hz, armed);
+    return TRUE;
+}
+
+// Symbolized function, identified by its start address.
+typedef struct sampler_symbol {
+    u64 address;
+    char name[120];
+    u32 self;
+    u32 total;
+    u32 last_sample;  // Avoids counting recursion twice towards total
+} sampler_symbol;
+
+static int compare_u64(const void* a, const void* b) {
+    u64 x = *(const u64*)a;
+    u64 y = *(const u64*)b;
+    return x < y ? -1 : x > y;
+}
+
+static int compare_symbol_self(const void* a, const void* b) {
+    const sampler_symbol* x = a;
+    const sampler_symbol* y = b;
+    if (x->self != y->self) return x->self < y->self ? 1 : -1;
+    return x->total < y->total ? 1 : (x->total > y->total ? -1 : 0);
+}
+
+static int compare_string(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+// Where in the code a frame address points. Return addresses point after the
+// call, step back one byte so they resolve to the calling line.
+static u64 frame_lookup_address(const u64* record, u32 frame) {
+    return frame == 0 ? record[1] : record[1 + frame] - 1;
+}
+
+// Start address of the function containing address, or the address itself when
+// dladdr knows no symbol for it.
+static u64 sampler_symbol_start(u64 address) {
+    Dl_info info;
+    if (dladdr((void*)address, &info) && info.dli_saddr) {
+        return (u64)info.dli_saddr;
+    }
+    return address;
+}
+
+static void sampler_symbol_name(u64 address, char* out_name, u64 size) {
+    Dl_info info;
+    if (dladdr((void*)address, &info) && info.dli_fname) {
+        const char* module = strrchr(info.dli_fname, '/');
+        module = module ? module + 1 : info.dli_fname;
+        if (info.dli_sname && info.dli_saddr == (void*)address) {
+            snprintf(out_name, size, "%s", info.dli_sname);
+        } else {
+            snprintf(out_name, size, "%s+0x%llx", module[0] ? module : "?", address - (u64)info.dli_fbase);
+        }
+        return;
+    }
+    snprintf(out_name, size, "0x%llx", address);
+}
+
+static u32 sampler_find_symbol(const sampler_symbol* symbols, u32 count, u64 start) {
+    u32 low = 0;
+    u32 high = count;
+    while (low < high) {
+        u32 mid = (low + high) / 2;
+        if (symbols[mid].address < start) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static void sampler_write_reports(const char* flat_path, const char* folded_path) {
+    u64 end = state.write_index < SAMPLER_BUFFER_WORDS ? state.write_index : SAMPLER_BUFFER_WORDS;
+
+    // Count samples and frames
+    u64 sample_count = 0;
+    u64 frame_count = 0;
+    for (u64 i = 0; i < end;) {
+        u32 depth = (u32)(state.buffer[i] & 0xFFFFFFFF);
+        if (depth == 0 || i + 1 + depth > end) break;
+        sample_count++;
+        frame_count += depth;
+        i += 1 + depth;
+    }
+    if (sample_count == 0) {
+        WARN("Sampling profiler: no samples recorded");
+        return;
+    }
+
+    // dladdr scans symbol tables, so resolve each distinct address only once
+    u64 raw_size = sizeof(u64) * frame_count;
+    u64* raw = kallocate(raw_size, MEMORY_TAG_APPLICATION);
+    u64 n = 0;
+    for (u64 i = 0; i < end;) {
+        const u64* record = state.buffer + i;
+        u32 depth = (u32)(record[0] & 0xFFFFFFFF);
+        if (depth == 0 || i + 1 + depth > end) break;
+        for (u32 f = 0; f < depth; ++f) {
+            raw[n++] = frame_lookup_address(record, f);
+        }
+        i += 1 + depth;
+    }
+    qsort(raw, n, sizeof(u64), compare_u64);
+    u64 raw_count = 0;
+    for (u64 i = 0; i < n; ++i) {
+        if (i == 0 || raw[i] != raw[i - 1]) {
+            raw[raw_count++] = raw[i];
+        }
+    }
+
+    // Function start addresses of those become the symbol table
+    u64 starts_size = sizeof(u64) * raw_count;
+    u64* starts = kallocate(starts_size, MEMORY_TAG_APPLICATION);
+    u64* sorted_starts = kallocate(starts_size, MEMORY_TAG_APPLICATION);
+    for (u64 i = 0; i < raw_count; ++i) {
+        starts[i] = sampler_symbol_start(raw[i]);
+        sorted_starts[i] = starts[i];
+    }
+    qsort(sorted_starts, raw_count, sizeof(u64), compare_u64);
+    u32 symbol_count = 0;
+    for (u64 i = 0; i < raw_count; ++i) {
+        if (i == 0 || sorted_starts[i] != sorted_starts[i - 1]) {
+            sorted_starts[symbol_count++] = sorted_starts[i];
+        }
+    }
+
+    u64 symbols_size = sizeof(sampler_symbol) * symbol_count;
+    sampler_symbol* symbols = kallocate(symbols_size, MEMORY_TAG_APPLICATION);
+    for (u32 s = 0; s < symbol_count; ++s) {
+        symbols[s].address = sorted_starts[s];
+        symbols[s].last_sample = 0xFFFFFFFF;
+        sampler_symbol_name(sorted_starts[s], symbols[s].name, sizeof(symbols[s].name));
+    }
+    kfree(sorted_starts, starts_size, MEMORY_TAG_APPLICATION);
+
+    // Symbol of each distinct address, indexed like raw
+    u64 raw_symbols_size = sizeof(u32) * raw_count;
+    u32* raw_symbols = kallocate(raw_symbols_size, MEMORY_TAG_APPLICATION);
+    for (u64 i = 0; i < raw_count; ++i) {
+        raw_symbols[i] = sampler_find_symbol(symbols, symbol_count, starts[i]);
+    }
+    kfree(starts, starts_size, MEMORY_TAG_APPLICATION);
+
+    // Folded stacks: "thread;root;...;leaf", one line per sample, merged below
+    u64 folded_capacity = 0;
+    char* folded = 0;
+    char** lines = 0;
+    u64 lines_size = sizeof(char*) * sample_count;
+    if (folded_path) {
+        folded_capacity = sample_count * 40 + frame_count * (sizeof(symbols[0].name) + 1);
+        folded = kallocate(folded_capacity, MEMORY_TAG_APPLICATION);
+        lines = kallocate(lines_size, MEMORY_TAG_APPLICATION);
+    }
+    u64 folded_offset = 0;
+
+    u32 sample = 0;
+    for (u64 i = 0; i < end; ++sample) {
+        const u64* record = state.buffer + i;
+        u32 depth = (u32)(record[0] & 0xFFFFFFFF);
+        if (depth == 0 || i + 1 + depth > end) break;
+        u32 slot = (u32)(record[0] >> 32) - 1;
+
+        u32 ids[SAMPLER_MAX_DEPTH];
+        for (u32 f = 0; f < depth; ++f) {
+            u64* found = bsearch(&(u64){frame_lookup_address(record, f)}, raw, raw_count, sizeof(u64), compare_u64);
+            ids[f] = raw_symbols[found - raw];
+            sampler_symbol* symbol = &symbols[ids[f]];
+            if (symbol->last_sample != sample) {
+                symbol->last_sample = sample;
+                symbol->total++;
+            }
+        }
+        symbols[ids[0]].self++;
+
+        if (folded) {
+            char* line = folded + folded_offset;
+            i32 length = snprintf(line, folded_capacity - folded_offset, "%s",
+                                  slot < SAMPLER_MAX_THREADS ? state.threads[slot].name : "thread");
+            for (i32 f = (i32)depth - 1; f >= 0; --f) {
+                length += snprintf(line + length, folded_capacity - folded_offset - length, ";%s", symbols[ids[f]].name);
+            }
+            lines[sample] = line;
+            folded_offset += length + 1;
+        }
+        i += 1 + depth;
+    }
+
+    kfree(raw, raw_size, MEMORY_TAG_APPLICATION);
+    kfree(raw_symbols, raw_symbols_size, MEMORY_TAG_APPLICATION);
+
+    f64 seconds = platform_get_absolute_time() - state.start_time;
+
+    if (flat_path) {
+        FILE* file = fopen(flat_path, "w");
+        if (file) {
+            qsort(symbols, symbol_count, sizeof(sampler_symbol), compare_symbol_self);
+            fprintf(file, "# %llu samples at %u Hz over %.1f s, %llu dropped\n", sample_count, state.frequency_hz,
+                    seconds, state.dropped);
+            fprintf(file, "#  self%%     self  total%%    total  function\n");
+            for (u32 s = 0; s < symbol_count; ++s) {
+                fprintf(file, "%6.2f%% %8u %6.2f%% %8u  %s\n",
+                        100.0 * symbols[s].self / sample_count, symbols[s].self,
+                        100.0 * symbols[s].total / sample_count, symbols[s].total, symbols[s].name);
+            }
+            fclose(file);
+            INFO("Sampling profiler: flat profile written to '%s'", flat_path);
+        } else {
+            ERROR("Sampling profiler: could not open '%s'", flat_path);
+        }
+    }
+
+    if (folded) {
+        FILE* file = fopen(folded_path, "w");
+        if (file) {
+            qsort(lines, sample, sizeof(char*), compare_string);
+            u32 run = 0;
+            for (u32 l = 0; l < sample; ++l) {
+                run++;
+                if (l + 1 == sample || strcmp(lines[l], lines[l + 1]) != 0) {
+                    fprintf(file, "%s %u\n", lines[l], run);
+                    run = 0;
+                }
+            }
+            fclose(file);
+            INFO("Sampling profiler: folded stacks written to '%s'", folded_path);
+        } else {
+            ERROR("Sampling profiler: could not open '%s'", folded_path);
+        }
+        kfree(folded, folded_capacity, MEMORY_TAG_APPLICATION);
+        kfree(lines, lines_size, MEMORY_TAG_APPLICATION);
+    }
+
+    kfree(symbols, symbols_size, MEMORY_TAG_APPLICATION);
+    INFO("Sampling profiler: %llu samples over %.1f s", sample_count, seconds);
+    if (state.dropped > 0) {
+        WARN("Sampling profiler: buffer full, %llu samples dropped", state.dropped);
+    }
+}
+
+b8 sampling_profiler_stop(const char* flat_path, const char* folded_path) {
+    if (!sampling_profiler_is_running()) {
+        return FALSE;
+    }
+
+    platform_mutex_lock(&state.lock);
+    __atomic_store_n(&state.running, 0, __ATOMIC_RELEASE);
+    for (u32 i = 0; i < state.thread_count; ++i) {
+        sampler_disarm_thread(&state.threads[i]);
+    }
+    platform_mutex_unlock(&state.lock);
+
+    // A handler may still be finishing on another thread
+    while (__atomic_load_n(&state.in_flight, __ATOMIC_ACQUIRE) > 0) {
+        sched_yield();
+    }
+    sigaction(SIGPROF, &state.previous_action, 0);
+
+    sampler_write_reports(flat_path, folded_path);
+    return TRUE;
+}
+
+#else
+
+b8 sampling_profiler_start(u32 frequency_hz) {
+    WARN("The sampling profiler is only implemented on Linux");
+    return FALSE;
+}
+
+b8 sampling_profiler_stop(const char* flat_path, const char* folded_path) {
+    return FALSE;
+}
+
+b8 sampling_profiler_is_running() {
+    return FALSE;
+}
+
+void sampling_profiler_register_thread(const char* name) {
+}
+
+void sampling_profiler_unregister_thread() {
+}
+
+#endif
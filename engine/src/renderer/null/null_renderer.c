@@ -0,0 +1,283 @@
+#include "null_renderer.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "renderer/renderer_stats.h"
+#include "models/model.h"
+#include "resources/texture_compression.h"
+
+static u32 next_mesh_id = 0;
+static u32 next_font_id = 0;
+static u32 next_texture_id = 1;
+static null_renderer_state* global_renderer_state = NULL;
+
+b8 null_renderer_backend_initialize(renderer_backend* backend, const char* application_name, struct platform_state* plat_state) {
+    null_renderer_state* state = kallocate(sizeof(null_renderer_state), MEMORY_TAG_RENDERER);
+    backend->internal_state = state;
+    backend->plat_state = plat_state;
+    global_renderer_state = state;
+
+    INFO("Null renderer initialized for '%s', no GPU work will be issued", application_name);
+    return TRUE;
+}
+
+void null_renderer_backend_shutdown(renderer_backend* backend) {
+    null_renderer_state* state = (null_renderer_state*)backend->internal_state;
+    if (!state) return;
+
+    INFO("Null renderer: %llu frames, %llu draw calls, %llu vertex bytes and %llu texture bytes uploaded",
+         backend->frame_number, state->total_draw_calls, state->vertex_bytes, state->texture_bytes);
+
+    // Anything still alive at this point was leaked by the caller
+    if (state->mesh_count || state->model_count || state->font_count || state->texture_count) {
+        WARN("Null renderer: leaked %llu meshes, %llu models, %llu fonts, %llu textures at shutdown",
+             state->mesh_count, state->model_count, state->font_count, state->texture_count);
+    }
+
+    kfree(state, sizeof(null_renderer_state), MEMORY_TAG_RENDERER);
+    backend->internal_state = NULL;
+    global_renderer_state = NULL;
+}
+
+void null_renderer_backend_resized(renderer_backend* backend, u16 width, u16 height) {
+}
+
+b8 null_renderer_backend_begin_frame(renderer_backend* backend, render_packet* packet) {
+    return TRUE;
+}
+
+b8 null_renderer_backend_end_frame(renderer_backend* backend, render_packet* packet) {
+    return TRUE;
+}
+
+b8 null_renderer_draw_frame(renderer_backend* backend, render_packet* packet) {
+    if (!packet) return FALSE;
+
+    for (u32 i = 0; i < packet->mesh_commands.count; i++) {
+        mesh_command* cmd = &packet->mesh_commands.commands[i];
+        null_renderer_draw_mesh(cmd->mesh, cmd->position, cmd->rotation, cmd->scale);
+    }
+    for (u32 i = 0; i < packet->model_commands.count; i++) {
+        model_command* cmd = &packet->model_commands.commands[i];
+        null_renderer_draw_model(cmd->model, cmd->position, cmd->rotation, cmd->scale);
+    }
+    null_renderer_draw_quads(packet->quad_commands.commands, packet->quad_commands.count);
+    for (u32 i = 0; i < packet->text_commands.count; i++) {
+        text_command* cmd = &packet->text_commands.commands[i];
+        null_renderer_draw_text(cmd->font, cmd->text, cmd->position, cmd->color, cmd->scale);
+    }
+    return TRUE;
+}
+
+b8 null_renderer_backend_bind_context(renderer_backend* backend, b8 bind) {
+    return TRUE;
+}
+
+void null_renderer_backend_begin_pass(renderer_backend* backend, renderer_pass pass) {
+}
+
+void null_renderer_backend_end_pass(renderer_backend* backend, renderer_pass pass) {
+}
+
+b8 null_renderer_backend_get_gpu_timings(renderer_backend* backend, renderer_gpu_timings* out_timings) {
+    // Nothing runs on a GPU
+    return FALSE;
+}
+
+// Mesh functions
+mesh* null_renderer_create_mesh(const vertex* vertices, u32 vertex_count) {
+    return null_renderer_create_indexed_mesh(vertices, vertex_count, 0, 0, 0);
+}
+
+mesh* null_renderer_create_indexed_mesh(const vertex* vertices, u32 vertex_count, const void* indices, u32 index_count, u32 index_size) {
+    mesh* m = kallocate(sizeof(mesh), MEMORY_TAG_RENDERER);
+    m->vertex_count = vertex_count;
+    m->vertex_buffer_size = sizeof(vertex) * vertex_count;
+    m->id = next_mesh_id++;
+    m->index_count = indices ? index_count : 0;
+    m->index_size = m->index_count == 0 ? 0 : vertex_count <= 0x10000 ? sizeof(u16) : index_size;
+
+    u64 uploaded = (u64)m->vertex_buffer_size + (u64)m->index_count * m->index_size;
+    if (global_renderer_state) {
+        global_renderer_state->mesh_count++;
+        global_renderer_state->vertex_bytes += uploaded;
+    }
+    renderer_stats_count_buffer_upload(uploaded);
+    return m;
+}
+
+void null_renderer_destroy_mesh(mesh* m) {
+    if (!m) return;
+
+    if (global_renderer_state) {
+        global_renderer_state->mesh_count--;
+    }
+    kfree(m, sizeof(mesh), MEMORY_TAG_RENDERER);
+}
+
+void null_renderer_draw_mesh(mesh* m, vec3 position, vec3 rotation, vec3 scale) {
+    if (!m) {
+        ERROR("Cannot draw NULL mesh");
+        return;
+    }
+    if (global_renderer_state) {
+        global_renderer_state->total_draw_calls++;
+    }
+    renderer_stats_count_draw(m->index_count ? m->index_count : m->vertex_count);
+}
+
+mesh* null_renderer_get_mesh(u32 mesh_id) {
+    return NULL;
+}
+
+// Font functions
+font* null_renderer_create_font(const char* font_path, u32 font_size) {
+    // Glyph metrics are left zeroed, the font only has to be a valid handle
+    font* f = kallocate(sizeof(font), MEMORY_TAG_RENDERER);
+    f->id = next_font_id++;
+    if (global_renderer_state) {
+        global_renderer_state->font_count++;
+    }
+    return f;
+}
+
+font* null_renderer_create_fallback_font(u32 font_size) {
+    return null_renderer_create_font(NULL, font_size);
+}
+
+void null_renderer_destroy_font(font* f) {
+    if (!f) return;
+
+    if (global_renderer_state) {
+        global_renderer_state->font_count--;
+    }
+    kfree(f, sizeof(font), MEMORY_TAG_RENDERER);
+}
+
+void null_renderer_draw_text(font* f, const char* text, vec2 position, vec4 color, f32 scale) {
+    PROFILE_FUNCTION();
+    if (!f || !text || !global_renderer_state) {
+        return;
+    }
+    // The OpenGL backend issues one draw per visible glyph, count the same way
+    for (const char* c = text; *c; c++) {
+        if (*c != ' ') {
+            global_renderer_state->total_draw_calls++;
+            renderer_stats_count_draw(6);
+        }
+    }
+}
+
+// Model functions
+model* null_renderer_create_model(const char* model_path) {
+    // Parsing still runs so headless runs measure real CPU-side load cost
+    model* m = model_load_obj(model_path);
+    if (!m) {
+        ERROR("Failed to load model from path: %s", model_path);
+        return NULL;
+    }
+    if (global_renderer_state) {
+        global_renderer_state->model_count++;
+    }
+    return m;
+}
+
+void null_renderer_destroy_model(model* m) {
+    if (!m) {
+        ERROR("Cannot destroy NULL model");
+        return;
+    }
+    if (global_renderer_state) {
+        global_renderer_state->model_count--;
+    }
+    model_destroy(m);
+}
+
+void null_renderer_draw_model(model* m, vec3 position, vec3 rotation, vec3 scale) {
+    if (!m) {
+        ERROR("Cannot draw NULL model");
+        return;
+    }
+    null_renderer_draw_mesh(m->mesh, position, rotation, scale);
+}
+
+// Texture functions
+b8 null_renderer_create_texture(texture* t, const u8* pixels) {
+    if (t->channels < 1 || t->channels > 4) {
+        ERROR("Unsupported number of channels: %d", t->channels);
+        return FALSE;
+    }
+    t->id = next_texture_id++;
+    if (global_renderer_state) {
+        global_renderer_state->texture_count++;
+        global_renderer_state->texture_bytes += (u64)t->width * t->height * t->channels;
+    }
+    renderer_stats_count_buffer_upload((u64)t->width * t->height * t->channels);
+    return TRUE;
+}
+
+void null_renderer_destroy_texture(texture* t) {
+    if (global_renderer_state) {
+        global_renderer_state->texture_count--;
+    }
+    t->id = 0;
+}
+
+b8 null_renderer_create_texture_storage(texture* t, u32 level_count) {
+    if (t->channels < 1 || t->channels > 4 || (t->compression != TEXTURE_COMPRESSION_NONE && level_count == 0)) {
+        ERROR("Unsupported texture: %d channels, %u levels", t->channels, level_count);
+        return FALSE;
+    }
+    t->id = next_texture_id++;
+    if (global_renderer_state) {
+        global_renderer_state->texture_count++;
+    }
+    return TRUE;
+}
+
+void null_renderer_upload_texture_rows(texture* t, u32 level, const u8* pixels, u32 first_row, u32 row_count) {
+    u32 width = t->width >> level ? t->width >> level : 1;
+    u64 bytes = t->compression != TEXTURE_COMPRESSION_NONE
+                    ? texture_compression_level_size(t->compression, width, row_count)
+                    : (u64)width * t->channels * row_count;
+    if (global_renderer_state) {
+        global_renderer_state->texture_bytes += bytes;
+    }
+    renderer_stats_count_buffer_upload(bytes);
+}
+
+void null_renderer_finish_texture_upload(texture* t, b8 generate_mipmaps) {
+}
+
+b8 null_renderer_create_texture_levels(texture* t, const texture_level* levels, u32 level_count) {
+    if (t->channels < 1 || t->channels > 4 || level_count == 0) {
+        ERROR("Unsupported texture: %d channels, %u levels", t->channels, level_count);
+        return FALSE;
+    }
+    t->id = next_texture_id++;
+    u64 bytes = 0;
+    for (u32 i = 0; i < level_count; ++i) {
+        bytes += levels[i].size;
+    }
+    if (global_renderer_state) {
+        global_renderer_state->texture_count++;
+        global_renderer_state->texture_bytes += bytes;
+    }
+    renderer_stats_count_buffer_upload(bytes);
+    return TRUE;
+}
+
+b8 null_renderer_supports_texture_compression(texture_compression compression) {
+    // Stands in for a GPU with every format, texture_bytes then shows the
+    // compressed sizes
+    return TRUE;
+}
+
+void null_renderer_draw_quads(const quad_command* quads, u32 count) {
+    if (!quads || count == 0 || !global_renderer_state) {
+        return;
+    }
+    // Batched into a single draw, same as the OpenGL backend
+    global_renderer_state->total_draw_calls++;
+    renderer_stats_count_draw(count * 6);
+}
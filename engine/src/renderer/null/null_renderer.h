@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../renderer_backend.h"
+
+// Bookkeeping kept by the null backend in place of GPU work.
+typedef struct null_renderer_state {
+    // Resources currently alive
+    u64 mesh_count;
+    u64 model_count;
+    u64 font_count;
+    u64 texture_count;
+    // Bytes that would have been uploaded to the GPU
+    u64 vertex_bytes;
+    u64 texture_bytes;
+    // Draw calls issued since startup
+    u64 total_draw_calls;
+} null_renderer_state;
+
+b8 null_renderer_backend_initialize(renderer_backend* backend, const char* application_name, struct platform_state* plat_state);
+void null_renderer_backend_shutdown(renderer_backend* backend);
+void null_renderer_backend_resized(renderer_backend* backend, u16 width, u16 height);
+b8 null_renderer_backend_begin_frame(renderer_backend* backend, render_packet* packet);
+b8 null_renderer_backend_end_frame(renderer_backend* backend, render_packet* packet);
+b8 null_renderer_draw_frame(renderer_backend* backend, render_packet* packet);
+b8 null_renderer_backend_bind_context(renderer_backend* backend, b8 bind);
+void null_renderer_backend_begin_pass(renderer_backend* backend, renderer_pass pass);
+void null_renderer_backend_end_pass(renderer_backend* backend, renderer_pass pass);
+b8 null_renderer_backend_get_gpu_timings(renderer_backend* backend, renderer_gpu_timings* out_timings);
+
+// Mesh functions
+mesh* null_renderer_create_mesh(const vertex* vertices, u32 vertex_count);
+mesh* null_renderer_create_indexed_mesh(const vertex* vertices, u32 vertex_count, const void* indices, u32 index_count, u32 index_size);
+void null_renderer_destroy_mesh(mesh* m);
+void null_renderer_draw_mesh(mesh* m, vec3 position, vec3 rotation, vec3 scale);
+mesh* null_renderer_get_mesh(u32 mesh_id);
+
+// Font functions
+font* null_renderer_create_font(const char* font_path, u32 font_size);
+font* null_renderer_create_fallback_font(u32 font_size);
+void null_renderer_destroy_font(font* f);
+void null_renderer_draw_text(font* f, const char* text, vec2 position, vec4 color, f32 scale);
+
+// Overlay functions
+void null_renderer_draw_quads(const quad_command* quads, u32 count);
+
+// Model functions
+model* null_renderer_create_model(const char* model_path);
+void null_renderer_destroy_model(model* m);
+void null_renderer_draw_model(model* m, vec3 position, vec3 rotation, vec3 scale);
+
+// Texture functions
+b8 null_renderer_create_texture(texture* t, const u8* pixels);
+void null_renderer_destroy_texture(texture* t);
+b8 null_renderer_create_texture_storage(texture* t, u32 level_count);
+void null_renderer_upload_texture_rows(texture* t, u32 level, const u8* pixels, u32 first_row, u32 row_count);
+void null_renderer_finish_texture_upload(texture* t, b8 generate_mipmaps);
+b8 null_renderer_create_texture_levels(texture* t, const texture_level* levels, u32 level_count);
+b8 null_renderer_supports_texture_compression(texture_compression compression);
@@ -0,0 +1,174 @@
+#include "opengl_gpu_timer.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+
+#define FRAME_BEGIN_QUERY 0
+#define FRAME_END_QUERY 1
+#define PASS_BEGIN_QUERY(pass) (2 + 2 * (pass))
+#define PASS_END_QUERY(pass) (3 + 2 * (pass))
+
+static const char* pass_names[RENDERER_PASS_MAX] = {"text", "meshes", "models", "quads"};
+
+static f64 query_interval_ms(const u64* stamps, const b8* issued, u32 begin, u32 end) {
+    if (!issued[begin] || !issued[end] || stamps[end] < stamps[begin]) {
+        return 0;
+    }
+    return (f64)(stamps[end] - stamps[begin]) / 1000000.0;
+}
+
+// Reads a frame's timestamps if the GPU has written all of them. Never waits.
+static b8 gpu_timer_try_resolve(gpu_timer* timer, gpu_timer_frame* frame) {
+    for (u32 i = 0; i < GPU_TIMER_QUERIES_PER_FRAME; ++i) {
+        if (!frame->issued[i]) continue;
+        GLint available = 0;
+        glGetQueryObjectiv(frame->queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            return FALSE;
+        }
+    }
+
+    u64 stamps[GPU_TIMER_QUERIES_PER_FRAME] = {0};
+    for (u32 i = 0; i < GPU_TIMER_QUERIES_PER_FRAME; ++i) {
+        if (frame->issued[i]) {
+            GLuint64 value = 0;
+            glGetQueryObjectui64v(frame->queries[i], GL_QUERY_RESULT, &value);
+            stamps[i] = value;
+        }
+    }
+
+    renderer_gpu_timings timings = {0};
+    timings.frame_number = frame->frame_number;
+    timings.frame_ms = query_interval_ms(stamps, frame->issued, FRAME_BEGIN_QUERY, FRAME_END_QUERY);
+    for (u32 p = 0; p < RENDERER_PASS_MAX; ++p) {
+        timings.pass_ms[p] = query_interval_ms(stamps, frame->issued, PASS_BEGIN_QUERY(p), PASS_END_QUERY(p));
+    }
+    frame->pending = FALSE;
+
+    if (!timer->has_latest || timings.frame_number > timer->latest.frame_number) {
+        timer->latest = timings;
+        timer->has_latest = TRUE;
+    }
+
+    timer->sum.frame_ms += timings.frame_ms;
+    for (u32 p = 0; p < RENDERER_PASS_MAX; ++p) {
+        timer->sum.pass_ms[p] += timings.pass_ms[p];
+    }
+    timer->sum_count++;
+    if (timer->sum_count >= GPU_TIMER_REPORT_FRAMES) {
+        f64 n = (f64)timer->sum_count;
+        INFO("GPU timings up to frame %llu (avg of %u): frame %.3f ms, %s %.3f ms, %s %.3f ms, %s %.3f ms, %s %.3f ms, %llu dropped",
+             timings.frame_number, timer->sum_count, timer->sum.frame_ms / n,
+             pass_names[RENDERER_PASS_TEXT], timer->sum.pass_ms[RENDERER_PASS_TEXT] / n,
+             pass_names[RENDERER_PASS_MESHES], timer->sum.pass_ms[RENDERER_PASS_MESHES] / n,
+             pass_names[RENDERER_PASS_MODELS], timer->sum.pass_ms[RENDERER_PASS_MODELS] / n,
+             pass_names[RENDERER_PASS_QUADS], timer->sum.pass_ms[RENDERER_PASS_QUADS] / n,
+             timer->dropped_frames);
+        kzero_memory(&timer->sum, sizeof(renderer_gpu_timings));
+        timer->sum_count = 0;
+        timer->dropped_frames = 0;
+    }
+    return TRUE;
+}
+
+void gpu_timer_initialize(gpu_timer* timer) {
+    kzero_memory(timer, sizeof(gpu_timer));
+
+    // Timestamp queries are core in GL 3.3, but some drivers expose the
+    // extension with a 0-bit counter or return garbage.
+    if (!GLEW_VERSION_3_3 && !GLEW_ARB_timer_query) {
+        WARN("GL timer queries not supported, GPU timings are disabled");
+        return;
+    }
+    GLint counter_bits = 0;
+    glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &counter_bits);
+    if (counter_bits == 0) {
+        WARN("GL timestamp counter has 0 bits, GPU timings are disabled");
+        return;
+    }
+
+    for (u32 i = 0; i < GPU_TIMER_FRAMES_IN_FLIGHT; ++i) {
+        glGenQueries(GPU_TIMER_QUERIES_PER_FRAME, timer->frames[i].queries);
+    }
+
+    // Read one pair back before trusting the counter. This waits on the GPU,
+    // but only once at startup.
+    const u32* probe = timer->frames[0].queries;
+    glQueryCounter(probe[0], GL_TIMESTAMP);
+    glQueryCounter(probe[1], GL_TIMESTAMP);
+    GLuint64 first = 0;
+    GLuint64 second = 0;
+    glGetQueryObjectui64v(probe[0], GL_QUERY_RESULT, &first);
+    glGetQueryObjectui64v(probe[1], GL_QUERY_RESULT, &second);
+    if (first == 0 || second < first) {
+        WARN("GL timestamps look broken (%llu then %llu), GPU timings are disabled", (u64)first, (u64)second);
+        for (u32 i = 0; i < GPU_TIMER_FRAMES_IN_FLIGHT; ++i) {
+            glDeleteQueries(GPU_TIMER_QUERIES_PER_FRAME, timer->frames[i].queries);
+        }
+        return;
+    }
+    timer->supported = TRUE;
+    INFO("GPU timer queries enabled (%d-bit counter, %d frames in flight)", counter_bits, GPU_TIMER_FRAMES_IN_FLIGHT);
+}
+
+void gpu_timer_shutdown(gpu_timer* timer) {
+    if (!timer->supported) return;
+    for (u32 i = 0; i < GPU_TIMER_FRAMES_IN_FLIGHT; ++i) {
+        glDeleteQueries(GPU_TIMER_QUERIES_PER_FRAME, timer->frames[i].queries);
+    }
+    timer->supported = FALSE;
+}
+
+void gpu_timer_begin_frame(gpu_timer* timer, u64 frame_number) {
+    if (!timer->supported) return;
+
+    // Pick up anything that finished since last frame, oldest first
+    for (u32 i = 0; i < GPU_TIMER_FRAMES_IN_FLIGHT; ++i) {
+        u64 oldest = frame_number - GPU_TIMER_FRAMES_IN_FLIGHT + i;
+        gpu_timer_frame* frame = &timer->frames[oldest % GPU_TIMER_FRAMES_IN_FLIGHT];
+        if (frame->pending && frame->frame_number == oldest) {
+            gpu_timer_try_resolve(timer, frame);
+        }
+    }
+
+    gpu_timer_frame* frame = &timer->frames[frame_number % GPU_TIMER_FRAMES_IN_FLIGHT];
+    if (frame->pending) {
+        // Still not done after a full ring of frames, reuse the queries anyway
+        // rather than block on the result.
+        timer->dropped_frames++;
+    }
+    kzero_memory(frame->issued, sizeof(frame->issued));
+    frame->frame_number = frame_number;
+    frame->pending = TRUE;
+    timer->current = frame;
+
+    glQueryCounter(frame->queries[FRAME_BEGIN_QUERY], GL_TIMESTAMP);
+    frame->issued[FRAME_BEGIN_QUERY] = TRUE;
+}
+
+void gpu_timer_end_frame(gpu_timer* timer) {
+    if (!timer->supported || !timer->current) return;
+    glQueryCounter(timer->current->queries[FRAME_END_QUERY], GL_TIMESTAMP);
+    timer->current->issued[FRAME_END_QUERY] = TRUE;
+    timer->current = 0;
+}
+
+void gpu_timer_begin_pass(gpu_timer* timer, renderer_pass pass) {
+    if (!timer->supported || !timer->current || pass >= RENDERER_PASS_MAX) return;
+    glQueryCounter(timer->current->queries[PASS_BEGIN_QUERY(pass)], GL_TIMESTAMP);
+    timer->current->issued[PASS_BEGIN_QUERY(pass)] = TRUE;
+}
+
+void gpu_timer_end_pass(gpu_timer* timer, renderer_pass pass) {
+    if (!timer->supported || !timer->current || pass >= RENDERER_PASS_MAX) return;
+    glQueryCounter(timer->current->queries[PASS_END_QUERY(pass)], GL_TIMESTAMP);
+    timer->current->issued[PASS_END_QUERY(pass)] = TRUE;
+}
+
+b8 gpu_timer_get_latest(const gpu_timer* timer, renderer_gpu_timings* out_timings) {
+    if (!timer->has_latest) {
+        return FALSE;
+    }
+    *out_timings = timer->latest;
+    return TRUE;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../renderer_types.inl"
+
+// Frames of queries kept in flight. Results are read this many frames late at
+// worst, by which time the GPU has normally finished and reads never stall.
+#define GPU_TIMER_FRAMES_IN_FLIGHT 4
+// Average GPU timings are logged every this many resolved frames.
+#define GPU_TIMER_REPORT_FRAMES 300
+
+// One begin/end timestamp pair for the frame and for each pass.
+#define GPU_TIMER_QUERIES_PER_FRAME (2 * (RENDERER_PASS_MAX + 1))
+
+typedef struct gpu_timer_frame {
+    u32 queries[GPU_TIMER_QUERIES_PER_FRAME];
+    // Which queries were issued this frame, passes that had no draws are skipped.
+    b8 issued[GPU_TIMER_QUERIES_PER_FRAME];
+    u64 frame_number;
+    b8 pending;
+} gpu_timer_frame;
+
+typedef struct gpu_timer {
+    b8 supported;
+    gpu_timer_frame frames[GPU_TIMER_FRAMES_IN_FLIGHT];
+    gpu_timer_frame* current;
+
+    renderer_gpu_timings latest;
+    b8 has_latest;
+
+    // Running sums for the periodic report.
+    renderer_gpu_timings sum;
+    u32 sum_count;
+    u64 dropped_frames;
+} gpu_timer;
+
+// Creates the query objects and checks that one timestamp pair reads back
+// nonzero and in order. Leaves the timer disabled if timestamp queries are
+// unavailable or fail that check, in which case every other call is a no-op.
+void gpu_timer_initialize(gpu_timer* timer);
+void gpu_timer_shutdown(gpu_timer* timer);
+
+// Collects finished frames and starts timing frame_number.
+void gpu_timer_begin_frame(gpu_timer* timer, u64 frame_number);
+void gpu_timer_end_frame(gpu_timer* timer);
+void gpu_timer_begin_pass(gpu_timer* timer, renderer_pass pass);
+void gpu_timer_end_pass(gpu_timer* timer, renderer_pass pass);
+
+b8 gpu_timer_get_latest(const gpu_timer* timer, renderer_gpu_timings* out_timings);
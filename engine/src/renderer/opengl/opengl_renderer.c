@@ -3,12 +3,17 @@
 #include "core/kmemory.h"
 #include "core/kstring.h"
 #include "core/logger.h"
+#include "core/profiler.h"
+#include "renderer/renderer_stats.h"
 #include "core/file_operations.h"
 #include "platform/platform.h"
 #include "models/model.h"
 #include "resources/texture.h"
+#include "resources/texture_compression.h"
+#include "containers/darray.h"
 #include <GL/glew.h>
 #include <SDL2/SDL.h>
+#include <stdlib.h>
 
 // Forward declare check functions
 void check_shader_error(u32 shader, const char* type);
@@ -17,8 +22,30 @@ void check_gl_error(const char* op);
 
 
 static u32 next_mesh_id = 0;
+static u32 next_font_id = 0;
 static opengl_renderer_state* global_renderer_state = NULL;
 
+// Overlay quads only need a position in pixels and a flat color
+static const char* quad_vertex_source =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 a_position;\n"
+    "layout(location = 1) in vec4 a_color;\n"
+    "uniform vec2 screen_size;\n"
+    "out vec4 v_color;\n"
+    "void main() {\n"
+    "    vec2 ndc = a_position / screen_size * 2.0 - 1.0;\n"
+    "    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);\n"
+    "    v_color = a_color;\n"
+    "}\n";
+
+static const char* quad_fragment_source =
+    "#version 330 core\n"
+    "in vec4 v_color;\n"
+    "out vec4 frag_color;\n"
+    "void main() {\n"
+    "    frag_color = v_color;\n"
+    "}\n";
+
 // Paths to common system fonts for fallback
 static const char* fallback_font_paths[] = {
     "/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf",  // Linux (Debian/Ubuntu)
@@ -158,6 +185,27 @@ b8 opengl_renderer_backend_initialize(renderer_backend* backend, const char* app
         0.0f, 0.0f, 0.0f, 1.0f
     };
 
+    gpu_timer_initialize(&state->gpu_timer);
+
+    // Overlay quads, batched into one dynamic buffer per frame
+    shader_program quad_shader = shader_create_from_source(quad_vertex_source, quad_fragment_source);
+    if (quad_shader.program_id == 0) {
+        ERROR("Failed to create overlay quad shader program");
+        return FALSE;
+    }
+    state->quad_shader_program = quad_shader.program_id;
+    state->quad_vertices = darray_create(quad_vertex);
+    glGenVertexArrays(1, &state->quad_vao);
+    glGenBuffers(1, &state->quad_vbo);
+    glBindVertexArray(state->quad_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, state->quad_vbo);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(quad_vertex), (void*)offsetof(quad_vertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(quad_vertex), (void*)offsetof(quad_vertex, color));
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
     return TRUE;
 }
 
@@ -166,8 +214,20 @@ void opengl_renderer_backend_shutdown(renderer_backend* backend) {
     if (!state) return;
 
     // Clean up OpenGL resources
+    gpu_timer_shutdown(&state->gpu_timer);
+    glDeleteVertexArrays(1, &state->quad_vao);
+    glDeleteBuffers(1, &state->quad_vbo);
+    shader_program quad_shader = {0};
+    quad_shader.program_id = state->quad_shader_program;
+    shader_destroy(&quad_shader);
+    if (state->quad_vertices) {
+        darray_destroy(state->quad_vertices);
+    }
     glDeleteVertexArrays(1, &state->vao);
     glDeleteBuffers(1, &state->vbo);
+    if (state->upload_pbo) {
+        glDeleteBuffers(1, &state->upload_pbo);
+    }
     
     // Clean up shaders using our new shader system
     shader_program standard_shader = {0};
@@ -201,6 +261,7 @@ void opengl_renderer_backend_resized(renderer_backend* backend, u16 width, u16 h
 b8 opengl_renderer_backend_begin_frame(renderer_backend* backend, render_packet* packet) {
     opengl_renderer_state* state = (opengl_renderer_state*)backend->internal_state;
     state->current_packet = packet;
+    gpu_timer_begin_frame(&state->gpu_timer, backend->frame_number);
 
     glClearColor(0.0f, 0.0f, 0.2f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -209,6 +270,8 @@ b8 opengl_renderer_backend_begin_frame(renderer_backend* backend, render_packet*
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // Clear color, depth test, blend and blend func
+    renderer_stats_count_state_changes(4);
     
     // Update view matrix with current camera data
     if (packet) {
@@ -220,27 +283,79 @@ b8 opengl_renderer_backend_begin_frame(renderer_backend* backend, render_packet*
 
 b8 opengl_renderer_backend_end_frame(renderer_backend* backend, render_packet* packet) {
     opengl_renderer_state* state = (opengl_renderer_state*)backend->internal_state;
+    gpu_timer_end_frame(&state->gpu_timer);
     SDL_GL_SwapWindow(backend->plat_state->window_handle);
     return TRUE;
 }
 
+b8 opengl_renderer_backend_bind_context(renderer_backend* backend, b8 bind) {
+    opengl_renderer_state* state = (opengl_renderer_state*)backend->internal_state;
+    // A GL context can only be current on one thread at a time
+    if (SDL_GL_MakeCurrent(state->window, bind ? state->gl_context : NULL) != 0) {
+        ERROR("Failed to %s GL context: %s", bind ? "bind" : "release", SDL_GetError());
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void opengl_renderer_backend_begin_pass(renderer_backend* backend, renderer_pass pass) {
+    opengl_renderer_state* state = (opengl_renderer_state*)backend->internal_state;
+    gpu_timer_begin_pass(&state->gpu_timer, pass);
+}
+
+void opengl_renderer_backend_end_pass(renderer_backend* backend, renderer_pass pass) {
+    opengl_renderer_state* state = (opengl_renderer_state*)backend->internal_state;
+    gpu_timer_end_pass(&state->gpu_timer, pass);
+}
+
+b8 opengl_renderer_backend_get_gpu_timings(renderer_backend* backend, renderer_gpu_timings* out_timings) {
+    opengl_renderer_state* state = (opengl_renderer_state*)backend->internal_state;
+    return gpu_timer_get_latest(&state->gpu_timer, out_timings);
+}
+
 // Mesh functions
 mesh* opengl_renderer_create_mesh(const vertex* vertices, u32 vertex_count) {
+    return opengl_renderer_create_indexed_mesh(vertices, vertex_count, 0, 0, 0);
+}
+
+mesh* opengl_renderer_create_indexed_mesh(const vertex* vertices, u32 vertex_count, const void* indices, u32 index_count, u32 index_size) {
     mesh* m = kallocate(sizeof(mesh), MEMORY_TAG_RENDERER);
     m->vertex_count = vertex_count;
     m->vertex_buffer_size = sizeof(vertex) * vertex_count;
-    m->vertices = kallocate(m->vertex_buffer_size, MEMORY_TAG_RENDERER);
     m->id = next_mesh_id++;
-    kcopy_memory(m->vertices, vertices, m->vertex_buffer_size);
 
     // Create and bind VAO
     glGenVertexArrays(1, &m->vao);
     glBindVertexArray(m->vao);
+    renderer_stats_count_vao_bind();
 
     // Create and bind VBO
     glGenBuffers(1, &m->vbo);
     glBindBuffer(GL_ARRAY_BUFFER, m->vbo);
-    glBufferData(GL_ARRAY_BUFFER, m->vertex_buffer_size, m->vertices, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, m->vertex_buffer_size, vertices, GL_STATIC_DRAW);
+    renderer_stats_count_buffer_upload(m->vertex_buffer_size);
+
+    // The element buffer binding is part of the VAO state
+    if (indices && index_count > 0) {
+        m->index_count = index_count;
+        glGenBuffers(1, &m->ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m->ebo);
+        if (index_size == sizeof(u32) && vertex_count <= 0x10000) {
+            // Half the index memory and bandwidth when every vertex fits in a u16
+            m->index_size = sizeof(u16);
+            const u32* wide = indices;
+            u16* narrow = kallocate(sizeof(u16) * index_count, MEMORY_TAG_RENDERER);
+            for (u32 i = 0; i < index_count; ++i) {
+                narrow[i] = (u16)wide[i];
+            }
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(u16) * index_count, narrow, GL_STATIC_DRAW);
+            kfree(narrow, sizeof(u16) * index_count, MEMORY_TAG_RENDERER);
+        } else {
+            m->index_size = index_size;
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, (u64)index_size * index_count, indices, GL_STATIC_DRAW);
+        }
+        renderer_stats_count_buffer_upload(m->index_size * index_count);
+    }
 
     // Set vertex attributes
     // Position attribute (3 floats)
@@ -257,6 +372,8 @@ mesh* opengl_renderer_create_mesh(const vertex* vertices, u32 vertex_count) {
     glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, color));
     glEnableVertexAttribArray(2);
     INFO("Mesh %u: Set color attribute at location 2, offset %lu", m->id, offsetof(vertex, color));
+    // Unbind so later buffer binds can't land in this mesh's VAO
+    glBindVertexArray(0);
 
     // Debug: Check first few vertices
     if (vertex_count > 0) {
@@ -278,13 +395,14 @@ void opengl_renderer_destroy_mesh(mesh* m) {
     // Clean up OpenGL resources
     glDeleteVertexArrays(1, &m->vao);
     glDeleteBuffers(1, &m->vbo);
+    if (m->ebo) {
+        glDeleteBuffers(1, &m->ebo);
+    }
 
-    // Free vertex data
-    kfree(m->vertices, m->vertex_buffer_size, MEMORY_TAG_RENDERER);
     kfree(m, sizeof(mesh), MEMORY_TAG_RENDERER);
 }
 
-void opengl_renderer_draw_mesh(mesh* m) {
+void opengl_renderer_draw_mesh(mesh* m, vec3 position, vec3 rotation, vec3 scale) {
     if (!m) {
         ERROR("Cannot draw NULL mesh");
         return;
@@ -316,38 +434,8 @@ void opengl_renderer_draw_mesh(mesh* m) {
         // Set the projection matrix uniform using our shader system
         shader_set_mat4(&program, "projection", &state->projection_matrix, FALSE);
         
-        // Find the matching mesh command to get position, rotation and scale values
-        for (u32 i = 0; i < state->current_packet->mesh_commands.count; i++) {
-            if (state->current_packet->mesh_commands.commands[i].mesh == m) {
-                // Create model matrix from mesh properties
-                create_model_matrix(&state->model_matrix,
-                                  state->current_packet->mesh_commands.commands[i].position,
-                                  state->current_packet->mesh_commands.commands[i].rotation,
-                                  state->current_packet->mesh_commands.commands[i].scale);
-                
-                // Set the model matrix uniform using our shader system
-                shader_set_mat4(&program, "model", &state->model_matrix, FALSE);
-                break;
-            }
-        }
-        //TODO: Find a better way to do this
-        for(u32 i = 0; i < state->current_packet->model_commands.count; i++)
-        {
-            if(state->current_packet->model_commands.commands[i].model->mesh == m)
-            {
-                // Create model matrix from mesh properties
-                create_model_matrix(&state->model_matrix,
-                                  state->current_packet->model_commands.commands[i].position,
-                                  state->current_packet->model_commands.commands[i].rotation,
-                                  state->current_packet->model_commands.commands[i].scale);
-                
-                // Set the model matrix uniform using our shader system
-                shader_set_mat4(&program, "model", &state->model_matrix, FALSE);
-                break;
-            }
-        }
     } else {
-        // Set identity matrices for model, view and projection when no packet is available
+        // Set identity matrices for view and projection when no packet is available
         mat4 identity = {
             1.0f, 0.0f, 0.0f, 0.0f,
             0.0f, 1.0f, 0.0f, 0.0f,
@@ -355,17 +443,29 @@ void opengl_renderer_draw_mesh(mesh* m) {
             0.0f, 0.0f, 0.0f, 1.0f
         };
         
-        shader_set_mat4(&program, "model", &identity, FALSE);
         shader_set_mat4(&program, "view", &identity, FALSE);
         shader_set_mat4(&program, "projection", &identity, FALSE);
     }
+
+    // The transform comes with each draw, a shared mesh shows up in several commands
+    create_model_matrix(&state->model_matrix, position, rotation, scale);
+    shader_set_mat4(&program, "model", &state->model_matrix, FALSE);
     
     // Bind VAO and draw
     glBindVertexArray(m->vao);
-    glDrawArrays(GL_TRIANGLES, 0, m->vertex_count);
+    if (m->index_count > 0) {
+        GLenum index_type = m->index_size == sizeof(u16) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        glDrawElements(GL_TRIANGLES, m->index_count, index_type, 0);
+        renderer_stats_count_draw(m->index_count);
+    } else {
+        glDrawArrays(GL_TRIANGLES, 0, m->vertex_count);
+        renderer_stats_count_draw(m->vertex_count);
+    }
+    renderer_stats_count_vao_bind();
     
     // Unbind
     glBindVertexArray(0);
+    renderer_stats_count_vao_bind();
 }
 
 // Model functions      
@@ -383,16 +483,13 @@ model* opengl_renderer_create_model(const char* model_path) {
 void opengl_renderer_destroy_model(model* m) {
     if (!m) {
         ERROR("Cannot destroy NULL model");
-    }else{
-        // Destroy the mesh
-        opengl_renderer_destroy_mesh(m->mesh);
+        return;
     }
-
-    // Free the model struct itself
-    kfree(m, sizeof(model), MEMORY_TAG_RENDERER);
+    // Releases the mesh and the model's texture reference
+    model_destroy(m);
 }
 
-void opengl_renderer_draw_model(model* m) {
+void opengl_renderer_draw_model(model* m, vec3 position, vec3 rotation, vec3 scale) {
     // INFO("%s Drawing model: %s", __FILE__, m->name);
     if (!m) {
         ERROR("Cannot draw NULL model");
@@ -437,7 +534,7 @@ void opengl_renderer_draw_model(model* m) {
         }
         
         // Draw the mesh
-        opengl_renderer_draw_mesh(m->mesh);
+        opengl_renderer_draw_mesh(m->mesh, position, rotation, scale);
         
         // Unbind texture
         if (m->texture) {
@@ -448,6 +545,239 @@ void opengl_renderer_draw_model(model* m) {
     }
 }
 
+// Texture functions
+static b8 opengl_texture_format(u32 channels, GLenum* out_format) {
+    switch (channels) {
+        case 1: *out_format = GL_RED; return TRUE;
+        case 2: *out_format = GL_RG; return TRUE;
+        case 3: *out_format = GL_RGB; return TRUE;
+        case 4: *out_format = GL_RGBA; return TRUE;
+        default:
+            ERROR("Unsupported number of channels: %d", channels);
+            return FALSE;
+    }
+}
+
+// Sized formats for immutable storage.
+static GLenum opengl_texture_internal_format(u32 channels) {
+    switch (channels) {
+        case 1: return GL_R8;
+        case 2: return GL_RG8;
+        case 3: return GL_RGB8;
+        default: return GL_RGBA8;
+    }
+}
+
+// Block formats, 0 for NONE. BC1 keeps its 1-bit alpha only for textures
+// that have alpha.
+static GLenum opengl_compressed_format(texture_compression compression, u32 channels) {
+    switch (compression) {
+        case TEXTURE_COMPRESSION_BC1:
+            return channels == 4 ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case TEXTURE_COMPRESSION_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case TEXTURE_COMPRESSION_BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM_ARB;
+        default: return 0;
+    }
+}
+
+// Pixel format and internal format for t. Block formats have no pixel format
+// and report 0 there.
+static b8 opengl_texture_formats(const texture* t, GLenum* out_format, GLenum* out_internal_format) {
+    *out_format = 0;
+    if (t->compression != TEXTURE_COMPRESSION_NONE) {
+        *out_internal_format = opengl_compressed_format(t->compression, t->channels);
+        return *out_internal_format != 0;
+    }
+    if (!opengl_texture_format(t->channels, out_format)) {
+        return FALSE;
+    }
+    *out_internal_format = opengl_texture_internal_format(t->channels);
+    return TRUE;
+}
+
+// Creates and binds a texture with the engine's sampling parameters.
+static GLuint opengl_texture_generate() {
+    GLuint texture_id;
+    glGenTextures(1, &texture_id);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    renderer_stats_count_texture_bind();
+    
+    // Set texture parameters
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return texture_id;
+}
+
+b8 opengl_renderer_create_texture(texture* t, const u8* pixels) {
+    // Upload texture data based on number of channels
+    GLenum format;
+    if (!opengl_texture_format(t->channels, &format)) {
+        return FALSE;
+    }
+
+    // Create OpenGL texture
+    GLuint texture_id = opengl_texture_generate();
+    glTexImage2D(GL_TEXTURE_2D, 0, format, t->width, t->height, 0, format, GL_UNSIGNED_BYTE, pixels);
+    renderer_stats_count_buffer_upload((u64)t->width * t->height * t->channels);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    
+    // Store OpenGL texture ID
+    t->id = texture_id;
+    return TRUE;
+}
+
+void opengl_renderer_destroy_texture(texture* t) {
+    glDeleteTextures(1, &t->id);
+    t->id = 0;
+}
+
+b8 opengl_renderer_create_texture_storage(texture* t, u32 level_count) {
+    b8 compressed = t->compression != TEXTURE_COMPRESSION_NONE;
+    GLenum format;
+    GLenum internal_format;
+    if (!opengl_texture_formats(t, &format, &internal_format) || (compressed && level_count == 0)) {
+        return FALSE;
+    }
+    GLuint texture_id = opengl_texture_generate();
+    if (level_count == 0) {
+        // finish_texture_upload generates the rest of the chain
+        glTexImage2D(GL_TEXTURE_2D, 0, format, t->width, t->height, 0, format, GL_UNSIGNED_BYTE, NULL);
+    } else if (GLEW_ARB_texture_storage) {
+        glTexStorage2D(GL_TEXTURE_2D, (GLsizei)level_count, internal_format, (GLsizei)t->width, (GLsizei)t->height);
+    } else {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)level_count - 1);
+        for (u32 i = 0; i < level_count; ++i) {
+            GLsizei width = (GLsizei)(t->width >> i ? t->width >> i : 1);
+            GLsizei height = (GLsizei)(t->height >> i ? t->height >> i : 1);
+            if (compressed) {
+                glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, internal_format, width, height, 0,
+                                       (GLsizei)texture_compression_level_size(t->compression, width, height), NULL);
+            } else {
+                glTexImage2D(GL_TEXTURE_2D, (GLint)i, internal_format, width, height, 0, format, GL_UNSIGNED_BYTE, NULL);
+            }
+        }
+    }
+    t->id = texture_id;
+    return TRUE;
+}
+
+void opengl_renderer_upload_texture_rows(texture* t, u32 level, const u8* pixels, u32 first_row, u32 row_count) {
+    GLenum format;
+    GLenum internal_format;
+    if (!opengl_texture_formats(t, &format, &internal_format)) {
+        return;
+    }
+    b8 compressed = t->compression != TEXTURE_COMPRESSION_NONE;
+    u32 width = t->width >> level ? t->width >> level : 1;
+    u64 bytes = compressed ? texture_compression_level_size(t->compression, width, row_count)
+                           : (u64)width * t->channels * row_count;
+    opengl_renderer_state* state = global_renderer_state;
+    if (!state->upload_pbo) {
+        glGenBuffers(1, &state->upload_pbo);
+    }
+
+    // The copy into the buffer is all the CPU waits for, the transfer into
+    // the texture runs asynchronously from the buffer. Re-specifying the
+    // storage orphans the previous upload's buffer instead of waiting on it.
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, state->upload_pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)bytes, NULL, GL_STREAM_DRAW);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)bytes,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    const void* source = 0;
+    if (mapped) {
+        kcopy_memory(mapped, pixels, bytes);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    } else {
+        // Upload from client memory instead
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        source = pixels;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, t->id);
+    renderer_stats_count_texture_bind();
+    if (compressed) {
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint)level, 0, (GLint)first_row, (GLsizei)width, (GLsizei)row_count,
+                                  internal_format, (GLsizei)bytes, source);
+    } else {
+        // Rows of 1 and 3 channel textures aren't always 4-byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, (GLint)level, 0, (GLint)first_row, (GLsizei)width, (GLsizei)row_count, format,
+                        GL_UNSIGNED_BYTE, source);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    renderer_stats_count_buffer_upload(bytes);
+}
+
+void opengl_renderer_finish_texture_upload(texture* t, b8 generate_mipmaps) {
+    if (!generate_mipmaps) {
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, t->id);
+    renderer_stats_count_texture_bind();
+    glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+b8 opengl_renderer_create_texture_levels(texture* t, const texture_level* levels, u32 level_count) {
+    b8 compressed = t->compression != TEXTURE_COMPRESSION_NONE;
+    GLenum format;
+    GLenum internal_format;
+    if (!opengl_texture_formats(t, &format, &internal_format)) {
+        return FALSE;
+    }
+    if (level_count == 0) {
+        return FALSE;
+    }
+    GLuint texture_id = opengl_texture_generate();
+    b8 immutable = GLEW_ARB_texture_storage;
+    if (immutable) {
+        // Storage for the whole chain at once, the driver doesn't have to
+        // guess whether more levels are coming
+        glTexStorage2D(GL_TEXTURE_2D, (GLsizei)level_count, internal_format, (GLsizei)t->width, (GLsizei)t->height);
+    } else {
+        // Sampling stops at the last level provided
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)level_count - 1);
+    }
+
+    // Rows of 1 and 3 channel levels aren't always 4-byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    u64 bytes = 0;
+    for (u32 i = 0; i < level_count; ++i) {
+        const texture_level* level = &levels[i];
+        GLsizei width = (GLsizei)level->width;
+        GLsizei height = (GLsizei)level->height;
+        if (compressed && immutable) {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint)i, 0, 0, width, height, internal_format,
+                                      (GLsizei)level->size, level->pixels);
+        } else if (compressed) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, internal_format, width, height, 0, (GLsizei)level->size,
+                                   level->pixels);
+        } else if (immutable) {
+            glTexSubImage2D(GL_TEXTURE_2D, (GLint)i, 0, 0, width, height, format, GL_UNSIGNED_BYTE, level->pixels);
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, (GLint)i, format, width, height, 0, format, GL_UNSIGNED_BYTE, level->pixels);
+        }
+        bytes += level->size;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    renderer_stats_count_buffer_upload(bytes);
+
+    t->id = texture_id;
+    return TRUE;
+}
+
+b8 opengl_renderer_supports_texture_compression(texture_compression compression) {
+    switch (compression) {
+        case TEXTURE_COMPRESSION_NONE: return TRUE;
+        case TEXTURE_COMPRESSION_BC1:
+        case TEXTURE_COMPRESSION_BC3: return GLEW_EXT_texture_compression_s3tc;
+        case TEXTURE_COMPRESSION_BC7: return GLEW_ARB_texture_compression_bptc;
+        default: return FALSE;
+    }
+}
+
 mesh* opengl_renderer_get_mesh(u32 mesh_id) {
     // This is a stub - in a full implementation, we would look up the mesh by ID
     // For now, we're just going to force direct mesh drawing
@@ -462,16 +792,25 @@ font* opengl_renderer_create_font(const char* font_path, u32 font_size) {
     INFO("Creating font from '%s' with size %u", font_path, font_size);
     
     font* f = kallocate(sizeof(font), MEMORY_TAG_RENDERER);
-    f->id = next_mesh_id++;
+    f->id = next_font_id++;
     
     // Zero out the character data to start with
     kzero_memory(f->characters, sizeof(font_character) * 128);
 
-    // Load font face
+    // Load font face from memory so packed fonts work. FreeType reads the
+    // buffer until the face is done.
+    char* font_data = NULL;
+    u64 font_data_size = 0;
+    if (!read_file_to_buffer(font_path, &font_data, &font_data_size)) {
+        ERROR("Failed to read font file '%s'", font_path);
+        kfree(f, sizeof(font), MEMORY_TAG_RENDERER);
+        return NULL;
+    }
     FT_Face face;
-    FT_Error error = FT_New_Face(state->ft_library, font_path, 0, &face);
+    FT_Error error = FT_New_Memory_Face(state->ft_library, (const FT_Byte*)font_data, (FT_Long)font_data_size, 0, &face);
     if (error) {
         ERROR("Failed to load font face: %d", error);
+        free(font_data);
         kfree(f, sizeof(font), MEMORY_TAG_RENDERER);
         return NULL;
     }
@@ -481,6 +820,7 @@ font* opengl_renderer_create_font(const char* font_path, u32 font_size) {
     if (error) {
         ERROR("Failed to set font size: %d", error);
         FT_Done_Face(face);
+        free(font_data);
         kfree(f, sizeof(font), MEMORY_TAG_RENDERER);
         return NULL;
     }
@@ -496,6 +836,8 @@ font* opengl_renderer_create_font(const char* font_path, u32 font_size) {
     glBindVertexArray(f->vao);
     glBindBuffer(GL_ARRAY_BUFFER, f->vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(text_vertex) * 6, NULL, GL_DYNAMIC_DRAW);
+    renderer_stats_count_vao_bind();
+    renderer_stats_count_buffer_upload(sizeof(text_vertex) * 6);
 
     // Set vertex attributes - fix the position to use 3 components
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(text_vertex), (void*)offsetof(text_vertex, position));
@@ -550,6 +892,8 @@ font* opengl_renderer_create_font(const char* font_path, u32 font_size) {
                     face->glyph->bitmap.rows,
                     0, GL_RED, GL_UNSIGNED_BYTE,
                     face->glyph->bitmap.buffer);
+        renderer_stats_count_texture_bind();
+        renderer_stats_count_buffer_upload((u64)face->glyph->bitmap.width * face->glyph->bitmap.rows);
         
         // Store character info
         f->characters[c].texture_id = texture;
@@ -578,6 +922,7 @@ font* opengl_renderer_create_font(const char* font_path, u32 font_size) {
 
     // Clean up FreeType face
     FT_Done_Face(face);
+    free(font_data);
     
     INFO("Font creation complete: id=%u", f->id);
     return f;
@@ -594,10 +939,7 @@ font* opengl_renderer_create_fallback_font(u32 font_size) {
         INFO("Trying fallback font: %s", font_path);
         
         // Check if file exists before attempting to load
-        FILE* file = fopen(font_path, "r");
-        if (file) {
-            fclose(file);
-            
+        if (file_exists(font_path)) {
             // Try to create the font
             font* f = opengl_renderer_create_font(font_path, font_size);
             if (f) {
@@ -623,7 +965,8 @@ b8 opengl_renderer_draw_frame(renderer_backend* backend, render_packet* packet)
         // Enable depth testing for 3D objects
         glEnable(GL_DEPTH_TEST);
         for (u32 i = 0; i < packet->mesh_commands.count; i++) {
-            opengl_renderer_draw_mesh(packet->mesh_commands.commands[i].mesh);
+            mesh_command* cmd = &packet->mesh_commands.commands[i];
+            opengl_renderer_draw_mesh(cmd->mesh, cmd->position, cmd->rotation, cmd->scale);
         }
     }
     
@@ -698,6 +1041,7 @@ void check_gl_error(const char* op) {
 }
 
 void opengl_renderer_draw_text(font* f, const char* text, vec2 position, vec4 color, f32 scale) {
+    PROFILE_FUNCTION();
     if (!f || !text) {
         return;
     }
@@ -715,6 +1059,7 @@ void opengl_renderer_draw_text(font* f, const char* text, vec2 position, vec4 co
     // Force blending for text
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    renderer_stats_count_state_changes(4);
 
     // Create a shader_program struct from the program ID
     shader_program program = {0};
@@ -741,9 +1086,11 @@ void opengl_renderer_draw_text(font* f, const char* text, vec2 position, vec4 co
     // Set texture unit using our shader system
     shader_set_int(&program, "textureSampler", 0);
     glActiveTexture(GL_TEXTURE0);
+    renderer_stats_count_state_changes(1);
     
     // Bind font's VAO
     glBindVertexArray(f->vao);
+    renderer_stats_count_vao_bind();
     
     // Starting position for rendering
     f32 x = position.x;
@@ -790,14 +1137,17 @@ void opengl_renderer_draw_text(font* f, const char* text, vec2 position, vec4 co
         
         // Bind character texture
         glBindTexture(GL_TEXTURE_2D, ch->texture_id);
+        renderer_stats_count_texture_bind();
         
         // Update buffer
         glBindBuffer(GL_ARRAY_BUFFER, f->vbo);
         glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
+        renderer_stats_count_buffer_upload(sizeof(vertices));
         
         // Draw the character quad
         glDrawArrays(GL_TRIANGLES, 0, 6);
+        renderer_stats_count_draw(6);
         
         // Advance cursor for next character
         x += (ch->advance >> 6) * scale;
@@ -808,6 +1158,9 @@ void opengl_renderer_draw_text(font* f, const char* text, vec2 position, vec4 co
     glBindTexture(GL_TEXTURE_2D, 0);
     glDisable(GL_BLEND);
     glEnable(GL_DEPTH_TEST);
+    renderer_stats_count_vao_bind();
+    renderer_stats_count_texture_bind();
+    renderer_stats_count_state_changes(2);
 }
 
 // Shader error checking functions
@@ -982,4 +1335,67 @@ void create_perspective_matrix(mat4* matrix, float fov_degrees, float aspect_rat
     // Debug output 
     INFO("Created perspective matrix with FOV=%.1f°, aspect=%.2f, near=%.2f, far=%.2f",
          fov_degrees, aspect_ratio, near_plane, far_plane);
-} 
\ No newline at end of file
+} 
+
+void opengl_renderer_draw_quads(const quad_command* quads, u32 count) {
+    opengl_renderer_state* state = global_renderer_state;
+    if (!state || !quads || count == 0) {
+        return;
+    }
+
+    // Two triangles per quad, expanded on the CPU so the whole batch is one draw
+    u32 vertex_count = count * 6;
+    if (darray_capacity(state->quad_vertices) < vertex_count) {
+        darray_destroy(state->quad_vertices);
+        state->quad_vertices = darray_reserve(quad_vertex, vertex_count);
+    }
+    quad_vertex* v = state->quad_vertices;
+    for (u32 i = 0; i < count; ++i) {
+        f32 x0 = quads[i].position.x;
+        f32 y0 = quads[i].position.y;
+        f32 x1 = x0 + quads[i].size.x;
+        f32 y1 = y0 + quads[i].size.y;
+        vec4 c = quads[i].color;
+        *v++ = (quad_vertex){{{x0, y0}}, c};
+        *v++ = (quad_vertex){{{x0, y1}}, c};
+        *v++ = (quad_vertex){{{x1, y1}}, c};
+        *v++ = (quad_vertex){{{x0, y0}}, c};
+        *v++ = (quad_vertex){{{x1, y1}}, c};
+        *v++ = (quad_vertex){{{x1, y0}}, c};
+    }
+
+    int width, height;
+    SDL_GetWindowSize(state->window, &width, &height);
+
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    renderer_stats_count_state_changes(3);
+
+    shader_program program = {0};
+    program.program_id = state->quad_shader_program;
+    shader_bind(&program);
+    vec2 screen_size = {{(f32)width, (f32)height}};
+    shader_set_vec2(&program, "screen_size", &screen_size);
+
+    glBindVertexArray(state->quad_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, state->quad_vbo);
+    u64 bytes = sizeof(quad_vertex) * vertex_count;
+    if (state->quad_vbo_capacity < vertex_count) {
+        // Orphan into a larger store; later frames reuse it with BufferSubData
+        glBufferData(GL_ARRAY_BUFFER, bytes, state->quad_vertices, GL_STREAM_DRAW);
+        state->quad_vbo_capacity = vertex_count;
+    } else {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, state->quad_vertices);
+    }
+    glDrawArrays(GL_TRIANGLES, 0, vertex_count);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    renderer_stats_count_vao_bind();
+    renderer_stats_count_vao_bind();
+    renderer_stats_count_buffer_upload(bytes);
+    renderer_stats_count_draw(vertex_count);
+
+    glEnable(GL_DEPTH_TEST);
+    renderer_stats_count_state_changes(1);
+}
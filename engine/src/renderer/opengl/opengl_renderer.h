@@ -2,6 +2,7 @@
 
 #include "../renderer_backend.h"
 #include "shaders/shader.h"
+#include "opengl_gpu_timer.h"
 #include <GL/glew.h>  // GLEW must be included before any OpenGL headers
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_opengl.h>
@@ -17,6 +18,12 @@ typedef struct FT_LibraryRec_ *FT_Library;
 // Forward declare model struct
 typedef struct model model;
 
+// Vertex of the screen-space overlay quads.
+typedef struct quad_vertex {
+    vec2 position;
+    vec4 color;
+} quad_vertex;
+
 typedef struct opengl_renderer_state {
     struct platform_state* plat_state;
     SDL_Window* window;
@@ -30,6 +37,13 @@ typedef struct opengl_renderer_state {
     f32 rotation;                  // Rotation state
     render_packet* current_packet; // Current packet pointer
     FT_Library ft_library;         // FreeType library instance
+    gpu_timer gpu_timer;           // Per-pass GPU timestamp queries
+    u32 quad_shader_program;       // Overlay quad shader program ID
+    u32 quad_vao;                  // Overlay quad VAO
+    u32 quad_vbo;                  // Overlay quad VBO, grown on demand
+    u32 quad_vbo_capacity;         // Vertices the quad VBO can hold
+    quad_vertex* quad_vertices;    // darray, staging for the quad VBO
+    u32 upload_pbo;                // Pixel unpack buffer for streamed texture rows, made on first use
     
     // Matrices for rendering
     mat4 projection_matrix;
@@ -48,10 +62,15 @@ void opengl_renderer_backend_resized(renderer_backend* backend, u16 width, u16 h
 b8 opengl_renderer_backend_begin_frame(renderer_backend* backend, render_packet* packet);
 b8 opengl_renderer_backend_end_frame(renderer_backend* backend, render_packet* packet);
 b8 opengl_renderer_draw_frame(renderer_backend* backend, render_packet* packet);
+b8 opengl_renderer_backend_bind_context(renderer_backend* backend, b8 bind);
+void opengl_renderer_backend_begin_pass(renderer_backend* backend, renderer_pass pass);
+void opengl_renderer_backend_end_pass(renderer_backend* backend, renderer_pass pass);
+b8 opengl_renderer_backend_get_gpu_timings(renderer_backend* backend, renderer_gpu_timings* out_timings);
 // Mesh functions
 mesh* opengl_renderer_create_mesh(const vertex* vertices, u32 vertex_count);
+mesh* opengl_renderer_create_indexed_mesh(const vertex* vertices, u32 vertex_count, const void* indices, u32 index_count, u32 index_size);
 void opengl_renderer_destroy_mesh(mesh* m);
-void opengl_renderer_draw_mesh(mesh* m);
+void opengl_renderer_draw_mesh(mesh* m, vec3 position, vec3 rotation, vec3 scale);
 mesh* opengl_renderer_get_mesh(u32 mesh_id);
 
 // Font functions
@@ -60,7 +79,19 @@ font* opengl_renderer_create_fallback_font(u32 font_size);
 void opengl_renderer_destroy_font(font* f);
 void opengl_renderer_draw_text(font* f, const char* text, vec2 position, vec4 color, f32 scale); 
 
+// Overlay functions
+void opengl_renderer_draw_quads(const quad_command* quads, u32 count);
+
 // Model functions
 model* opengl_renderer_create_model(const char* model_path);
 void opengl_renderer_destroy_model(model* m);
-void opengl_renderer_draw_model(model* m);
\ No newline at end of file
+void opengl_renderer_draw_model(model* m, vec3 position, vec3 rotation, vec3 scale);
+
+// Texture functions
+b8 opengl_renderer_create_texture(texture* t, const u8* pixels);
+void opengl_renderer_destroy_texture(texture* t);
+b8 opengl_renderer_create_texture_storage(texture* t, u32 level_count);
+void opengl_renderer_upload_texture_rows(texture* t, u32 level, const u8* pixels, u32 first_row, u32 row_count);
+void opengl_renderer_finish_texture_upload(texture* t, b8 generate_mipmaps);
+b8 opengl_renderer_create_texture_levels(texture* t, const texture_level* levels, u32 level_count);
+b8 opengl_renderer_supports_texture_compression(texture_compression compression);
\ No newline at end of file
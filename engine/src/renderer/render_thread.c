@@ -0,0 +1,297 @@
+#include "render_thread.h"
+
+#include "containers/darray.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "platform/platform.h"
+#include "platform/sampling_profiler.h"
+
+#include <string.h>
+
+// A packet plus storage for everything it points to, so the main thread can
+// overwrite its own command arrays while the render thread is still drawing.
+typedef struct render_packet_slot {
+    render_packet packet;
+    text_command* text_commands;   // darray
+    mesh_command* mesh_commands;   // darray
+    model_command* model_commands; // darray
+    quad_command* quad_commands;   // darray
+    texture_upload_command* texture_uploads; // darray
+    char* text_storage;            // darray, backing store for text_commands[i].text
+} render_packet_slot;
+
+typedef struct render_thread_state {
+    renderer_backend* backend;
+    PFN_render_thread_draw draw;
+    platform_thread thread;
+
+    render_packet_slot slots[RENDER_THREAD_PACKET_SLOTS];
+    u32 write_index;  // Only touched by the main thread
+    u32 read_index;   // Only touched by the render thread
+
+    // Counts free slots, the main thread waits on it before filling one.
+    platform_semaphore free_slots;
+    // Signalled once per queued packet, context request and quit request.
+    platform_semaphore work;
+    // Context handoff between the render thread and the main thread.
+    platform_semaphore context_released;
+    platform_semaphore context_returned;
+
+    // Shared flags, always accessed through __atomic builtins.
+    u32 queued_packets;
+    u32 context_requested;
+    u32 quit_requested;
+    u32 pending_resize;  // (width << 16) | height, 0 when nothing is pending
+
+    // Nesting depth of render_thread_acquire_context, main thread only.
+    u32 context_depth;
+} render_thread_state;
+
+static render_thread_state* state = 0;
+
+// Grows a slot darray so it can hold count elements. Contents are not preserved.
+#define slot_reserve(array, type, count)           \
+    if (darray_capacity(array) < (count)) {        \
+        darray_destroy(array);                     \
+        array = darray_reserve(type, (count));     \
+    }
+
+static void render_thread_draw_next() {
+    u32 resize = __atomic_exchange_n(&state->pending_resize, 0, __ATOMIC_ACQ_REL);
+    if (resize) {
+        state->backend->resized(state->backend, (u16)(resize >> 16), (u16)(resize & 0xFFFF));
+    }
+
+    render_packet_slot* slot = &state->slots[state->read_index];
+    if (!state->draw(&slot->packet)) {
+        ERROR("Render thread failed to draw frame!");
+    }
+    state->read_index = (state->read_index + 1) % RENDER_THREAD_PACKET_SLOTS;
+
+    __atomic_sub_fetch(&state->queued_packets, 1, __ATOMIC_RELEASE);
+    platform_semaphore_signal(&state->free_slots);
+}
+
+static u32 render_thread_main(void* params) {
+    profiler_set_thread_name("render");
+    sampling_profiler_register_thread("render");
+    renderer_backend* backend = state->backend;
+    if (!backend->bind_context(backend, TRUE)) {
+        ERROR("Render thread could not take over the renderer context");
+    }
+
+    while (TRUE) {
+        platform_semaphore_wait(&state->work);
+
+        // Queued packets always go first. That keeps frames in order and means
+        // a context request or quit only happens once in-flight work is done.
+        if (__atomic_load_n(&state->queued_packets, __ATOMIC_ACQUIRE) > 0) {
+            render_thread_draw_next();
+            continue;
+        }
+
+        if (__atomic_load_n(&state->context_requested, __ATOMIC_ACQUIRE)) {
+            backend->bind_context(backend, FALSE);
+            __atomic_store_n(&state->context_requested, 0, __ATOMIC_RELEASE);
+            platform_semaphore_signal(&state->context_released);
+            platform_semaphore_wait(&state->context_returned);
+            backend->bind_context(backend, TRUE);
+            continue;
+        }
+
+        if (__atomic_load_n(&state->quit_requested, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+    }
+
+    backend->bind_context(backend, FALSE);
+    sampling_profiler_unregister_thread();
+    return 0;
+}
+
+b8 render_thread_start(renderer_backend* backend, PFN_render_thread_draw draw) {
+    if (state) {
+        WARN("render_thread_start called while the render thread is already running");
+        return TRUE;
+    }
+
+    state = kallocate(sizeof(render_thread_state), MEMORY_TAG_RENDERER);
+    state->backend = backend;
+    state->draw = draw;
+
+    for (u32 i = 0; i < RENDER_THREAD_PACKET_SLOTS; ++i) {
+        state->slots[i].text_commands = darray_create(text_command);
+        state->slots[i].mesh_commands = darray_create(mesh_command);
+        state->slots[i].model_commands = darray_create(model_command);
+        state->slots[i].quad_commands = darray_create(quad_command);
+        state->slots[i].texture_uploads = darray_create(texture_upload_command);
+        state->slots[i].text_storage = darray_create(char);
+    }
+
+    platform_semaphore_create(RENDER_THREAD_PACKET_SLOTS, &state->free_slots);
+    platform_semaphore_create(0, &state->work);
+    platform_semaphore_create(0, &state->context_released);
+    platform_semaphore_create(0, &state->context_returned);
+
+    // Hand the context over, the render thread binds it as its first action
+    backend->bind_context(backend, FALSE);
+    if (!platform_thread_create(render_thread_main, state, &state->thread)) {
+        ERROR("Failed to create render thread, staying single-threaded");
+        backend->bind_context(backend, TRUE);
+        render_thread_state* failed = state;
+        state = 0;
+        for (u32 i = 0; i < RENDER_THREAD_PACKET_SLOTS; ++i) {
+            darray_destroy(failed->slots[i].text_commands);
+            darray_destroy(failed->slots[i].mesh_commands);
+            darray_destroy(failed->slots[i].model_commands);
+            darray_destroy(failed->slots[i].quad_commands);
+            darray_destroy(failed->slots[i].texture_uploads);
+            darray_destroy(failed->slots[i].text_storage);
+        }
+        platform_semaphore_destroy(&failed->free_slots);
+        platform_semaphore_destroy(&failed->work);
+        platform_semaphore_destroy(&failed->context_released);
+        platform_semaphore_destroy(&failed->context_returned);
+        kfree(failed, sizeof(render_thread_state), MEMORY_TAG_RENDERER);
+        return FALSE;
+    }
+
+    INFO("Render thread started with %u packet slots", RENDER_THREAD_PACKET_SLOTS);
+    return TRUE;
+}
+
+void render_thread_stop() {
+    if (!state) {
+        return;
+    }
+
+    __atomic_store_n(&state->quit_requested, 1, __ATOMIC_RELEASE);
+    platform_semaphore_signal(&state->work);
+    platform_thread_join(&state->thread);
+
+    // Take the context back for whatever runs after us, e.g. renderer shutdown
+    state->backend->bind_context(state->backend, TRUE);
+
+    for (u32 i = 0; i < RENDER_THREAD_PACKET_SLOTS; ++i) {
+        darray_destroy(state->slots[i].text_commands);
+        darray_destroy(state->slots[i].mesh_commands);
+        darray_destroy(state->slots[i].model_commands);
+        darray_destroy(state->slots[i].quad_commands);
+        darray_destroy(state->slots[i].texture_uploads);
+        darray_destroy(state->slots[i].text_storage);
+    }
+    platform_semaphore_destroy(&state->free_slots);
+    platform_semaphore_destroy(&state->work);
+    platform_semaphore_destroy(&state->context_released);
+    platform_semaphore_destroy(&state->context_returned);
+
+    kfree(state, sizeof(render_thread_state), MEMORY_TAG_RENDERER);
+    state = 0;
+    INFO("Render thread stopped");
+}
+
+b8 render_thread_is_active() {
+    return state != 0;
+}
+
+b8 render_thread_submit(const render_packet* packet) {
+    if (!state || !packet) {
+        return FALSE;
+    }
+
+    PROFILE_BEGIN("render_thread_wait_slot");
+    platform_semaphore_wait(&state->free_slots);
+    PROFILE_END();
+    render_packet_slot* slot = &state->slots[state->write_index];
+
+    // Commands
+    u32 mesh_count = packet->mesh_commands.commands ? packet->mesh_commands.count : 0;
+    u32 model_count = packet->model_commands.commands ? packet->model_commands.count : 0;
+    u32 text_count = packet->text_commands.commands ? packet->text_commands.count : 0;
+    u32 quad_count = packet->quad_commands.commands ? packet->quad_commands.count : 0;
+    u32 upload_count = packet->texture_uploads.commands ? packet->texture_uploads.count : 0;
+
+    slot_reserve(slot->mesh_commands, mesh_command, mesh_count);
+    slot_reserve(slot->model_commands, model_command, model_count);
+    slot_reserve(slot->text_commands, text_command, text_count);
+    slot_reserve(slot->quad_commands, quad_command, quad_count);
+    slot_reserve(slot->texture_uploads, texture_upload_command, upload_count);
+    kcopy_memory(slot->mesh_commands, packet->mesh_commands.commands, sizeof(mesh_command) * mesh_count);
+    kcopy_memory(slot->model_commands, packet->model_commands.commands, sizeof(model_command) * model_count);
+    kcopy_memory(slot->text_commands, packet->text_commands.commands, sizeof(text_command) * text_count);
+    kcopy_memory(slot->quad_commands, packet->quad_commands.commands, sizeof(quad_command) * quad_count);
+    kcopy_memory(slot->texture_uploads, packet->texture_uploads.commands, sizeof(texture_upload_command) * upload_count);
+
+    // Text strings are owned by the game and may change next frame, copy them too
+    u64 text_bytes = 0;
+    for (u32 i = 0; i < text_count; ++i) {
+        if (slot->text_commands[i].text) {
+            text_bytes += strlen(slot->text_commands[i].text) + 1;
+        }
+    }
+    slot_reserve(slot->text_storage, char, text_bytes);
+    u64 offset = 0;
+    for (u32 i = 0; i < text_count; ++i) {
+        const char* text = slot->text_commands[i].text;
+        if (text) {
+            u64 length = strlen(text) + 1;
+            kcopy_memory(slot->text_storage + offset, text, length);
+            slot->text_commands[i].text = slot->text_storage + offset;
+            offset += length;
+        }
+    }
+
+    slot->packet = *packet;
+    slot->packet.mesh_commands.commands = slot->mesh_commands;
+    slot->packet.mesh_commands.count = mesh_count;
+    slot->packet.model_commands.commands = slot->model_commands;
+    slot->packet.model_commands.count = model_count;
+    slot->packet.text_commands.commands = slot->text_commands;
+    slot->packet.text_commands.count = text_count;
+    slot->packet.quad_commands.commands = slot->quad_commands;
+    slot->packet.quad_commands.count = quad_count;
+    slot->packet.texture_uploads.commands = slot->texture_uploads;
+    slot->packet.texture_uploads.count = upload_count;
+
+    state->write_index = (state->write_index + 1) % RENDER_THREAD_PACKET_SLOTS;
+
+    // Publish: every write to the slot above must be visible before the count moves
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_add_fetch(&state->queued_packets, 1, __ATOMIC_RELEASE);
+    platform_semaphore_signal(&state->work);
+    return TRUE;
+}
+
+void render_thread_acquire_context() {
+    if (!state) {
+        return;
+    }
+    if (state->context_depth++ > 0) {
+        return;
+    }
+
+    __atomic_store_n(&state->context_requested, 1, __ATOMIC_RELEASE);
+    platform_semaphore_signal(&state->work);
+    platform_semaphore_wait(&state->context_released);
+    state->backend->bind_context(state->backend, TRUE);
+}
+
+void render_thread_release_context() {
+    if (!state || state->context_depth == 0) {
+        return;
+    }
+    if (--state->context_depth > 0) {
+        return;
+    }
+
+    state->backend->bind_context(state->backend, FALSE);
+    platform_semaphore_signal(&state->context_returned);
+}
+
+void render_thread_request_resize(u16 width, u16 height) {
+    if (!state) {
+        return;
+    }
+    __atomic_store_n(&state->pending_resize, ((u32)width << 16) | height, __ATOMIC_RELEASE);
+}
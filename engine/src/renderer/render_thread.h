@@ -0,0 +1,32 @@
+#pragma once
+
+#include "renderer_types.inl"
+
+// Number of packets in flight: one being drawn, one queued, one being filled.
+#define RENDER_THREAD_PACKET_SLOTS 3
+
+// Draw callback run on the render thread for each submitted packet.
+typedef b8 (*PFN_render_thread_draw)(render_packet* packet);
+
+// Moves the backend's context onto a new render thread. From then on
+// packets passed to render_thread_submit are drawn there.
+b8 render_thread_start(renderer_backend* backend, PFN_render_thread_draw draw);
+
+// Draws any queued packets, stops the thread and moves the context back to the caller.
+void render_thread_stop();
+
+b8 render_thread_is_active();
+
+// Deep-copies the packet into a free slot and queues it. Blocks only when all
+// slots are in use, which keeps the main thread at most two frames ahead.
+b8 render_thread_submit(const render_packet* packet);
+
+// Temporarily moves the context to the calling (main) thread for resource
+// creation or destruction. Queued packets are drawn first so nothing in flight
+// refers to a resource that is about to go away. Calls may nest.
+// Both are no-ops when the render thread isn't running.
+void render_thread_acquire_context();
+void render_thread_release_context();
+
+// Records a new framebuffer size to apply on the render thread before its next draw.
+void render_thread_request_resize(u16 width, u16 height);
@@ -1,5 +1,6 @@
 #include "renderer_backend.h"
 #include "renderer/opengl/opengl_renderer.h"
+#include "renderer/null/null_renderer.h"
 #include "core/logger.h"
 
 b8 renderer_backend_create(renderer_backend_type type, struct platform_state* plat_state, renderer_backend* out_renderer_backend) {
@@ -13,7 +14,12 @@ b8 renderer_backend_create(renderer_backend_type type, struct platform_state* pl
             out_renderer_backend->begin_frame = opengl_renderer_backend_begin_frame;
             out_renderer_backend->end_frame = opengl_renderer_backend_end_frame;
             out_renderer_backend->draw_frame = opengl_renderer_draw_frame;
+            out_renderer_backend->bind_context = opengl_renderer_backend_bind_context;
+            out_renderer_backend->begin_pass = opengl_renderer_backend_begin_pass;
+            out_renderer_backend->end_pass = opengl_renderer_backend_end_pass;
+            out_renderer_backend->get_gpu_timings = opengl_renderer_backend_get_gpu_timings;
             out_renderer_backend->create_mesh = opengl_renderer_create_mesh;
+            out_renderer_backend->create_indexed_mesh = opengl_renderer_create_indexed_mesh;
             out_renderer_backend->destroy_mesh = opengl_renderer_destroy_mesh;
             out_renderer_backend->draw_mesh = opengl_renderer_draw_mesh;
             out_renderer_backend->get_mesh = opengl_renderer_get_mesh;
@@ -21,8 +27,49 @@ b8 renderer_backend_create(renderer_backend_type type, struct platform_state* pl
             out_renderer_backend->destroy_model = opengl_renderer_destroy_model;
             out_renderer_backend->draw_model = opengl_renderer_draw_model;
             out_renderer_backend->create_font = opengl_renderer_create_font;
+            out_renderer_backend->create_fallback_font = opengl_renderer_create_fallback_font;
             out_renderer_backend->destroy_font = opengl_renderer_destroy_font;
             out_renderer_backend->draw_text = opengl_renderer_draw_text;
+            out_renderer_backend->draw_quads = opengl_renderer_draw_quads;
+            out_renderer_backend->create_texture = opengl_renderer_create_texture;
+            out_renderer_backend->destroy_texture = opengl_renderer_destroy_texture;
+            out_renderer_backend->create_texture_storage = opengl_renderer_create_texture_storage;
+            out_renderer_backend->upload_texture_rows = opengl_renderer_upload_texture_rows;
+            out_renderer_backend->finish_texture_upload = opengl_renderer_finish_texture_upload;
+            out_renderer_backend->create_texture_levels = opengl_renderer_create_texture_levels;
+            out_renderer_backend->supports_texture_compression = opengl_renderer_supports_texture_compression;
+            break;
+        case RENDERER_BACKEND_TYPE_NULL:
+            out_renderer_backend->initialize = null_renderer_backend_initialize;
+            out_renderer_backend->shutdown = null_renderer_backend_shutdown;
+            out_renderer_backend->resized = null_renderer_backend_resized;
+            out_renderer_backend->begin_frame = null_renderer_backend_begin_frame;
+            out_renderer_backend->end_frame = null_renderer_backend_end_frame;
+            out_renderer_backend->draw_frame = null_renderer_draw_frame;
+            out_renderer_backend->bind_context = null_renderer_backend_bind_context;
+            out_renderer_backend->begin_pass = null_renderer_backend_begin_pass;
+            out_renderer_backend->end_pass = null_renderer_backend_end_pass;
+            out_renderer_backend->get_gpu_timings = null_renderer_backend_get_gpu_timings;
+            out_renderer_backend->create_mesh = null_renderer_create_mesh;
+            out_renderer_backend->create_indexed_mesh = null_renderer_create_indexed_mesh;
+            out_renderer_backend->destroy_mesh = null_renderer_destroy_mesh;
+            out_renderer_backend->draw_mesh = null_renderer_draw_mesh;
+            out_renderer_backend->get_mesh = null_renderer_get_mesh;
+            out_renderer_backend->create_model = null_renderer_create_model;
+            out_renderer_backend->destroy_model = null_renderer_destroy_model;
+            out_renderer_backend->draw_model = null_renderer_draw_model;
+            out_renderer_backend->create_font = null_renderer_create_font;
+            out_renderer_backend->create_fallback_font = null_renderer_create_fallback_font;
+            out_renderer_backend->destroy_font = null_renderer_destroy_font;
+            out_renderer_backend->draw_text = null_renderer_draw_text;
+            out_renderer_backend->draw_quads = null_renderer_draw_quads;
+            out_renderer_backend->create_texture = null_renderer_create_texture;
+            out_renderer_backend->destroy_texture = null_renderer_destroy_texture;
+            out_renderer_backend->create_texture_storage = null_renderer_create_texture_storage;
+            out_renderer_backend->upload_texture_rows = null_renderer_upload_texture_rows;
+            out_renderer_backend->finish_texture_upload = null_renderer_finish_texture_upload;
+            out_renderer_backend->create_texture_levels = null_renderer_create_texture_levels;
+            out_renderer_backend->supports_texture_compression = null_renderer_supports_texture_compression;
             break;
         default:
             ERROR("Unsupported renderer backend type: %d", type);
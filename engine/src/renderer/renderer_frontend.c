@@ -1,8 +1,11 @@
 #include "renderer_frontend.h"
 #include "renderer_backend.h"
-#include "opengl/opengl_renderer.h"
+#include "render_thread.h"
+#include "renderer_stats.h"
 #include "core/logger.h"
 #include "core/kmemory.h"
+#include "core/profiler.h"
+#include "containers/darray.h"
 #include <stddef.h>  // For NULL
 #include "platform/platform.h"
 
@@ -12,28 +15,52 @@ struct platform_state;
 static renderer_backend* backend = 0;
 static font* default_font = 0;
 
-b8 renderer_initialize(const char* application_name, struct platform_state* plat_state) {
+// Engine overlay drawn on top of every packet, e.g. the performance HUD. The
+// commands are owned by the caller and merged into each packet at draw time.
+typedef struct renderer_overlay {
+    const text_command* text_commands;
+    u32 text_count;
+    const quad_command* quad_commands;
+    u32 quad_count;
+    // darrays, grown to the largest merged packet and reused after that
+    text_command* merged_text;
+    quad_command* merged_quads;
+} renderer_overlay;
+
+static renderer_overlay overlay = {0};
+
+// Streamed texture work waiting to go out with the next packet while a render
+// thread runs, without one it is done on the spot. darray, main thread only.
+static texture_upload_command* pending_uploads = 0;
+// Packets handed to the drawing thread, and packets whose texture work is done.
+// A fence is a submitted count, passed once the done count reaches it.
+static u64 packets_submitted = 0;
+static u64 packets_uploaded = 0;  // __atomic, written by the drawing thread
+
+// Duration of the last backend end_frame (the buffer swap) in nanoseconds.
+// Written by whichever thread draws, read by the main thread.
+static u64 last_present_ns = 0;
+
+static b8 renderer_draw_packet(render_packet* packet);
+static void renderer_run_texture_upload(const texture_upload_command* command);
+
+b8 renderer_initialize(renderer_backend_type type, const char* application_name, struct platform_state* plat_state) {
     backend = kallocate(sizeof(renderer_backend), MEMORY_TAG_RENDERER);
-    backend->plat_state = plat_state;
     backend->frame_number = 0;
+    renderer_stats_initialize();
+    kzero_memory(&overlay, sizeof(renderer_overlay));
+    overlay.merged_text = darray_create(text_command);
+    overlay.merged_quads = darray_create(quad_command);
+    pending_uploads = darray_create(texture_upload_command);
+    packets_submitted = 0;
+    packets_uploaded = 0;
 
-    // TODO: make this configurable.
-    backend->initialize = opengl_renderer_backend_initialize;
-    backend->shutdown = opengl_renderer_backend_shutdown;
-    backend->begin_frame = opengl_renderer_backend_begin_frame;
-    backend->end_frame = opengl_renderer_backend_end_frame;
-    backend->draw_frame = opengl_renderer_draw_frame;
-    backend->resized = opengl_renderer_backend_resized;
-    backend->create_mesh = opengl_renderer_create_mesh;
-    backend->destroy_mesh = opengl_renderer_destroy_mesh;
-    backend->draw_mesh = opengl_renderer_draw_mesh;
-    backend->create_model = opengl_renderer_create_model;
-    backend->destroy_model = opengl_renderer_destroy_model;
-    backend->draw_model = opengl_renderer_draw_model;
-    backend->create_font = opengl_renderer_create_font;
-    backend->create_fallback_font = opengl_renderer_create_fallback_font;
-    backend->destroy_font = opengl_renderer_destroy_font;
-    backend->draw_text = opengl_renderer_draw_text;
+    if (!renderer_backend_create(type, plat_state, backend)) {
+        ERROR("Failed to create renderer backend.");
+        kfree(backend, sizeof(renderer_backend), MEMORY_TAG_RENDERER);
+        backend = 0;
+        return FALSE;
+    }
 
     // Initialize the backend
     b8 result = backend->initialize(backend, application_name, plat_state);
@@ -61,14 +88,26 @@ font* renderer_get_default_font() {
 }
 
 void renderer_shutdown() {
+    renderer_stop_render_thread();
+    // The default font is a backend resource, so release it while the backend is still up
+    if (default_font) {
+        renderer_destroy_font(default_font);
+        default_font = NULL;
+    }
     if (backend) {
         backend->shutdown(backend);
         kfree(backend, sizeof(renderer_backend), MEMORY_TAG_RENDERER);
         backend = 0;
     }
-    if (default_font) {
-        renderer_destroy_font(default_font);
-        default_font = NULL;
+    renderer_stats_shutdown();
+    if (overlay.merged_text) {
+        darray_destroy(overlay.merged_text);
+        darray_destroy(overlay.merged_quads);
+        kzero_memory(&overlay, sizeof(renderer_overlay));
+    }
+    if (pending_uploads) {
+        darray_destroy(pending_uploads);
+        pending_uploads = 0;
     }
 }
 
@@ -93,17 +132,154 @@ b8 renderer_end_frame(render_packet* packet) {
     return result;
 }
 
+b8 renderer_start_render_thread() {
+    if (!backend) {
+        ERROR("Renderer backend not initialized!");
+        return FALSE;
+    }
+    return render_thread_start(backend, renderer_draw_packet);
+}
+
+void renderer_stop_render_thread() {
+    if (!render_thread_is_active()) {
+        return;
+    }
+    render_thread_stop();
+    // Work that missed the last packet is done here instead, counting as a packet
+    for (u64 i = 0; i < darray_length(pending_uploads); ++i) {
+        renderer_run_texture_upload(&pending_uploads[i]);
+    }
+    darray_clear(pending_uploads);
+    packets_submitted++;
+    __atomic_store_n(&packets_uploaded, packets_submitted, __ATOMIC_RELEASE);
+}
+
+void renderer_set_overlay(const text_command* text_commands, u32 text_count, const quad_command* quad_commands, u32 quad_count) {
+    overlay.text_commands = text_commands;
+    overlay.text_count = text_commands ? text_count : 0;
+    overlay.quad_commands = quad_commands;
+    overlay.quad_count = quad_commands ? quad_count : 0;
+}
+
+// Grows a merge darray so it can hold count elements. Contents are not preserved.
+#define overlay_reserve(array, type, count)        \
+    if (darray_capacity(array) < (count)) {        \
+        darray_destroy(array);                     \
+        array = darray_reserve(type, (count));     \
+    }
+
+// Appends the overlay after the packet's own commands, so it is drawn last.
+static void renderer_merge_overlay(const render_packet* packet, render_packet* out_packet) {
+    *out_packet = *packet;
+
+    if (overlay.text_count > 0) {
+        u32 count = packet->text_commands.commands ? packet->text_commands.count : 0;
+        overlay_reserve(overlay.merged_text, text_command, count + overlay.text_count);
+        kcopy_memory(overlay.merged_text, packet->text_commands.commands, sizeof(text_command) * count);
+        kcopy_memory(overlay.merged_text + count, overlay.text_commands, sizeof(text_command) * overlay.text_count);
+        out_packet->text_commands.commands = overlay.merged_text;
+        out_packet->text_commands.count = count + overlay.text_count;
+    }
+
+    if (overlay.quad_count > 0) {
+        u32 count = packet->quad_commands.commands ? packet->quad_commands.count : 0;
+        overlay_reserve(overlay.merged_quads, quad_command, count + overlay.quad_count);
+        kcopy_memory(overlay.merged_quads, packet->quad_commands.commands, sizeof(quad_command) * count);
+        kcopy_memory(overlay.merged_quads + count, overlay.quad_commands, sizeof(quad_command) * overlay.quad_count);
+        out_packet->quad_commands.commands = overlay.merged_quads;
+        out_packet->quad_commands.count = count + overlay.quad_count;
+    }
+}
+
 b8 renderer_draw_frame(render_packet* packet) {
     if (!packet) return FALSE;
-    
+    PROFILE_FUNCTION();
+
+    render_packet merged;
+    if (overlay.text_count > 0 || overlay.quad_count > 0) {
+        renderer_merge_overlay(packet, &merged);
+    } else {
+        merged = *packet;
+    }
+    merged.texture_uploads.commands = pending_uploads;
+    merged.texture_uploads.count = (u32)darray_length(pending_uploads);
+    packets_submitted++;
+
+    // With a render thread running, the packet is copied and drawn there while
+    // the caller goes on to simulate the next frame.
+    if (render_thread_is_active()) {
+        b8 result = render_thread_submit(&merged);
+        darray_clear(pending_uploads);
+        return result;
+    }
+    return renderer_draw_packet(&merged);
+}
+
+static void renderer_run_texture_upload(const texture_upload_command* command) {
+    texture* t = command->texture;
+    switch (command->type) {
+        case TEXTURE_UPLOAD_CREATE_STORAGE:
+            if (!backend->create_texture_storage(t, command->level)) {
+                t->id = 0;
+            }
+            break;
+        case TEXTURE_UPLOAD_ROWS:
+            if (t->id) {
+                backend->upload_texture_rows(t, command->level, command->pixels, command->first_row, command->row_count);
+            }
+            break;
+        case TEXTURE_UPLOAD_FINISH:
+            if (t->id) {
+                backend->finish_texture_upload(t, command->generate_mipmaps);
+            }
+            break;
+    }
+}
+
+static b8 renderer_draw_packet(render_packet* packet) {
+    PROFILE_FUNCTION();
+    // Texture work first, so this frame's draws already see it
+    for (u32 i = 0; i < packet->texture_uploads.count; ++i) {
+        renderer_run_texture_upload(&packet->texture_uploads.commands[i]);
+    }
+    __atomic_add_fetch(&packets_uploaded, 1, __ATOMIC_RELEASE);
+
     // Begin frame
     if (!backend->begin_frame(backend, packet)) {
         ERROR("Renderer backend failed to begin frame!");
         return FALSE;
     }
     
-    // Draw text commands
+    // Draw mesh commands
+    if (packet->mesh_commands.commands && packet->mesh_commands.count > 0) {
+        backend->begin_pass(backend, RENDERER_PASS_MESHES);
+        for (u32 i = 0; i < packet->mesh_commands.count; i++) {
+            mesh_command* cmd = &packet->mesh_commands.commands[i];
+            backend->draw_mesh(cmd->mesh, cmd->position, cmd->rotation, cmd->scale);
+        }
+        backend->end_pass(backend, RENDERER_PASS_MESHES);
+    }
+
+    // Draw model commands
+    if (packet->model_commands.commands && packet->model_commands.count > 0) {
+        backend->begin_pass(backend, RENDERER_PASS_MODELS);
+        for (u32 i = 0; i < packet->model_commands.count; i++) {
+            model_command* cmd = &packet->model_commands.commands[i];
+            backend->draw_model(cmd->model, cmd->position, cmd->rotation, cmd->scale);
+        }
+        backend->end_pass(backend, RENDERER_PASS_MODELS);
+    }
+
+    // Draw screen-space quads, over the scene but under text
+    if (packet->quad_commands.commands && packet->quad_commands.count > 0) {
+        backend->begin_pass(backend, RENDERER_PASS_QUADS);
+        backend->draw_quads(packet->quad_commands.commands, packet->quad_commands.count);
+        backend->end_pass(backend, RENDERER_PASS_QUADS);
+    }
+
+    // Draw text commands last, so they appear on top
     if (packet->text_commands.commands && packet->text_commands.count > 0) {
+        backend->begin_pass(backend, RENDERER_PASS_TEXT);
         for (u32 i = 0; i < packet->text_commands.count; i++) {
             // Use INFO for critical debugging info, but not all of it to avoid spam
             // INFO("Drawing text: %s", packet->text_commands.commands[i].text);                                                                           
@@ -122,33 +298,55 @@ b8 renderer_draw_frame(render_packet* packet) {
                 ERROR("Attempted to draw text with NULL font");
             }
         }
-    } 
-    
-    // Draw mesh commands
-    if (packet->mesh_commands.commands && packet->mesh_commands.count > 0) {
-        for (u32 i = 0; i < packet->mesh_commands.count; i++) {
-            backend->draw_mesh(packet->mesh_commands.commands[i].mesh);
-        }
+        backend->end_pass(backend, RENDERER_PASS_TEXT);
     }
 
-    // Draw model commands
-    if (packet->model_commands.commands && packet->model_commands.count > 0) {
-        for (u32 i = 0; i < packet->model_commands.count; i++) {
-            backend->draw_model(packet->model_commands.commands[i].model);
-        }
-    }
-    
     // End frame
+    f64 present_start = platform_get_absolute_time();
     if (!backend->end_frame(backend, packet)) {
         ERROR("Renderer backend failed to end frame!");
         return FALSE;
     }
+    u64 present_ns = (u64)((platform_get_absolute_time() - present_start) * 1000000000.0);
+    __atomic_store_n(&last_present_ns, present_ns, __ATOMIC_RELAXED);
+    renderer_stats_end_frame(backend->frame_number);
+    renderer_gpu_timings gpu_timings;
+    if (backend->get_gpu_timings(backend, &gpu_timings)) {
+        renderer_stats_publish_gpu_timings(&gpu_timings);
+    }
+    backend->frame_number++;
     
     return TRUE;
 }
 
+b8 renderer_get_gpu_timings(renderer_gpu_timings* out_timings) {
+    if (!backend || !out_timings) {
+        return FALSE;
+    }
+    return renderer_stats_get_gpu_timings(out_timings);
+}
+
+f64 renderer_get_last_present_seconds() {
+    return (f64)__atomic_load_n(&last_present_ns, __ATOMIC_RELAXED) / 1000000000.0;
+}
+
+b8 renderer_get_frame_stats(renderer_frame_stats* out_stats) {
+    return renderer_stats_get_last(out_stats);
+}
+
+b8 renderer_begin_stats_csv(const char* path) {
+    return renderer_stats_open_csv(path);
+}
+
+void renderer_end_stats_csv() {
+    renderer_stats_close_csv();
+}
+
 void renderer_on_resized(u16 width, u16 height) {
-    if (backend) {
+    if (backend && render_thread_is_active()) {
+        // The viewport belongs to the render thread's context
+        render_thread_request_resize(width, height);
+    } else if (backend) {
         backend->resized(backend, width, height);
     } else {
         WARN("renderer_on_resized called with no active renderer backend!");
@@ -161,7 +359,10 @@ model* renderer_create_model(const char* model_path) {
         return NULL;
     }
     INFO("Frontend: Creating model from path: %s", model_path);
-    return backend->create_model(model_path);
+    render_thread_acquire_context();
+    model* result = backend->create_model(model_path);
+    render_thread_release_context();
+    return result;
 }
 
 void renderer_destroy_model(model* m) {
@@ -169,16 +370,20 @@ void renderer_destroy_model(model* m) {
         ERROR("Renderer backend not initialized!");
         return;
     }
+    render_thread_acquire_context();
     backend->destroy_model(m);
+    render_thread_release_context();
 }
 
-void renderer_draw_model(model* m) {
+void renderer_draw_model(model* m, vec3 position, vec3 rotation, vec3 scale) {
     if (!backend) {
         ERROR("Renderer backend not initialized!");
         return;
     }
     // INFO("%s Drawing model: %s", __FILE__, m->name);
-    backend->draw_model(m);
+    render_thread_acquire_context();
+    backend->draw_model(m, position, rotation, scale);
+    render_thread_release_context();
 }   
 
 // Mesh functions
@@ -187,7 +392,21 @@ mesh* renderer_create_mesh(const vertex* vertices, u32 vertex_count) {
         ERROR("Renderer backend not initialized!");
         return NULL;
     }
-    return backend->create_mesh(vertices, vertex_count);
+    render_thread_acquire_context();
+    mesh* result = backend->create_mesh(vertices, vertex_count);
+    render_thread_release_context();
+    return result;
+}
+
+mesh* renderer_create_indexed_mesh(const vertex* vertices, u32 vertex_count, const void* indices, u32 index_count, u32 index_size) {
+    if (!backend) {
+        ERROR("Renderer backend not initialized!");
+        return NULL;
+    }
+    render_thread_acquire_context();
+    mesh* result = backend->create_indexed_mesh(vertices, vertex_count, indices, index_count, index_size);
+    render_thread_release_context();
+    return result;
 }
 
 void renderer_destroy_mesh(mesh* m) {
@@ -195,15 +414,19 @@ void renderer_destroy_mesh(mesh* m) {
         ERROR("Renderer backend not initialized!");
         return;
     }
+    render_thread_acquire_context();
     backend->destroy_mesh(m);
+    render_thread_release_context();
 }
 
-void renderer_draw_mesh(mesh* m) {
+void renderer_draw_mesh(mesh* m, vec3 position, vec3 rotation, vec3 scale) {
     if (!backend) {
         ERROR("Renderer backend not initialized!");
         return;
     }
-    backend->draw_mesh(m);
+    render_thread_acquire_context();
+    backend->draw_mesh(m, position, rotation, scale);
+    render_thread_release_context();
 }
 
 font* renderer_create_font(const char* font_path, u32 font_size) {
@@ -211,7 +434,10 @@ font* renderer_create_font(const char* font_path, u32 font_size) {
         ERROR("Renderer backend not initialized!");
         return NULL;
     }
-    return backend->create_font(font_path, font_size);
+    render_thread_acquire_context();
+    font* result = backend->create_font(font_path, font_size);
+    render_thread_release_context();
+    return result;
 }
 
 font* renderer_create_fallback_font(u32 font_size) {
@@ -219,7 +445,10 @@ font* renderer_create_fallback_font(u32 font_size) {
         ERROR("Renderer backend not initialized!");
         return NULL;
     }
-    return backend->create_fallback_font(font_size);
+    render_thread_acquire_context();
+    font* result = backend->create_fallback_font(font_size);
+    render_thread_release_context();
+    return result;
 }
 
 void renderer_destroy_font(font* f) {
@@ -227,7 +456,9 @@ void renderer_destroy_font(font* f) {
         ERROR("Renderer backend not initialized!");
         return;
     }
+    render_thread_acquire_context();
     backend->destroy_font(f);
+    render_thread_release_context();
 }
 
 void renderer_draw_text(font* f, const char* text, vec2 position, vec4 color, f32 scale) {
@@ -235,5 +466,103 @@ void renderer_draw_text(font* f, const char* text, vec2 position, vec4 color, f3
         ERROR("Renderer backend not initialized!");
         return;
     }
+    render_thread_acquire_context();
     backend->draw_text(f, text, position, color, scale);
+    render_thread_release_context();
+}
+
+b8 renderer_create_texture(texture* t, const u8* pixels) {
+    if (!backend) {
+        ERROR("Renderer backend not initialized!");
+        return FALSE;
+    }
+    render_thread_acquire_context();
+    b8 result = backend->create_texture(t, pixels);
+    render_thread_release_context();
+    return result;
+}
+
+void renderer_destroy_texture(texture* t) {
+    if (!backend) {
+        ERROR("Renderer backend not initialized!");
+        return;
+    }
+    // Streamed work that hasn't gone out yet is dropped, taking the context
+    // below waits for what has
+    for (u64 i = darray_length(pending_uploads); i > 0; --i) {
+        if (pending_uploads[i - 1].texture == t) {
+            texture_upload_command dropped;
+            darray_pop_at(pending_uploads, i - 1, &dropped);
+        }
+    }
+    render_thread_acquire_context();
+    // 0 when its storage was still queued and got dropped above
+    if (t->id) {
+        backend->destroy_texture(t);
+    }
+    render_thread_release_context();
+}
+
+b8 renderer_create_texture_levels(texture* t, const texture_level* levels, u32 level_count) {
+    if (!backend) {
+        ERROR("Renderer backend not initialized!");
+        return FALSE;
+    }
+    render_thread_acquire_context();
+    b8 result = backend->create_texture_levels(t, levels, level_count);
+    render_thread_release_context();
+    return result;
+}
+
+b8 renderer_supports_texture_compression(texture_compression compression) {
+    if (!backend) {
+        return FALSE;
+    }
+    return compression == TEXTURE_COMPRESSION_NONE || backend->supports_texture_compression(compression);
+}
+
+// Done on the spot without a render thread, otherwise sent with the next packet.
+static void renderer_queue_texture_upload(texture_upload_command command) {
+    if (render_thread_is_active()) {
+        darray_push(pending_uploads, command);
+    } else {
+        renderer_run_texture_upload(&command);
+    }
+}
+
+void renderer_create_texture_storage(texture* t, u32 level_count) {
+    if (!backend) {
+        ERROR("Renderer backend not initialized!");
+        return;
+    }
+    renderer_queue_texture_upload(
+        (texture_upload_command){.type = TEXTURE_UPLOAD_CREATE_STORAGE, .texture = t, .level = level_count});
+}
+
+void renderer_upload_texture_rows(texture* t, u32 level, const u8* pixels, u32 first_row, u32 row_count) {
+    if (!backend) {
+        ERROR("Renderer backend not initialized!");
+        return;
+    }
+    renderer_queue_texture_upload((texture_upload_command){.type = TEXTURE_UPLOAD_ROWS,
+                                                           .texture = t,
+                                                           .level = level,
+                                                           .pixels = pixels,
+                                                           .first_row = first_row,
+                                                           .row_count = row_count});
+}
+
+u64 renderer_finish_texture_upload(texture* t, b8 generate_mipmaps) {
+    if (!backend) {
+        ERROR("Renderer backend not initialized!");
+        return 0;
+    }
+    renderer_queue_texture_upload(
+        (texture_upload_command){.type = TEXTURE_UPLOAD_FINISH, .texture = t, .generate_mipmaps = generate_mipmaps});
+    // Queued work rides on the next packet, otherwise it is done already
+    return render_thread_is_active() ? packets_submitted + 1 : packets_submitted;
+}
+
+b8 renderer_texture_upload_done(u64 fence) {
+    return __atomic_load_n(&packets_uploaded, __ATOMIC_ACQUIRE) >= fence;
 }
@@ -9,7 +9,7 @@
 struct static_mesh_data;
 struct platform_state;
  
-b8 renderer_initialize(const char* application_name, struct platform_state* plat_state);
+b8 renderer_initialize(renderer_backend_type type, const char* application_name, struct platform_state* plat_state);
 void renderer_shutdown();
  
 void renderer_on_resized(u16 width, u16 height);
@@ -18,15 +18,45 @@ b8 renderer_begin_frame(render_packet* packet, f32 delta_time);
 b8 renderer_end_frame(render_packet* packet);
 b8 renderer_draw_frame(render_packet* packet);
 
+// Moves drawing onto a dedicated render thread that owns the context. After this,
+// renderer_draw_frame queues a copy of the packet and returns without waiting for
+// the GPU. Resource creation and destruction keep working from the calling thread.
+b8 renderer_start_render_thread();
+// Drains queued frames and moves the context back to the calling thread.
+void renderer_stop_render_thread();
+
+// Latest frame with resolved GPU timings, a few frames behind the CPU. The
+// drawing thread publishes them after each frame, so this never waits on the GPU
+// or on a running render thread.
+API b8 renderer_get_gpu_timings(renderer_gpu_timings* out_timings);
+
+// Time the backend spent in end_frame, i.e. the buffer swap, for the last drawn frame.
+API f64 renderer_get_last_present_seconds();
+
+// Counters of the last fully drawn frame.
+API b8 renderer_get_frame_stats(renderer_frame_stats* out_stats);
+// Writes the counters of every frame drawn from now on to a CSV file.
+API b8 renderer_begin_stats_csv(const char* path);
+API void renderer_end_stats_csv();
+
+// Draws the given commands on top of every frame until replaced, pass zero counts
+// to clear. The arrays must stay valid until the next call, they are copied into
+// each packet at draw time.
+API void renderer_set_overlay(const text_command* text_commands, u32 text_count, const quad_command* quad_commands, u32 quad_count);
+
 // Mesh functions
 mesh* renderer_create_mesh(const vertex* vertices, u32 vertex_count);
+// Triangle list drawn through an index buffer of index_size (2 or 4) byte
+// indices. The data is uploaded straight from the given pointers, which only
+// need to stay valid for the call.
+mesh* renderer_create_indexed_mesh(const vertex* vertices, u32 vertex_count, const void* indices, u32 index_count, u32 index_size);
 void renderer_destroy_mesh(mesh* m);
-void renderer_draw_mesh(mesh* m);
+void renderer_draw_mesh(mesh* m, vec3 position, vec3 rotation, vec3 scale);
 
 // Model functions
 model* renderer_create_model(const char* model_path);
 void renderer_destroy_model(model* m);
-void renderer_draw_model(model* m);
+void renderer_draw_model(model* m, vec3 position, vec3 rotation, vec3 scale);
 
 // Text functions
 font* renderer_create_font(const char* font_path, u32 font_size);
@@ -34,5 +64,22 @@ font* renderer_create_fallback_font(u32 font_size);
 void renderer_destroy_font(font* f);
 void renderer_draw_text(font* f, const char* text, vec2 position, vec4 color, f32 scale);
 
+// Texture functions
+b8 renderer_create_texture(texture* t, const u8* pixels);
+void renderer_destroy_texture(texture* t);
+// Streamed uploads, see renderer_backend. With a render thread running they are
+// queued and done there before the next packet's draws, so the thread never
+// hands its context over for them. Pixels and t must stay valid until
+// renderer_texture_upload_done passes the fence returned by finish, or until t
+// is destroyed. t->id is 0 by then if the storage couldn't be created.
+void renderer_create_texture_storage(texture* t, u32 level_count);
+void renderer_upload_texture_rows(texture* t, u32 level, const u8* pixels, u32 first_row, u32 row_count);
+u64 renderer_finish_texture_upload(texture* t, b8 generate_mipmaps);
+b8 renderer_texture_upload_done(u64 fence);
+// Pre-built mip chains, see renderer_backend
+b8 renderer_create_texture_levels(texture* t, const texture_level* levels, u32 level_count);
+// Whether the GPU samples a block format directly. Safe from any thread.
+b8 renderer_supports_texture_compression(texture_compression compression);
+
 // Default font
 API font* renderer_get_default_font();
@@ -0,0 +1,125 @@
+#include "renderer_stats.h"
+
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+
+#include <stdio.h>
+
+typedef struct renderer_stats_state {
+    // Guards everything below, the drawing thread publishes while others read.
+    platform_mutex lock;
+    renderer_frame_stats last;
+    b8 has_last;
+    renderer_gpu_timings gpu_timings;
+    b8 has_gpu_timings;
+    FILE* csv;
+} renderer_stats_state;
+
+renderer_frame_stats renderer_stats_current;
+
+static renderer_stats_state state;
+static b8 initialized = FALSE;
+
+void renderer_stats_initialize() {
+    kzero_memory(&state, sizeof(renderer_stats_state));
+    kzero_memory(&renderer_stats_current, sizeof(renderer_frame_stats));
+    platform_mutex_create(&state.lock);
+    initialized = TRUE;
+}
+
+void renderer_stats_shutdown() {
+    if (!initialized) return;
+    renderer_stats_close_csv();
+    platform_mutex_destroy(&state.lock);
+    initialized = FALSE;
+}
+
+void renderer_stats_end_frame(u64 frame_number) {
+    renderer_stats_current.frame_number = frame_number;
+
+    if (initialized) {
+        platform_mutex_lock(&state.lock);
+        state.last = renderer_stats_current;
+        state.has_last = TRUE;
+        if (state.csv) {
+            renderer_frame_stats* s = &renderer_stats_current;
+            fprintf(state.csv, "%llu,%u,%llu,%u,%u,%u,%u,%llu,%u,%u\n",
+                    s->frame_number, s->draw_calls, s->triangles, s->shader_binds, s->texture_binds,
+                    s->vao_binds, s->buffer_uploads, s->buffer_upload_bytes, s->uniform_updates,
+                    s->state_changes);
+        }
+        platform_mutex_unlock(&state.lock);
+    }
+
+    kzero_memory(&renderer_stats_current, sizeof(renderer_frame_stats));
+}
+
+b8 renderer_stats_get_last(renderer_frame_stats* out_stats) {
+    if (!initialized || !out_stats) return FALSE;
+
+    platform_mutex_lock(&state.lock);
+    b8 has_last = state.has_last;
+    if (has_last) {
+        *out_stats = state.last;
+    }
+    platform_mutex_unlock(&state.lock);
+    return has_last;
+}
+
+void renderer_stats_publish_gpu_timings(const renderer_gpu_timings* timings) {
+    if (!initialized) return;
+
+    platform_mutex_lock(&state.lock);
+    state.gpu_timings = *timings;
+    state.has_gpu_timings = TRUE;
+    platform_mutex_unlock(&state.lock);
+}
+
+b8 renderer_stats_get_gpu_timings(renderer_gpu_timings* out_timings) {
+    if (!initialized || !out_timings) return FALSE;
+
+    platform_mutex_lock(&state.lock);
+    b8 has_timings = state.has_gpu_timings;
+    if (has_timings) {
+        *out_timings = state.gpu_timings;
+    }
+    platform_mutex_unlock(&state.lock);
+    return has_timings;
+}
+
+b8 renderer_stats_open_csv(const char* path) {
+    if (!initialized) return FALSE;
+
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        ERROR("Failed to open '%s' for renderer stats", path);
+        return FALSE;
+    }
+    fprintf(file, "frame,draw_calls,triangles,shader_binds,texture_binds,vao_binds,"
+                  "buffer_uploads,buffer_upload_bytes,uniform_updates,state_changes\n");
+
+    platform_mutex_lock(&state.lock);
+    FILE* previous = state.csv;
+    state.csv = file;
+    platform_mutex_unlock(&state.lock);
+
+    if (previous) {
+        fclose(previous);
+    }
+    INFO("Writing per-frame renderer stats to '%s'", path);
+    return TRUE;
+}
+
+void renderer_stats_close_csv() {
+    if (!initialized) return;
+
+    platform_mutex_lock(&state.lock);
+    FILE* file = state.csv;
+    state.csv = 0;
+    platform_mutex_unlock(&state.lock);
+
+    if (file) {
+        fclose(file);
+    }
+}
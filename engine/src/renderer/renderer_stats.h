@@ -0,0 +1,42 @@
+#pragma once
+
+#include "renderer_types.inl"
+
+// Counters for the frame being drawn. Only touched by the thread that owns the
+// renderer context, so the increments below need no synchronization.
+extern renderer_frame_stats renderer_stats_current;
+
+#define renderer_stats_count_draw(vertex_count)                     \
+    do {                                                            \
+        renderer_stats_current.draw_calls++;                        \
+        renderer_stats_current.triangles += (vertex_count) / 3;     \
+    } while (0)
+#define renderer_stats_count_shader_bind() (renderer_stats_current.shader_binds++)
+#define renderer_stats_count_texture_bind() (renderer_stats_current.texture_binds++)
+#define renderer_stats_count_vao_bind() (renderer_stats_current.vao_binds++)
+#define renderer_stats_count_uniform_update() (renderer_stats_current.uniform_updates++)
+#define renderer_stats_count_state_changes(count) (renderer_stats_current.state_changes += (count))
+#define renderer_stats_count_buffer_upload(bytes)                   \
+    do {                                                            \
+        renderer_stats_current.buffer_uploads++;                    \
+        renderer_stats_current.buffer_upload_bytes += (bytes);      \
+    } while (0)
+
+void renderer_stats_initialize();
+void renderer_stats_shutdown();
+
+// Closes the current frame: publishes its counters, appends them to the CSV if
+// one is open and starts counting the next frame.
+void renderer_stats_end_frame(u64 frame_number);
+
+// Copies the counters of the last completed frame. Safe from any thread.
+b8 renderer_stats_get_last(renderer_frame_stats* out_stats);
+
+// Latest resolved GPU timings, published by the drawing thread after each frame
+// so readers never need the renderer context. Get is safe from any thread.
+void renderer_stats_publish_gpu_timings(const renderer_gpu_timings* timings);
+b8 renderer_stats_get_gpu_timings(renderer_gpu_timings* out_timings);
+
+// Appends one line per completed frame to path until renderer_stats_close_csv.
+b8 renderer_stats_open_csv(const char* path);
+void renderer_stats_close_csv();
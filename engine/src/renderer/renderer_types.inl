@@ -7,7 +7,9 @@
 typedef enum renderer_backend_type {
     RENDERER_BACKEND_TYPE_OPENGL,
     RENDERER_BACKEND_TYPE_VULKAN,
-    RENDERER_BACKEND_TYPE_DIRECTX
+    RENDERER_BACKEND_TYPE_DIRECTX,
+    // Issues no GPU calls. Used for headless runs on machines without a display.
+    RENDERER_BACKEND_TYPE_NULL
 } renderer_backend_type;
 
 // Vertex data structure
@@ -44,6 +46,17 @@ typedef struct font {
     u32 vbo;
 } font;
 
+// GPU block formats, each stores 4x4 pixel blocks in a fixed number of bytes
+typedef enum texture_compression {
+    TEXTURE_COMPRESSION_NONE,
+    // 8 bytes per block, RGB with 1-bit alpha
+    TEXTURE_COMPRESSION_BC1,
+    // 16 bytes per block, BC1 colour plus interpolated alpha
+    TEXTURE_COMPRESSION_BC3,
+    // 16 bytes per block, RGBA with a choice of modes per block
+    TEXTURE_COMPRESSION_BC7
+} texture_compression;
+
 // Texture data structure
 typedef struct texture {
     u32 id;                // OpenGL texture ID
@@ -52,17 +65,32 @@ typedef struct texture {
     u32 channels;          // Number of channels (1=R, 2=RG, 3=RGB, 4=RGBA)
     char path[256];        // Path to the texture file
     void* data;            // Raw texture data (can be NULL after upload to GPU)
+    b8 streaming;          // texture_load_async hasn't finished, id is the shared placeholder's
+    texture_compression compression; // Block format of the GPU copy, NONE for plain pixels
 } texture;
 
+// One mip level of a pre-built texture, rows tightly packed. Block
+// compressed levels are rows of blocks instead.
+typedef struct texture_level {
+    const u8* pixels;
+    u64 size;
+    u32 width;
+    u32 height;
+} texture_level;
+
 // Mesh data structure
 typedef struct mesh {
     u32 id;
     u32 vertex_count;
     u32 vertex_buffer_size;
-    vertex* vertices;
+    // Indexed meshes draw index_count indices of index_size bytes, 2 when every
+    // vertex fits in a u16 and 4 otherwise. index_count is 0 for plain triangle lists.
+    u32 index_count;
+    u32 index_size;
     // OpenGL-specific data
     GLuint vao;
     GLuint vbo;
+    GLuint ebo;
 } mesh;
 
 // Command structures
@@ -83,17 +111,28 @@ typedef struct mesh_command {
     mesh* mesh;
 } mesh_command;
 
+// Solid screen-space rectangle, in pixels from the top-left corner. Drawn on
+// top of the scene, all quads of a frame in a single draw call.
+typedef struct quad_command {
+    vec2 position;
+    vec2 size;
+    vec4 color;
+} quad_command;
+
 // Model data structure
 typedef struct model {
     u32 id;                // Unique model ID
     u32 vertex_count;      // Number of vertices
     u32 index_count;       // Number of indices (if indexed)
-    vertex* vertices;      // Array of vertices
-    u32* indices;          // Array of indices (if indexed)
+    vertex* vertices;      // Array of vertices, NULL when loaded from the mesh cache
+    u32* indices;          // Array of indices (if indexed), NULL when loaded from the mesh cache
     b8 is_indexed;         // Whether the model uses indexed geometry
+    vec3 bounds_min;       // Axis-aligned bounds of the vertex positions
+    vec3 bounds_max;
     char name[64];         // Model name
     mesh* mesh;
     texture* texture;      // Model texture
+    u32 texture_handle;    // resource_handle that keeps the texture loaded
 } model;
 
 typedef struct model_command {
@@ -105,6 +144,27 @@ typedef struct model_command {
     model* model;
 } model_command;
 
+// Streamed texture work. The renderer attaches queued commands to the next
+// packet and runs them before its draws, so a render thread keeps its context.
+typedef enum texture_upload_type {
+    TEXTURE_UPLOAD_CREATE_STORAGE,
+    TEXTURE_UPLOAD_ROWS,
+    TEXTURE_UPLOAD_FINISH
+} texture_upload_type;
+
+typedef struct texture_upload_command {
+    texture_upload_type type;
+    texture* texture;
+    // Level count for the storage, the level the rows belong to
+    u32 level;
+    // Rows only
+    const u8* pixels;
+    u32 first_row;
+    u32 row_count;
+    // Finish only
+    b8 generate_mipmaps;
+} texture_upload_command;
+
 // Render packet structure
 typedef struct render_packet {
     f32 delta_time;  // Time since last frame
@@ -120,10 +180,54 @@ typedef struct render_packet {
         model_command* commands;
         u32 count;
     } model_commands;
+    struct {
+        quad_command* commands;
+        u32 count;
+    } quad_commands;
+    // Filled in by the renderer, not by the game
+    struct {
+        texture_upload_command* commands;
+        u32 count;
+    } texture_uploads;
     vec3 camera_position;
     vec3 camera_rotation;
 } render_packet;
  
+// Groups of draws timed separately on the GPU.
+typedef enum renderer_pass {
+    RENDERER_PASS_TEXT,
+    RENDERER_PASS_MESHES,
+    RENDERER_PASS_MODELS,
+    RENDERER_PASS_QUADS,
+    RENDERER_PASS_MAX
+} renderer_pass;
+
+// GPU time spent on one frame, resolved a few frames after it was drawn.
+typedef struct renderer_gpu_timings {
+    // renderer_backend.frame_number of the frame these timings belong to.
+    u64 frame_number;
+    // Milliseconds from begin_frame to end_frame on the GPU timeline.
+    f64 frame_ms;
+    f64 pass_ms[RENDERER_PASS_MAX];
+} renderer_gpu_timings;
+
+// Work submitted to the graphics API during one frame. Uploads made between
+// frames, e.g. while creating resources, count towards the next frame.
+typedef struct renderer_frame_stats {
+    u64 frame_number;
+    u32 draw_calls;
+    u64 triangles;
+    u32 shader_binds;
+    u32 texture_binds;
+    u32 vao_binds;
+    // Vertex buffer and texture image uploads.
+    u32 buffer_uploads;
+    u64 buffer_upload_bytes;
+    u32 uniform_updates;
+    // Fixed-function state toggles: enable/disable, blend func, clear color and the like.
+    u32 state_changes;
+} renderer_frame_stats;
+
 typedef struct renderer_backend {
     struct platform_state* plat_state;
     void* internal_state;
@@ -136,21 +240,52 @@ typedef struct renderer_backend {
     b8 (*begin_frame)(struct renderer_backend* backend, render_packet* packet);
     b8 (*end_frame)(struct renderer_backend* backend, render_packet* packet);
     b8 (*draw_frame)(struct renderer_backend* backend, render_packet* packet);
+    // Makes the backend's context current on (bind) or releases it from (!bind) the calling thread.
+    b8 (*bind_context)(struct renderer_backend* backend, b8 bind);
+    // Brackets the draws of one pass for GPU timing.
+    void (*begin_pass)(struct renderer_backend* backend, renderer_pass pass);
+    void (*end_pass)(struct renderer_backend* backend, renderer_pass pass);
+    // Copies out the most recent frame whose GPU timings are available. FALSE if none are.
+    b8 (*get_gpu_timings)(struct renderer_backend* backend, renderer_gpu_timings* out_timings);
 
     // Mesh functions
     mesh* (*create_mesh)(const vertex* vertices, u32 vertex_count);
+    mesh* (*create_indexed_mesh)(const vertex* vertices, u32 vertex_count, const void* indices, u32 index_count, u32 index_size);
     void (*destroy_mesh)(mesh* m);
-    void (*draw_mesh)(mesh* m);
+    // Drawn with a model matrix built from the transform, per command since
+    // shared meshes and models appear in several commands
+    void (*draw_mesh)(mesh* m, vec3 position, vec3 rotation, vec3 scale);
     mesh* (*get_mesh)(u32 mesh_id);
 
     // Model functions
     model* (*create_model)(const char* model_path);
     void (*destroy_model)(model* m);
-    void (*draw_model)(model* m);
+    void (*draw_model)(model* m, vec3 position, vec3 rotation, vec3 scale);
 
     // Text functions
     font* (*create_font)(const char* font_path, u32 font_size);
     font* (*create_fallback_font)(u32 font_size);
     void (*destroy_font)(font* f);
     void (*draw_text)(font* f, const char* text, vec2 position, vec4 color, f32 scale);
+
+    // Overlay functions
+    void (*draw_quads)(const quad_command* quads, u32 count);
+
+    // Texture functions. pixels is width * height * channels bytes, t->id is set on success.
+    b8 (*create_texture)(texture* t, const u8* pixels);
+    void (*destroy_texture)(texture* t);
+    // Streamed uploads: storage for the texture's size without contents, then
+    // each level's rows in slices (pixels starts at first_row), then
+    // finish_texture_upload. level_count 0 allocates level 0 only and has
+    // finish generate the rest of the chain, otherwise that many levels of
+    // t->compression are allocated. Block formats go up in whole rows of
+    // blocks. Released with destroy_texture.
+    b8 (*create_texture_storage)(texture* t, u32 level_count);
+    void (*upload_texture_rows)(texture* t, u32 level, const u8* pixels, u32 first_row, u32 row_count);
+    void (*finish_texture_upload)(texture* t, b8 generate_mipmaps);
+    // Pre-built mip chain, levels[0] is t's full size and each next level
+    // halves it. Nothing is generated, a chain that stops early stays short.
+    // Levels are in t->compression's block format, which must be supported.
+    b8 (*create_texture_levels)(texture* t, const texture_level* levels, u32 level_count);
+    b8 (*supports_texture_compression)(texture_compression compression);
 } renderer_backend;
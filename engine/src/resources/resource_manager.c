@@ -0,0 +1,523 @@
+#include "resource_manager.h"
+#include "containers/probe_table.h"
+#include "core/hash.h"
+#include "core/idle_tasks.h"
+#include "core/kmemory.h"
+#include "core/kstring.h"
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "core/vfs.h"
+#include "platform/platform.h"
+#include "renderer/renderer_frontend.h"
+#include "resources/texture.h"
+#include "resources/texture_streaming.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define RESOURCE_INITIAL_CAPACITY 64
+// Handles hold the entry index plus one in the low bits and the entry's
+// generation in the high bits, so a stale handle doesn't reach a reused entry.
+#define RESOURCE_INDEX_BITS 16
+#define RESOURCE_INDEX_MASK ((1u << RESOURCE_INDEX_BITS) - 1)
+#define RESOURCE_MAX_ENTRIES RESOURCE_INDEX_MASK
+#define RESOURCE_NONE 0xFFFFFFFFu
+
+typedef struct resource_entry {
+    resource_type type;
+    // RESOURCE_STATE_NONE for free entries
+    resource_state state;
+    u32 generation;
+    u32 ref_count;
+    u64 hash;
+    char* key;
+    void* data;
+    // Links in the unused list while ref_count is 0, lru_next also threads
+    // the free list
+    u32 lru_prev;
+    u32 lru_next;
+    f64 released_at;
+} resource_entry;
+
+typedef struct resource_loader {
+    pfn_resource_load load;
+    pfn_resource_unload unload;
+    // Returns at once with a placeholder that fills in later, 0 loads in place
+    pfn_resource_load load_async;
+} resource_loader;
+
+typedef struct resource_manager_state {
+    f64 grace_seconds;
+    u32 max_unused;
+    resource_loader loaders[RESOURCE_TYPE_COUNT];
+
+    resource_entry* entries;
+    u32 entry_capacity;
+    u32 entry_count;
+    u32 free_head;
+
+    // Open-addressed with linear probing from key hash to entry index plus
+    // one, 0 is an empty slot. Capacity is a power of two, at least twice the
+    // entry count.
+    u32* slots;
+    u32 slot_capacity;
+
+    // Unused entries, least recently released first
+    u32 lru_head;
+    u32 lru_tail;
+    u32 unused_count;
+    // Unloads expired entries in idle time, INVALID_IDLE_TASK_ID when not queued
+    idle_task_id unload_task;
+
+    u64 acquires;
+    u64 loads;
+} resource_manager_state;
+
+static resource_manager_state state;
+static b8 initialized = FALSE;
+
+static const char* resource_type_names[RESOURCE_TYPE_COUNT] = {"texture", "mesh", "model"};
+
+static void* resource_load_texture(const char* path) {
+    return texture_load(path);
+}
+
+static void* resource_load_texture_async(const char* path) {
+    return texture_load_async(path);
+}
+
+static void resource_unload_texture(void* resource) {
+    texture_destroy(resource);
+}
+
+static void resource_unload_mesh(void* resource) {
+    renderer_destroy_mesh(resource);
+}
+
+static void* resource_load_model(const char* path) {
+    return renderer_create_model(path);
+}
+
+static void resource_unload_model(void* resource) {
+    renderer_destroy_model(resource);
+}
+
+static resource_handle resource_make_handle(u32 index) {
+    return (state.entries[index].generation << RESOURCE_INDEX_BITS) | (index + 1);
+}
+
+static resource_entry* resource_lookup(resource_handle handle) {
+    if (!initialized || handle == INVALID_RESOURCE_HANDLE) {
+        return 0;
+    }
+    u32 index = (handle & RESOURCE_INDEX_MASK) - 1;
+    if (index >= state.entry_capacity) {
+        return 0;
+    }
+    resource_entry* entry = &state.entries[index];
+    if (entry->state == RESOURCE_STATE_NONE || entry->generation != handle >> RESOURCE_INDEX_BITS) {
+        return 0;
+    }
+    return entry;
+}
+
+// Returns the slot holding the key, or the empty slot it belongs in.
+static u32 resource_find_slot(resource_type type, const char* key, u64 hash) {
+    u32 mask = state.slot_capacity - 1;
+    u32 slot = (u32)(hash & mask);
+    while (state.slots[slot]) {
+        const resource_entry* entry = &state.entries[state.slots[slot] - 1];
+        if (entry->hash == hash && entry->type == type && strcmp(entry->key, key) == 0) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void resource_slots_grow() {
+    u32* old = state.slots;
+    u32 old_capacity = state.slot_capacity;
+    state.slot_capacity = old_capacity * 2;
+    state.slots = kallocate(sizeof(u32) * state.slot_capacity, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < old_capacity; ++i) {
+        if (old[i]) {
+            const resource_entry* entry = &state.entries[old[i] - 1];
+            state.slots[resource_find_slot(entry->type, entry->key, entry->hash)] = old[i];
+        }
+    }
+    kfree(old, sizeof(u32) * old_capacity, MEMORY_TAG_ARRAY);
+}
+
+static b8 resource_slot_used(void* table, u32 slot) {
+    return ((u32*)table)[slot] != 0;
+}
+
+static u64 resource_slot_hash(void* table, u32 slot) {
+    return state.entries[((u32*)table)[slot] - 1].hash;
+}
+
+static void resource_slot_move(void* table, u32 to, u32 from) {
+    ((u32*)table)[to] = ((u32*)table)[from];
+}
+
+// Empties a slot, see probe_table_remove.
+static void resource_slots_remove(u32 slot) {
+    u32 hole = probe_table_remove(state.slots, state.slot_capacity, slot, resource_slot_used, resource_slot_hash,
+                                  resource_slot_move);
+    state.slots[hole] = 0;
+}
+
+static void resource_entries_grow() {
+    u32 old_capacity = state.entry_capacity;
+    u32 new_capacity = old_capacity * 2 < RESOURCE_MAX_ENTRIES ? old_capacity * 2 : RESOURCE_MAX_ENTRIES;
+    resource_entry* entries = kallocate(sizeof(resource_entry) * new_capacity, MEMORY_TAG_ARRAY);
+    kcopy_memory(entries, state.entries, sizeof(resource_entry) * old_capacity);
+    kfree(state.entries, sizeof(resource_entry) * old_capacity, MEMORY_TAG_ARRAY);
+    state.entries = entries;
+    state.entry_capacity = new_capacity;
+    // New entries join the free list in index order
+    for (u32 i = new_capacity; i > old_capacity; --i) {
+        state.entries[i - 1].lru_next = state.free_head;
+        state.free_head = i - 1;
+    }
+}
+
+static void resource_lru_unlink(u32 index) {
+    resource_entry* entry = &state.entries[index];
+    if (entry->lru_prev != RESOURCE_NONE) {
+        state.entries[entry->lru_prev].lru_next = entry->lru_next;
+    } else {
+        state.lru_head = entry->lru_next;
+    }
+    if (entry->lru_next != RESOURCE_NONE) {
+        state.entries[entry->lru_next].lru_prev = entry->lru_prev;
+    } else {
+        state.lru_tail = entry->lru_prev;
+    }
+    entry->lru_prev = RESOURCE_NONE;
+    entry->lru_next = RESOURCE_NONE;
+    state.unused_count--;
+}
+
+static void resource_lru_push(u32 index) {
+    resource_entry* entry = &state.entries[index];
+    entry->lru_prev = state.lru_tail;
+    entry->lru_next = RESOURCE_NONE;
+    if (state.lru_tail != RESOURCE_NONE) {
+        state.entries[state.lru_tail].lru_next = index;
+    } else {
+        state.lru_head = index;
+    }
+    state.lru_tail = index;
+    state.unused_count++;
+}
+
+// Drops the entry from the map and returns it to the free list. Unloading the
+// data is up to the caller.
+static void resource_remove(u32 index) {
+    resource_entry* entry = &state.entries[index];
+    resource_slots_remove(resource_find_slot(entry->type, entry->key, entry->hash));
+    kfree(entry->key, strlen(entry->key) + 1, MEMORY_TAG_STRING);
+    entry->key = 0;
+    entry->data = 0;
+    entry->state = RESOURCE_STATE_NONE;
+    entry->ref_count = 0;
+    // Handles to the old contents stop matching
+    entry->generation = (entry->generation + 1) & (0xFFFFFFFFu >> RESOURCE_INDEX_BITS);
+    entry->lru_next = state.free_head;
+    state.free_head = index;
+    state.entry_count--;
+}
+
+static void resource_unload(u32 index) {
+    resource_entry* entry = &state.entries[index];
+    if (entry->ref_count == 0) {
+        resource_lru_unlink(index);
+    }
+    DEBUG("Unloading %s '%s'", resource_type_names[entry->type], entry->key);
+    void* data = entry->data;
+    resource_type type = entry->type;
+    resource_remove(index);
+    // After removal, an unload that releases other resources may move entries
+    state.loaders[type].unload(data);
+}
+
+static void resource_unload_unused() {
+    while (state.lru_head != RESOURCE_NONE) {
+        resource_unload(state.lru_head);
+    }
+}
+
+static resource_handle resource_acquire_key(resource_type type, const char* key, pfn_resource_load load,
+                                            pfn_resource_create create, void* params) {
+    if (!initialized) {
+        ERROR("resource_manager_initialize must be called before acquiring resources");
+        return INVALID_RESOURCE_HANDLE;
+    }
+    state.acquires++;
+    u64 hash = hash_string(key, (u64)type);
+    u32 slot = resource_find_slot(type, key, hash);
+    if (state.slots[slot]) {
+        u32 index = state.slots[slot] - 1;
+        resource_entry* entry = &state.entries[index];
+        if (entry->ref_count == 0) {
+            resource_lru_unlink(index);
+        }
+        entry->ref_count++;
+        return resource_make_handle(index);
+    }
+
+    if (state.entry_count == RESOURCE_MAX_ENTRIES) {
+        ERROR("Resource manager is full, can't load %s '%s'", resource_type_names[type], key);
+        return INVALID_RESOURCE_HANDLE;
+    }
+    if (state.free_head == RESOURCE_NONE) {
+        resource_entries_grow();
+    }
+    if ((state.entry_count + 1) * 2 > state.slot_capacity) {
+        resource_slots_grow();
+        slot = resource_find_slot(type, key, hash);
+    }
+
+    u32 index = state.free_head;
+    resource_entry* entry = &state.entries[index];
+    state.free_head = entry->lru_next;
+    state.entry_count++;
+    entry->type = type;
+    // Acquires of the same key during the load share this entry
+    entry->state = RESOURCE_STATE_LOADING;
+    entry->ref_count = 1;
+    entry->hash = hash;
+    entry->key = string_duplicate(key);
+    entry->data = 0;
+    entry->lru_prev = RESOURCE_NONE;
+    entry->lru_next = RESOURCE_NONE;
+    state.slots[slot] = index + 1;
+    resource_handle handle = resource_make_handle(index);
+
+    // Loaders may acquire other resources, which can move the entries
+    void* data = load ? load(entry->key) : create(params);
+    entry = &state.entries[index];
+    if (!data) {
+        WARN("Failed to load %s '%s'", resource_type_names[type], key);
+        resource_remove(index);
+        return INVALID_RESOURCE_HANDLE;
+    }
+    entry->data = data;
+    entry->state = RESOURCE_STATE_READY;
+    state.loads++;
+    return handle;
+}
+
+b8 resource_manager_initialize(f64 grace_seconds, u32 max_unused) {
+    if (initialized) {
+        return TRUE;
+    }
+    kzero_memory(&state, sizeof(state));
+    state.grace_seconds = grace_seconds;
+    state.max_unused = max_unused;
+    state.loaders[RESOURCE_TYPE_TEXTURE] = (resource_loader){resource_load_texture, resource_unload_texture,
+                                                                   resource_load_texture_async};
+    state.loaders[RESOURCE_TYPE_MESH] = (resource_loader){0, resource_unload_mesh, 0};
+    state.loaders[RESOURCE_TYPE_MODEL] = (resource_loader){resource_load_model, resource_unload_model, 0};
+
+    state.entry_capacity = RESOURCE_INITIAL_CAPACITY;
+    state.entries = kallocate(sizeof(resource_entry) * state.entry_capacity, MEMORY_TAG_ARRAY);
+    state.free_head = RESOURCE_NONE;
+    for (u32 i = state.entry_capacity; i > 0; --i) {
+        state.entries[i - 1].lru_next = state.free_head;
+        state.free_head = i - 1;
+    }
+    state.slot_capacity = RESOURCE_INITIAL_CAPACITY * 2;
+    state.slots = kallocate(sizeof(u32) * state.slot_capacity, MEMORY_TAG_ARRAY);
+    state.lru_head = RESOURCE_NONE;
+    state.lru_tail = RESOURCE_NONE;
+
+    initialized = TRUE;
+    return TRUE;
+}
+
+void resource_manager_shutdown() {
+    if (!initialized) {
+        return;
+    }
+    INFO("Resource manager: %llu acquires, %llu loads", state.acquires, state.loads);
+    idle_tasks_cancel(state.unload_task);
+    resource_unload_unused();
+    // Whatever is left was never released. Models go first since they hold
+    // textures, which then aren't reported as well.
+    for (i32 type = RESOURCE_TYPE_COUNT - 1; type >= 0; --type) {
+        for (u32 i = 0; i < state.entry_capacity; ++i) {
+            resource_entry* entry = &state.entries[i];
+            if (entry->state == RESOURCE_STATE_NONE || entry->type != (resource_type)type) {
+                continue;
+            }
+            WARN("Resource %s '%s' still has %u references at shutdown", resource_type_names[type], entry->key,
+                 entry->ref_count);
+            entry->ref_count = 0;
+            resource_lru_push(i);
+            resource_unload_unused();
+        }
+    }
+    kfree(state.slots, sizeof(u32) * state.slot_capacity, MEMORY_TAG_ARRAY);
+    kfree(state.entries, sizeof(resource_entry) * state.entry_capacity, MEMORY_TAG_ARRAY);
+    initialized = FALSE;
+}
+
+static b8 resource_expired_head() {
+    return state.lru_head != RESOURCE_NONE &&
+           platform_get_absolute_time() - state.entries[state.lru_head].released_at >= state.grace_seconds;
+}
+
+static b8 resource_unload_expired(void* user_data, f64 deadline, f32* out_progress) {
+    // One at a time, unloads free GPU memory and can take a while
+    while (resource_expired_head()) {
+        resource_unload(state.lru_head);
+        if (platform_get_absolute_time() >= deadline && resource_expired_head()) {
+            return FALSE;
+        }
+    }
+    state.unload_task = INVALID_IDLE_TASK_ID;
+    return TRUE;
+}
+
+static void resource_unload_expired_drop(void* user_data) {
+    state.unload_task = INVALID_IDLE_TASK_ID;
+}
+
+void resource_manager_update() {
+    if (!initialized || state.unload_task != INVALID_IDLE_TASK_ID || !resource_expired_head()) {
+        return;
+    }
+    state.unload_task =
+        idle_tasks_submit("unload expired resources", resource_unload_expired, resource_unload_expired_drop, 0);
+    if (state.unload_task == INVALID_IDLE_TASK_ID) {
+        // No idle queue, unload right away
+        resource_unload_expired(0, platform_get_absolute_time() + 1e9, &(f32){0});
+    }
+}
+
+void resource_manager_set_loader(resource_type type, pfn_resource_load load, pfn_resource_unload unload) {
+    state.loaders[type].load = load;
+    state.loaders[type].unload = unload;
+}
+
+void resource_manager_set_async_loader(resource_type type, pfn_resource_load load_async) {
+    state.loaders[type].load_async = load_async;
+}
+
+static resource_handle resource_acquire_path(resource_type type, const char* path, pfn_resource_load load) {
+    if (!load) {
+        ERROR("No loader for %s files, can't load '%s'", resource_type_names[type], path);
+        return INVALID_RESOURCE_HANDLE;
+    }
+    // The same file reached through "./a" and "a" is one resource
+    char normalized[VFS_PATH_MAX];
+    if (!vfs_normalize(path, normalized)) {
+        return INVALID_RESOURCE_HANDLE;
+    }
+    return resource_acquire_key(type, normalized, load, 0, 0);
+}
+
+resource_handle resource_acquire(resource_type type, const char* path) {
+    PROFILE_FUNCTION();
+    return resource_acquire_path(type, path, state.loaders[type].load);
+}
+
+resource_handle resource_acquire_async(resource_type type, const char* path) {
+    PROFILE_FUNCTION();
+    pfn_resource_load load = state.loaders[type].load_async;
+    return resource_acquire_path(type, path, load ? load : state.loaders[type].load);
+}
+
+resource_handle resource_acquire_generated(resource_type type, const char* key, pfn_resource_create create,
+                                           void* params) {
+    return resource_acquire_key(type, key, 0, create, params);
+}
+
+typedef struct mesh_params {
+    const vertex* vertices;
+    u32 vertex_count;
+} mesh_params;
+
+static void* resource_create_mesh(void* params) {
+    mesh_params* data = params;
+    return renderer_create_mesh(data->vertices, data->vertex_count);
+}
+
+resource_handle resource_acquire_mesh(const vertex* vertices, u32 vertex_count) {
+    char key[64];
+    snprintf(key, sizeof(key), "mesh:%016llx:%u",
+             (unsigned long long)hash_bytes(vertices, sizeof(vertex) * vertex_count, 0), vertex_count);
+    mesh_params params = {vertices, vertex_count};
+    return resource_acquire_key(RESOURCE_TYPE_MESH, key, 0, resource_create_mesh, &params);
+}
+
+static void* resource_create_checkerboard(void* params) {
+    return texture_create_default_checkerboard();
+}
+
+resource_handle resource_acquire_checkerboard() {
+    return resource_acquire_key(RESOURCE_TYPE_TEXTURE, "builtin:checkerboard", 0, resource_create_checkerboard, 0);
+}
+
+resource_handle resource_retain(resource_handle handle) {
+    resource_entry* entry = resource_lookup(handle);
+    if (!entry) {
+        return INVALID_RESOURCE_HANDLE;
+    }
+    if (entry->ref_count == 0) {
+        resource_lru_unlink((handle & RESOURCE_INDEX_MASK) - 1);
+    }
+    entry->ref_count++;
+    return handle;
+}
+
+void resource_release(resource_handle handle) {
+    resource_entry* entry = resource_lookup(handle);
+    if (!entry || entry->ref_count == 0) {
+        if (handle != INVALID_RESOURCE_HANDLE && initialized) {
+            WARN("Releasing resource handle %u that isn't held", handle);
+        }
+        return;
+    }
+    if (--entry->ref_count > 0) {
+        return;
+    }
+
+    u32 index = (handle & RESOURCE_INDEX_MASK) - 1;
+    entry->released_at = platform_get_absolute_time();
+    resource_lru_push(index);
+    if (state.grace_seconds <= 0.0) {
+        resource_unload(index);
+    } else if (state.unused_count > state.max_unused) {
+        resource_unload(state.lru_head);
+    }
+}
+
+resource_state resource_get_state(resource_handle handle) {
+    resource_entry* entry = resource_lookup(handle);
+    return entry ? entry->state : RESOURCE_STATE_NONE;
+}
+
+static void* resource_get(resource_handle handle, resource_type type) {
+    resource_entry* entry = resource_lookup(handle);
+    return entry && entry->type == type ? entry->data : 0;
+}
+
+texture* resource_get_texture(resource_handle handle) {
+    return resource_get(handle, RESOURCE_TYPE_TEXTURE);
+}
+
+mesh* resource_get_mesh(resource_handle handle) {
+    return resource_get(handle, RESOURCE_TYPE_MESH);
+}
+
+model* resource_get_model(resource_handle handle) {
+    return resource_get(handle, RESOURCE_TYPE_MODEL);
+}
+
+u32 resource_manager_count() {
+    return initialized ? state.entry_count : 0;
+}
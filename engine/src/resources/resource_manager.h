@@ -0,0 +1,85 @@
+#pragma once
+
+#include "definitions.h"
+#include "renderer/renderer_types.inl"
+
+// Shared assets behind reference-counted handles. However many users acquire
+// an asset, it is loaded and uploaded once: file assets are keyed by their
+// normalized path, assets made in code by a key naming their content, e.g. a
+// hash of it. After the last release an asset stays cached for a grace
+// period, so dropping and re-acquiring it, as a level reload does, is free.
+//
+// Main thread only, loaders upload to the GPU.
+
+// Unused assets are kept this long before they are unloaded, 0 unloads on
+// the last release.
+#define RESOURCE_DEFAULT_GRACE_SECONDS 5.0
+// Unused assets kept at most, the least recently released are unloaded first.
+#define RESOURCE_DEFAULT_MAX_UNUSED 64
+
+typedef u32 resource_handle;
+#define INVALID_RESOURCE_HANDLE 0
+
+typedef enum resource_type {
+    RESOURCE_TYPE_TEXTURE,
+    RESOURCE_TYPE_MESH,
+    RESOURCE_TYPE_MODEL,
+    RESOURCE_TYPE_COUNT
+} resource_type;
+
+typedef enum resource_state {
+    // Unknown or released handle
+    RESOURCE_STATE_NONE,
+    // Acquired again while its load is still running, e.g. from a loader
+    RESOURCE_STATE_LOADING,
+    RESOURCE_STATE_READY
+} resource_state;
+
+// Loads the asset stored at path, 0 on failure.
+typedef void* (*pfn_resource_load)(const char* path);
+// Makes an asset from the params given to resource_acquire_generated, 0 on failure.
+typedef void* (*pfn_resource_create)(void* params);
+typedef void (*pfn_resource_unload)(void* resource);
+
+API b8 resource_manager_initialize(f64 grace_seconds, u32 max_unused);
+// Unloads everything, warning about assets that are still referenced.
+API void resource_manager_shutdown();
+// Queues the unload of unused assets whose grace period ran out as an idle
+// task, so GPU frees happen in the frame's slack. Called once per frame by the
+// application loop.
+API void resource_manager_update();
+
+// Replaces how files of a type are loaded and how the type is unloaded.
+API void resource_manager_set_loader(resource_type type, pfn_resource_load load, pfn_resource_unload unload);
+// Sets the loader resource_acquire_async uses for a type, 0 makes it load in
+// place like resource_acquire.
+API void resource_manager_set_async_loader(resource_type type, pfn_resource_load load_async);
+
+// Returns a reference to the asset at path, loading it on first use.
+// INVALID_RESOURCE_HANDLE when it can't be loaded.
+API resource_handle resource_acquire(resource_type type, const char* path);
+// Same, but returns before the asset is ready when its type can stream in:
+// textures draw as a placeholder until texture streaming has uploaded them.
+// Shares the entry with resource_acquire of the same path, whichever came first.
+API resource_handle resource_acquire_async(resource_type type, const char* path);
+// Same for assets made in code. create only runs when nothing with the key
+// exists yet.
+API resource_handle resource_acquire_generated(resource_type type, const char* key, pfn_resource_create create,
+                                               void* params);
+// A mesh keyed by a hash of the vertex data, identical data shares one buffer.
+API resource_handle resource_acquire_mesh(const vertex* vertices, u32 vertex_count);
+// The checkerboard texture for models without one of their own.
+API resource_handle resource_acquire_checkerboard();
+
+// Adds a reference to a handle the caller holds, returns it for chaining.
+API resource_handle resource_retain(resource_handle handle);
+API void resource_release(resource_handle handle);
+
+API resource_state resource_get_state(resource_handle handle);
+// 0 for invalid handles and handles of another type.
+API texture* resource_get_texture(resource_handle handle);
+API mesh* resource_get_mesh(resource_handle handle);
+API model* resource_get_model(resource_handle handle);
+
+// Assets currently loaded, referenced or not.
+API u32 resource_manager_count();
@@ -1,6 +1,11 @@
 #include "texture.h"
 #include "core/logger.h"
 #include "core/kstring.h"
+#include "core/file_operations.h"
+#include "renderer/renderer_frontend.h"
+#include "renderer/renderer_stats.h"
+#include "resources/texture_container.h"
+#include "resources/texture_streaming.h"
 #include <GL/glew.h>
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -18,10 +23,35 @@ texture* texture_load(const char* file_path) {
     strncpy(t->path, file_path, sizeof(t->path) - 1);
     t->path[sizeof(t->path) - 1] = '\0'; // Ensure null termination
     
+    // Decoded straight from the mapped file or pack entry
+    file_view file;
+    if (!file_map_readonly(file_path, PLATFORM_MAP_HINT_SEQUENTIAL | PLATFORM_MAP_HINT_WILL_NEED, &file)) {
+        ERROR("Failed to load texture from '%s': can't open", file_path);
+        kfree(t, sizeof(texture), MEMORY_TAG_TEXTURE);
+        return NULL;
+    }
+
+    if (ktex_is_container(file.data, file.size)) {
+        // Already decoded and mipmapped by tools/texconv, the levels upload
+        // straight from the mapping
+        ktex_file container;
+        b8 loaded = ktex_parse(file.data, file.size, file_path, &container) && ktex_upload(&container, t);
+        u32 level_count = loaded ? container.header->level_count : 0;
+        file_unmap(&file);
+        if (!loaded) {
+            kfree(t, sizeof(texture), MEMORY_TAG_TEXTURE);
+            return NULL;
+        }
+        INFO("Texture loaded successfully: %ux%u, %u channels, %u levels, ID: %u", t->width, t->height,
+             t->channels, level_count, t->id);
+        return t;
+    }
+
     // Load image data with stb_image
     stbi_set_flip_vertically_on_load(1); // Flip Y axis to match OpenGL's coordinate system
     int width, height, channels;
-    unsigned char* data = stbi_load(file_path, &width, &height, &channels, 0);
+    unsigned char* data = stbi_load_from_memory((const stbi_uc*)file.data, (int)file.size, &width, &height, &channels, 0);
+    file_unmap(&file);
     
     if (!data) {
         ERROR("Failed to load texture from '%s': %s", file_path, stbi_failure_reason());
@@ -35,37 +65,13 @@ texture* texture_load(const char* file_path) {
     t->channels = channels;
     t->data = data;
     
-    // Create OpenGL texture
-    GLuint texture_id;
-    glGenTextures(1, &texture_id);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    
-    // Set texture parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    
-    // Upload texture data based on number of channels
-    GLenum format;
-    switch (channels) {
-        case 1: format = GL_RED; break;
-        case 2: format = GL_RG; break;
-        case 3: format = GL_RGB; break;
-        case 4: format = GL_RGBA; break;
-        default:
-            ERROR("Unsupported number of channels: %d", channels);
-            stbi_image_free(data);
-            kfree(t, sizeof(texture), MEMORY_TAG_TEXTURE);
-            return NULL;
+    // Upload to the GPU through the active renderer backend
+    if (!renderer_create_texture(t, data)) {
+        stbi_image_free(data);
+        kfree(t, sizeof(texture), MEMORY_TAG_TEXTURE);
+        return NULL;
     }
     
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    
-    // Store OpenGL texture ID
-    t->id = texture_id;
-    
     // Free image data as it's now uploaded to GPU
     stbi_image_free(data);
     t->data = NULL;
@@ -84,36 +90,12 @@ texture* texture_create(unsigned char* data, u32 width, u32 height, u32 channels
     t->data = NULL;
     t->path[0] = '\0'; // Empty path for generated textures
     
-    // Create OpenGL texture
-    GLuint texture_id;
-    glGenTextures(1, &texture_id);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-    
-    // Set texture parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    
-    // Upload texture data based on number of channels
-    GLenum format;
-    switch (channels) {
-        case 1: format = GL_RED; break;
-        case 2: format = GL_RG; break;
-        case 3: format = GL_RGB; break;
-        case 4: format = GL_RGBA; break;
-        default:
-            ERROR("Unsupported number of channels: %d", channels);
-            kfree(t, sizeof(texture), MEMORY_TAG_TEXTURE);
-            return NULL;
+    // Upload to the GPU through the active renderer backend
+    if (!renderer_create_texture(t, data)) {
+        kfree(t, sizeof(texture), MEMORY_TAG_TEXTURE);
+        return NULL;
     }
     
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    
-    // Store OpenGL texture ID
-    t->id = texture_id;
-    
     INFO("Texture created successfully: %dx%d, %d channels, ID: %u", width, height, channels, t->id);
     
     return t;
@@ -122,8 +104,13 @@ texture* texture_create(unsigned char* data, u32 width, u32 height, u32 channels
 void texture_destroy(texture* t) {
     if (!t) return;
     
-    // Delete OpenGL texture
-    glDeleteTextures(1, &t->id);
+    if (t->streaming) {
+        // Still showing the placeholder's id, which isn't ours to delete
+        texture_streaming_cancel(t);
+    } else {
+        // Release the GPU side
+        renderer_destroy_texture(t);
+    }
     
     // Free any remaining data
     if (t->data) {
@@ -140,10 +127,14 @@ void texture_bind(texture* t, u32 unit) {
     
     glActiveTexture(GL_TEXTURE0 + unit);
     glBindTexture(GL_TEXTURE_2D, t->id);
+    // Active texture unit plus the bind itself
+    renderer_stats_count_state_changes(1);
+    renderer_stats_count_texture_bind();
 }
 
 void texture_unbind_all() {
     glBindTexture(GL_TEXTURE_2D, 0);
+    renderer_stats_count_texture_bind();
 }
 
 // Create a default checkerboard texture
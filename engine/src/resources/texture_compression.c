@@ -0,0 +1,341 @@
+#include "texture_compression.h"
+
+#include "core/kmemory.h"
+
+// BC7 interpolation weights out of 64 for 2, 3 and 4 bit indices
+static const u8 bc7_weights2[4] = {0, 21, 43, 64};
+static const u8 bc7_weights3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+static const u8 bc7_weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+u32 texture_compression_block_bytes(texture_compression compression) {
+    switch (compression) {
+        case TEXTURE_COMPRESSION_BC1: return 8;
+        case TEXTURE_COMPRESSION_BC3:
+        case TEXTURE_COMPRESSION_BC7: return 16;
+        default: return 0;
+    }
+}
+
+u64 texture_compression_level_size(texture_compression compression, u32 width, u32 height) {
+    u64 blocks_x = (width + TEXTURE_BLOCK_SIZE - 1) / TEXTURE_BLOCK_SIZE;
+    u64 blocks_y = (height + TEXTURE_BLOCK_SIZE - 1) / TEXTURE_BLOCK_SIZE;
+    return blocks_x * blocks_y * texture_compression_block_bytes(compression);
+}
+
+static void rgb565_expand(u16 colour, u8* out) {
+    u8 r = (colour >> 11) & 0x1F;
+    u8 g = (colour >> 5) & 0x3F;
+    u8 b = colour & 0x1F;
+    out[0] = (u8)((r << 3) | (r >> 2));
+    out[1] = (u8)((g << 2) | (g >> 4));
+    out[2] = (u8)((b << 3) | (b >> 2));
+    out[3] = 255;
+}
+
+void bc1_decode_block(const u8* block, b8 four_colour_only, u8* out_pixels) {
+    u16 c0 = (u16)(block[0] | (block[1] << 8));
+    u16 c1 = (u16)(block[2] | (block[3] << 8));
+    u8 palette[4][4];
+    rgb565_expand(c0, palette[0]);
+    rgb565_expand(c1, palette[1]);
+    if (c0 > c1 || four_colour_only) {
+        for (u32 ch = 0; ch < 3; ++ch) {
+            palette[2][ch] = (u8)((2 * palette[0][ch] + palette[1][ch] + 1) / 3);
+            palette[3][ch] = (u8)((palette[0][ch] + 2 * palette[1][ch] + 1) / 3);
+        }
+        palette[2][3] = 255;
+        palette[3][3] = 255;
+    } else {
+        for (u32 ch = 0; ch < 3; ++ch) {
+            palette[2][ch] = (u8)((palette[0][ch] + palette[1][ch] + 1) / 2);
+            palette[3][ch] = 0;
+        }
+        palette[2][3] = 255;
+        palette[3][3] = 0;
+    }
+
+    u32 indices = (u32)block[4] | ((u32)block[5] << 8) | ((u32)block[6] << 16) | ((u32)block[7] << 24);
+    for (u32 i = 0; i < 16; ++i) {
+        kcopy_memory(out_pixels + i * 4, palette[(indices >> (i * 2)) & 3], 4);
+    }
+}
+
+void bc3_decode_block(const u8* block, u8* out_pixels) {
+    bc1_decode_block(block + 8, TRUE, out_pixels);
+
+    u8 a0 = block[0];
+    u8 a1 = block[1];
+    u8 palette[8] = {a0, a1};
+    if (a0 > a1) {
+        for (u32 i = 1; i < 7; ++i) {
+            palette[i + 1] = (u8)(((7 - i) * a0 + i * a1 + 3) / 7);
+        }
+    } else {
+        for (u32 i = 1; i < 5; ++i) {
+            palette[i + 1] = (u8)(((5 - i) * a0 + i * a1 + 2) / 5);
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    u64 indices = 0;
+    for (u32 i = 0; i < 6; ++i) {
+        indices |= (u64)block[2 + i] << (i * 8);
+    }
+    for (u32 i = 0; i < 16; ++i) {
+        out_pixels[i * 4 + 3] = palette[(indices >> (i * 3)) & 7];
+    }
+}
+
+// Reads BC7's fields, least significant bit first.
+typedef struct bit_reader {
+    const u8* data;
+    u32 position;
+} bit_reader;
+
+static u32 read_bits(bit_reader* reader, u32 count) {
+    u32 value = 0;
+    for (u32 i = 0; i < count; ++i, ++reader->position) {
+        value |= (u32)((reader->data[reader->position >> 3] >> (reader->position & 7)) & 1) << i;
+    }
+    return value;
+}
+
+static u8 bc7_expand(u32 value, u32 bits) {
+    value <<= 8 - bits;
+    return (u8)(value | (value >> bits));
+}
+
+static u8 bc7_interpolate(u8 e0, u8 e1, u32 weight) {
+    return (u8)(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+}
+
+static const u8* bc7_weight_table(u32 bits) {
+    return bits == 2 ? bc7_weights2 : (bits == 3 ? bc7_weights3 : bc7_weights4);
+}
+
+// Subset of each pixel in the 64 two-subset partitions, bit i set for pixel i
+// in the second subset
+static const u16 bc7_partitions2[64] = {
+    0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8,
+    0xFF00, 0xFFF0, 0xF000, 0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110,
+    0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C, 0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696,
+    0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660, 0x0272, 0x04E4, 0x4E40, 0x2720,
+    0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22};
+
+// Subset of each pixel in the 64 three-subset partitions
+static const u8 bc7_partitions3[64][16] = {
+    {0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2}, {0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1}, {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2}, {0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2},
+    {0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1}, {0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2}, {0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2},
+    {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2},
+    {0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2}, {0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2},
+    {0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2}, {0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0},
+    {0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2}, {0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0},
+    {0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2}, {0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1},
+    {0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2}, {0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2}, {0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0},
+    {0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0}, {0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2},
+    {0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0}, {0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1},
+    {0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2}, {0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2},
+    {0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1}, {0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2}, {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1},
+    {0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2}, {0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0},
+    {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0}, {0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0},
+    {0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0}, {0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1},
+    {0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1}, {0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1}, {0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2},
+    {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1}, {0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1},
+    {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1}, {0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1},
+    {0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2}, {0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1},
+    {0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2}, {0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2},
+    {0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2}, {0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2}, {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2},
+    {0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2},
+    {0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1}, {0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2},
+    {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0}};
+
+// Pixel holding the anchor index of the second subset in two-subset
+// partitions, and of the second and third in three-subset ones. The first
+// subset's anchor is always pixel 0.
+static const u8 bc7_anchors2[64] = {15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+                                    15, 2,  8,  2,  2,  8,  8,  15, 2,  8,  2,  2,  8,  8,  2,  2,
+                                    15, 15, 6,  8,  2,  8,  15, 15, 2,  8,  2,  2,  2,  15, 15, 6,
+                                    6,  2,  6,  8,  15, 15, 2,  2,  15, 15, 15, 15, 15, 2,  2,  15};
+static const u8 bc7_anchors3_second[64] = {3,  3,  15, 15, 8,  3,  15, 15, 8,  8,  6,  6,  6,  5,  3,  3,
+                                           3,  3,  8,  15, 3,  3,  6,  10, 5,  8,  8,  6,  8,  5,  15, 15,
+                                           8,  15, 3,  5,  6,  10, 8,  15, 15, 3,  15, 5,  15, 15, 15, 15,
+                                           3,  15, 5,  5,  5,  8,  5,  10, 5,  10, 8,  13, 15, 12, 3,  3};
+static const u8 bc7_anchors3_third[64] = {15, 8,  8,  3,  15, 15, 3,  8,  15, 15, 15, 15, 15, 15, 15, 8,
+                                          15, 8,  15, 3,  15, 8,  15, 8,  3,  15, 6,  10, 15, 15, 10, 8,
+                                          15, 3,  15, 10, 10, 8,  9,  10, 6,  15, 8,  15, 3,  6,  6,  8,
+                                          15, 3,  15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3,  15, 15, 8};
+
+// Field sizes of each BC7 mode, in bits
+typedef struct bc7_mode {
+    u8 subsets;
+    u8 partition_bits;
+    u8 rotation_bits;
+    u8 index_selection_bits;
+    u8 colour_bits;
+    // 0 when the mode has no alpha, which then decodes as opaque
+    u8 alpha_bits;
+    // A p-bit per endpoint, or one shared by both endpoints of a subset
+    u8 endpoint_pbits;
+    u8 shared_pbits;
+    u8 index_bits;
+    // Second index set for alpha, or for colour when the selection bit is set
+    u8 second_index_bits;
+} bc7_mode;
+
+static const bc7_mode bc7_modes[8] = {
+    {3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+    {2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+    {3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+    {2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+    {1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+    {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+    {1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+    {2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+};
+
+// Reads 16 indices of the given size, anchors with their top bit implied 0.
+static void bc7_read_indices(bit_reader* reader, u32 bits, u16 anchors, u8* out_indices) {
+    for (u32 i = 0; i < 16; ++i) {
+        out_indices[i] = (u8)read_bits(reader, ((anchors >> i) & 1) ? bits - 1 : bits);
+    }
+}
+
+void bc7_decode_block(const u8* block, u8* out_pixels) {
+    u32 mode_index = 0;
+    while (mode_index < 8 && !((block[0] >> mode_index) & 1)) {
+        mode_index++;
+    }
+    if (mode_index == 8) {
+        // Reserved, decodes as transparent black like it does on the GPU
+        kzero_memory(out_pixels, 16 * 4);
+        return;
+    }
+    const bc7_mode* mode = &bc7_modes[mode_index];
+
+    bit_reader reader = {block, mode_index + 1};
+    u32 partition = read_bits(&reader, mode->partition_bits);
+    u32 rotation = read_bits(&reader, mode->rotation_bits);
+    u32 index_selection = read_bits(&reader, mode->index_selection_bits);
+
+    // Endpoints come channel by channel, each with both endpoints of every
+    // subset in turn, followed by the p-bits
+    u32 raw[3][2][4] = {0};
+    for (u32 ch = 0; ch < 4; ++ch) {
+        u32 width = ch == 3 ? mode->alpha_bits : mode->colour_bits;
+        for (u32 s = 0; width && s < mode->subsets; ++s) {
+            raw[s][0][ch] = read_bits(&reader, width);
+            raw[s][1][ch] = read_bits(&reader, width);
+        }
+    }
+    u32 pbits[3][2] = {0};
+    for (u32 s = 0; s < mode->subsets; ++s) {
+        if (mode->endpoint_pbits) {
+            pbits[s][0] = read_bits(&reader, 1);
+            pbits[s][1] = read_bits(&reader, 1);
+        }
+    }
+    for (u32 s = 0; s < mode->subsets; ++s) {
+        if (mode->shared_pbits) {
+            pbits[s][0] = pbits[s][1] = read_bits(&reader, 1);
+        }
+    }
+    u32 has_pbits = mode->endpoint_pbits || mode->shared_pbits;
+    u8 endpoints[3][2][4];
+    for (u32 s = 0; s < mode->subsets; ++s) {
+        for (u32 e = 0; e < 2; ++e) {
+            for (u32 ch = 0; ch < 4; ++ch) {
+                u32 width = ch == 3 ? mode->alpha_bits : mode->colour_bits;
+                if (!width) {
+                    endpoints[s][e][ch] = 255;
+                } else if (has_pbits) {
+                    endpoints[s][e][ch] = bc7_expand((raw[s][e][ch] << 1) | pbits[s][e], width + 1);
+                } else {
+                    endpoints[s][e][ch] = bc7_expand(raw[s][e][ch], width);
+                }
+            }
+        }
+    }
+
+    u8 subset_of[16] = {0};
+    u16 anchors = 1;
+    if (mode->subsets == 2) {
+        for (u32 i = 0; i < 16; ++i) {
+            subset_of[i] = (bc7_partitions2[partition] >> i) & 1;
+        }
+        anchors |= 1 << bc7_anchors2[partition];
+    } else if (mode->subsets == 3) {
+        kcopy_memory(subset_of, bc7_partitions3[partition], sizeof(subset_of));
+        anchors |= 1 << bc7_anchors3_second[partition];
+        anchors |= 1 << bc7_anchors3_third[partition];
+    }
+
+    u8 colour_indices[16];
+    u8 alpha_indices[16];
+    u32 colour_bits = mode->index_bits;
+    u32 alpha_bits = mode->index_bits;
+    bc7_read_indices(&reader, mode->index_bits, anchors, colour_indices);
+    if (mode->second_index_bits) {
+        bc7_read_indices(&reader, mode->second_index_bits, anchors, alpha_indices);
+        alpha_bits = mode->second_index_bits;
+        if (index_selection) {
+            u8 swap[16];
+            kcopy_memory(swap, colour_indices, sizeof(swap));
+            kcopy_memory(colour_indices, alpha_indices, sizeof(swap));
+            kcopy_memory(alpha_indices, swap, sizeof(swap));
+            colour_bits = mode->second_index_bits;
+            alpha_bits = mode->index_bits;
+        }
+    } else {
+        kcopy_memory(alpha_indices, colour_indices, sizeof(alpha_indices));
+    }
+
+    const u8* colour_weights = bc7_weight_table(colour_bits);
+    const u8* alpha_weights = bc7_weight_table(alpha_bits);
+    for (u32 i = 0; i < 16; ++i) {
+        u8* pixel = out_pixels + i * 4;
+        u8(*e)[4] = endpoints[subset_of[i]];
+        for (u32 ch = 0; ch < 3; ++ch) {
+            pixel[ch] = bc7_interpolate(e[0][ch], e[1][ch], colour_weights[colour_indices[i]]);
+        }
+        pixel[3] = bc7_interpolate(e[0][3], e[1][3], alpha_weights[alpha_indices[i]]);
+        // Rotation swaps alpha with a colour channel afterwards
+        if (rotation) {
+            u8 swap = pixel[3];
+            pixel[3] = pixel[rotation - 1];
+            pixel[rotation - 1] = swap;
+        }
+    }
+}
+
+b8 texture_decompress(texture_compression compression, const u8* blocks, u32 width, u32 height, u8* out_pixels) {
+    u32 block_bytes = texture_compression_block_bytes(compression);
+    if (!block_bytes) {
+        return FALSE;
+    }
+    u8 decoded[16 * 4];
+    for (u32 by = 0; by < height; by += TEXTURE_BLOCK_SIZE) {
+        for (u32 bx = 0; bx < width; bx += TEXTURE_BLOCK_SIZE, blocks += block_bytes) {
+            switch (compression) {
+                case TEXTURE_COMPRESSION_BC1: bc1_decode_block(blocks, FALSE, decoded); break;
+                case TEXTURE_COMPRESSION_BC3: bc3_decode_block(blocks, decoded); break;
+                default: bc7_decode_block(blocks, decoded); break;
+            }
+            // Padding pixels past the edges are dropped
+            for (u32 y = 0; y < TEXTURE_BLOCK_SIZE && by + y < height; ++y) {
+                u32 columns = width - bx < TEXTURE_BLOCK_SIZE ? width - bx : TEXTURE_BLOCK_SIZE;
+                kcopy_memory(out_pixels + ((u64)(by + y) * width + bx) * 4, decoded + y * TEXTURE_BLOCK_SIZE * 4,
+                             columns * 4);
+            }
+        }
+    }
+    return TRUE;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "definitions.h"
+#include "renderer/renderer_types.inl"
+
+// Block-compressed texture formats on the CPU side. tools/texconv encodes
+// them offline, the GPU samples them directly, and this decodes them back to
+// RGBA8 for GPUs without the format. Blocks cover 4x4 pixels row by row,
+// partial blocks at the right and top edges are padded.
+//
+// The BC7 decoder covers all eight modes, also the partitioned ones texconv
+// doesn't write, so textures from other encoders decode as well.
+
+#define TEXTURE_BLOCK_SIZE 4
+
+// Bytes per block, 0 for TEXTURE_COMPRESSION_NONE.
+API u32 texture_compression_block_bytes(texture_compression compression);
+// Size of a width x height level in blocks.
+API u64 texture_compression_level_size(texture_compression compression, u32 width, u32 height);
+
+// Decodes a level into width * height RGBA8 pixels. FALSE for
+// TEXTURE_COMPRESSION_NONE.
+API b8 texture_decompress(texture_compression compression, const u8* blocks, u32 width, u32 height, u8* out_pixels);
+
+// Single blocks into 16 RGBA8 pixels, row by row. A BC1 block decodes in its
+// 3-colour mode with transparent black when the first endpoint isn't the
+// larger one, except as the colour half of BC3 where it is always 4-colour.
+// BC7 blocks in the reserved mode decode as transparent black.
+API void bc1_decode_block(const u8* block, b8 four_colour_only, u8* out_pixels);
+API void bc3_decode_block(const u8* block, u8* out_pixels);
+API void bc7_decode_block(const u8* block, u8* out_pixels);
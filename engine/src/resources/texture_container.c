@@ -0,0 +1,137 @@
+#include "texture_container.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "renderer/renderer_frontend.h"
+#include "resources/texture_compression.h"
+
+b8 ktex_is_container(const void* data, u64 size) {
+    return data && size >= sizeof(ktex_header) && ((const ktex_header*)data)->magic == KTEX_MAGIC;
+}
+
+u32 ktex_format_bytes_per_pixel(ktex_format format) {
+    switch (format) {
+        case KTEX_FORMAT_R8: return 1;
+        case KTEX_FORMAT_RG8: return 2;
+        case KTEX_FORMAT_RGB8: return 3;
+        case KTEX_FORMAT_RGBA8: return 4;
+        default: return 0;
+    }
+}
+
+texture_compression ktex_format_compression(ktex_format format) {
+    switch (format) {
+        case KTEX_FORMAT_BC1: return TEXTURE_COMPRESSION_BC1;
+        case KTEX_FORMAT_BC3: return TEXTURE_COMPRESSION_BC3;
+        case KTEX_FORMAT_BC7: return TEXTURE_COMPRESSION_BC7;
+        default: return TEXTURE_COMPRESSION_NONE;
+    }
+}
+
+u64 ktex_level_size(ktex_format format, u32 width, u32 height) {
+    texture_compression compression = ktex_format_compression(format);
+    if (compression != TEXTURE_COMPRESSION_NONE) {
+        return texture_compression_level_size(compression, width, height);
+    }
+    return (u64)width * height * ktex_format_bytes_per_pixel(format);
+}
+
+b8 ktex_parse(const void* data, u64 size, const char* name, ktex_file* out_file) {
+    if (!ktex_is_container(data, size)) {
+        ERROR("'%s' is not a texture container", name);
+        return FALSE;
+    }
+    const ktex_header* header = data;
+    if (header->version != KTEX_VERSION) {
+        ERROR("Texture container '%s' is version %u, expected %u", name, header->version, KTEX_VERSION);
+        return FALSE;
+    }
+    if (ktex_level_size(header->format, 1, 1) == 0) {
+        ERROR("Texture container '%s' has unknown format %u", name, header->format);
+        return FALSE;
+    }
+    if (header->file_size != size || header->width == 0 || header->height == 0 || header->level_count == 0 ||
+        header->level_count > KTEX_MAX_LEVELS ||
+        sizeof(ktex_header) + (u64)header->level_count * sizeof(ktex_level) > size) {
+        ERROR("Texture container '%s' is truncated or corrupt", name);
+        return FALSE;
+    }
+
+    const ktex_level* levels = (const ktex_level*)((const u8*)data + sizeof(ktex_header));
+    for (u32 i = 0; i < header->level_count; ++i) {
+        const ktex_level* level = &levels[i];
+        // Each level halves the previous one, rounding down but not below 1
+        u32 width = header->width >> i ? header->width >> i : 1;
+        u32 height = header->height >> i ? header->height >> i : 1;
+        if (level->width != width || level->height != height ||
+            level->size != ktex_level_size(header->format, width, height) || level->offset > size ||
+            level->size > size - level->offset) {
+            ERROR("Texture container '%s' has level %u out of bounds", name, i);
+            return FALSE;
+        }
+    }
+
+    out_file->header = header;
+    out_file->levels = levels;
+    out_file->data = data;
+    return TRUE;
+}
+
+void ktex_get_levels(const ktex_file* file, texture* t, texture_level* out_levels, u8** out_decoded,
+                     u64* out_decoded_size) {
+    const ktex_header* header = file->header;
+    for (u32 i = 0; i < header->level_count; ++i) {
+        out_levels[i].pixels = file->data + file->levels[i].offset;
+        out_levels[i].size = file->levels[i].size;
+        out_levels[i].width = file->levels[i].width;
+        out_levels[i].height = file->levels[i].height;
+    }
+    *out_decoded = 0;
+    *out_decoded_size = 0;
+    t->width = header->width;
+    t->height = header->height;
+    t->compression = ktex_format_compression(header->format);
+    if (t->compression == TEXTURE_COMPRESSION_NONE) {
+        t->channels = ktex_format_bytes_per_pixel(header->format);
+        return;
+    }
+    t->channels = t->compression == TEXTURE_COMPRESSION_BC1 && !(header->flags & KTEX_FLAG_ALPHA) ? 3 : 4;
+    if (renderer_supports_texture_compression(t->compression)) {
+        return;
+    }
+
+    // The GPU can't sample the format, decode the whole chain into one buffer
+    static const char* names[] = {"none", "BC1", "BC3", "BC7"};
+    static u32 warned = 0;
+    if (!(__atomic_fetch_or(&warned, 1u << t->compression, __ATOMIC_RELAXED) & (1u << t->compression))) {
+        WARN("GPU lacks %s textures, decompressing them on the CPU", names[t->compression]);
+    }
+    u64 decoded_size = 0;
+    for (u32 i = 0; i < header->level_count; ++i) {
+        decoded_size += (u64)out_levels[i].width * out_levels[i].height * 4;
+    }
+    u8* decoded = kallocate(decoded_size, MEMORY_TAG_TEXTURE);
+    u64 offset = 0;
+    for (u32 i = 0; i < header->level_count; ++i) {
+        texture_decompress(t->compression, out_levels[i].pixels, out_levels[i].width, out_levels[i].height,
+                           decoded + offset);
+        out_levels[i].pixels = decoded + offset;
+        out_levels[i].size = (u64)out_levels[i].width * out_levels[i].height * 4;
+        offset += out_levels[i].size;
+    }
+    t->compression = TEXTURE_COMPRESSION_NONE;
+    t->channels = 4;
+    *out_decoded = decoded;
+    *out_decoded_size = decoded_size;
+}
+
+b8 ktex_upload(const ktex_file* file, texture* t) {
+    texture_level levels[KTEX_MAX_LEVELS];
+    u8* decoded;
+    u64 decoded_size;
+    ktex_get_levels(file, t, levels, &decoded, &decoded_size);
+    b8 result = renderer_create_texture_levels(t, levels, file->header->level_count);
+    if (decoded) {
+        kfree(decoded, decoded_size, MEMORY_TAG_TEXTURE);
+    }
+    return result;
+}
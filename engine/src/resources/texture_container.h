@@ -0,0 +1,89 @@
+#pragma once
+
+#include "definitions.h"
+#include "renderer/renderer_types.inl"
+
+// Pre-decoded textures with their whole mip chain, built offline by
+// tools/texconv. Loading one is a mapping plus one upload per level: no image
+// decode and no mip generation at runtime. texture_load recognizes the
+// container by its magic, whatever the file is called.
+//
+// File layout: ktex_header, level_count ktex_level records from the largest
+// level down to 1x1, then the level data, each level starting at a multiple
+// of KTEX_ALIGNMENT. Rows are tightly packed and stored bottom-up, the order
+// texture_load gives OpenGL. Block compressed levels hold rows of 4x4 blocks
+// in the same order, see resources/texture_compression.h.
+
+#define KTEX_MAGIC 0x5845544Bu // "KTEX"
+#define KTEX_VERSION 1
+#define KTEX_ALIGNMENT 16
+// Enough for a 65536x65536 texture
+#define KTEX_MAX_LEVELS 17
+
+typedef enum ktex_format {
+    KTEX_FORMAT_R8 = 1,
+    KTEX_FORMAT_RG8 = 2,
+    KTEX_FORMAT_RGB8 = 3,
+    KTEX_FORMAT_RGBA8 = 4,
+    KTEX_FORMAT_BC1 = 16,
+    KTEX_FORMAT_BC3 = 17,
+    KTEX_FORMAT_BC7 = 18
+} ktex_format;
+
+typedef enum ktex_flags {
+    // Colour channels are sRGB encoded and the mips were filtered in linear
+    // light
+    KTEX_FLAG_SRGB = 0x1,
+    // The source image had alpha. Picks BC1's variant with 1-bit alpha over
+    // the opaque one.
+    KTEX_FLAG_ALPHA = 0x2
+} ktex_flags;
+
+typedef struct ktex_header {
+    u32 magic;
+    u32 version;
+    u32 format;
+    u32 flags;
+    u32 width;
+    u32 height;
+    u32 level_count;
+    u32 reserved;
+    u64 file_size;
+} ktex_header;
+
+typedef struct ktex_level {
+    u64 offset;
+    u64 size;
+    u32 width;
+    u32 height;
+} ktex_level;
+
+// A validated container in memory, levels and data point into it.
+typedef struct ktex_file {
+    const ktex_header* header;
+    const ktex_level* levels;
+    const u8* data;
+} ktex_file;
+
+// TRUE when data starts with the container magic.
+API b8 ktex_is_container(const void* data, u64 size);
+// Checks the header and that every level lies inside the size bytes, logging
+// what is wrong with the file called name otherwise.
+API b8 ktex_parse(const void* data, u64 size, const char* name, ktex_file* out_file);
+
+// Describes the levels into out_levels and sets t's size, channels and
+// compression. Block formats the GPU lacks are decompressed to RGBA8 into a
+// buffer the caller frees with kfree(*out_decoded, *out_decoded_size,
+// MEMORY_TAG_TEXTURE), *out_decoded is 0 otherwise. Safe on any thread.
+API void ktex_get_levels(const ktex_file* file, texture* t, texture_level* out_levels, u8** out_decoded,
+                         u64* out_decoded_size);
+// Uploads every level into t, setting its id, size, channels and compression.
+// Block formats the GPU lacks are decompressed to RGBA8 first. Main thread.
+API b8 ktex_upload(const ktex_file* file, texture* t);
+
+// Bytes per pixel of an uncompressed format, 0 for block formats and unknown
+// ones.
+API u32 ktex_format_bytes_per_pixel(ktex_format format);
+API texture_compression ktex_format_compression(ktex_format format);
+// Size of one level of a format, rows tightly packed. 0 for unknown formats.
+API u64 ktex_level_size(ktex_format format, u32 width, u32 height);
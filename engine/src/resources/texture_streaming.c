@@ -0,0 +1,393 @@
+#include "texture_streaming.h"
+
+#include "containers/darray.h"
+#include "core/file_operations.h"
+#include "core/job_system.h"
+#include "core/kmemory.h"
+#include "core/logger.h"
+#include "core/profiler.h"
+#include "core/vfs.h"
+#include "platform/async_io.h"
+#include "platform/platform.h"
+#include "renderer/renderer_frontend.h"
+#include "resources/resource_manager.h"
+#include "resources/texture.h"
+#include "resources/texture_compression.h"
+#include "resources/texture_container.h"
+
+#include <string.h>
+
+#include "../vendor/stb_image.h"
+
+typedef enum texture_stream_state {
+    // Waiting for room in the job queue
+    TEXTURE_STREAM_QUEUED,
+    // Files on disk are read by async I/O before the decode job starts
+    TEXTURE_STREAM_READING,
+    TEXTURE_STREAM_DECODING,
+    TEXTURE_STREAM_DECODED,
+    // Every upload is queued, waiting for the renderer to have done them
+    TEXTURE_STREAM_UPLOADED,
+    TEXTURE_STREAM_FAILED
+} texture_stream_state;
+
+typedef struct texture_stream {
+    // texture_stream_state, the decoding worker stores the outcome with release
+    // semantics after writing pixels and the size
+    u32 state;
+    // 0 once the texture was destroyed
+    texture* target;
+    char path[256];
+    // Decoded by stb_image
+    u8* pixels;
+    // stb_image keeps it per thread, so the worker copies it here
+    const char* failure;
+    // The file's bytes once read. Texture containers skip the image decode
+    // and keep it for the upload, unless their block format had to be
+    // decompressed into decoded.
+    b8 is_container;
+    file_view file;
+    async_io_id read;
+    ktex_file container;
+    u8* decoded;
+    u64 decoded_size;
+
+    // What the worker left for the upload: a single level for images, which
+    // get their mips generated, every level for containers
+    texture_level levels[KTEX_MAX_LEVELS];
+    u32 level_count;
+
+    // The real texture being filled in, swapped into target when complete.
+    // The worker sets its size, channels and compression.
+    texture staging;
+    b8 has_storage;
+    u32 level;
+    u32 rows_uploaded;
+    // Passed once the renderer has done the queued uploads, see
+    // renderer_texture_upload_done
+    u64 upload_fence;
+    u64 uploaded_bytes;
+} texture_stream;
+
+typedef struct texture_streaming_state {
+    u64 upload_budget;
+    // darray of texture_stream*, oldest first
+    texture_stream** streams;
+    resource_handle placeholder;
+    u64 streamed_bytes;
+    u32 streamed_count;
+} texture_streaming_state;
+
+static texture_streaming_state state;
+static b8 initialized = FALSE;
+
+// Runs on a job system worker.
+static void texture_stream_decode(void* context) {
+    texture_stream* stream = context;
+    // Already read by async I/O, or mapped here for pack and memory files
+    file_view file = stream->file;
+    stream->file = (file_view){0};
+    if (file.source == FILE_VIEW_NONE &&
+        !file_map_readonly(stream->path, PLATFORM_MAP_HINT_SEQUENTIAL | PLATFORM_MAP_HINT_WILL_NEED, &file)) {
+        stream->failure = "can't open file";
+    } else if (ktex_is_container(file.data, file.size)) {
+        // The main thread uploads the levels from the mapping, or from the
+        // CPU decode of a block format the GPU lacks, which happens here
+        if (ktex_parse(file.data, file.size, stream->path, &stream->container)) {
+            stream->file = file;
+            stream->is_container = TRUE;
+            ktex_get_levels(&stream->container, &stream->staging, stream->levels, &stream->decoded,
+                            &stream->decoded_size);
+            stream->level_count = stream->container.header->level_count;
+        } else {
+            stream->failure = "corrupt texture container";
+            file_unmap(&file);
+        }
+    } else {
+        // The flag is per thread here, texture_load sets the global one
+        stbi_set_flip_vertically_on_load_thread(1);
+        i32 width;
+        i32 height;
+        i32 channels;
+        stream->pixels =
+            stbi_load_from_memory((const stbi_uc*)file.data, (int)file.size, &width, &height, &channels, 0);
+        if (stream->pixels) {
+            stream->staging.width = (u32)width;
+            stream->staging.height = (u32)height;
+            stream->staging.channels = (u32)channels;
+            stream->levels[0] = (texture_level){stream->pixels, (u64)width * height * channels, (u32)width, (u32)height};
+            stream->level_count = 1;
+        } else {
+            stream->failure = stbi_failure_reason();
+        }
+        file_unmap(&file);
+    }
+    b8 decoded = stream->pixels || stream->is_container;
+    __atomic_store_n(&stream->state, decoded ? TEXTURE_STREAM_DECODED : TEXTURE_STREAM_FAILED, __ATOMIC_RELEASE);
+}
+
+static void texture_stream_read_complete(const async_io_result* result, void* user_data) {
+    texture_stream* stream = user_data;
+    stream->read = INVALID_ASYNC_IO_ID;
+    if (!result->success) {
+        stream->failure = "can't read file";
+        __atomic_store_n(&stream->state, TEXTURE_STREAM_FAILED, __ATOMIC_RELEASE);
+        return;
+    }
+    // Allocated with platform_allocate, which file_unmap frees for copies
+    stream->file.data = result->buffer;
+    stream->file.size = result->size;
+    stream->file.source = FILE_VIEW_COPY;
+    // The next update hands it to the decode job, or drops it if the
+    // texture was destroyed meanwhile
+    __atomic_store_n(&stream->state, TEXTURE_STREAM_QUEUED, __ATOMIC_RELEASE);
+}
+
+// Files in directory mounts are read with async I/O first, so the decode job
+// doesn't block a worker on the disk. Pack and memory files are in memory
+// already and go straight to the job.
+static b8 texture_stream_read(texture_stream* stream) {
+    vfs_file file;
+    if (async_io_get_backend() == ASYNC_IO_BACKEND_NONE || !vfs_stat(stream->path, &file) ||
+        file.type != VFS_MOUNT_DIRECTORY) {
+        return FALSE;
+    }
+    __atomic_store_n(&stream->state, TEXTURE_STREAM_READING, __ATOMIC_RELEASE);
+    stream->read = async_io_read(stream->path, 0, 0, 0, texture_stream_read_complete, stream);
+    if (stream->read == INVALID_ASYNC_IO_ID) {
+        // Queue full, the job maps it instead
+        __atomic_store_n(&stream->state, TEXTURE_STREAM_QUEUED, __ATOMIC_RELEASE);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void texture_stream_submit(texture_stream* stream) {
+    // Set first, without workers the job runs before submit returns
+    __atomic_store_n(&stream->state, TEXTURE_STREAM_DECODING, __ATOMIC_RELEASE);
+    if (!job_system_submit(texture_stream_decode, stream)) {
+        __atomic_store_n(&stream->state, TEXTURE_STREAM_QUEUED, __ATOMIC_RELEASE);
+    }
+}
+
+static void texture_stream_free(texture_stream* stream) {
+    if (stream->has_storage) {
+        renderer_destroy_texture(&stream->staging);
+    }
+    if (stream->pixels) {
+        stbi_image_free(stream->pixels);
+    }
+    if (stream->decoded) {
+        kfree(stream->decoded, stream->decoded_size, MEMORY_TAG_TEXTURE);
+    }
+    file_unmap(&stream->file);
+    kfree(stream, sizeof(texture_stream), MEMORY_TAG_TEXTURE);
+}
+
+static void texture_stream_remove(u64 index) {
+    texture_stream* stream;
+    darray_pop_at(state.streams, index, &stream);
+    texture_stream_free(stream);
+}
+
+// Uploads as many rows as the budget allows, level after level. Returns TRUE
+// once every level is in.
+static b8 texture_stream_upload(texture_stream* stream, u64* budget_left) {
+    if (!stream->has_storage) {
+        strncpy(stream->staging.path, stream->path, sizeof(stream->staging.path) - 1);
+        // Failures show as a 0 id once the uploads are done
+        renderer_create_texture_storage(&stream->staging, stream->is_container ? stream->level_count : 0);
+        stream->has_storage = TRUE;
+    }
+
+    // Block formats go up in whole rows of blocks
+    u32 row_step = stream->staging.compression != TEXTURE_COMPRESSION_NONE ? TEXTURE_BLOCK_SIZE : 1;
+    while (stream->level < stream->level_count) {
+        const texture_level* level = &stream->levels[stream->level];
+        u32 step_count = (level->height + row_step - 1) / row_step;
+        u64 step_bytes = level->size / step_count;
+        u64 steps = *budget_left / step_bytes;
+        if (steps == 0) {
+            if (*budget_left < state.upload_budget) {
+                // Continue next frame
+                return FALSE;
+            }
+            // A single row is over the whole budget, send it anyway to make progress
+            steps = 1;
+        }
+        u32 steps_done = stream->rows_uploaded / row_step;
+        u32 remaining = step_count - steps_done;
+        u32 count = steps < remaining ? (u32)steps : remaining;
+        u32 row_count = count * row_step;
+        if (row_count > level->height - stream->rows_uploaded) {
+            row_count = level->height - stream->rows_uploaded;
+        }
+        renderer_upload_texture_rows(&stream->staging, stream->level, level->pixels + step_bytes * steps_done,
+                                     stream->rows_uploaded, row_count);
+        stream->rows_uploaded += row_count;
+        u64 sent = step_bytes * count;
+        stream->uploaded_bytes += sent;
+        *budget_left = sent < *budget_left ? *budget_left - sent : 0;
+        if (stream->rows_uploaded < level->height) {
+            return FALSE;
+        }
+        stream->level++;
+        stream->rows_uploaded = 0;
+    }
+    return TRUE;
+}
+
+b8 texture_streaming_initialize(u64 upload_budget) {
+    if (initialized) {
+        return TRUE;
+    }
+    kzero_memory(&state, sizeof(state));
+    state.upload_budget = upload_budget ? upload_budget : TEXTURE_STREAMING_DEFAULT_BUDGET;
+    state.streams = darray_create(texture_stream*);
+    // Streaming textures draw as the same checkerboard untextured models use
+    state.placeholder = resource_acquire_checkerboard();
+    initialized = TRUE;
+    return TRUE;
+}
+
+void texture_streaming_shutdown() {
+    if (!initialized) {
+        return;
+    }
+    // Workers and pending reads still hold pointers to these
+    for (u64 i = 0; i < darray_length(state.streams); ++i) {
+        if (state.streams[i]->read != INVALID_ASYNC_IO_ID) {
+            async_io_wait(state.streams[i]->read);
+        }
+        while (__atomic_load_n(&state.streams[i]->state, __ATOMIC_ACQUIRE) == TEXTURE_STREAM_DECODING) {
+            platform_sleep(1);
+        }
+    }
+    while (darray_length(state.streams) > 0) {
+        texture_stream_remove(darray_length(state.streams) - 1);
+    }
+    darray_destroy(state.streams);
+    INFO("Texture streaming: %u textures, %.2f MiB uploaded", state.streamed_count,
+         (f64)state.streamed_bytes / (1024.0 * 1024.0));
+    resource_release(state.placeholder);
+    initialized = FALSE;
+}
+
+void texture_streaming_set_budget(u64 upload_budget) {
+    state.upload_budget = upload_budget ? upload_budget : TEXTURE_STREAMING_DEFAULT_BUDGET;
+}
+
+void texture_streaming_update() {
+    if (!initialized || darray_length(state.streams) == 0) {
+        return;
+    }
+    PROFILE_FUNCTION();
+    u64 budget_left = state.upload_budget;
+    u64 i = 0;
+    while (i < darray_length(state.streams)) {
+        texture_stream* stream = state.streams[i];
+        texture_stream_state stream_state = __atomic_load_n(&stream->state, __ATOMIC_ACQUIRE);
+        if (stream_state == TEXTURE_STREAM_QUEUED && stream->target) {
+            texture_stream_submit(stream);
+            stream_state = __atomic_load_n(&stream->state, __ATOMIC_ACQUIRE);
+        }
+        if ((stream_state == TEXTURE_STREAM_QUEUED && stream->target) || stream_state == TEXTURE_STREAM_READING ||
+            stream_state == TEXTURE_STREAM_DECODING) {
+            i++;
+            continue;
+        }
+        if (!stream->target) {
+            // Destroyed while decoding
+            texture_stream_remove(i);
+            continue;
+        }
+        if (stream_state == TEXTURE_STREAM_FAILED) {
+            WARN("Failed to stream texture '%s': %s", stream->path, stream->failure);
+            // Stays on the placeholder, which texture_destroy must not delete
+            texture_stream_remove(i);
+            continue;
+        }
+        if (stream_state == TEXTURE_STREAM_DECODED) {
+            if (budget_left == 0 || !texture_stream_upload(stream, &budget_left)) {
+                // Out of budget for this frame
+                i++;
+                continue;
+            }
+            // Containers bring their own mips
+            stream->upload_fence = renderer_finish_texture_upload(&stream->staging, !stream->is_container);
+            __atomic_store_n(&stream->state, TEXTURE_STREAM_UPLOADED, __ATOMIC_RELEASE);
+        }
+
+        // The placeholder stays until the renderer has done every upload
+        if (!renderer_texture_upload_done(stream->upload_fence)) {
+            i++;
+            continue;
+        }
+        if (!stream->staging.id) {
+            WARN("Could not create storage for streamed texture '%s'", stream->path);
+            texture_stream_remove(i);
+            continue;
+        }
+        texture* target = stream->target;
+        target->id = stream->staging.id;
+        target->width = stream->staging.width;
+        target->height = stream->staging.height;
+        target->channels = stream->staging.channels;
+        target->compression = stream->staging.compression;
+        target->streaming = FALSE;
+        stream->has_storage = FALSE;
+        state.streamed_bytes += stream->uploaded_bytes;
+        state.streamed_count++;
+        DEBUG("Streamed in texture '%s': %ux%u, %u channels", target->path, target->width, target->height,
+              target->channels);
+        texture_stream_remove(i);
+    }
+}
+
+u32 texture_streaming_pending() {
+    return initialized ? (u32)darray_length(state.streams) : 0;
+}
+
+texture* texture_load_async(const char* file_path) {
+    if (!initialized) {
+        return texture_load(file_path);
+    }
+    PROFILE_FUNCTION();
+    texture* t = kallocate(sizeof(texture), MEMORY_TAG_TEXTURE);
+    strncpy(t->path, file_path, sizeof(t->path) - 1);
+    texture* placeholder = resource_get_texture(state.placeholder);
+    if (placeholder) {
+        t->id = placeholder->id;
+        t->width = placeholder->width;
+        t->height = placeholder->height;
+        t->channels = placeholder->channels;
+    }
+    t->streaming = TRUE;
+
+    texture_stream* stream = kallocate(sizeof(texture_stream), MEMORY_TAG_TEXTURE);
+    stream->target = t;
+    strncpy(stream->path, file_path, sizeof(stream->path) - 1);
+    darray_push(state.streams, stream);
+    if (!texture_stream_read(stream)) {
+        texture_stream_submit(stream);
+    }
+    return t;
+}
+
+void texture_streaming_cancel(texture* t) {
+    if (!initialized) {
+        return;
+    }
+    for (u64 i = 0; i < darray_length(state.streams); ++i) {
+        texture_stream* stream = state.streams[i];
+        if (stream->target != t) {
+            continue;
+        }
+        stream->target = 0;
+        texture_stream_state stream_state = __atomic_load_n(&stream->state, __ATOMIC_ACQUIRE);
+        if (stream_state != TEXTURE_STREAM_READING && stream_state != TEXTURE_STREAM_DECODING) {
+            texture_stream_remove(i);
+        }
+        return;
+    }
+}
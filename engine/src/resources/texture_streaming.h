@@ -0,0 +1,42 @@
+#pragma once
+
+#include "definitions.h"
+#include "renderer/renderer_types.inl"
+
+// Texture loads that don't stall the frame. texture_load_async returns at
+// once with a texture that draws as the shared checkerboard. Files on disk are
+// read with platform/async_io.h, a job system worker decodes the file, and
+// texture_streaming_update uploads it in row slices of at most a budget of
+// bytes per frame, counted as the bytes the GPU receives. Texture containers
+// (resources/texture_container.h) skip the image decode, the worker only
+// decompresses block formats the GPU lacks, and go up level by level. The
+// texture's id switches to the real one once the renderer has done the last
+// slice, so holders of the texture pointer don't have to do anything.
+//
+// Main thread only, apart from the decoding itself.
+
+// Bytes uploaded per frame when the application doesn't set a budget.
+#define TEXTURE_STREAMING_DEFAULT_BUDGET (4 * 1024 * 1024)
+
+// upload_budget is in bytes per frame, 0 picks the default. Textures larger
+// than the budget are spread over several frames.
+API b8 texture_streaming_initialize(u64 upload_budget);
+// Waits for decodes in flight and drops unfinished uploads. Textures that
+// were still streaming keep drawing the placeholder.
+API void texture_streaming_shutdown();
+API void texture_streaming_set_budget(u64 upload_budget);
+
+// Uploads decoded textures within the budget, oldest requests first. Called
+// once per frame by the application loop.
+API void texture_streaming_update();
+// Textures decoding or waiting to be uploaded.
+API u32 texture_streaming_pending();
+
+// Starts streaming the texture in, t->streaming is TRUE until it is ready.
+// Release it with texture_destroy as usual, also while it streams. Falls back
+// to texture_load when streaming isn't initialized. Decode failures are
+// logged and leave the placeholder in place.
+API texture* texture_load_async(const char* file_path);
+
+// Drops the upload of a texture that is being destroyed.
+void texture_streaming_cancel(texture* t);
@@ -2,7 +2,9 @@
 #include "core/logger.h"
 #include "core/file_operations.h"
 #include "core/kmemory.h"
+#include "renderer/renderer_stats.h"
 #include <GL/glew.h>
+#include <stdlib.h>
 
 // Forward declare internal functions
 static void check_shader_error(u32 shader, const char* type);
@@ -51,16 +53,16 @@ shader_program shader_create_from_files(const char* vertex_path, const char* fra
     if(!read_file_to_buffer(fragment_path, (void**)&fragment_source, &fragment_source_size)) {
         ERROR("Failed to read fragment shader from file: %s", fragment_path);
         // Free vertex source memory before returning
-        kfree(vertex_source, vertex_source_size, MEMORY_TAG_RENDERER);
+        free(vertex_source);
         return program;
     }
     
     // Create the shader program
     program = shader_create_from_source(vertex_source, fragment_source);
     
-    // Free the source code memory
-    kfree(vertex_source, vertex_source_size, MEMORY_TAG_RENDERER);
-    kfree(fragment_source, fragment_source_size, MEMORY_TAG_RENDERER);
+    // Buffers from read_file_to_buffer are released with free()
+    free(vertex_source);
+    free(fragment_source);
     
     return program;
 }
@@ -100,11 +102,13 @@ void shader_destroy(shader_program* program) {
 void shader_bind(const shader_program* program) {
     if (program && program->program_id) {
         glUseProgram(program->program_id);
+        renderer_stats_count_shader_bind();
     }
 }
 
 void shader_unbind(void) {
     glUseProgram(0);
+    renderer_stats_count_shader_bind();
 }
 
 void shader_set_mat4(const shader_program* program, const char* name, const void* value, b8 transpose) {
@@ -113,6 +117,7 @@ void shader_set_mat4(const shader_program* program, const char* name, const void
     GLint location = glGetUniformLocation(program->program_id, name);
     if (location != -1) {
         glUniformMatrix4fv(location, 1, transpose ? GL_TRUE : GL_FALSE, (const GLfloat*)value);
+        renderer_stats_count_uniform_update();
     }
 }
 
@@ -122,6 +127,7 @@ void shader_set_vec4(const shader_program* program, const char* name, const void
     GLint location = glGetUniformLocation(program->program_id, name);
     if (location != -1) {
         glUniform4fv(location, 1, (const GLfloat*)value);
+        renderer_stats_count_uniform_update();
     }
 }
 
@@ -131,6 +137,7 @@ void shader_set_vec3(const shader_program* program, const char* name, const void
     GLint location = glGetUniformLocation(program->program_id, name);
     if (location != -1) {
         glUniform3fv(location, 1, (const GLfloat*)value);
+        renderer_stats_count_uniform_update();
     }
 }
 
@@ -140,6 +147,7 @@ void shader_set_vec2(const shader_program* program, const char* name, const void
     GLint location = glGetUniformLocation(program->program_id, name);
     if (location != -1) {
         glUniform2fv(location, 1, (const GLfloat*)value);
+        renderer_stats_count_uniform_update();
     }
 }
 
@@ -149,6 +157,7 @@ void shader_set_int(const shader_program* program, const char* name, int value)
     GLint location = glGetUniformLocation(program->program_id, name);
     if (location != -1) {
         glUniform1i(location, value);
+        renderer_stats_count_uniform_update();
         // INFO("Set uniform '%s' to value %d in shader %u", name, value, program->program_id);
     } else {
         WARN("Uniform '%s' not found in shader %u", name, program->program_id);
@@ -161,6 +170,7 @@ void shader_set_float(const shader_program* program, const char* name, float val
     GLint location = glGetUniformLocation(program->program_id, name);
     if (location != -1) {
         glUniform1f(location, value);
+        renderer_stats_count_uniform_update();
     }
 }
 
@@ -2,6 +2,7 @@
 #include "entry.h"
 
 #include <core/kmemory.h>
+#include <stdlib.h>
 
 b8 create_game(game* out_game) {
     // Application configuration
@@ -10,11 +11,40 @@ b8 create_game(game* out_game) {
     out_game->app_config.start_width = 1280;
     out_game->app_config.start_height = 720;
     out_game->app_config.name = "Game Engine";
+    out_game->app_config.fixed_timestep = FALSE;
+    out_game->app_config.tick_rate = 60.0f;
+    out_game->app_config.max_ticks_per_frame = 5;
+    out_game->app_config.target_frame_rate = 60.0f;
+    // Written by buildall.sh, loose files under assets/ are used without it
+    out_game->app_config.asset_pack = "assets.pack";
+
+    // Headless runs for build servers, e.g. TESTBED_HEADLESS=1 TESTBED_FRAMES=600 ./testbed
+    const char* headless = getenv("TESTBED_HEADLESS");
+    const char* frames = getenv("TESTBED_FRAMES");
+    const char* threaded = getenv("TESTBED_THREADED");
+    const char* hud = getenv("TESTBED_HUD");
+    const char* hitch_ms = getenv("TESTBED_HITCH_MS");
+    const char* telemetry = getenv("TESTBED_TELEMETRY");
+    const char* counters = getenv("TESTBED_PERF_COUNTERS");
+    const char* sample_hz = getenv("TESTBED_SAMPLE_HZ");
+    out_game->app_config.headless = headless && headless[0] == '1';
+    out_game->app_config.max_frames = frames ? strtoull(frames, NULL, 10) : 0;
+    out_game->app_config.threaded_rendering = threaded && threaded[0] == '1';
+    out_game->app_config.show_perf_hud = hud && hud[0] == '1';
+    out_game->app_config.hitch_threshold_ms = hitch_ms ? strtof(hitch_ms, NULL) : 0.0f;
+    out_game->app_config.publish_telemetry = telemetry && telemetry[0] == '1';
+    out_game->app_config.perf_counters = counters && counters[0] == '1';
+    out_game->app_config.sampling_profiler_hz = sample_hz ? (u32)strtoul(sample_hz, NULL, 10) : 0;
+    if (out_game->app_config.headless) {
+        // Nothing is presented, so measure raw CPU cost instead of pacing to 60
+        out_game->app_config.target_frame_rate = FRAME_RATE_UNLIMITED;
+    }
 
     // Function pointers
     out_game->initialize = game_initialize;
     out_game->update = game_update;
     out_game->render = game_render;
+    out_game->shutdown = game_shutdown;
     out_game->onresize = game_on_resize;
     out_game->on_key_event = game_on_event;
     out_game->on_mouse_event = game_on_event;
@@ -4,13 +4,16 @@
 #include "core/event.h"
 #include "renderer/renderer_frontend.h"
 #include "core/file_operations.h"
+#include "core/profiler.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 #include "core/kstring.h" 
 #include "cube.h" // just for testing
 
 #define CAMERA_SPEED 0.5f
 #define CAMERA_ROTATION_SPEED 1.5f
+#define PROFILE_CAPTURE_FRAMES 120
 
 // Event handler function
 b8 game_on_event(u16 code, void *sender, void *listener_inst, event_context context)
@@ -86,6 +89,12 @@ b8 game_on_event(u16 code, void *sender, void *listener_inst, event_context cont
             INFO("Camera moved down: %.2f", state->camera_position.y);
             return TRUE;
         }
+        else if (key_code == 'p' || key_code == 'P')
+        {
+            // Capture a trace, open it in chrome://tracing or ui.perfetto.dev
+            profiler_capture_frames(PROFILE_CAPTURE_FRAMES, "profile_trace.json");
+            return TRUE;
+        }
         break;
     }
     case EVENT_CODE_KEY_RELEASED:
@@ -249,7 +258,6 @@ b8 game_initialize(game *game_instance)
 
     state->delta_time = 0.0f;
     state->clear_color = (vec4){{0.0f, 0.0f, 0.2f, 1.0f}};
-    state->fps = 0.0f;
     state->mouse_pressed = FALSE;
 
     // Initialize camera with logical position behind and above the cubes
@@ -271,16 +279,28 @@ b8 game_initialize(game *game_instance)
     event_register(EVENT_CODE_BUTTON_PRESSED, state, game_on_event);
     event_register(EVENT_CODE_BUTTON_RELEASED, state, game_on_event);
 
-    // TODO: Move this to a separate function
-    //  Create mesh with 36 vertices (6 faces, 2 triangles per face, 3 vertices per triangle)
-    mesh *cube_mesh = renderer_create_mesh(cube_vertices, 36);
-    if (!cube_mesh)
+    // TESTBED_PROFILE=1 captures the first frames, handy together with TESTBED_HEADLESS
+    const char* profile = getenv("TESTBED_PROFILE");
+    if (profile && profile[0] == '1')
     {
-        ERROR("Failed to create cube mesh!");
-        return FALSE;
+        profiler_capture_frames(PROFILE_CAPTURE_FRAMES, "profile_trace.json");
+    }
+
+    // TESTBED_STATS_CSV=<path> records renderer counters for every frame
+    const char* stats_csv = getenv("TESTBED_STATS_CSV");
+    if (stats_csv && stats_csv[0])
+    {
+        renderer_begin_stats_csv(stats_csv);
     }
-    mesh *cube_mesh2 = renderer_create_mesh(cube_vertices, 36);
-    if (!cube_mesh2)
+
+    // TODO: Move this to a separate function
+    //  Create mesh with 36 vertices (6 faces, 2 triangles per face, 3 vertices per triangle)
+    // Both cubes use the same vertices, so they share one GPU buffer
+    state->cube_meshes[0] = resource_acquire_mesh(cube_vertices, 36);
+    state->cube_meshes[1] = resource_acquire_mesh(cube_vertices, 36);
+    mesh *cube_mesh = resource_get_mesh(state->cube_meshes[0]);
+    mesh *cube_mesh2 = resource_get_mesh(state->cube_meshes[1]);
+    if (!cube_mesh || !cube_mesh2)
     {
         ERROR("Failed to create cube mesh!");
         return FALSE;
@@ -292,11 +312,11 @@ b8 game_initialize(game *game_instance)
                 (vec3){{1.0f, 1.0f, 1.0f}},            // uniform scale
                 (vec4){{1.0f, 0.0f, 0.0f, 1.0f}});     // bright red color
                 
-    // add_mesh_to_render_packet(state, cube_mesh2, 
-    //             (vec3){{-3.0f, 0.0f, 0.0f}},           // positioned 3 units left of origin
-    //             (vec3){{0.0f, 0.0f, 0.0f}},            // no rotation
-    //             (vec3){{1.0f, 2.0f, 1.0f}},            // taller cube
-    //             (vec4){{0.0f, 1.0f, 0.0f, 1.0f}});     // bright green color
+    add_mesh_to_render_packet(state, cube_mesh2, 
+                (vec3){{-3.0f, 0.0f, 0.0f}},           // positioned 3 units left of origin
+                (vec3){{0.0f, 0.0f, 0.0f}},            // no rotation
+                (vec3){{1.0f, 2.0f, 1.0f}},            // taller cube
+                (vec4){{0.0f, 1.0f, 0.0f, 1.0f}});     // bright green color
 
     // Create a new font
     state->font = renderer_create_font("assets/fonts/NotoMono-Regular.ttf", 18);
@@ -306,7 +326,8 @@ b8 game_initialize(game *game_instance)
     }
 
     // Create a new model
-    state->model_commands->model = renderer_create_model("assets/models/plane.obj");
+    state->plane_model = resource_acquire(RESOURCE_TYPE_MODEL, "assets/models/plane.obj");
+    state->model_commands->model = resource_get_model(state->plane_model);
     if (!state->model_commands->model) {
         ERROR("Failed to create model!");
         return FALSE;
@@ -330,11 +351,7 @@ b8 game_update(game *game_instance, f32 delta_time)
         return FALSE;
 
     state->delta_time = delta_time;
-    state->fps = 1.0f / delta_time;
     char text[128]; 
-    sprintf(text, "FPS: %.1f", state->fps);
-    render_text(state, text, 0, (vec2){{20.0f, 50.0f}}, (vec4){{1.0f, 1.0f, 1.0f, 1.0f}}, 1.0f, state->font);
-
     sprintf(text, "Camera: (%.1f, %.1f, %.1f)", 
             state->camera_position.x, state->camera_position.y, state->camera_position.z);
     render_text(state, text, 1, (vec2){{20.0f, 70.0f}}, (vec4){{1.0f, 1.0f, 1.0f, 1.0f}}, 1.0f, state->font);
@@ -357,14 +374,14 @@ b8 game_update(game *game_instance, f32 delta_time)
     return TRUE;
 }
 
-b8 game_render(game *game_instance, f32 delta_time)
+b8 game_render(game *game_instance, f32 delta_time, f32 alpha)
 {
     game_state *state = (game_state *)game_instance->state;
     if (!state)
         return FALSE;
 
     // Set camera position in the render packet
-    render_packet current_packet;
+    render_packet current_packet = {0};
     current_packet.camera_position = state->camera_position;
     current_packet.camera_rotation = state->camera_rotation;
 
@@ -448,16 +465,14 @@ void game_shutdown(game *game_instance)
     event_unregister(EVENT_CODE_BUTTON_PRESSED, state, game_on_event);
     event_unregister(EVENT_CODE_BUTTON_RELEASED, state, game_on_event);
 
-    // Destroy meshes in the darray
-    u64 mesh_count = darray_length(state->mesh_commands);
-    for (u64 i = 0; i < mesh_count; ++i)
+    // Release the shared assets, the resource manager unloads them
+    for (u32 i = 0; i < sizeof(state->cube_meshes) / sizeof(state->cube_meshes[0]); ++i)
     {
-        if (state->mesh_commands[i].mesh)
-        {
-            renderer_destroy_mesh(state->mesh_commands[i].mesh);
-            state->mesh_commands[i].mesh = NULL;
-        }
+        resource_release(state->cube_meshes[i]);
+        state->cube_meshes[i] = INVALID_RESOURCE_HANDLE;
     }
+    resource_release(state->plane_model);
+    state->plane_model = INVALID_RESOURCE_HANDLE;
 
     // Destroy the darray
     if (state->mesh_commands)
@@ -8,11 +8,11 @@
 #include "renderer/renderer_types.inl"
 #include "game_types.h"
 #include "containers/darray.h"
+#include "resources/resource_manager.h"
 #include <SDL2/SDL_keycode.h>  // For SDLK_* constants
 
 typedef struct game_state {
     f32 delta_time;
-    f32 fps;
     vec4 clear_color;  // Color to clear the screen with
 
     // Models
@@ -34,12 +34,16 @@ typedef struct game_state {
     b8 mouse_pressed;
     // Text rendering
     font* font;
+
+    // References to shared assets, released in game_shutdown
+    resource_handle cube_meshes[2];
+    resource_handle plane_model;
 } game_state;
 
 b8 game_on_event(u16 code, void* sender, void* listener_inst, event_context context);
 b8 game_initialize(game* game_instance);
 b8 game_update(game* game_instance, f32 delta_time);
-b8 game_render(game* game_instance, f32 delta_time);
+b8 game_render(game* game_instance, f32 delta_time, f32 alpha);
 void game_on_resize(game* game_instance, u32 width, u32 height);
 void game_shutdown(game* game_instance);
 void rotate_camera(game_state *state, f32 x, f32 y);
@@ -0,0 +1,8 @@
+#!/bin/bash
+
+echo "Building OBJ parser benchmark..."
+
+# Links the engine so it measures the same parsers model_load_obj uses
+clang -g -O2 -fno-omit-frame-pointer src/*.c -I../../engine/src -L../../engine -lengine -D_GNU_SOURCE=1 -D_REENTRANT -lm -lpthread -Wl,-rpath='$ORIGIN' -o objbench
+
+echo "OBJ parser benchmark build complete."
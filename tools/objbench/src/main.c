@@ -0,0 +1,141 @@
+// Times the engine's OBJ parsers against each other on the same file.
+//
+//   objbench <file.obj> [runs] [workers]     parallel parser vs the fgets/sscanf baseline
+//   objbench generate <file.obj> <megabytes> write a synthetic grid mesh to test with
+//
+// workers sets the job system size, 0 (the default) uses one per extra processor.
+
+#include "containers/darray.h"
+#include "core/job_system.h"
+#include "models/obj_parser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#define DEFAULT_RUNS 5
+
+typedef b8 (*pfn_parse)(const char* path, obj_data* out_data);
+
+static double now_seconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static int generate(const char* path, double megabytes) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        perror(path);
+        return 1;
+    }
+
+    // A height-field grid: every cell is a quad with its own texcoords and normals
+    // shared per vertex, roughly 150 bytes of text per vertex.
+    unsigned side = 2;
+    while ((double)side * side * 150.0 < megabytes * 1024.0 * 1024.0) side++;
+    for (unsigned z = 0; z < side; ++z) {
+        for (unsigned x = 0; x < side; ++x) {
+            float fx = (float)x / (side - 1), fz = (float)z / (side - 1);
+            fprintf(file, "v %.6f %.6f %.6f\n", fx * 100.0f - 50.0f, (float)((x * 7 + z * 13) % 17) * 0.125f, fz * 100.0f - 50.0f);
+            fprintf(file, "vt %.6f %.6f\n", fx, fz);
+            fprintf(file, "vn %.6f %.6f %.6f\n", 0.0f, 1.0f, 0.0f);
+        }
+    }
+    for (unsigned z = 0; z + 1 < side; ++z) {
+        for (unsigned x = 0; x + 1 < side; ++x) {
+            unsigned a = z * side + x + 1, b = a + 1, c = a + side + 1, d = a + side;
+            fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c, d, d, d);
+        }
+    }
+    fclose(file);
+
+    struct stat info;
+    stat(path, &info);
+    printf("Wrote %s: %u vertices, %u quads, %.1f MiB\n", path, side * side, (side - 1) * (side - 1),
+           (double)info.st_size / (1024.0 * 1024.0));
+    return 0;
+}
+
+static b8 run(const char* name, pfn_parse parse, const char* path, unsigned runs, double megabytes, obj_data* out_data) {
+    double best = 1e30, total = 0;
+    for (unsigned i = 0; i < runs; ++i) {
+        obj_data data;
+        double start = now_seconds();
+        b8 ok = parse(path, &data);
+        double elapsed = now_seconds() - start;
+        if (!ok) {
+            fprintf(stderr, "%s failed to parse %s\n", name, path);
+            return FALSE;
+        }
+        if (elapsed < best) best = elapsed;
+        total += elapsed;
+        // Keep the last result for the comparison
+        if (i + 1 == runs) {
+            *out_data = data;
+        } else {
+            obj_data_destroy(&data);
+        }
+    }
+    printf("%-10s best %9.2f ms  mean %9.2f ms  %8.1f MiB/s\n", name, best * 1000.0, total / runs * 1000.0, megabytes / best);
+    return TRUE;
+}
+
+static b8 same_array(const char* what, void* a, void* b, u64 stride) {
+    u64 length = darray_length(a);
+    if (length != darray_length(b)) {
+        printf("  %s: count differs, %llu vs %llu\n", what, length, darray_length(b));
+        return FALSE;
+    }
+    if (length && memcmp(a, b, length * stride) != 0) {
+        printf("  %s: contents differ\n", what);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 4 && strcmp(argv[1], "generate") == 0) {
+        return generate(argv[2], atof(argv[3]));
+    }
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <file.obj> [runs] [workers]\n       %s generate <file.obj> <megabytes>\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    const char* path = argv[1];
+    unsigned runs = argc > 2 ? (unsigned)atoi(argv[2]) : DEFAULT_RUNS;
+    if (runs == 0) runs = 1;
+    job_system_initialize(argc > 3 ? (u32)atoi(argv[3]) : 0);
+
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        perror(path);
+        return 1;
+    }
+    double megabytes = (double)info.st_size / (1024.0 * 1024.0);
+    printf("%s: %.1f MiB, %u runs, %u job workers\n", path, megabytes, runs, job_system_worker_count());
+
+    obj_data reference, parallel;
+    if (!run("reference", obj_parse_reference, path, runs, megabytes, &reference) ||
+        !run("parallel", obj_parse, path, runs, megabytes, &parallel)) {
+        return 1;
+    }
+
+    printf("%llu vertices, %llu texcoords, %llu normals, %llu triangles\n", darray_length(parallel.vertices),
+           darray_length(parallel.texcoords), darray_length(parallel.normals), darray_length(parallel.faces));
+    // Floats can legitimately differ in the last bit between strtof and the fast
+    // path, so a mismatch here is worth a look rather than proof of a bug.
+    b8 same = same_array("vertices", reference.vertices, parallel.vertices, sizeof(obj_vertex));
+    same &= same_array("texcoords", reference.texcoords, parallel.texcoords, sizeof(obj_texcoord));
+    same &= same_array("normals", reference.normals, parallel.normals, sizeof(obj_normal));
+    same &= same_array("faces", reference.faces, parallel.faces, sizeof(obj_face));
+    printf("Results %s\n", same ? "match" : "differ");
+
+    obj_data_destroy(&reference);
+    obj_data_destroy(&parallel);
+    job_system_shutdown();
+    return same ? 0 : 2;
+}
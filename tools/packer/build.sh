@@ -0,0 +1,8 @@
+#!/bin/bash
+
+echo "Building asset packer..."
+
+# Links the engine for the pack format, hashing and LZ4 the runtime reads with
+clang -g -O2 src/*.c -I../../engine/src -L../../engine -lengine -D_GNU_SOURCE=1 -D_REENTRANT -lm -lpthread -Wl,-rpath='$ORIGIN' -o packer
+
+echo "Asset packer build complete."
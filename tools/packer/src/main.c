@@ -0,0 +1,296 @@
+// Builds pack files for core/pack.h from directories of loose assets.
+//
+//   packer <output.pack> <directory>... [-z] [-a alignment]   pack every file under the directories
+//   packer list <file.pack>                                   print the table of contents
+//
+// Entries are named by the path they were found under, so run it from the
+// directory the game runs in: cd bin && ./packer assets.pack assets
+// -z stores entries LZ4-compressed when that saves at least an eighth.
+
+#include "core/hash.h"
+#include "core/lz4.h"
+#include "core/pack.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+// Entries smaller than this aren't worth decompressing
+#define MIN_COMPRESS_BYTES 64
+
+typedef struct input_file {
+    char* name;
+    unsigned char* stored;
+    u64 stored_size;
+    u64 size;
+    u64 content_hash;
+    b8 compressed;
+} input_file;
+
+typedef struct input_list {
+    input_file* files;
+    u32 count;
+    u32 capacity;
+} input_list;
+
+static void add_name(input_list* list, const char* name) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 64;
+        list->files = realloc(list->files, sizeof(input_file) * list->capacity);
+    }
+    memset(&list->files[list->count], 0, sizeof(input_file));
+    list->files[list->count++].name = strdup(name);
+}
+
+static b8 walk(input_list* list, const char* path) {
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        perror(path);
+        return FALSE;
+    }
+    if (S_ISREG(info.st_mode)) {
+        add_name(list, path);
+        return TRUE;
+    }
+    if (!S_ISDIR(info.st_mode)) {
+        return TRUE;
+    }
+
+    DIR* dir = opendir(path);
+    if (!dir) {
+        perror(path);
+        return FALSE;
+    }
+    b8 ok = TRUE;
+    struct dirent* child;
+    while (ok && (child = readdir(dir))) {
+        if (strcmp(child->d_name, ".") == 0 || strcmp(child->d_name, "..") == 0) {
+            continue;
+        }
+        char child_path[4096];
+        snprintf(child_path, sizeof(child_path), "%s/%s", path, child->d_name);
+        ok = walk(list, child_path);
+    }
+    closedir(dir);
+    return ok;
+}
+
+static int compare_names(const void* a, const void* b) {
+    return strcmp(((const input_file*)a)->name, ((const input_file*)b)->name);
+}
+
+static b8 load(input_file* file, b8 compress) {
+    FILE* handle = fopen(file->name, "rb");
+    if (!handle) {
+        perror(file->name);
+        return FALSE;
+    }
+    fseek(handle, 0, SEEK_END);
+    file->size = (u64)ftell(handle);
+    fseek(handle, 0, SEEK_SET);
+    unsigned char* data = malloc(file->size ? file->size : 1);
+    if (fread(data, 1, file->size, handle) != file->size) {
+        fprintf(stderr, "%s: short read\n", file->name);
+        fclose(handle);
+        free(data);
+        return FALSE;
+    }
+    fclose(handle);
+    file->content_hash = hash_bytes(data, file->size, 0);
+    file->stored = data;
+    file->stored_size = file->size;
+
+    if (compress && file->size >= MIN_COMPRESS_BYTES) {
+        u64 bound = lz4_compress_bound(file->size);
+        unsigned char* packed = malloc(bound);
+        u64 packed_size = lz4_compress(data, file->size, packed, bound);
+        if (packed_size > 0 && packed_size <= file->size - file->size / 8) {
+            free(data);
+            file->stored = packed;
+            file->stored_size = packed_size;
+            file->compressed = TRUE;
+        } else {
+            free(packed);
+        }
+    }
+    return TRUE;
+}
+
+static u64 align_up(u64 value, u64 alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static b8 write_padding(FILE* file, u64 count) {
+    static const unsigned char zeros[4096] = {0};
+    while (count > 0) {
+        u64 chunk = count < sizeof(zeros) ? count : sizeof(zeros);
+        if (fwrite(zeros, 1, chunk, file) != chunk) return FALSE;
+        count -= chunk;
+    }
+    return TRUE;
+}
+
+static int pack(const char* output, const char** inputs, u32 input_count, b8 compress, u32 alignment) {
+    input_list list = {0};
+    for (u32 i = 0; i < input_count; ++i) {
+        // Names are looked up without a leading ./
+        const char* input = inputs[i];
+        while (input[0] == '.' && input[1] == '/') input += 2;
+        if (!walk(&list, input)) return 1;
+    }
+    if (list.count == 0) {
+        fprintf(stderr, "No files to pack\n");
+        return 1;
+    }
+    // Sorted so the same inputs always produce the same pack
+    qsort(list.files, list.count, sizeof(input_file), compare_names);
+
+    pack_header header = {0};
+    header.magic = PACK_MAGIC;
+    header.version = PACK_VERSION;
+    header.entry_count = list.count;
+    header.alignment = alignment;
+    header.slot_count = 16;
+    while (header.slot_count < list.count * 2) header.slot_count <<= 1;
+    header.toc_offset = sizeof(pack_header);
+    header.names_offset = header.toc_offset + (u64)header.slot_count * sizeof(pack_entry);
+
+    pack_entry* toc = calloc(header.slot_count, sizeof(pack_entry));
+    u64 names_size = 0;
+    for (u32 i = 0; i < list.count; ++i) {
+        names_size += strlen(list.files[i].name) + 1;
+    }
+
+    u64 offset = align_up(header.names_offset + names_size, alignment);
+    u64 name_offset = 0, total_size = 0, total_stored = 0;
+    u32 compressed_count = 0;
+    for (u32 i = 0; i < list.count; ++i) {
+        input_file* file = &list.files[i];
+        if (!load(file, compress)) return 1;
+
+        u64 hash = hash_string(file->name, 0);
+        u32 slot = (u32)(hash & (header.slot_count - 1));
+        while (toc[slot].flags & PACK_ENTRY_USED) {
+            slot = (slot + 1) & (header.slot_count - 1);
+        }
+        pack_entry* entry = &toc[slot];
+        entry->name_hash = hash;
+        entry->name_offset = (u32)name_offset;
+        entry->flags = PACK_ENTRY_USED | (file->compressed ? PACK_ENTRY_COMPRESSED : 0);
+        entry->offset = offset;
+        entry->stored_size = file->stored_size;
+        entry->size = file->size;
+        entry->content_hash = file->content_hash;
+
+        name_offset += strlen(file->name) + 1;
+        offset = align_up(offset + file->stored_size, alignment);
+        total_size += file->size;
+        total_stored += file->stored_size;
+        compressed_count += file->compressed;
+        // The file ends right after the last entry
+        header.file_size = entry->offset + file->stored_size;
+    }
+
+    FILE* out = fopen(output, "wb");
+    if (!out) {
+        perror(output);
+        return 1;
+    }
+    b8 ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    ok = ok && fwrite(toc, sizeof(pack_entry), header.slot_count, out) == header.slot_count;
+    for (u32 i = 0; ok && i < list.count; ++i) {
+        ok = fwrite(list.files[i].name, 1, strlen(list.files[i].name) + 1, out) == strlen(list.files[i].name) + 1;
+    }
+    u64 written = header.names_offset + names_size;
+    for (u32 i = 0; ok && i < list.count; ++i) {
+        input_file* file = &list.files[i];
+        u64 start = align_up(written, alignment);
+        ok = write_padding(out, start - written) &&
+             (file->stored_size == 0 || fwrite(file->stored, 1, file->stored_size, out) == file->stored_size);
+        written = start + file->stored_size;
+    }
+    ok = (fclose(out) == 0) && ok;
+    if (!ok) {
+        fprintf(stderr, "Failed writing %s\n", output);
+        remove(output);
+        return 1;
+    }
+
+    printf("Packed %u files into %s: %.2f MiB of data stored as %.2f MiB, %u compressed, %u TOC slots\n", list.count,
+           output, (double)total_size / (1024.0 * 1024.0), (double)total_stored / (1024.0 * 1024.0), compressed_count,
+           header.slot_count);
+
+    for (u32 i = 0; i < list.count; ++i) {
+        free(list.files[i].name);
+        free(list.files[i].stored);
+    }
+    free(list.files);
+    free(toc);
+    return 0;
+}
+
+static int list_pack(const char* path) {
+    // Validates the pack before the raw reads below
+    pack_archive archive;
+    if (!pack_open(path, &archive)) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return 1;
+    }
+    pack_close(&archive);
+    FILE* file = fopen(path, "rb");
+    pack_header header;
+    if (!file || fread(&header, sizeof(header), 1, file) != 1) {
+        perror(path);
+        return 1;
+    }
+    pack_entry* toc = malloc(sizeof(pack_entry) * header.slot_count);
+    u64 names_size = header.file_size - header.names_offset;
+    char* names = malloc(names_size);
+    fseek(file, (long)header.toc_offset, SEEK_SET);
+    fread(toc, sizeof(pack_entry), header.slot_count, file);
+    fseek(file, (long)header.names_offset, SEEK_SET);
+    fread(names, 1, names_size, file);
+    fclose(file);
+
+    printf("%s: %u entries, %u slots, %u byte alignment\n", path, header.entry_count, header.slot_count, header.alignment);
+    for (u32 i = 0; i < header.slot_count; ++i) {
+        if (!(toc[i].flags & PACK_ENTRY_USED)) continue;
+        printf("  %10llu %10llu %s %s\n", toc[i].size, toc[i].stored_size,
+               (toc[i].flags & PACK_ENTRY_COMPRESSED) ? "lz4 " : "    ", names + toc[i].name_offset);
+    }
+    free(toc);
+    free(names);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 3 && strcmp(argv[1], "list") == 0) {
+        return list_pack(argv[2]);
+    }
+
+    const char* output = 0;
+    const char* inputs[256];
+    u32 input_count = 0;
+    b8 compress = FALSE;
+    u32 alignment = PACK_DEFAULT_ALIGNMENT;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-z") == 0) {
+            compress = TRUE;
+        } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            alignment = (u32)strtoul(argv[++i], 0, 10);
+        } else if (!output) {
+            output = argv[i];
+        } else if (input_count < 256) {
+            inputs[input_count++] = argv[i];
+        }
+    }
+    if (!output || input_count == 0 || alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        fprintf(stderr, "usage: %s <output.pack> <directory>... [-z] [-a alignment]\n       %s list <file.pack>\n", argv[0],
+                argv[0]);
+        fprintf(stderr, "alignment must be a power of two\n");
+        return 1;
+    }
+    return pack(output, inputs, input_count, compress, alignment);
+}
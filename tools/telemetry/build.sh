@@ -0,0 +1,8 @@
+#!/bin/bash
+
+echo "Building telemetry reader..."
+
+# Only shares the telemetry_block layout with the engine, no need to link it
+clang src/*.c -I../../engine/src -D_GNU_SOURCE=1 -lrt -o telemetry
+
+echo "Telemetry reader build complete."
@@ -0,0 +1,138 @@
+// Prints the live stats a running engine publishes in shared memory.
+//
+//   telemetry              first instance found in /dev/shm, refreshed twice a second
+//   telemetry <pid>        a specific instance
+//   telemetry <pid> once   print a single snapshot and exit
+//   telemetry list         running instances
+
+#include "core/telemetry.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#define REFRESH_MS 500
+
+static const telemetry_block* map_block(u32 pid) {
+    char name[64];
+    snprintf(name, sizeof(name), TELEMETRY_NAME_PREFIX "%u", pid);
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        fprintf(stderr, "No telemetry for pid %u (%s)\n", pid, name);
+        return 0;
+    }
+    void* block = mmap(0, sizeof(telemetry_block), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (block == MAP_FAILED) {
+        perror("mmap");
+        return 0;
+    }
+
+    const telemetry_block* telemetry = block;
+    if (telemetry->magic != TELEMETRY_MAGIC || telemetry->version != TELEMETRY_VERSION ||
+        telemetry->size != sizeof(telemetry_block)) {
+        fprintf(stderr, "pid %u publishes telemetry version %u, this reader understands %u\n",
+                pid, telemetry->version, TELEMETRY_VERSION);
+        munmap(block, sizeof(telemetry_block));
+        return 0;
+    }
+    return telemetry;
+}
+
+// Calls found(pid) for every published segment, returns how many there were.
+static u32 find_instances(void (*found)(u32 pid), u32 max) {
+    // Skip the leading '/', shm_open names live directly in /dev/shm
+    const char* prefix = TELEMETRY_NAME_PREFIX + 1;
+    u64 prefix_length = strlen(prefix);
+    DIR* dir = opendir("/dev/shm");
+    if (!dir) {
+        return 0;
+    }
+    u32 count = 0;
+    struct dirent* entry;
+    while (count < max && (entry = readdir(dir))) {
+        if (strncmp(entry->d_name, prefix, prefix_length) == 0) {
+            found((u32)strtoul(entry->d_name + prefix_length, 0, 10));
+            count++;
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+static void print_pid(u32 pid) {
+    printf("%u\n", pid);
+}
+
+static u32 first_pid = 0;
+static void take_pid(u32 pid) {
+    first_pid = pid;
+}
+
+static void print_snapshot(const telemetry_block* s) {
+    printf("frame %llu  up %.1fs  frame %.2f ms  avg %.2f  p50 %.2f  p95 %.2f  p99 %.2f  max %.2f\n",
+           s->frame_number, s->uptime_seconds, s->frame_ms, s->smoothed_ms, s->p50_ms, s->p95_ms, s->p99_ms,
+           s->max_ms);
+    printf("  draws %u  tris %llu  shaders %u  textures %u  uploads %u (%llu bytes)  loading %u\n",
+           s->draw_calls, s->triangles, s->shader_binds, s->texture_binds, s->buffer_uploads,
+           s->buffer_upload_bytes, s->loading_queue_depth);
+    printf("  memory %llu bytes  %llu allocations (%llu bytes lifetime)\n",
+           s->memory_total, s->allocation_count, s->allocated_bytes);
+    u32 tags = s->tag_count < TELEMETRY_MAX_TAGS ? s->tag_count : TELEMETRY_MAX_TAGS;
+    for (u32 i = 0; i < tags; ++i) {
+        if (s->tagged_allocations[i] > 0) {
+            printf("    %.*s %llu\n", TELEMETRY_TAG_NAME_LENGTH, s->tag_names[i], s->tagged_allocations[i]);
+        }
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "list") == 0) {
+        return find_instances(print_pid, 1024) > 0 ? 0 : 1;
+    }
+
+    u32 pid = 0;
+    if (argc > 1) {
+        pid = (u32)strtoul(argv[1], 0, 10);
+    } else if (find_instances(take_pid, 1) > 0) {
+        pid = first_pid;
+    }
+    if (pid == 0) {
+        fprintf(stderr, "No running instance found\n");
+        return 1;
+    }
+    int once = argc > 2 && strcmp(argv[2], "once") == 0;
+
+    const telemetry_block* block = map_block(pid);
+    if (!block) {
+        return 1;
+    }
+
+    telemetry_block snapshot;
+    struct timespec refresh = {REFRESH_MS / 1000, (REFRESH_MS % 1000) * 1000000L};
+    for (;;) {
+        // A crashed instance leaves its segment behind with running still set
+        if (!__atomic_load_n(&block->running, __ATOMIC_ACQUIRE) || (kill((pid_t)pid, 0) != 0 && errno == ESRCH)) {
+            printf("pid %u has shut down\n", pid);
+            break;
+        }
+        if (telemetry_read(block, &snapshot)) {
+            print_snapshot(&snapshot);
+        }
+        if (once) {
+            break;
+        }
+        nanosleep(&refresh, 0);
+    }
+
+    munmap((void*)block, sizeof(telemetry_block));
+    return 0;
+}
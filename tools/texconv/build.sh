@@ -0,0 +1,8 @@
+#!/bin/bash
+
+echo "Building texture converter..."
+
+# Links the engine for the container format and stb_image, -msse2 for the filter loops on any x86 target
+clang -g -O2 -msse2 src/*.c -I../../engine/src -L../../engine -lengine -D_GNU_SOURCE=1 -D_REENTRANT -lm -lpthread -Wl,-rpath='$ORIGIN' -o texconv
+
+echo "Texture converter build complete."
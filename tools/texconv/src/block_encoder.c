@@ -0,0 +1,640 @@
+#include "block_encoder.h"
+#include "resources/texture_compression.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// A 4x4 block with its channels planar, so the distance loop runs over four
+// pixels at a time.
+typedef struct block {
+    float c[4][16];
+    // Per-pixel error weight, 0 for pixels whose colour doesn't matter
+    float weight[16];
+} block;
+
+// Endpoints as floats in 0-255
+typedef struct endpoints {
+    float e[2][4];
+} endpoints;
+
+static const float rgb_weights[4] = {1.0f, 1.0f, 1.0f, 0.0f};
+static const float alpha_weights[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+static const float rgba_weights[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+
+static const u8 bc7_weights2[4] = {0, 21, 43, 64};
+static const u8 bc7_weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+static float clampf(float value, float lo, float hi) {
+    return value < lo ? lo : (value > hi ? hi : value);
+}
+
+// Picks the nearest palette entry for every pixel by weighted squared
+// distance, returning the total error.
+static float fit_indices(const block* b, const float (*palette)[4], u32 count, const float* channel_weights,
+                         u8* out_indices) {
+    float total = 0.0f;
+#if defined(__SSE2__)
+    for (u32 p = 0; p < 16; p += 4) {
+        __m128 channels[4];
+        for (u32 ch = 0; ch < 4; ++ch) {
+            channels[ch] = _mm_loadu_ps(b->c[ch] + p);
+        }
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128i best_index = _mm_setzero_si128();
+        for (u32 e = 0; e < count; ++e) {
+            __m128 distance = _mm_setzero_ps();
+            for (u32 ch = 0; ch < 4; ++ch) {
+                if (channel_weights[ch] == 0.0f) continue;
+                __m128 diff = _mm_sub_ps(channels[ch], _mm_set1_ps(palette[e][ch]));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_mul_ps(diff, diff), _mm_set1_ps(channel_weights[ch])));
+            }
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+            best = _mm_min_ps(distance, best);
+            best_index = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32((int)e)), _mm_andnot_si128(closer, best_index));
+        }
+        best = _mm_mul_ps(best, _mm_loadu_ps(b->weight + p));
+        float errors[4];
+        i32 indices[4];
+        _mm_storeu_ps(errors, best);
+        _mm_storeu_si128((__m128i*)indices, best_index);
+        for (u32 i = 0; i < 4; ++i) {
+            out_indices[p + i] = (u8)indices[i];
+            total += errors[i];
+        }
+    }
+#else
+    for (u32 p = 0; p < 16; ++p) {
+        float best = FLT_MAX;
+        u8 best_index = 0;
+        for (u32 e = 0; e < count; ++e) {
+            float distance = 0.0f;
+            for (u32 ch = 0; ch < 4; ++ch) {
+                float diff = b->c[ch][p] - palette[e][ch];
+                distance += diff * diff * channel_weights[ch];
+            }
+            if (distance < best) {
+                best = distance;
+                best_index = (u8)e;
+            }
+        }
+        out_indices[p] = best_index;
+        total += best * b->weight[p];
+    }
+#endif
+    return total;
+}
+
+static endpoints bounding_endpoints(const block* b, u32 first_channel, u32 channel_count) {
+    endpoints result = {0};
+    for (u32 ch = first_channel; ch < first_channel + channel_count; ++ch) {
+        float lo = 255.0f, hi = 0.0f;
+        for (u32 p = 0; p < 16; ++p) {
+            if (b->weight[p] == 0.0f) continue;
+            lo = fminf(lo, b->c[ch][p]);
+            hi = fmaxf(hi, b->c[ch][p]);
+        }
+        if (lo > hi) lo = hi = 0.0f;
+        // Inset so the extremes land near palette entries instead of on them
+        float inset = (hi - lo) / 16.0f;
+        result.e[0][ch] = hi - inset;
+        result.e[1][ch] = lo + inset;
+    }
+    return result;
+}
+
+// Endpoints at the extremes of the pixels along their principal axis.
+static endpoints principal_endpoints(const block* b, u32 first_channel, u32 channel_count) {
+    float mean[4] = {0}, total = 0.0f;
+    for (u32 p = 0; p < 16; ++p) {
+        total += b->weight[p];
+        for (u32 ch = first_channel; ch < first_channel + channel_count; ++ch) {
+            mean[ch] += b->c[ch][p] * b->weight[p];
+        }
+    }
+    if (total == 0.0f) {
+        return bounding_endpoints(b, first_channel, channel_count);
+    }
+    for (u32 ch = 0; ch < 4; ++ch) mean[ch] /= total;
+
+    float covariance[4][4] = {0};
+    for (u32 p = 0; p < 16; ++p) {
+        for (u32 i = first_channel; i < first_channel + channel_count; ++i) {
+            for (u32 j = first_channel; j < first_channel + channel_count; ++j) {
+                covariance[i][j] += (b->c[i][p] - mean[i]) * (b->c[j][p] - mean[j]) * b->weight[p];
+            }
+        }
+    }
+    // Power iteration, starting from the channel that varies most
+    float axis[4] = {0};
+    u32 widest = first_channel;
+    for (u32 ch = first_channel; ch < first_channel + channel_count; ++ch) {
+        if (covariance[ch][ch] > covariance[widest][widest]) widest = ch;
+    }
+    axis[widest] = 1.0f;
+    for (u32 iteration = 0; iteration < 8; ++iteration) {
+        float next[4] = {0}, length = 0.0f;
+        for (u32 i = first_channel; i < first_channel + channel_count; ++i) {
+            for (u32 j = first_channel; j < first_channel + channel_count; ++j) {
+                next[i] += covariance[i][j] * axis[j];
+            }
+            length += next[i] * next[i];
+        }
+        if (length < 1e-12f) break;
+        length = sqrtf(length);
+        for (u32 ch = 0; ch < 4; ++ch) axis[ch] = next[ch] / length;
+    }
+
+    float lo = FLT_MAX, hi = -FLT_MAX;
+    for (u32 p = 0; p < 16; ++p) {
+        if (b->weight[p] == 0.0f) continue;
+        float t = 0.0f;
+        for (u32 ch = first_channel; ch < first_channel + channel_count; ++ch) {
+            t += (b->c[ch][p] - mean[ch]) * axis[ch];
+        }
+        lo = fminf(lo, t);
+        hi = fmaxf(hi, t);
+    }
+    endpoints result = {0};
+    for (u32 ch = first_channel; ch < first_channel + channel_count; ++ch) {
+        result.e[0][ch] = clampf(mean[ch] + axis[ch] * hi, 0.0f, 255.0f);
+        result.e[1][ch] = clampf(mean[ch] + axis[ch] * lo, 0.0f, 255.0f);
+    }
+    return result;
+}
+
+// Endpoints minimizing the squared error for fixed indices, where index i
+// sits at position[i] between the endpoints. FALSE when the indices don't
+// pin both endpoints down.
+static b8 least_squares_endpoints(const block* b, const u8* indices, const float* position, u32 first_channel,
+                                  u32 channel_count, endpoints* out) {
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[4] = {0}, bx[4] = {0};
+    for (u32 p = 0; p < 16; ++p) {
+        float w = b->weight[p];
+        float t = position[indices[p]];
+        float s = 1.0f - t;
+        aa += s * s * w;
+        ab += s * t * w;
+        bb += t * t * w;
+        for (u32 ch = first_channel; ch < first_channel + channel_count; ++ch) {
+            ax[ch] += s * b->c[ch][p] * w;
+            bx[ch] += t * b->c[ch][p] * w;
+        }
+    }
+    float determinant = aa * bb - ab * ab;
+    if (fabsf(determinant) < 1e-6f) {
+        return FALSE;
+    }
+    for (u32 ch = first_channel; ch < first_channel + channel_count; ++ch) {
+        out->e[0][ch] = clampf((bb * ax[ch] - ab * bx[ch]) / determinant, 0.0f, 255.0f);
+        out->e[1][ch] = clampf((aa * bx[ch] - ab * ax[ch]) / determinant, 0.0f, 255.0f);
+    }
+    return TRUE;
+}
+
+static u32 refinements(encode_quality quality) {
+    return quality == ENCODE_QUALITY_FAST ? 0 : (quality == ENCODE_QUALITY_NORMAL ? 1 : 4);
+}
+
+// BC1 ------------------------------------------------------------------------
+
+typedef struct bc1_block {
+    u16 c0;
+    u16 c1;
+    u8 indices[16];
+    float error;
+} bc1_block;
+
+static u16 pack_565(const float* colour) {
+    u32 r = (u32)(clampf(colour[0], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+    u32 g = (u32)(clampf(colour[1], 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+    u32 b = (u32)(clampf(colour[2], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+    return (u16)((r << 11) | (g << 5) | b);
+}
+
+static void unpack_565(u16 colour, float* out) {
+    u32 r = (colour >> 11) & 0x1F, g = (colour >> 5) & 0x3F, b = colour & 0x1F;
+    out[0] = (float)((r << 3) | (r >> 2));
+    out[1] = (float)((g << 2) | (g >> 4));
+    out[2] = (float)((b << 3) | (b >> 2));
+    out[3] = 255.0f;
+}
+
+// Palette positions of BC1 indices in 4 and 3 colour mode
+static const float bc1_positions4[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+static const float bc1_positions3[4] = {0.0f, 1.0f, 0.5f, 0.0f};
+
+// Quantizes the endpoints and fits indices. 3-colour mode keeps index 3 for
+// transparent pixels. four_colour_only is BC3's colour half, which decodes
+// in 4-colour mode whatever the endpoint order.
+static bc1_block bc1_evaluate(const block* b, const endpoints* ends, b8 three_colour, b8 four_colour_only,
+                              const b8* transparent) {
+    bc1_block result;
+    u16 c0 = pack_565(ends->e[0]);
+    u16 c1 = pack_565(ends->e[1]);
+    if (c0 == c1 && !four_colour_only) {
+        three_colour = TRUE;
+    }
+    // 4-colour mode is signalled by c0 > c1, 3-colour by c0 <= c1
+    if (three_colour ? c0 > c1 : c0 < c1) {
+        u16 swap = c0;
+        c0 = c1;
+        c1 = swap;
+    }
+
+    float palette[4][4];
+    unpack_565(c0, palette[0]);
+    unpack_565(c1, palette[1]);
+    // The same rounding as bc1_decode_block
+    for (u32 ch = 0; ch < 3; ++ch) {
+        u32 a = (u32)palette[0][ch], z = (u32)palette[1][ch];
+        if (three_colour) {
+            palette[2][ch] = (float)((a + z + 1) / 2);
+            palette[3][ch] = 0.0f;
+        } else {
+            palette[2][ch] = (float)((2 * a + z + 1) / 3);
+            palette[3][ch] = (float)((a + 2 * z + 1) / 3);
+        }
+    }
+    result.c0 = c0;
+    result.c1 = c1;
+    result.error = fit_indices(b, (const float (*)[4])palette, three_colour ? 3 : 4, rgb_weights, result.indices);
+    for (u32 p = 0; transparent && p < 16; ++p) {
+        if (transparent[p]) result.indices[p] = 3;
+    }
+    return result;
+}
+
+static bc1_block bc1_search(const block* b, encode_quality quality, b8 three_colour, b8 four_colour_only,
+                            const b8* transparent) {
+    endpoints start = quality == ENCODE_QUALITY_FAST ? bounding_endpoints(b, 0, 3) : principal_endpoints(b, 0, 3);
+    bc1_block best = bc1_evaluate(b, &start, three_colour, four_colour_only, transparent);
+    if (quality == ENCODE_QUALITY_HIGH) {
+        endpoints box = bounding_endpoints(b, 0, 3);
+        bc1_block candidate = bc1_evaluate(b, &box, three_colour, four_colour_only, transparent);
+        if (candidate.error < best.error) best = candidate;
+    }
+    for (u32 i = 0; i < refinements(quality) && best.error > 0.0f; ++i) {
+        // Indices follow the evaluated block's mode, which c0 <= c1 signals
+        b8 three = !four_colour_only && best.c0 <= best.c1;
+        endpoints refined = {0};
+        if (!least_squares_endpoints(b, best.indices, three ? bc1_positions3 : bc1_positions4, 0, 3, &refined)) {
+            break;
+        }
+        bc1_block candidate = bc1_evaluate(b, &refined, three_colour, four_colour_only, transparent);
+        if (candidate.error >= best.error) break;
+        best = candidate;
+    }
+    return best;
+}
+
+static void bc1_write(const bc1_block* encoded, u8* out) {
+    out[0] = (u8)(encoded->c0 & 0xFF);
+    out[1] = (u8)(encoded->c0 >> 8);
+    out[2] = (u8)(encoded->c1 & 0xFF);
+    out[3] = (u8)(encoded->c1 >> 8);
+    u32 indices = 0;
+    for (u32 p = 0; p < 16; ++p) {
+        indices |= (u32)encoded->indices[p] << (p * 2);
+    }
+    memcpy(out + 4, &indices, 4);
+}
+
+static void encode_bc1(const block* source, encode_quality quality, b8 alpha, u8* out) {
+    block b = *source;
+    b8 transparent[16] = {0};
+    b8 any_transparent = FALSE;
+    for (u32 p = 0; alpha && p < 16; ++p) {
+        // 1-bit alpha, transparent pixels drop out of the colour fit
+        if (b.c[3][p] < 128.0f) {
+            transparent[p] = TRUE;
+            any_transparent = TRUE;
+            b.weight[p] = 0.0f;
+        }
+    }
+
+    bc1_block best = bc1_search(&b, quality, any_transparent, FALSE, any_transparent ? transparent : 0);
+    if (quality == ENCODE_QUALITY_HIGH && !any_transparent) {
+        // The midpoint of 3-colour mode sometimes fits better
+        bc1_block candidate = bc1_search(&b, quality, TRUE, FALSE, 0);
+        if (candidate.error < best.error) best = candidate;
+    }
+    bc1_write(&best, out);
+}
+
+// BC3 ------------------------------------------------------------------------
+
+typedef struct bc3_alpha_block {
+    u8 a0;
+    u8 a1;
+    u8 indices[16];
+    float error;
+} bc3_alpha_block;
+
+static bc3_alpha_block bc3_alpha_evaluate(const block* b, u32 a0, u32 a1) {
+    bc3_alpha_block result;
+    result.a0 = (u8)a0;
+    result.a1 = (u8)a1;
+    // The same rounding as bc3_decode_block
+    float palette[8][4] = {{0}};
+    palette[0][3] = (float)a0;
+    palette[1][3] = (float)a1;
+    if (a0 > a1) {
+        for (u32 i = 1; i < 7; ++i) palette[i + 1][3] = (float)(((7 - i) * a0 + i * a1 + 3) / 7);
+    } else {
+        for (u32 i = 1; i < 5; ++i) palette[i + 1][3] = (float)(((5 - i) * a0 + i * a1 + 2) / 5);
+        palette[6][3] = 0.0f;
+        palette[7][3] = 255.0f;
+    }
+    result.error = fit_indices(b, (const float (*)[4])palette, 8, alpha_weights, result.indices);
+    return result;
+}
+
+static bc3_alpha_block bc3_alpha_search(const block* b, encode_quality quality) {
+    u32 lo = 255, hi = 0, inner_lo = 255, inner_hi = 0;
+    for (u32 p = 0; p < 16; ++p) {
+        u32 a = (u32)b->c[3][p];
+        lo = a < lo ? a : lo;
+        hi = a > hi ? a : hi;
+        if (a != 0 && a != 255) {
+            inner_lo = a < inner_lo ? a : inner_lo;
+            inner_hi = a > inner_hi ? a : inner_hi;
+        }
+    }
+    // 8 interpolated values between the extremes
+    bc3_alpha_block best = bc3_alpha_evaluate(b, hi, lo);
+    if (quality == ENCODE_QUALITY_FAST || best.error == 0.0f) {
+        return best;
+    }
+    if (inner_lo <= inner_hi) {
+        // 6 values between the inner extremes, 0 and 255 are exact
+        bc3_alpha_block candidate = bc3_alpha_evaluate(b, inner_lo, inner_hi);
+        if (candidate.error < best.error) best = candidate;
+    }
+    if (quality == ENCODE_QUALITY_HIGH && hi > lo) {
+        // Pulling the endpoints in can centre the steps on the values
+        for (u32 d0 = 0; d0 <= 4 && d0 <= hi; ++d0) {
+            for (u32 d1 = 0; d1 <= 4 && lo + d1 < hi - d0; ++d1) {
+                bc3_alpha_block candidate = bc3_alpha_evaluate(b, hi - d0, lo + d1);
+                if (candidate.error < best.error) best = candidate;
+            }
+        }
+    }
+    return best;
+}
+
+static void encode_bc3(const block* b, encode_quality quality, u8* out) {
+    bc3_alpha_block alpha = bc3_alpha_search(b, quality);
+    out[0] = alpha.a0;
+    out[1] = alpha.a1;
+    u64 indices = 0;
+    for (u32 p = 0; p < 16; ++p) {
+        indices |= (u64)alpha.indices[p] << (p * 3);
+    }
+    for (u32 i = 0; i < 6; ++i) {
+        out[2 + i] = (u8)(indices >> (i * 8));
+    }
+
+    bc1_block colour = bc1_search(b, quality, FALSE, TRUE, 0);
+    bc1_write(&colour, out + 8);
+}
+
+// BC7 ------------------------------------------------------------------------
+
+typedef struct bit_writer {
+    u8* data;
+    u32 position;
+} bit_writer;
+
+static void write_bits(bit_writer* writer, u32 value, u32 count) {
+    for (u32 i = 0; i < count; ++i, ++writer->position) {
+        writer->data[writer->position >> 3] |= (u8)(((value >> i) & 1) << (writer->position & 7));
+    }
+}
+
+static u8 bc7_interpolate(u32 e0, u32 e1, u32 weight) {
+    return (u8)(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+}
+
+// The weights as palette positions for the least-squares fit
+static const float bc7_positions2[4] = {0.0f, 21.0f / 64.0f, 43.0f / 64.0f, 1.0f};
+static const float bc7_positions4[16] = {0.0f,          4.0f / 64.0f,  9.0f / 64.0f,  13.0f / 64.0f,
+                                         17.0f / 64.0f, 21.0f / 64.0f, 26.0f / 64.0f, 30.0f / 64.0f,
+                                         34.0f / 64.0f, 38.0f / 64.0f, 43.0f / 64.0f, 47.0f / 64.0f,
+                                         51.0f / 64.0f, 55.0f / 64.0f, 60.0f / 64.0f, 1.0f};
+
+typedef struct bc7_mode6_block {
+    // 7-bit endpoints and the p-bit of each endpoint
+    u8 q[2][4];
+    u8 pbit[2];
+    u8 indices[16];
+    float error;
+} bc7_mode6_block;
+
+static bc7_mode6_block bc7_mode6_evaluate(const block* b, const endpoints* ends) {
+    bc7_mode6_block result;
+    u32 full[2][4];
+    for (u32 e = 0; e < 2; ++e) {
+        // The p-bit is shared by all four channels, keep the closer choice
+        float best_error = FLT_MAX;
+        for (u32 p = 0; p < 2; ++p) {
+            float error = 0.0f;
+            u8 q[4];
+            for (u32 ch = 0; ch < 4; ++ch) {
+                q[ch] = (u8)clampf(floorf((ends->e[e][ch] - (float)p) / 2.0f + 0.5f), 0.0f, 127.0f);
+                float diff = (float)(q[ch] * 2 + p) - ends->e[e][ch];
+                error += diff * diff;
+            }
+            if (error < best_error) {
+                best_error = error;
+                result.pbit[e] = (u8)p;
+                memcpy(result.q[e], q, 4);
+            }
+        }
+        for (u32 ch = 0; ch < 4; ++ch) full[e][ch] = result.q[e][ch] * 2u + result.pbit[e];
+    }
+
+    float palette[16][4];
+    for (u32 i = 0; i < 16; ++i) {
+        for (u32 ch = 0; ch < 4; ++ch) {
+            palette[i][ch] = (float)bc7_interpolate(full[0][ch], full[1][ch], bc7_weights4[i]);
+        }
+    }
+    result.error = fit_indices(b, (const float (*)[4])palette, 16, rgba_weights, result.indices);
+    return result;
+}
+
+static bc7_mode6_block bc7_mode6_search(const block* b, encode_quality quality) {
+    endpoints start = quality == ENCODE_QUALITY_FAST ? bounding_endpoints(b, 0, 4) : principal_endpoints(b, 0, 4);
+    bc7_mode6_block best = bc7_mode6_evaluate(b, &start);
+    for (u32 i = 0; i < refinements(quality) && best.error > 0.0f; ++i) {
+        endpoints refined;
+        if (!least_squares_endpoints(b, best.indices, bc7_positions4, 0, 4, &refined)) break;
+        bc7_mode6_block candidate = bc7_mode6_evaluate(b, &refined);
+        if (candidate.error >= best.error) break;
+        best = candidate;
+    }
+    return best;
+}
+
+static void bc7_mode6_write(bc7_mode6_block* encoded, u8* out) {
+    // The first index has its top bit implied 0, flip the block if it's set
+    if (encoded->indices[0] & 8) {
+        for (u32 ch = 0; ch < 4; ++ch) {
+            u8 swap = encoded->q[0][ch];
+            encoded->q[0][ch] = encoded->q[1][ch];
+            encoded->q[1][ch] = swap;
+        }
+        u8 swap = encoded->pbit[0];
+        encoded->pbit[0] = encoded->pbit[1];
+        encoded->pbit[1] = swap;
+        for (u32 p = 0; p < 16; ++p) encoded->indices[p] = (u8)(15 - encoded->indices[p]);
+    }
+    memset(out, 0, 16);
+    bit_writer writer = {out, 0};
+    write_bits(&writer, 1u << 6, 7);
+    for (u32 ch = 0; ch < 4; ++ch) {
+        write_bits(&writer, encoded->q[0][ch], 7);
+        write_bits(&writer, encoded->q[1][ch], 7);
+    }
+    write_bits(&writer, encoded->pbit[0], 1);
+    write_bits(&writer, encoded->pbit[1], 1);
+    for (u32 p = 0; p < 16; ++p) write_bits(&writer, encoded->indices[p], p == 0 ? 3 : 4);
+}
+
+typedef struct bc7_mode5_block {
+    u32 rotation;
+    // 7-bit colour endpoints and 8-bit alpha endpoints
+    u8 colour[2][3];
+    u8 alpha[2];
+    u8 colour_indices[16];
+    u8 alpha_indices[16];
+    float error;
+} bc7_mode5_block;
+
+// b is already rotated, alpha holds the channel that is indexed separately.
+static bc7_mode5_block bc7_mode5_evaluate(const block* b, const endpoints* ends) {
+    bc7_mode5_block result = {0};
+    float palette[4][4] = {{0}};
+    for (u32 e = 0; e < 2; ++e) {
+        for (u32 ch = 0; ch < 3; ++ch) {
+            result.colour[e][ch] = (u8)clampf(floorf(ends->e[e][ch] * 127.0f / 255.0f + 0.5f), 0.0f, 127.0f);
+        }
+        result.alpha[e] = (u8)clampf(floorf(ends->e[e][3] + 0.5f), 0.0f, 255.0f);
+    }
+    for (u32 i = 0; i < 4; ++i) {
+        for (u32 ch = 0; ch < 3; ++ch) {
+            u32 e0 = (result.colour[0][ch] << 1) | (result.colour[0][ch] >> 6);
+            u32 e1 = (result.colour[1][ch] << 1) | (result.colour[1][ch] >> 6);
+            palette[i][ch] = (float)bc7_interpolate(e0, e1, bc7_weights2[i]);
+        }
+        palette[i][3] = (float)bc7_interpolate(result.alpha[0], result.alpha[1], bc7_weights2[i]);
+    }
+    result.error = fit_indices(b, (const float (*)[4])palette, 4, rgb_weights, result.colour_indices) +
+                   fit_indices(b, (const float (*)[4])palette, 4, alpha_weights, result.alpha_indices);
+    return result;
+}
+
+static bc7_mode5_block bc7_mode5_search(const block* source, u32 rotation, encode_quality quality) {
+    block b = *source;
+    if (rotation) {
+        // The decoder swaps them back after interpolating
+        for (u32 p = 0; p < 16; ++p) {
+            float swap = b.c[3][p];
+            b.c[3][p] = b.c[rotation - 1][p];
+            b.c[rotation - 1][p] = swap;
+        }
+    }
+    endpoints start = principal_endpoints(&b, 0, 3);
+    endpoints alpha = bounding_endpoints(&b, 3, 1);
+    start.e[0][3] = alpha.e[0][3];
+    start.e[1][3] = alpha.e[1][3];
+    bc7_mode5_block best = bc7_mode5_evaluate(&b, &start);
+    for (u32 i = 0; i < refinements(quality) && best.error > 0.0f; ++i) {
+        endpoints refined = start;
+        b8 colour = least_squares_endpoints(&b, best.colour_indices, bc7_positions2, 0, 3, &refined);
+        b8 alpha_refined = least_squares_endpoints(&b, best.alpha_indices, bc7_positions2, 3, 1, &refined);
+        if (!colour && !alpha_refined) break;
+        bc7_mode5_block candidate = bc7_mode5_evaluate(&b, &refined);
+        if (candidate.error >= best.error) break;
+        best = candidate;
+        start = refined;
+    }
+    best.rotation = rotation;
+    return best;
+}
+
+static void bc7_mode5_write(bc7_mode5_block* encoded, u8* out) {
+    if (encoded->colour_indices[0] & 2) {
+        for (u32 ch = 0; ch < 3; ++ch) {
+            u8 swap = encoded->colour[0][ch];
+            encoded->colour[0][ch] = encoded->colour[1][ch];
+            encoded->colour[1][ch] = swap;
+        }
+        for (u32 p = 0; p < 16; ++p) encoded->colour_indices[p] = (u8)(3 - encoded->colour_indices[p]);
+    }
+    if (encoded->alpha_indices[0] & 2) {
+        u8 swap = encoded->alpha[0];
+        encoded->alpha[0] = encoded->alpha[1];
+        encoded->alpha[1] = swap;
+        for (u32 p = 0; p < 16; ++p) encoded->alpha_indices[p] = (u8)(3 - encoded->alpha_indices[p]);
+    }
+    memset(out, 0, 16);
+    bit_writer writer = {out, 0};
+    write_bits(&writer, 1u << 5, 6);
+    write_bits(&writer, encoded->rotation, 2);
+    for (u32 ch = 0; ch < 3; ++ch) {
+        write_bits(&writer, encoded->colour[0][ch], 7);
+        write_bits(&writer, encoded->colour[1][ch], 7);
+    }
+    write_bits(&writer, encoded->alpha[0], 8);
+    write_bits(&writer, encoded->alpha[1], 8);
+    for (u32 p = 0; p < 16; ++p) write_bits(&writer, encoded->colour_indices[p], p == 0 ? 1 : 2);
+    for (u32 p = 0; p < 16; ++p) write_bits(&writer, encoded->alpha_indices[p], p == 0 ? 1 : 2);
+}
+
+static void encode_bc7(const block* b, encode_quality quality, u8* out) {
+    bc7_mode6_block mode6 = bc7_mode6_search(b, quality);
+    if (quality == ENCODE_QUALITY_HIGH && mode6.error > 0.0f) {
+        bc7_mode5_block best = {0};
+        best.error = FLT_MAX;
+        for (u32 rotation = 0; rotation < 4; ++rotation) {
+            bc7_mode5_block candidate = bc7_mode5_search(b, rotation, quality);
+            if (candidate.error < best.error) best = candidate;
+        }
+        if (best.error < mode6.error) {
+            bc7_mode5_write(&best, out);
+            return;
+        }
+    }
+    bc7_mode6_write(&mode6, out);
+}
+
+void compress_level(texture_compression compression, encode_quality quality, b8 alpha, const u8* pixels, u32 width,
+                    u32 height, u8* out_blocks) {
+    u32 block_bytes = texture_compression_block_bytes(compression);
+    for (u32 by = 0; by < height; by += TEXTURE_BLOCK_SIZE) {
+        for (u32 bx = 0; bx < width; bx += TEXTURE_BLOCK_SIZE, out_blocks += block_bytes) {
+            block b;
+            for (u32 p = 0; p < 16; ++p) {
+                // Edge pixels repeat into the padding
+                u32 x = bx + p % 4 < width ? bx + p % 4 : width - 1;
+                u32 y = by + p / 4 < height ? by + p / 4 : height - 1;
+                const u8* pixel = pixels + ((u64)y * width + x) * 4;
+                for (u32 ch = 0; ch < 4; ++ch) b.c[ch][p] = (float)pixel[ch];
+                b.weight[p] = 1.0f;
+            }
+            switch (compression) {
+                case TEXTURE_COMPRESSION_BC1: encode_bc1(&b, quality, alpha, out_blocks); break;
+                case TEXTURE_COMPRESSION_BC3: encode_bc3(&b, quality, out_blocks); break;
+                case TEXTURE_COMPRESSION_BC7: encode_bc7(&b, quality, out_blocks); break;
+                default: break;
+            }
+        }
+    }
+}
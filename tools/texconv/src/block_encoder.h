@@ -0,0 +1,26 @@
+#pragma once
+
+#include "renderer/renderer_types.inl"
+
+// BC1, BC3 and BC7 encoding for texconv. Every block is decoded back with the
+// engine's palettes while searching, so the error being minimized is the one
+// the GPU will show.
+//
+// BC7 blocks are written in the single-subset modes: 6 everywhere, plus 5
+// with each channel rotation at high quality, which wins where alpha doesn't
+// follow the colour.
+
+typedef enum encode_quality {
+    // Bounding box endpoints, no refinement
+    ENCODE_QUALITY_FAST,
+    // Principal axis endpoints and one least-squares refinement
+    ENCODE_QUALITY_NORMAL,
+    // Several refinements and every candidate mode
+    ENCODE_QUALITY_HIGH
+} encode_quality;
+
+// Compresses a width x height RGBA8 level into rows of blocks, edge pixels
+// repeat into partial blocks. alpha is FALSE when every alpha is 255, which
+// keeps BC1 out of its 1-bit alpha mode.
+void compress_level(texture_compression compression, encode_quality quality, b8 alpha, const u8* pixels, u32 width,
+                    u32 height, u8* out_blocks);
@@ -0,0 +1,484 @@
+// Converts images to texture containers (resources/texture_container.h) with
+// the full mip chain computed offline, so loading them at runtime needs no
+// decode and no glGenerateMipmap.
+//
+//   texconv <input image> <output.ktex> [-f box|kaiser] [-l] [-n] [-c bc1|bc3|bc7] [-q fast|normal|high]
+//                                       convert an image stb_image can read
+//   texconv info <file.ktex>            print the header and levels
+//
+// -f picks the downsampling filter: kaiser (default) is a Kaiser-windowed sinc
+//    that keeps mips sharp, box averages the pixels each one covers.
+// -l treats colour channels as linear data, e.g. normal maps. By default they
+//    are sRGB and filtered in linear light, so mips don't darken.
+// -n stores the base level only.
+// -c block compresses every level, see block_encoder.h. BC1 suits opaque
+//    textures at 4 bits per pixel, BC3 and BC7 take alpha at 8, BC7 with the
+//    better quality. The PSNR of the base level is printed.
+// -q trades encoding time for quality, normal by default.
+//
+// Levels are filtered from the previous level in float, only the stored copy
+// of each is rounded to 8 bits.
+
+#include "block_encoder.h"
+#include "resources/texture_compression.h"
+#include "resources/texture_container.h"
+#include "vendor/stb_image.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Half-width of the Kaiser-windowed sinc in destination pixels, and the
+// window's shape parameter. Wider is sharper but rings more.
+#define KAISER_RADIUS 3.0f
+#define KAISER_ALPHA 4.0f
+
+typedef enum filter_type {
+    FILTER_BOX,
+    FILTER_KAISER
+} filter_type;
+
+// A level in float, channels interleaved.
+typedef struct image {
+    float* pixels;
+    u32 width;
+    u32 height;
+    u32 channels;
+} image;
+
+// Source pixels and weights that make up one destination pixel along an axis.
+typedef struct contribution {
+    u32 first;
+    u32 count;
+    float* weights;
+} contribution;
+
+static float srgb_to_linear[256];
+
+static void build_srgb_table() {
+    for (u32 i = 0; i < 256; ++i) {
+        float c = (float)i / 255.0f;
+        srgb_to_linear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+    }
+}
+
+static u8 encode_linear(float value) {
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return (u8)(value * 255.0f + 0.5f);
+}
+
+static u8 encode_srgb(float value) {
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    float c = value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+    return (u8)(c * 255.0f + 0.5f);
+}
+
+// Alpha is the last channel of 2 and 4 channel images, always linear.
+static b8 is_colour_channel(u32 channel, u32 channels) {
+    return !((channels == 2 || channels == 4) && channel == channels - 1);
+}
+
+// Zeroth-order modified Bessel function of the first kind, by its series.
+static double bessel_i0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+// x is in destination pixels from the destination pixel's centre.
+static float kaiser_sinc(float x) {
+    if (fabsf(x) >= KAISER_RADIUS) return 0.0f;
+    double t = x / KAISER_RADIUS;
+    double window = bessel_i0(KAISER_ALPHA * sqrt(1.0 - t * t)) / bessel_i0(KAISER_ALPHA);
+    double sinc = x == 0.0f ? 1.0 : sin(M_PI * x) / (M_PI * x);
+    return (float)(sinc * window);
+}
+
+// Weights for shrinking an axis from src_size to dst_size pixels. Samples past
+// the edges are clamped onto the edge pixels.
+static contribution* build_contributions(u32 src_size, u32 dst_size, filter_type filter) {
+    contribution* contributions = calloc(dst_size, sizeof(contribution));
+    float scale = (float)src_size / (float)dst_size;
+    float support = filter == FILTER_BOX ? scale * 0.5f : KAISER_RADIUS * scale;
+    for (u32 i = 0; i < dst_size; ++i) {
+        float centre = ((float)i + 0.5f) * scale;
+        i32 first = (i32)floorf(centre - support);
+        i32 last = (i32)ceilf(centre + support);
+        contribution* c = &contributions[i];
+        c->first = first < 0 ? 0 : (u32)first;
+        u32 end = last > (i32)src_size ? src_size : (u32)last;
+        c->count = end - c->first;
+        c->weights = calloc(c->count, sizeof(float));
+
+        float total = 0.0f;
+        for (i32 j = first; j < last; ++j) {
+            float weight;
+            if (filter == FILTER_BOX) {
+                // Coverage of source pixel [j, j + 1] by the destination pixel
+                float lo = fmaxf((float)j, centre - support);
+                float hi = fminf((float)j + 1.0f, centre + support);
+                weight = hi > lo ? hi - lo : 0.0f;
+            } else {
+                weight = kaiser_sinc(((float)j + 0.5f - centre) / scale);
+            }
+            i32 clamped = j < 0 ? 0 : (j >= (i32)src_size ? (i32)src_size - 1 : j);
+            c->weights[(u32)clamped - c->first] += weight;
+            total += weight;
+        }
+        for (u32 k = 0; k < c->count; ++k) {
+            c->weights[k] /= total;
+        }
+    }
+    return contributions;
+}
+
+static void free_contributions(contribution* contributions, u32 count) {
+    for (u32 i = 0; i < count; ++i) {
+        free(contributions[i].weights);
+    }
+    free(contributions);
+}
+
+// dst += weight * src over count floats, the inner loop of the vertical pass.
+static void accumulate_row(float* restrict dst, const float* restrict src, float weight, u32 count) {
+    u32 i = 0;
+#if defined(__SSE2__)
+    __m128 w = _mm_set1_ps(weight);
+    for (; i + 8 <= count; i += 8) {
+        __m128 a = _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(w, _mm_loadu_ps(src + i)));
+        __m128 b = _mm_add_ps(_mm_loadu_ps(dst + i + 4), _mm_mul_ps(w, _mm_loadu_ps(src + i + 4)));
+        _mm_storeu_ps(dst + i, a);
+        _mm_storeu_ps(dst + i + 4, b);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] += weight * src[i];
+    }
+}
+
+// Shrinks src into the next level, halving each side but not below 1.
+static image downsample(const image* src, filter_type filter) {
+    image dst;
+    dst.width = src->width > 1 ? src->width / 2 : 1;
+    dst.height = src->height > 1 ? src->height / 2 : 1;
+    dst.channels = src->channels;
+    u32 channels = src->channels;
+
+    // Horizontal pass into a src->height x dst.width buffer
+    contribution* columns = build_contributions(src->width, dst.width, filter);
+    float* wide = malloc(sizeof(float) * src->height * dst.width * channels);
+    for (u32 y = 0; y < src->height; ++y) {
+        const float* in = src->pixels + (u64)y * src->width * channels;
+        float* out = wide + (u64)y * dst.width * channels;
+        for (u32 x = 0; x < dst.width; ++x) {
+            const contribution* c = &columns[x];
+            float sum[4] = {0};
+            for (u32 k = 0; k < c->count; ++k) {
+                const float* p = in + (u64)(c->first + k) * channels;
+                for (u32 ch = 0; ch < channels; ++ch) {
+                    sum[ch] += c->weights[k] * p[ch];
+                }
+            }
+            memcpy(out + (u64)x * channels, sum, sizeof(float) * channels);
+        }
+    }
+    free_contributions(columns, dst.width);
+
+    // Vertical pass, whole rows at a time
+    contribution* rows = build_contributions(src->height, dst.height, filter);
+    u32 row_floats = dst.width * channels;
+    dst.pixels = calloc((u64)dst.height * row_floats, sizeof(float));
+    for (u32 y = 0; y < dst.height; ++y) {
+        const contribution* c = &rows[y];
+        float* out = dst.pixels + (u64)y * row_floats;
+        for (u32 k = 0; k < c->count; ++k) {
+            accumulate_row(out, wide + (u64)(c->first + k) * row_floats, c->weights[k], row_floats);
+        }
+    }
+    free_contributions(rows, dst.height);
+    free(wide);
+    return dst;
+}
+
+static void encode_level(const image* level, b8 srgb, u8* out) {
+    u64 count = (u64)level->width * level->height;
+    for (u64 i = 0; i < count; ++i) {
+        for (u32 ch = 0; ch < level->channels; ++ch) {
+            float value = level->pixels[i * level->channels + ch];
+            out[i * level->channels + ch] =
+                srgb && is_colour_channel(ch, level->channels) ? encode_srgb(value) : encode_linear(value);
+        }
+    }
+}
+
+// Widens a level to RGBA the way the GPU samples it: missing colour channels
+// read as 0 and missing alpha as 255.
+static void expand_rgba(const u8* pixels, u32 width, u32 height, u32 channels, u8* out) {
+    for (u64 i = 0; i < (u64)width * height; ++i) {
+        u8 rgba[4] = {0, 0, 0, 255};
+        memcpy(rgba, pixels + i * channels, channels);
+        memcpy(out + i * 4, rgba, 4);
+    }
+}
+
+// Peak signal to noise ratio in dB over the channels the texture has.
+static double psnr(const u8* a, const u8* b, u64 pixel_count, u32 channels) {
+    double sum = 0.0;
+    for (u64 i = 0; i < pixel_count; ++i) {
+        for (u32 ch = 0; ch < channels; ++ch) {
+            double diff = (double)a[i * 4 + ch] - (double)b[i * 4 + ch];
+            sum += diff * diff;
+        }
+    }
+    double mse = sum / (double)(pixel_count * channels);
+    return mse == 0.0 ? INFINITY : 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+static ktex_format compressed_format(texture_compression compression) {
+    switch (compression) {
+        case TEXTURE_COMPRESSION_BC1: return KTEX_FORMAT_BC1;
+        case TEXTURE_COMPRESSION_BC3: return KTEX_FORMAT_BC3;
+        default: return KTEX_FORMAT_BC7;
+    }
+}
+
+static const char* format_name(u32 format) {
+    switch (format) {
+        case KTEX_FORMAT_R8: return "R8";
+        case KTEX_FORMAT_RG8: return "RG8";
+        case KTEX_FORMAT_RGB8: return "RGB8";
+        case KTEX_FORMAT_RGBA8: return "RGBA8";
+        case KTEX_FORMAT_BC1: return "BC1";
+        case KTEX_FORMAT_BC3: return "BC3";
+        case KTEX_FORMAT_BC7: return "BC7";
+        default: return "unknown";
+    }
+}
+
+static u64 align_up(u64 value, u64 alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static int convert(const char* input, const char* output, filter_type filter, b8 srgb, b8 mips,
+                   texture_compression compression, encode_quality quality) {
+    // Stored bottom-up, the row order texture_load uploads
+    stbi_set_flip_vertically_on_load(1);
+    int width, height, channels;
+    u8* pixels = stbi_load(input, &width, &height, &channels, 0);
+    if (!pixels) {
+        fprintf(stderr, "%s: %s\n", input, stbi_failure_reason());
+        return 1;
+    }
+
+    if (compression == TEXTURE_COMPRESSION_BC1 && channels == 4) {
+        for (u64 i = 0; i < (u64)width * height; ++i) {
+            u8 alpha = pixels[i * 4 + 3];
+            if (alpha != 0 && alpha != 255) {
+                fprintf(stderr, "%s: BC1 keeps 1-bit alpha, bc3 or bc7 suit blended alpha\n", input);
+                break;
+            }
+        }
+    }
+
+    build_srgb_table();
+    image level = {malloc(sizeof(float) * (u64)width * height * channels), (u32)width, (u32)height, (u32)channels};
+    for (u64 i = 0; i < (u64)width * height; ++i) {
+        for (u32 ch = 0; ch < (u32)channels; ++ch) {
+            u8 value = pixels[i * channels + ch];
+            level.pixels[i * channels + ch] =
+                srgb && is_colour_channel(ch, channels) ? srgb_to_linear[value] : (float)value / 255.0f;
+        }
+    }
+    stbi_image_free(pixels);
+
+    ktex_header header = {0};
+    header.magic = KTEX_MAGIC;
+    header.version = KTEX_VERSION;
+    header.format = compression ? compressed_format(compression) : (u32)channels;
+    header.flags = (srgb ? KTEX_FLAG_SRGB : 0) | (channels == 4 ? KTEX_FLAG_ALPHA : 0);
+    header.width = (u32)width;
+    header.height = (u32)height;
+    header.level_count = 1;
+    if (mips) {
+        for (u32 w = header.width, h = header.height; w > 1 || h > 1; w = w > 1 ? w / 2 : 1, h = h > 1 ? h / 2 : 1) {
+            header.level_count++;
+        }
+    }
+
+    ktex_level levels[KTEX_MAX_LEVELS] = {0};
+    u8* data[KTEX_MAX_LEVELS] = {0};
+    double base_psnr = 0.0;
+    u64 offset = align_up(sizeof(ktex_header) + sizeof(ktex_level) * header.level_count, KTEX_ALIGNMENT);
+    for (u32 i = 0; i < header.level_count; ++i) {
+        if (i > 0) {
+            image next = downsample(&level, filter);
+            free(level.pixels);
+            level = next;
+        }
+        levels[i].offset = offset;
+        levels[i].size = ktex_level_size(header.format, level.width, level.height);
+        levels[i].width = level.width;
+        levels[i].height = level.height;
+        data[i] = malloc(levels[i].size);
+        if (compression) {
+            u64 pixel_count = (u64)level.width * level.height;
+            u8* encoded = malloc(pixel_count * channels);
+            u8* rgba = malloc(pixel_count * 4);
+            encode_level(&level, srgb, encoded);
+            expand_rgba(encoded, level.width, level.height, (u32)channels, rgba);
+            compress_level(compression, quality, channels == 4, rgba, level.width, level.height, data[i]);
+            if (i == 0) {
+                // Decoded the way GPUs without the format get it
+                u8* decoded = malloc(pixel_count * 4);
+                if (texture_decompress(compression, data[i], level.width, level.height, decoded)) {
+                    base_psnr = psnr(rgba, decoded, pixel_count, (u32)channels);
+                }
+                free(decoded);
+            }
+            free(rgba);
+            free(encoded);
+        } else {
+            encode_level(&level, srgb, data[i]);
+        }
+        header.file_size = offset + levels[i].size;
+        offset = align_up(offset + levels[i].size, KTEX_ALIGNMENT);
+    }
+    free(level.pixels);
+
+    static const u8 zeros[KTEX_ALIGNMENT] = {0};
+    FILE* out = fopen(output, "wb");
+    if (!out) {
+        perror(output);
+        return 1;
+    }
+    b8 ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    ok = ok && fwrite(levels, sizeof(ktex_level), header.level_count, out) == header.level_count;
+    u64 written = sizeof(ktex_header) + sizeof(ktex_level) * header.level_count;
+    for (u32 i = 0; ok && i < header.level_count; ++i) {
+        u64 padding = levels[i].offset - written;
+        ok = fwrite(zeros, 1, padding, out) == padding && fwrite(data[i], 1, levels[i].size, out) == levels[i].size;
+        written = levels[i].offset + levels[i].size;
+        free(data[i]);
+    }
+    ok = (fclose(out) == 0) && ok;
+    if (!ok) {
+        fprintf(stderr, "Failed writing %s\n", output);
+        remove(output);
+        return 1;
+    }
+
+    printf("Converted %s to %s: %ux%u, %d channels, %s, %u levels, %s filter, %s, %.2f KiB\n", input, output, width,
+           height, channels, format_name(header.format), header.level_count, filter == FILTER_BOX ? "box" : "kaiser",
+           srgb ? "sRGB" : "linear", (double)header.file_size / 1024.0);
+    if (compression) {
+        printf("Base level PSNR %.2f dB\n", base_psnr);
+    }
+    return 0;
+}
+
+static int info(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    u64 size = (u64)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    u8* data = malloc(size ? size : 1);
+    b8 read = fread(data, 1, size, file) == size;
+    fclose(file);
+
+    ktex_file container;
+    if (!read || !ktex_parse(data, size, path, &container)) {
+        fprintf(stderr, "Could not read %s\n", path);
+        free(data);
+        return 1;
+    }
+    const ktex_header* header = container.header;
+    printf("%s: %ux%u, %s, %u levels%s%s, %llu bytes\n", path, header->width, header->height,
+           format_name(header->format), header->level_count, (header->flags & KTEX_FLAG_SRGB) ? ", sRGB" : "",
+           (header->flags & KTEX_FLAG_ALPHA) ? ", alpha" : "", header->file_size);
+    for (u32 i = 0; i < header->level_count; ++i) {
+        const ktex_level* level = &container.levels[i];
+        printf("  %2u %5ux%-5u %10llu bytes at %llu\n", i, level->width, level->height, level->size, level->offset);
+    }
+    free(data);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 3 && strcmp(argv[1], "info") == 0) {
+        return info(argv[2]);
+    }
+
+    const char* input = 0;
+    const char* output = 0;
+    filter_type filter = FILTER_KAISER;
+    b8 srgb = TRUE;
+    b8 mips = TRUE;
+    texture_compression compression = TEXTURE_COMPRESSION_NONE;
+    encode_quality quality = ENCODE_QUALITY_NORMAL;
+    b8 usage = FALSE;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (strcmp(name, "box") == 0) {
+                filter = FILTER_BOX;
+            } else if (strcmp(name, "kaiser") == 0) {
+                filter = FILTER_KAISER;
+            } else {
+                usage = TRUE;
+            }
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (strcmp(name, "bc1") == 0) {
+                compression = TEXTURE_COMPRESSION_BC1;
+            } else if (strcmp(name, "bc3") == 0) {
+                compression = TEXTURE_COMPRESSION_BC3;
+            } else if (strcmp(name, "bc7") == 0) {
+                compression = TEXTURE_COMPRESSION_BC7;
+            } else {
+                usage = TRUE;
+            }
+        } else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (strcmp(name, "fast") == 0) {
+                quality = ENCODE_QUALITY_FAST;
+            } else if (strcmp(name, "normal") == 0) {
+                quality = ENCODE_QUALITY_NORMAL;
+            } else if (strcmp(name, "high") == 0) {
+                quality = ENCODE_QUALITY_HIGH;
+            } else {
+                usage = TRUE;
+            }
+        } else if (strcmp(argv[i], "-l") == 0) {
+            srgb = FALSE;
+        } else if (strcmp(argv[i], "-n") == 0) {
+            mips = FALSE;
+        } else if (!input) {
+            input = argv[i];
+        } else if (!output) {
+            output = argv[i];
+        } else {
+            usage = TRUE;
+        }
+    }
+    if (usage || !input || !output) {
+        fprintf(stderr,
+                "usage: %s <input image> <output.ktex> [-f box|kaiser] [-l] [-n] [-c bc1|bc3|bc7] [-q fast|normal|high]\n"
+                "       %s info <file.ktex>\n",
+                argv[0], argv[0]);
+        return 1;
+    }
+    return convert(input, output, filter, srgb, mips, compression, quality);
+}